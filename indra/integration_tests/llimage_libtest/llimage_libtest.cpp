@@ -87,6 +87,9 @@ static const char USAGE[] = "\n"
 " -rev, --reversible\n"
 "        Set the compression to be lossless (reversible in j2c parlance).\n"
 "        Only valid for output j2c images.\n"
+" -t, --threads <n>\n"
+"        Maximum number of threads used to decode a single image.\n"
+"        Only valid for input j2c images. Default is 1.\n"
 " -f, --filter <file>\n"
 "        Apply the filter <file> to the input images.\n"
 " -log, --logmetrics <metric>\n"
@@ -356,6 +359,7 @@ int main(int argc, char** argv)
     int blocks_size = -1;
     int levels = 0;
     bool reversible = false;
+    int decode_threads = 1;
     std::string filter_name = "";
 
     // Init whatever is necessary
@@ -507,6 +511,22 @@ int main(int argc, char** argv)
         {
             reversible = true;
         }
+        else if (!strcmp(argv[arg], "--threads") || !strcmp(argv[arg], "-t"))
+        {
+            std::string value_str;
+            if ((arg + 1) < argc)
+            {
+                value_str = argv[arg+1];
+            }
+            if (((arg + 1) >= argc) || (value_str[0] == '-'))
+            {
+                std::cout << "No valid --threads argument given, threads ignored" << std::endl;
+            }
+            else
+            {
+                decode_threads = llmax(atoi(value_str.c_str()), 1);
+            }
+        }
         else if (!strcmp(argv[arg], "--logmetrics") || !strcmp(argv[arg], "-log"))
         {
             // '--logmetrics' needs to be specified with a named test metric argument
@@ -559,6 +579,8 @@ int main(int argc, char** argv)
         }
     }
 
+    LLImageJ2C::setDecodeThreads(decode_threads, 256 * 256);
+
     // Check arguments consistency. Exit with proper message if inconsistent.
     if (input_filenames.size() == 0)
     {
@@ -160,6 +160,7 @@ LLAvatarAppearance::LLAvatarXmlInfo::~LLAvatarXmlInfo()
 LLAvatarSkeletonInfo* LLAvatarAppearance::sAvatarSkeletonInfo = NULL;
 LLAvatarAppearance::LLAvatarXmlInfo* LLAvatarAppearance::sAvatarXmlInfo = NULL;
 LLAvatarAppearanceDefines::LLAvatarAppearanceDictionary* LLAvatarAppearance::sAvatarDictionary = NULL;
+bool LLAvatarAppearance::sBatchMorphs = true;
 
 
 LLAvatarAppearance::LLAvatarAppearance(LLWearableData* wearable_data) :
@@ -187,6 +188,7 @@ void LLAvatarAppearance::initInstance()
     //-------------------------------------------------------------------------
     mRoot = createAvatarJoint();
     mRoot->setName( "mRoot" );
+    mRoot->setFlattenHierarchy(true);
 
     for (const LLAvatarAppearanceDictionary::MeshEntries::value_type& mesh_pair : sAvatarDictionary->getMeshEntries())
     {
@@ -1325,6 +1327,35 @@ LLPolyMesh* LLAvatarAppearance::getUpperBodyMesh()
     return mMeshLOD[MESH_ID_UPPER_BODY]->mMeshParts[0]->getMesh();
 }
 
+// virtual
+void LLAvatarAppearance::updateVisualParams()
+{
+    if (!sBatchMorphs)
+    {
+        LLCharacter::updateVisualParams();
+        return;
+    }
+
+    // morphs only apply to the meshes LODs are made from
+    for (polymesh_map_t::value_type& mesh_pair : mPolyMeshes)
+    {
+        if (!mesh_pair.second->isLOD())
+        {
+            mesh_pair.second->beginMorphBatch();
+        }
+    }
+
+    LLCharacter::updateVisualParams();
+
+    for (polymesh_map_t::value_type& mesh_pair : mPolyMeshes)
+    {
+        if (!mesh_pair.second->isLOD())
+        {
+            mesh_pair.second->endMorphBatch();
+        }
+    }
+}
+
 
 
 // virtual
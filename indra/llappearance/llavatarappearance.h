@@ -98,6 +98,11 @@ public:
     /*virtual*/ LLPolyMesh*     getHeadMesh();
     /*virtual*/ LLPolyMesh*     getUpperBodyMesh();
 
+    // Applies the changed params in one morph batch per mesh, see
+    // LLPolyMesh::beginMorphBatch(), unless sBatchMorphs is off.
+    /*virtual*/ void            updateVisualParams();
+    static bool                 sBatchMorphs;
+
 /**                    Inherited
  **                                                                            **
  *******************************************************************************/
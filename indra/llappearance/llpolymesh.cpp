@@ -757,6 +757,8 @@ LLPolyMesh::LLPolyMesh(LLPolyMeshSharedData *shared_data, LLPolyMesh *reference_
     mReferenceMesh = reference_mesh;
     mAvatarp = NULL;
     mVertexData = NULL;
+    mMorphBatchDepth = 0;
+    mNumMorphedVertices = 0;
 
     mCurVertexCount = 0;
     mFaceIndexCount = 0;
@@ -971,6 +973,86 @@ LLVector4a *LLPolyMesh::getScaledBinormals()
 }
 
 
+//-----------------------------------------------------------------------------
+// beginMorphBatch()
+//-----------------------------------------------------------------------------
+void LLPolyMesh::beginMorphBatch()
+{
+    if (mMorphBatchDepth++ == 0)
+    {
+        // endMorphBatch() leaves the flags clear
+        mMorphedVertices.resize(mSharedData->mNumVertices, 0);
+        mNumMorphedVertices = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// endMorphBatch()
+//-----------------------------------------------------------------------------
+void LLPolyMesh::endMorphBatch()
+{
+    llassert(mMorphBatchDepth > 0);
+    if (--mMorphBatchDepth > 0 || !mNumMorphedVertices)
+    {
+        return;
+    }
+
+    LL_PROFILE_ZONE_SCOPED;
+
+    const U32 num_vertices = (U32)mMorphedVertices.size();
+    for (U32 index = 0; index < num_vertices; ++index)
+    {
+        if (mMorphedVertices[index])
+        {
+            mMorphedVertices[index] = 0;
+            renormalizeVertex(index);
+        }
+    }
+    mNumMorphedVertices = 0;
+}
+
+//-----------------------------------------------------------------------------
+// addMorphedVertices()
+//-----------------------------------------------------------------------------
+void LLPolyMesh::addMorphedVertices(const U32* indices, U32 count)
+{
+    if (mMorphBatchDepth > 0)
+    {
+        U8* morphed = mMorphedVertices.data();
+        for (U32 i = 0; i < count; ++i)
+        {
+            U8& flag = morphed[indices[i]];
+            mNumMorphedVertices += !flag;
+            flag = 1;
+        }
+    }
+    else
+    {
+        for (U32 i = 0; i < count; ++i)
+        {
+            renormalizeVertex(indices[i]);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// renormalizeVertex()
+//-----------------------------------------------------------------------------
+void LLPolyMesh::renormalizeVertex(U32 index)
+{
+    // normals from half angles
+    LLVector4a norm = mScaledNormals[index];
+    norm.normalize3fast();
+    mNormals[index] = norm;
+
+    LLVector4a tangent;
+    tangent.setCross3(mScaledBinormals[index], norm);
+    LLVector4a& normalized_binormal = mBinormals[index];
+
+    normalized_binormal.setCross3(norm, tangent);
+    normalized_binormal.normalize3fast();
+}
+
 //-----------------------------------------------------------------------------
 // initializeForMorph()
 //-----------------------------------------------------------------------------
@@ -29,6 +29,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include "llstl.h"
 
 #include "v3math.h"
@@ -252,6 +253,15 @@ public:
     LLVector4a *getWritableBinormals();
     LLVector4a *getScaledBinormals();
 
+    // Morph targets add into the scaled normals and binormals, and the
+    // output ones of the vertices they moved are then renormalized. Between
+    // beginMorphBatch() and endMorphBatch() that happens once per vertex at
+    // the end of the batch, however many morphs moved it, in vertex order;
+    // otherwise right away. The results are the same either way.
+    void beginMorphBatch();
+    void endMorphBatch();
+    void addMorphedVertices(const U32* indices, U32 count);
+
     // Get texCoords
     const LLVector2 *getTexCoords() const {
         return mTexCoords;
@@ -330,6 +340,7 @@ public:
     U32             mCurVertexCount;
 private:
     void initializeForMorph();
+    void renormalizeVertex(U32 index);
 
     // Dumps diagnostic information about the global mesh table
     static void dumpDiagInfo();
@@ -356,6 +367,11 @@ protected:
 
     LLPolyMesh              *mReferenceMesh;
 
+    // vertices moved by morphs since the batch began, if one is open
+    S32                     mMorphBatchDepth;
+    std::vector<U8>         mMorphedVertices;
+    U32                     mNumMorphedVertices;
+
     // global mesh list
     typedef std::map<std::string, LLPolyMeshSharedData*> LLPolyMeshSharedDataTable;
     static LLPolyMeshSharedDataTable sGlobalSharedMeshList;
@@ -571,52 +571,41 @@ void LLPolyMorphTarget::apply( ESex avatar_sex )
         LLVector4a *coords = mMesh->getWritableCoords();
 
         LLVector4a *scaled_normals = mMesh->getScaledNormals();
-        LLVector4a *normals = mMesh->getWritableNormals();
-
         LLVector4a *scaled_binormals = mMesh->getScaledBinormals();
-        LLVector4a *binormals = mMesh->getWritableBinormals();
 
         LLVector4a *clothing_weights = mMesh->getWritableClothingWeights();
         LLVector2 *tex_coords = mMesh->getWritableTexCoords();
 
         F32 *maskWeightArray = (mVertMask) ? mVertMask->getMorphMaskWeights() : NULL;
 
-        for(U32 vert_index_morph = 0; vert_index_morph < mMorphData->mNumIndices; vert_index_morph++)
-        {
-            S32 vert_index_mesh = mMorphData->mVertexIndices[vert_index_morph];
+        const bool is_clothing_morph = getInfo()->mIsClothingMorph && clothing_weights;
+        const U32* vertex_indices = mMorphData->mVertexIndices;
+        const U32 num_indices = mMorphData->mNumIndices;
 
-            F32 maskWeight = 1.f;
-            if (maskWeightArray)
-            {
-                maskWeight = maskWeightArray[vert_index_morph];
-            }
+        // add the deltas, the mesh renormalizes the vertices they moved
+        for (U32 vert_index_morph = 0; vert_index_morph < num_indices; vert_index_morph++)
+        {
+            S32 vert_index_mesh = vertex_indices[vert_index_morph];
 
+            const F32 maskWeight = maskWeightArray ? maskWeightArray[vert_index_morph] : 1.f;
+            const F32 weight = delta_weight * maskWeight;
 
             LLVector4a pos = mMorphData->mCoords[vert_index_morph];
-            pos.mul(delta_weight*maskWeight);
+            pos.mul(weight);
             coords[vert_index_mesh].add(pos);
 
-            if (getInfo()->mIsClothingMorph && clothing_weights)
+            if (is_clothing_morph)
             {
-                LLVector4a clothing_offset = mMorphData->mCoords[vert_index_morph];
-                clothing_offset.mul(delta_weight * maskWeight);
                 LLVector4a* clothing_weight = &clothing_weights[vert_index_mesh];
-                clothing_weight->add(clothing_offset);
+                clothing_weight->add(pos);
                 clothing_weight->getF32ptr()[VW] = maskWeight;
             }
 
-            // calculate new normals based on half angles
+            // new normals based on half angles
             LLVector4a norm = mMorphData->mNormals[vert_index_morph];
-            norm.mul(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
+            norm.mul(weight * NORMAL_SOFTEN_FACTOR);
             scaled_normals[vert_index_mesh].add(norm);
-            norm = scaled_normals[vert_index_mesh];
 
-            // guard against degenerate input data before we create NaNs below!
-            //
-            norm.normalize3fast();
-            normals[vert_index_mesh] = norm;
-
-            // calculate new binormals
             LLVector4a binorm = mMorphData->mBinormals[vert_index_morph];
 
             // guard against degenerate input data before we create NaNs below!
@@ -626,18 +615,14 @@ void LLPolyMorphTarget::apply( ESex avatar_sex )
                 binorm.set(1,0,0,1);
             }
 
-            binorm.mul(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
+            binorm.mul(weight * NORMAL_SOFTEN_FACTOR);
             scaled_binormals[vert_index_mesh].add(binorm);
-            LLVector4a tangent;
-            tangent.setCross3(scaled_binormals[vert_index_mesh], norm);
-            LLVector4a& normalized_binormal = binormals[vert_index_mesh];
-
-            normalized_binormal.setCross3(norm, tangent);
-            normalized_binormal.normalize3fast();
 
             tex_coords[vert_index_mesh] += mMorphData->mTexCoords[vert_index_morph] * delta_weight * maskWeight;
         }
 
+        mMesh->addMorphedVertices(vertex_indices, num_indices);
+
         // now apply volume changes
         for(LLPolyVolumeMorph& volume_morph : mVolumeMorphs)
         {
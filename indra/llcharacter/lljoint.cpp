@@ -31,11 +31,12 @@
 
 #include "lljoint.h"
 
+#include "lljointhierarchy.h"
 #include "llmath.h"
 #include <boost/algorithm/string.hpp>
 
-S32 LLJoint::sNumUpdates = 0;
-S32 LLJoint::sNumTouches = 0;
+std::atomic<S32> LLJoint::sNumUpdates(0);
+std::atomic<S32> LLJoint::sNumTouches(0);
 
 template <class T>
 bool attachment_map_iter_compare_key(const T& a, const T& b)
@@ -104,6 +105,7 @@ void LLJoint::init()
 {
     mName = "unnamed";
     mParent = NULL;
+    mHierarchy = NULL;
     mXform.setScaleChildOffset(true);
     mXform.setScale(LLVector3(1.0f, 1.0f, 1.0f));
     mDirtyFlags = MATRIX_DIRTY | ROTATION_DIRTY | POSITION_DIRTY;
@@ -155,6 +157,7 @@ LLJoint::~LLJoint()
         mParent->removeChild( this );
     }
     removeAllChildren();
+    delete mHierarchy;
 }
 
 
@@ -199,7 +202,7 @@ void LLJoint::touch(U32 flags)
 {
     if ((flags | mDirtyFlags) != mDirtyFlags)
     {
-        sNumTouches++;
+        sNumTouches.fetch_add(1, std::memory_order_relaxed);
         mDirtyFlags |= flags;
         U32 child_flags = flags;
         if (flags & ROTATION_DIRTY)
@@ -272,6 +275,7 @@ void LLJoint::addChild(LLJoint* joint)
     joint->mXform.setParent(&mXform);
     joint->mParent = this;
     joint->touch();
+    invalidateHierarchy();
 }
 
 
@@ -288,6 +292,7 @@ void LLJoint::removeChild(LLJoint* joint)
         joint->mXform.setParent(NULL);
         joint->mParent = NULL;
         joint->touch();
+        invalidateHierarchy();
     }
 }
 
@@ -308,6 +313,37 @@ void LLJoint::removeAllChildren()
         }
     }
     mChildren.clear();
+    invalidateHierarchy();
+}
+
+
+//--------------------------------------------------------------------
+// invalidateHierarchy()
+//--------------------------------------------------------------------
+void LLJoint::invalidateHierarchy()
+{
+    LLJoint* root = getRoot();
+    if (root->mHierarchy)
+    {
+        root->mHierarchy->invalidate();
+    }
+}
+
+
+//--------------------------------------------------------------------
+// setFlattenHierarchy()
+//--------------------------------------------------------------------
+void LLJoint::setFlattenHierarchy(bool flatten)
+{
+    if (flatten && !mHierarchy)
+    {
+        mHierarchy = new LLJointHierarchy(this);
+    }
+    else if (!flatten && mHierarchy)
+    {
+        delete mHierarchy;
+        mHierarchy = NULL;
+    }
 }
 
 
@@ -963,6 +999,13 @@ void LLJoint::updateWorldPRSParent()
 //-----------------------------------------------------------------------------
 void LLJoint::updateWorldMatrixChildren()
 {
+    // only a root knows where its hierarchy starts
+    if (mHierarchy && !mParent)
+    {
+        mHierarchy->updateWorldMatrices();
+        return;
+    }
+
     if (!this->mUpdateXform) return;
 
     if (mDirtyFlags & MATRIX_DIRTY)
@@ -982,7 +1025,7 @@ void LLJoint::updateWorldMatrix()
 {
     if (mDirtyFlags & MATRIX_DIRTY)
     {
-        sNumUpdates++;
+        sNumUpdates.fetch_add(1, std::memory_order_relaxed);
         mXform.updateMatrix(false);
         mWorldMatrix.loadu(mXform.getWorldMatrix());
         mDirtyFlags = 0x0;
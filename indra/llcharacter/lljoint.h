@@ -30,6 +30,7 @@
 //-----------------------------------------------------------------------------
 // Header Files
 //-----------------------------------------------------------------------------
+#include <atomic>
 #include <string>
 #include <list>
 
@@ -56,6 +57,8 @@ constexpr F32 LL_MAX_PELVIS_OFFSET = 5.f;
 
 constexpr F32 LL_JOINT_TRESHOLD_POS_OFFSET = 0.0001f; //0.1 mm
 
+class LLJointHierarchy;
+
 class LLVector3OverrideMap
 {
 public:
@@ -90,6 +93,7 @@ LL_ALIGN_PREFIX(16)
 class LLJoint
 {
     LL_ALIGN_NEW
+    friend class LLJointHierarchy;
 public:
     // priority levels, from highest to lowest
     enum JointPriority
@@ -131,6 +135,9 @@ protected:
     LLVector3       mDefaultPosition;
     LLVector3       mDefaultScale;
 
+    // joints under this root in arrays, if flattened
+    LLJointHierarchy* mHierarchy;
+
 public:
     U32             mDirtyFlags;
     bool            mUpdateXform;
@@ -148,9 +155,9 @@ public:
     typedef std::vector<LLJoint*> joints_t;
     joints_t mChildren;
 
-    // debug statics
-    static S32      sNumTouches;
-    static S32      sNumUpdates;
+    // debug statics, counted from every thread updating skeletons
+    static std::atomic<S32> sNumTouches;
+    static std::atomic<S32> sNumUpdates;
     typedef std::set<std::string> debug_joint_name_t;
     static debug_joint_name_t s_debugJointNames;
     static void setDebugJointNames(const debug_joint_name_t& names);
@@ -191,6 +198,7 @@ public:
 
 private:
     void init();
+    void invalidateHierarchy();
 
 public:
     // set name and parent
@@ -268,6 +276,11 @@ public:
     void updateWorldMatrixChildren();
     void updateWorldMatrixParent();
 
+    // A flattened root keeps its joints in an LLJointHierarchy and
+    // updateWorldMatrixChildren() updates them in one pass down its arrays.
+    void setFlattenHierarchy(bool flatten);
+    bool getFlattenHierarchy() const { return mHierarchy != NULL; }
+
     void updateWorldPRSParent();
 
     void updateWorldMatrix();
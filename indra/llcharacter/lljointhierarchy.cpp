@@ -0,0 +1,116 @@
+/**
+ * @file lljointhierarchy.cpp
+ * @brief A skeleton of joints flattened into arrays in parent first order.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lljointhierarchy.h"
+
+#include "lljoint.h"
+
+LLJointHierarchy::LLJointHierarchy(LLJoint* root) :
+    mRoot(root),
+    mStale(true)
+{
+}
+
+void LLJointHierarchy::build()
+{
+    mJoints.clear();
+    mParents.clear();
+    mSubtreeEnds.clear();
+    add(mRoot, -1);
+
+    size_t count = mJoints.size();
+    mChildOffsetScales.resize(count);
+    mWorldPositions.resize(count);
+    mWorldRotations.resize(count);
+    mStale = false;
+}
+
+void LLJointHierarchy::add(LLJoint* joint, S32 parent)
+{
+    S32 index = (S32)mJoints.size();
+    mJoints.push_back(joint);
+    mParents.push_back(parent);
+    mSubtreeEnds.push_back(0);
+    for (LLJoint* child : joint->mChildren)
+    {
+        add(child, index);
+    }
+    mSubtreeEnds[index] = (S32)mJoints.size();
+}
+
+void LLJointHierarchy::updateWorldMatrices()
+{
+    if (mStale)
+    {
+        build();
+    }
+
+    const S32 count = (S32)mJoints.size();
+    S32 i = 0;
+    while (i < count)
+    {
+        LLJoint* joint = mJoints[i];
+        if (!joint->mUpdateXform)
+        {
+            i = mSubtreeEnds[i];
+            continue;
+        }
+
+        LLXformMatrix& xform = joint->mXform;
+        S32 parent = mParents[i];
+        if (parent < 0)
+        {
+            // the xform of the root can have a parent outside the joints,
+            // the seat of a sitting avatar, which only the xform knows of
+            joint->updateWorldMatrix();
+        }
+        else if (joint->mDirtyFlags & LLJoint::MATRIX_DIRTY)
+        {
+            // LLXformMatrix::update(), from the parent's entries
+            LLVector3 world_pos = xform.getPosition();
+            world_pos.scaleVec(mChildOffsetScales[parent]);
+            world_pos *= mWorldRotations[parent];
+            world_pos += mWorldPositions[parent];
+            LLQuaternion world_rot = xform.getRotation() * mWorldRotations[parent];
+
+            LLJoint::sNumUpdates.fetch_add(1, std::memory_order_relaxed);
+            xform.setWorldTransform(world_pos, world_rot);
+            joint->mWorldMatrix.loadu(xform.getWorldMatrix());
+            joint->mDirtyFlags = 0x0;
+        }
+
+        if (mSubtreeEnds[i] > i + 1)
+        {
+            // a clean joint may have been updated on its own since the last pass
+            mWorldPositions[i] = xform.getWorldPosition();
+            mWorldRotations[i] = xform.getWorldRotation();
+            mChildOffsetScales[i] = xform.getScaleChildOffset() ? xform.getScale() : LLVector3(1.f, 1.f, 1.f);
+        }
+        ++i;
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * @file lljointhierarchy.h
+ * @brief A skeleton of joints flattened into arrays in parent first order.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLJOINTHIERARCHY_H
+#define LL_LLJOINTHIERARCHY_H
+
+#include "v3math.h"
+#include "llquaternion.h"
+
+#include <vector>
+
+class LLJoint;
+
+// The joints under a root joint, listed so that every joint comes after
+// its parent, with the index of each parent. Updating the world matrices
+// is then one pass down the arrays instead of a recursion through the
+// child lists: a joint finds the world transform of its parent at its
+// parent's index, where the pass has just left it, without going back to
+// the parent joint.
+//
+// The joints stay the owners of their transforms; the pass reads the local
+// transform of the dirty ones and writes back what it computes, so LLJoint
+// getters and the per joint updates work as before. The arrays only hold
+// the parent's part of the computation while a pass runs. The root is
+// updated through its own xform, whose parent is the seat of a sitting
+// avatar.
+//
+// Any change to the joints under the root makes LLJoint::addChild() and
+// removeChild() invalidate the hierarchy, and the next update lists the
+// joints again. See LLJoint::setFlattenHierarchy().
+class LLJointHierarchy
+{
+public:
+    LLJointHierarchy(LLJoint* root);
+
+    void invalidate() { mStale = true; }
+
+    // What root->updateWorldMatrixChildren() does for an unflattened root,
+    // with the same results to the bit.
+    void updateWorldMatrices();
+
+    S32 getNumJoints() const { return (S32)mJoints.size(); }
+
+private:
+    void build();
+    void add(LLJoint* joint, S32 parent);
+
+    LLJoint* mRoot;
+    bool mStale;
+
+    std::vector<LLJoint*> mJoints;
+    std::vector<S32> mParents;
+    // one past the last joint under each joint, to skip joints that are
+    // not updated with their children
+    std::vector<S32> mSubtreeEnds;
+
+    // filled in as the pass goes, for the children of each joint
+    std::vector<LLVector3> mChildOffsetScales;
+    std::vector<LLVector3> mWorldPositions;
+    std::vector<LLQuaternion> mWorldRotations;
+};
+
+#endif // LL_LLJOINTHIERARCHY_H
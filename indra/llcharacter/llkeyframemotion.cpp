@@ -127,6 +127,77 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 
+namespace
+{
+    // Index of the first of times not before time, as std::lower_bound()
+    // finds it, trying the key cursor was left at and the one after it
+    // before searching.
+    S32 find_key(const std::vector<F32>& times, F32 time, S32& cursor)
+    {
+        const S32 count = static_cast<S32>(times.size());
+        S32 right = llclamp(cursor, 0, count);
+        for (S32 tries = 0; tries < 2; ++tries, ++right)
+        {
+            if (right > count || (right > 0 && times[right - 1] >= time))
+            {
+                break;
+            }
+            if (right == count || times[right] >= time)
+            {
+                cursor = right;
+                return right;
+            }
+        }
+
+        right = static_cast<S32>(std::lower_bound(times.begin(), times.end(), time) - times.begin());
+        cursor = right;
+        return right;
+    }
+
+    // Keys mostly come in time order, so this is usually a push_back().
+    template <typename T>
+    void add_key(std::vector<F32>& times, std::vector<T>& values, F32 time, const T& value)
+    {
+        std::vector<F32>::iterator it = times.end();
+        if (!times.empty() && times.back() >= time)
+        {
+            it = std::lower_bound(times.begin(), times.end(), time);
+        }
+
+        size_t index = it - times.begin();
+        if (it != times.end() && *it == time)
+        {
+            values[index] = value;
+        }
+        else
+        {
+            times.insert(it, time);
+            values.insert(values.begin() + index, value);
+        }
+    }
+
+    // Before the first key, on a key or past the last one the value is that
+    // of the nearest key, between two it is interpolated.
+    template <typename T, typename CURVE>
+    T sample(const CURVE& curve, const std::vector<T>& values, F32 time, S32& cursor)
+    {
+        const std::vector<F32>& times = curve.mKeyTimes;
+        S32 right = find_key(times, time, cursor);
+        if (right == static_cast<S32>(times.size()))
+        {
+            return values[right - 1];
+        }
+        if (right == 0 || times[right] == time)
+        {
+            return values[right];
+        }
+
+        F32 index_before = times[right - 1];
+        F32 index_after = times[right];
+        F32 u = (time - index_before) / (index_after - index_before);
+        return curve.interp(u, values[right - 1], values[right]);
+    }
+}
 
 //-----------------------------------------------------------------------------
 // ScaleCurve::ScaleCurve()
@@ -142,72 +213,49 @@ LLKeyframeMotion::ScaleCurve::ScaleCurve()
 //-----------------------------------------------------------------------------
 LLKeyframeMotion::ScaleCurve::~ScaleCurve()
 {
-    mKeys.clear();
     mNumKeys = 0;
 }
 
 //-----------------------------------------------------------------------------
 // getValue()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
+LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration, S32& cursor) const
 {
-    LLVector3 value;
-
-    if (mKeys.empty())
+    if (mKeyTimes.empty())
     {
+        LLVector3 value;
         value.clearVec();
         return value;
     }
 
-    key_map_t::iterator right = mKeys.lower_bound(time);
-    if (right == mKeys.end())
-    {
-        // Past last key
-        --right;
-        value = right->second.mScale;
-    }
-    else if (right == mKeys.begin() || right->first == time)
-    {
-        // Before first key or exactly on a key
-        value = right->second.mScale;
-    }
-    else
-    {
-        // Between two keys
-        key_map_t::iterator left = right; --left;
-        F32 index_before = left->first;
-        F32 index_after = right->first;
-        ScaleKey& scale_before = left->second;
-        ScaleKey& scale_after = right->second;
-        if (right == mKeys.end())
-        {
-            scale_after = mLoopInKey;
-            index_after = duration;
-        }
-
-        F32 u = (time - index_before) / (index_after - index_before);
-        value = interp(u, scale_before, scale_after);
-    }
-    return value;
+    return sample(*this, mKeyScales, time, cursor);
 }
 
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, ScaleKey& before, ScaleKey& after)
+LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, const LLVector3& before, const LLVector3& after) const
 {
     switch (mInterpolationType)
     {
     case IT_STEP:
-        return before.mScale;
+        return before;
 
     default:
     case IT_LINEAR:
     case IT_SPLINE:
-        return lerp(before.mScale, after.mScale, u);
+        return lerp(before, after, u);
     }
 }
 
+//-----------------------------------------------------------------------------
+// addKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::ScaleCurve::addKey(const ScaleKey& key)
+{
+    add_key(mKeyTimes, mKeyScales, key.mTime, key.mScale);
+}
+
 //-----------------------------------------------------------------------------
 // RotationCurve::RotationCurve()
 //-----------------------------------------------------------------------------
@@ -222,72 +270,47 @@ LLKeyframeMotion::RotationCurve::RotationCurve()
 //-----------------------------------------------------------------------------
 LLKeyframeMotion::RotationCurve::~RotationCurve()
 {
-    mKeys.clear();
     mNumKeys = 0;
 }
 
 //-----------------------------------------------------------------------------
 // RotationCurve::getValue()
 //-----------------------------------------------------------------------------
-LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
+LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration, S32& cursor) const
 {
-    LLQuaternion value;
-
-    if (mKeys.empty())
-    {
-        value = LLQuaternion::DEFAULT;
-        return value;
-    }
-
-    key_map_t::iterator right = mKeys.lower_bound(time);
-    if (right == mKeys.end())
-    {
-        // Past last key
-        --right;
-        value = right->second.mRotation;
-    }
-    else if (right == mKeys.begin() || right->first == time)
+    if (mKeyTimes.empty())
     {
-        // Before first key or exactly on a key
-        value = right->second.mRotation;
+        return LLQuaternion::DEFAULT;
     }
-    else
-    {
-        // Between two keys
-        key_map_t::iterator left = right; --left;
-        F32 index_before = left->first;
-        F32 index_after = right->first;
-        RotationKey& rot_before = left->second;
-        RotationKey& rot_after = right->second;
-        if (right == mKeys.end())
-        {
-            rot_after = mLoopInKey;
-            index_after = duration;
-        }
 
-        F32 u = (time - index_before) / (index_after - index_before);
-        value = interp(u, rot_before, rot_after);
-    }
-    return value;
+    return sample(*this, mKeyRotations, time, cursor);
 }
 
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, RotationKey& before, RotationKey& after)
+LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, const LLQuaternion& before, const LLQuaternion& after) const
 {
     switch (mInterpolationType)
     {
     case IT_STEP:
-        return before.mRotation;
+        return before;
 
     default:
     case IT_LINEAR:
     case IT_SPLINE:
-        return nlerp(u, before.mRotation, after.mRotation);
+        return nlerp(u, before, after);
     }
 }
 
+//-----------------------------------------------------------------------------
+// addKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::RotationCurve::addKey(const RotationKey& key)
+{
+    add_key(mKeyTimes, mKeyRotations, key.mTime, key.mRotation);
+}
+
 
 //-----------------------------------------------------------------------------
 // PositionCurve::PositionCurve()
@@ -303,52 +326,22 @@ LLKeyframeMotion::PositionCurve::PositionCurve()
 //-----------------------------------------------------------------------------
 LLKeyframeMotion::PositionCurve::~PositionCurve()
 {
-    mKeys.clear();
     mNumKeys = 0;
 }
 
 //-----------------------------------------------------------------------------
 // PositionCurve::getValue()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
+LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration, S32& cursor) const
 {
-    LLVector3 value;
-
-    if (mKeys.empty())
+    if (mKeyTimes.empty())
     {
+        LLVector3 value;
         value.clearVec();
         return value;
     }
 
-    key_map_t::iterator right = mKeys.lower_bound(time);
-    if (right == mKeys.end())
-    {
-        // Past last key
-        --right;
-        value = right->second.mPosition;
-    }
-    else if (right == mKeys.begin() || right->first == time)
-    {
-        // Before first key or exactly on a key
-        value = right->second.mPosition;
-    }
-    else
-    {
-        // Between two keys
-        key_map_t::iterator left = right; --left;
-        F32 index_before = left->first;
-        F32 index_after = right->first;
-        PositionKey& pos_before = left->second;
-        PositionKey& pos_after = right->second;
-        if (right == mKeys.end())
-        {
-            pos_after = mLoopInKey;
-            index_after = duration;
-        }
-
-        F32 u = (time - index_before) / (index_after - index_before);
-        value = interp(u, pos_before, pos_after);
-    }
+    LLVector3 value = sample(*this, mKeyPositions, time, cursor);
 
     llassert(value.isFinite());
 
@@ -358,19 +351,27 @@ LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, PositionKey& after)
+LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, const LLVector3& before, const LLVector3& after) const
 {
     switch (mInterpolationType)
     {
     case IT_STEP:
-        return before.mPosition;
+        return before;
     default:
     case IT_LINEAR:
     case IT_SPLINE:
-        return lerp(before.mPosition, after.mPosition, u);
+        return lerp(before, after, u);
     }
 }
 
+//-----------------------------------------------------------------------------
+// addKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::PositionCurve::addKey(const PositionKey& key)
+{
+    add_key(mKeyTimes, mKeyPositions, key.mTime, key.mPosition);
+}
+
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -381,7 +382,7 @@ LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, Po
 //-----------------------------------------------------------------------------
 // JointMotion::update()
 //-----------------------------------------------------------------------------
-void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration)
+void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration, CurveCursors& cursors) const
 {
     // this value being 0 is the cause of https://jira.lindenlab.com/browse/SL-22678 but I haven't
     // managed to get a stack to see how it got here. Testing for 0 here will stop the crash.
@@ -397,7 +398,7 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
     //-------------------------------------------------------------------------
     if ((usage & LLJointState::SCALE) && mScaleCurve.mNumKeys)
     {
-        joint_state->setScale( mScaleCurve.getValue( time, duration ) );
+        joint_state->setScale( mScaleCurve.getValue( time, duration, cursors.mScale ) );
     }
 
     //-------------------------------------------------------------------------
@@ -405,7 +406,7 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
     //-------------------------------------------------------------------------
     if ((usage & LLJointState::ROT) && mRotationCurve.mNumKeys)
     {
-        joint_state->setRotation( mRotationCurve.getValue( time, duration ) );
+        joint_state->setRotation( mRotationCurve.getValue( time, duration, cursors.mRotation ) );
     }
 
     //-------------------------------------------------------------------------
@@ -413,7 +414,7 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
     //-------------------------------------------------------------------------
     if ((usage & LLJointState::POS) && mPositionCurve.mNumKeys)
     {
-        joint_state->setPosition( mPositionCurve.getValue( time, duration ) );
+        joint_state->setPosition( mPositionCurve.getValue( time, duration, cursors.mPosition ) );
     }
 }
 
@@ -736,11 +737,13 @@ bool LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
 void LLKeyframeMotion::applyKeyframes(F32 time)
 {
     llassert_always (mJointMotionList->getNumJointMotions() <= mJointStates.size());
+    mCurveCursors.resize(mJointMotionList->getNumJointMotions());
     for (U32 i=0; i<mJointMotionList->getNumJointMotions(); i++)
     {
         mJointMotionList->getJointMotion(i)->update(mJointStates[i],
                                                       time,
-                                                      mJointMotionList->mDuration );
+                                                      mJointMotionList->mDuration,
+                                                      mCurveCursors[i] );
     }
 
     LLJoint::JointPriority* pose_priority = (LLJoint::JointPriority* )mCharacter->getAnimationData("Hand Pose Priority");
@@ -1661,14 +1664,14 @@ bool LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
                 return false;
             }
 
-            rCurve->mKeys[time] = rot_key;
+            rCurve->addKey(rot_key);
         }
 
-        if (joint_motion->mRotationCurve.mNumKeys > joint_motion->mRotationCurve.mKeys.size())
+        if (joint_motion->mRotationCurve.mNumKeys > joint_motion->mRotationCurve.getKeyCount())
         {
             rotation_duplicates++;
             LL_INFOS() << "Motion " << asset() << " had duplicated rotation keys that were removed: "
-                << joint_motion->mRotationCurve.mNumKeys << " > " << joint_motion->mRotationCurve.mKeys.size()
+                << joint_motion->mRotationCurve.mNumKeys << " > " << joint_motion->mRotationCurve.getKeyCount()
                 << " (" << rotation_duplicates << ")" << LL_ENDL;
         }
 
@@ -1770,7 +1773,7 @@ bool LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
                 return false;
             }
 
-            pCurve->mKeys[pos_key.mTime] = pos_key;
+            pCurve->addKey(pos_key);
 
             if (is_pelvis)
             {
@@ -1778,11 +1781,11 @@ bool LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
             }
         }
 
-        if (joint_motion->mPositionCurve.mNumKeys > joint_motion->mPositionCurve.mKeys.size())
+        if (joint_motion->mPositionCurve.mNumKeys > joint_motion->mPositionCurve.getKeyCount())
         {
             position_duplicates++;
             LL_INFOS() << "Motion " << asset() << " had duplicated position keys that were removed: "
-                << joint_motion->mPositionCurve.mNumKeys << " > " << joint_motion->mPositionCurve.mKeys.size()
+                << joint_motion->mPositionCurve.mNumKeys << " > " << joint_motion->mPositionCurve.getKeyCount()
                 << " (" << position_duplicates << ")" << LL_ENDL;
         }
 
@@ -2080,19 +2083,20 @@ bool LLKeyframeMotion::serialize(LLDataPacker& dp) const
         JointMotion* joint_motionp = mJointMotionList->getJointMotion(i);
         success &= dp.packString(joint_motionp->mJointName, "joint_name");
         success &= dp.packS32(joint_motionp->mPriority, "joint_priority");
-        success &= dp.packS32(static_cast<S32>(joint_motionp->mRotationCurve.mKeys.size()), "num_rot_keys");
+        success &= dp.packS32(static_cast<S32>(joint_motionp->mRotationCurve.getKeyCount()), "num_rot_keys");
 
         LL_DEBUGS("BVH") << "Joint " << i
             << " name: " << joint_motionp->mJointName
-            << " Rotation keys: " << joint_motionp->mRotationCurve.mKeys.size()
-            << " Position keys: " << joint_motionp->mPositionCurve.mKeys.size() << LL_ENDL;
-        for (RotationCurve::key_map_t::value_type& rot_pair : joint_motionp->mRotationCurve.mKeys)
+            << " Rotation keys: " << joint_motionp->mRotationCurve.getKeyCount()
+            << " Position keys: " << joint_motionp->mPositionCurve.getKeyCount() << LL_ENDL;
+        RotationCurve& rot_curve = joint_motionp->mRotationCurve;
+        for (U32 k = 0; k < rot_curve.getKeyCount(); ++k)
         {
-            RotationKey& rot_key = rot_pair.second;
-            U16 time_short = F32_to_U16(rot_key.mTime, 0.f, mJointMotionList->mDuration);
+            F32 time = rot_curve.mKeyTimes[k];
+            U16 time_short = F32_to_U16(time, 0.f, mJointMotionList->mDuration);
             success &= dp.packU16(time_short, "time");
 
-            LLVector3 rot_angles = rot_key.mRotation.packToVector3();
+            LLVector3 rot_angles = rot_curve.mKeyRotations[k].packToVector3();
 
             U16 x, y, z;
             rot_angles.quantize16(-1.f, 1.f, -1.f, 1.f);
@@ -2103,26 +2107,28 @@ bool LLKeyframeMotion::serialize(LLDataPacker& dp) const
             success &= dp.packU16(y, "rot_angle_y");
             success &= dp.packU16(z, "rot_angle_z");
 
-            LL_DEBUGS("BVH") << "  rot: t " << rot_key.mTime << " angles " << rot_angles.mV[VX] <<","<< rot_angles.mV[VY] <<","<< rot_angles.mV[VZ] << LL_ENDL;
+            LL_DEBUGS("BVH") << "  rot: t " << time << " angles " << rot_angles.mV[VX] <<","<< rot_angles.mV[VY] <<","<< rot_angles.mV[VZ] << LL_ENDL;
         }
 
-        success &= dp.packS32(static_cast<S32>(joint_motionp->mPositionCurve.mKeys.size()), "num_pos_keys");
-        for (PositionCurve::key_map_t::value_type& pos_pair : joint_motionp->mPositionCurve.mKeys)
+        success &= dp.packS32(static_cast<S32>(joint_motionp->mPositionCurve.getKeyCount()), "num_pos_keys");
+        PositionCurve& pos_curve = joint_motionp->mPositionCurve;
+        for (U32 k = 0; k < pos_curve.getKeyCount(); ++k)
         {
-            PositionKey& pos_key = pos_pair.second;
-            U16 time_short = F32_to_U16(pos_key.mTime, 0.f, mJointMotionList->mDuration);
+            F32 time = pos_curve.mKeyTimes[k];
+            LLVector3& position = pos_curve.mKeyPositions[k];
+            U16 time_short = F32_to_U16(time, 0.f, mJointMotionList->mDuration);
             success &= dp.packU16(time_short, "time");
 
             U16 x, y, z;
-            pos_key.mPosition.quantize16(-LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET, -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-            x = F32_to_U16(pos_key.mPosition.mV[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-            y = F32_to_U16(pos_key.mPosition.mV[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-            z = F32_to_U16(pos_key.mPosition.mV[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+            position.quantize16(-LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET, -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+            x = F32_to_U16(position.mV[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+            y = F32_to_U16(position.mV[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+            z = F32_to_U16(position.mV[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
             success &= dp.packU16(x, "pos_x");
             success &= dp.packU16(y, "pos_y");
             success &= dp.packU16(z, "pos_z");
 
-            LL_DEBUGS("BVH") << "  pos: t " << pos_key.mTime << " pos " << pos_key.mPosition.mV[VX] <<","<< pos_key.mPosition.mV[VY] <<","<< pos_key.mPosition.mV[VZ] << LL_ENDL;
+            LL_DEBUGS("BVH") << "  pos: t " << time << " pos " << position.mV[VX] <<","<< position.mV[VY] <<","<< position.mV[VZ] << LL_ENDL;
         }
     }
 
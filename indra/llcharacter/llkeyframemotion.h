@@ -325,13 +325,20 @@ public:
     public:
         ScaleCurve();
         ~ScaleCurve();
-        LLVector3 getValue(F32 time, F32 duration);
-        LLVector3 interp(F32 u, ScaleKey& before, ScaleKey& after);
+        // cursor is the key the last call for the same playing motion
+        // stopped at, see CurveCursors
+        LLVector3 getValue(F32 time, F32 duration, S32& cursor) const;
+        LLVector3 getValue(F32 time, F32 duration) const { S32 cursor = 0; return getValue(time, duration, cursor); }
+        LLVector3 interp(F32 u, const LLVector3& before, const LLVector3& after) const;
+        // replaces any key at the same time
+        void addKey(const ScaleKey& key);
+        U32 getKeyCount() const { return static_cast<U32>(mKeyTimes.size()); }
 
         InterpolationType   mInterpolationType;
         S32                 mNumKeys;
-        typedef std::map<F32, ScaleKey> key_map_t;
-        key_map_t           mKeys;
+        // keys sorted by time, times apart from values
+        std::vector<F32>        mKeyTimes;
+        std::vector<LLVector3>  mKeyScales;
         ScaleKey            mLoopInKey;
         ScaleKey            mLoopOutKey;
     };
@@ -344,13 +351,16 @@ public:
     public:
         RotationCurve();
         ~RotationCurve();
-        LLQuaternion getValue(F32 time, F32 duration);
-        LLQuaternion interp(F32 u, RotationKey& before, RotationKey& after);
+        LLQuaternion getValue(F32 time, F32 duration, S32& cursor) const;
+        LLQuaternion getValue(F32 time, F32 duration) const { S32 cursor = 0; return getValue(time, duration, cursor); }
+        LLQuaternion interp(F32 u, const LLQuaternion& before, const LLQuaternion& after) const;
+        void addKey(const RotationKey& key);
+        U32 getKeyCount() const { return static_cast<U32>(mKeyTimes.size()); }
 
         InterpolationType   mInterpolationType;
         S32                 mNumKeys;
-        typedef std::map<F32, RotationKey> key_map_t;
-        key_map_t       mKeys;
+        std::vector<F32>            mKeyTimes;
+        std::vector<LLQuaternion>   mKeyRotations;
         RotationKey     mLoopInKey;
         RotationKey     mLoopOutKey;
     };
@@ -363,17 +373,37 @@ public:
     public:
         PositionCurve();
         ~PositionCurve();
-        LLVector3 getValue(F32 time, F32 duration);
-        LLVector3 interp(F32 u, PositionKey& before, PositionKey& after);
+        LLVector3 getValue(F32 time, F32 duration, S32& cursor) const;
+        LLVector3 getValue(F32 time, F32 duration) const { S32 cursor = 0; return getValue(time, duration, cursor); }
+        LLVector3 interp(F32 u, const LLVector3& before, const LLVector3& after) const;
+        void addKey(const PositionKey& key);
+        U32 getKeyCount() const { return static_cast<U32>(mKeyTimes.size()); }
 
         InterpolationType   mInterpolationType;
         S32                 mNumKeys;
-        typedef std::map<F32, PositionKey> key_map_t;
-        key_map_t       mKeys;
+        std::vector<F32>        mKeyTimes;
+        std::vector<LLVector3>  mKeyPositions;
         PositionKey     mLoopInKey;
         PositionKey     mLoopOutKey;
     };
 
+    //-------------------------------------------------------------------------
+    // CurveCursors
+    //-------------------------------------------------------------------------
+    // Curves are shared by every motion playing the same animation, so where
+    // each motion is in them is kept by the motion. Playback mostly moves
+    // forward a little each frame, so the next key is usually the one the
+    // last lookup stopped at or the one after it.
+    class CurveCursors
+    {
+    public:
+        CurveCursors() : mPosition(0), mRotation(0), mScale(0) {}
+
+        S32             mPosition;
+        S32             mRotation;
+        S32             mScale;
+    };
+
     //-------------------------------------------------------------------------
     // JointMotion
     //-------------------------------------------------------------------------
@@ -387,7 +417,7 @@ public:
         U32             mUsage;
         LLJoint::JointPriority  mPriority;
 
-        void update(LLJointState* joint_state, F32 time, F32 duration);
+        void update(LLJointState* joint_state, F32 time, F32 duration, CurveCursors& cursors) const;
     };
 
     //-------------------------------------------------------------------------
@@ -426,6 +456,7 @@ public:
 protected:
     JointMotionList*                mJointMotionList;
     std::vector<LLPointer<LLJointState> > mJointStates;
+    std::vector<CurveCursors>       mCurveCursors;
     LLJoint*                        mPelvisp;
     LLCharacter*                    mCharacter;
     typedef std::list<JointConstraint*> constraint_list_t;
@@ -139,6 +139,8 @@ LLMotionController::LLMotionController()
       mTimeStep(0.f),
       mTimeStepCount(0),
       mLastInterp(0.f),
+      mDeferPose(false),
+      mPoseDeferred(false),
       mIsSelf(false),
       mLastCountAfterPurge(0)
 {
@@ -817,6 +819,9 @@ void LLMotionController::updateMotions(bool force_update)
     // Currently setting mTimeStep to nonzero is disabled elsewhere.
     bool use_quantum = (mTimeStep != 0.f);
 
+    // a pose left from a deferred update nobody applied goes in first
+    applyDeferredPose();
+
     // Always update mPrevTimerElapsed
     F32 cur_time = mTimer.getElapsedTimeF32();
     F32 delta_time = cur_time - mPrevTimerElapsed;
@@ -887,6 +892,10 @@ void LLMotionController::updateMotions(bool force_update)
         {
             mPoseBlender.blendAndCache(true);
         }
+        else if (mDeferPose)
+        {
+            mPoseDeferred = true;
+        }
         else
         {
             mPoseBlender.blendAndApply();
@@ -897,6 +906,21 @@ void LLMotionController::updateMotions(bool force_update)
 //  LL_INFOS() << "Motion controller time " << motionTimer.getElapsedTimeF32() << LL_ENDL;
 }
 
+//-----------------------------------------------------------------------------
+// applyDeferredPose()
+// blends the motions of the last updateMotions() into the skeleton, if it
+// was deferred
+//-----------------------------------------------------------------------------
+void LLMotionController::applyDeferredPose()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    if (mPoseDeferred)
+    {
+        mPoseBlender.blendAndApply();
+        mPoseDeferred = false;
+    }
+}
+
 //-----------------------------------------------------------------------------
 // updateMotionsMinimal()
 // minimal update (e.g. while hidden)
@@ -135,6 +135,13 @@ public:
     // minimal update (e.g. while hidden)
     void updateMotionsMinimal();
 
+    // while set, updateMotions() leaves blending the motions into the
+    // skeleton to applyDeferredPose(), which only touches this character's
+    // joints and so can run on another thread
+    void setDeferPose(bool defer) { mDeferPose = defer; }
+    bool hasDeferredPose() const { return mPoseDeferred; }
+    void applyDeferredPose();
+
     void clearBlenders() { mPoseBlender.clearBlenders(); }
 
     // flush motions
@@ -226,6 +233,8 @@ protected:
     F32                 mTimeStep;
     S32                 mTimeStepCount;
     F32                 mLastInterp;
+    bool                mDeferPose;
+    bool                mPoseDeferred;
 
     U8                  mJointSignature[2][LL_CHARACTER_MAX_ANIMATED_JOINTS];
 private:
@@ -0,0 +1,167 @@
+/**
+ * @file llkeyframemotion_test.cpp
+ * @date 2026-10
+ * @brief Test cases for adding and finding keyframe curve keys.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include "../llkeyframemotion.h"
+#include "llrand.h"
+#include "stringize.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace
+{
+    // Keys at 0, 0.5, 1, ... with the key's index as its value. A step curve
+    // returns the value of the key before the time, so the value says which
+    // key the search found.
+    void make_curve(LLKeyframeMotion::ScaleCurve& curve, S32 count)
+    {
+        curve.mInterpolationType = LLKeyframeMotion::IT_STEP;
+        for (S32 i = 0; i < count; ++i)
+        {
+            curve.addKey(LLKeyframeMotion::ScaleKey(0.5f * i, LLVector3((F32)i, 0.f, 0.f)));
+        }
+        curve.mNumKeys = count;
+    }
+
+    // What getValue() should find, through std::lower_bound()
+    S32 lower_bound_key(const LLKeyframeMotion::ScaleCurve& curve, F32 time, S32& right)
+    {
+        const std::vector<F32>& times = curve.mKeyTimes;
+        right = (S32)(std::lower_bound(times.begin(), times.end(), time) - times.begin());
+        if (right == (S32)times.size())
+        {
+            return right - 1;
+        }
+        if (right == 0 || times[right] == time)
+        {
+            return right;
+        }
+        return right - 1;
+    }
+
+    // Looks every time up with one cursor, as a playing motion does
+    void check_times(const char* what, const LLKeyframeMotion::ScaleCurve& curve, const std::vector<F32>& times, S32 cursor = 0)
+    {
+        for (size_t i = 0; i < times.size(); ++i)
+        {
+            S32 right = 0;
+            S32 expected = lower_bound_key(curve, times[i], right);
+            LLVector3 value = curve.getValue(times[i], 0.f, cursor);
+            tut::ensure_equals(STRINGIZE(what << " key at " << times[i]), (S32)value.mV[VX], expected);
+            tut::ensure_equals(STRINGIZE(what << " cursor at " << times[i]), cursor, right);
+        }
+    }
+}
+
+namespace tut
+{
+    struct keyframemotion_data
+    {
+    };
+    typedef test_group<keyframemotion_data> keyframemotion_test;
+    typedef keyframemotion_test::object keyframemotion_object;
+    tut::keyframemotion_test tkeyframemotion("LLKeyframeMotion");
+
+    template<> template<>
+    void keyframemotion_object::test<1>()
+    {
+        set_test_name("Curve lookups find the key std::lower_bound finds");
+
+        LLKeyframeMotion::ScaleCurve curve;
+        make_curve(curve, 40);
+
+        // playing forward a frame at a time, on keys, before the first and
+        // past the last
+        std::vector<F32> forward;
+        for (F32 time = -1.f; time < 21.f; time += 0.125f)
+        {
+            forward.push_back(time);
+        }
+        check_times("forward", curve, forward);
+
+        // played backward, and big jumps either way
+        std::vector<F32> backward(forward.rbegin(), forward.rend());
+        check_times("backward", curve, backward);
+        check_times("jumps", curve, { 0.f, 19.5f, 0.25f, 30.f, 10.f, 10.f, 9.75f, -5.f, 19.5f });
+
+        // anywhere at all
+        std::vector<F32> random;
+        for (S32 i = 0; i < 1000; ++i)
+        {
+            random.push_back(ll_frand(22.f) - 1.f);
+        }
+        check_times("random", curve, random);
+
+        // a cursor left past the end, or before the start, of another curve
+        check_times("cursor past the end", curve, { 5.f, 5.25f }, 100);
+        check_times("cursor before the start", curve, { 5.f, 5.25f }, -3);
+
+        // a curve with one key, and interpolation between two
+        LLKeyframeMotion::ScaleCurve single;
+        make_curve(single, 1);
+        check_times("single", single, { -1.f, 0.f, 1.f, 0.f });
+
+        LLKeyframeMotion::ScaleCurve linear;
+        linear.addKey(LLKeyframeMotion::ScaleKey(1.f, LLVector3(2.f, 0.f, 0.f)));
+        linear.addKey(LLKeyframeMotion::ScaleKey(2.f, LLVector3(4.f, 0.f, 0.f)));
+        S32 cursor = 0;
+        ensure_equals("interpolated", linear.getValue(1.5f, 0.f, cursor).mV[VX], 3.f);
+    }
+
+    template<> template<>
+    void keyframemotion_object::test<2>()
+    {
+        set_test_name("Adding keys keeps them sorted and replaces keys at the same time");
+
+        // what the curves did when their keys were in a map
+        std::map<F32, LLVector3> keys;
+        LLKeyframeMotion::ScaleCurve curve;
+        for (S32 i = 0; i < 500; ++i)
+        {
+            // mostly in order, as assets list them, some out of order and
+            // some at a time already used
+            F32 time = (i % 7 == 0) ? 0.25f * ll_rand(i / 2 + 1) : 0.25f * (i / 2);
+            LLVector3 value((F32)i, (F32)-i, 0.f);
+            keys[time] = value;
+            curve.addKey(LLKeyframeMotion::ScaleKey(time, value));
+
+            ensure_equals(STRINGIZE("key count after " << i), curve.getKeyCount(), (U32)keys.size());
+        }
+
+        ensure_equals("values", curve.mKeyScales.size(), keys.size());
+        size_t index = 0;
+        for (const auto& key : keys)
+        {
+            ensure_equals(STRINGIZE("time " << index), curve.mKeyTimes[index], key.first);
+            ensure(STRINGIZE("value " << index), curve.mKeyScales[index] == key.second);
+            ++index;
+        }
+    }
+}
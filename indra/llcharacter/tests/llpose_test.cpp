@@ -0,0 +1,307 @@
+/**
+ * @file llpose_test.cpp
+ * @date 2026-10
+ * @brief Test cases for blending poses into skeletons and updating them.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include "../lljoint.h"
+#include "../lljointhierarchy.h"
+#include "../lljointstate.h"
+#include "../llpose.h"
+#include "lltimer.h"
+#include "stringize.h"
+#include "threadpool.h"
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // About the shape of an avatar skeleton: a spine with a head and two
+    // arms ending in five fingers, two legs, and a collision volume hanging
+    // off every bone. Each bone has a base and an overlay animation playing
+    // on it, as a standing pose and a gesture would.
+    class Skeleton
+    {
+    public:
+        Skeleton()
+        {
+            mRoot = addJoint(NULL, false);
+            LLJoint* pelvis = addJoint(mRoot);
+            LLJoint* chest = addChain(pelvis, 4);
+            addChain(chest, 3);
+            for (S32 side = 0; side < 2; ++side)
+            {
+                LLJoint* wrist = addChain(chest, 4);
+                for (S32 finger = 0; finger < 5; ++finger)
+                {
+                    addChain(wrist, 3);
+                }
+                addChain(pelvis, 4);
+            }
+        }
+
+        // what the motions do in LLMotionController::updateMotions()
+        void animate(S32 frame)
+        {
+            for (size_t i = 0; i < mBones.size(); ++i)
+            {
+                F32 phase = 0.05f * frame + 0.3f * i + 0.01f * mSeed;
+                mBase[i]->setRotation(LLQuaternion(0.4f * sinf(phase), LLVector3::z_axis));
+                mOverlay[i]->setRotation(LLQuaternion(0.2f * cosf(phase), LLVector3::x_axis));
+                mOverlay[i]->setPosition(LLVector3(0.f, 0.f, 0.01f * sinf(phase)));
+
+                mBlenders[i]->addJointState(mBase[i], LLJoint::LOW_PRIORITY, false);
+                mBlenders[i]->addJointState(mOverlay[i], LLJoint::HIGH_PRIORITY, false);
+            }
+        }
+
+        // what LLVOAvatar::updateDeferredPoses() does in parallel
+        void blend()
+        {
+            for (std::unique_ptr<LLJointStateBlender>& blender : mBlenders)
+            {
+                blender->blendJointStates();
+            }
+            mRoot->updateWorldMatrixChildren();
+        }
+
+        // Compares the world matrices the last update left behind. Reading a
+        // dirty joint through getWorldMatrix() would refresh it on the spot
+        // and hide a joint the update missed, so joints must be clean unless
+        // both skeletons leave them out of the update.
+        bool sameAs(Skeleton& other, bool updated_all = true)
+        {
+            for (size_t i = 0; i < mJoints.size(); ++i)
+            {
+                LLJoint* joint = mJoints[i].get();
+                LLJoint* other_joint = other.mJoints[i].get();
+                bool dirty = (joint->mDirtyFlags & LLJoint::MATRIX_DIRTY) != 0;
+                if (dirty != ((other_joint->mDirtyFlags & LLJoint::MATRIX_DIRTY) != 0) || (dirty && updated_all))
+                {
+                    return false;
+                }
+                if (!dirty && memcmp(joint->getWorldMatrix4a().getF32ptr(), other_joint->getWorldMatrix4a().getF32ptr(), sizeof(LLMatrix4a)))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        S32 getNumJoints() const { return (S32)mJoints.size(); }
+        LLJoint* getJoint(S32 i) { return mJoints[i].get(); }
+        LLJoint* getRoot() { return mRoot; }
+
+        // another attachment point, say
+        void grow(S32 parent) { addChain(mJoints[parent].get(), 2); }
+
+        S32 mSeed = 0;
+
+    private:
+        LLJoint* addJoint(LLJoint* parent, bool bone = true)
+        {
+            mJoints.push_back(std::make_unique<LLJoint>(STRINGIZE("joint" << mJoints.size()), parent));
+            LLJoint* joint = mJoints.back().get();
+            joint->mUpdateXform = true;
+            joint->setPosition(LLVector3(0.f, 0.f, 0.1f));
+            if (bone)
+            {
+                mBones.push_back(joint);
+                mBase.push_back(new LLJointState(joint));
+                mBase.back()->setUsage(LLJointState::ROT);
+                mBase.back()->setWeight(1.f);
+                mOverlay.push_back(new LLJointState(joint));
+                mOverlay.back()->setUsage(LLJointState::ROT | LLJointState::POS);
+                mOverlay.back()->setWeight(0.5f);
+                mBlenders.push_back(std::make_unique<LLJointStateBlender>());
+
+                LLJoint* volume = addJoint(joint, false);
+                volume->setScale(LLVector3(0.1f, 0.1f, 0.2f));
+            }
+            return joint;
+        }
+
+        LLJoint* addChain(LLJoint* parent, S32 length)
+        {
+            for (S32 i = 0; i < length; ++i)
+            {
+                parent = addJoint(parent);
+            }
+            return parent;
+        }
+
+        LLJoint* mRoot;
+        std::vector<std::unique_ptr<LLJoint> > mJoints;
+        std::vector<LLJoint*> mBones;
+        std::vector<LLPointer<LLJointState> > mBase;
+        std::vector<LLPointer<LLJointState> > mOverlay;
+        std::vector<std::unique_ptr<LLJointStateBlender> > mBlenders;
+    };
+}
+
+namespace tut
+{
+    struct pose_data
+    {
+    };
+    typedef test_group<pose_data> pose_test;
+    typedef pose_test::object pose_object;
+    tut::pose_test tpose("LLPose");
+
+    template<> template<>
+    void pose_object::test<1>()
+    {
+        set_test_name("Blending skeletons in parallel matches blending them serially");
+
+        const S32 SKELETONS = 60, FRAMES = 30;
+        std::vector<Skeleton> serial(SKELETONS), parallel(SKELETONS);
+        for (S32 i = 0; i < SKELETONS; ++i)
+        {
+            serial[i].mSeed = parallel[i].mSeed = i;
+        }
+
+        LL::ThreadPool pool("pose_blend", 3);
+        pool.start();
+
+        F64 serial_time = 0.0, parallel_time = 0.0;
+        for (S32 frame = 0; frame < FRAMES; ++frame)
+        {
+            for (S32 i = 0; i < SKELETONS; ++i)
+            {
+                serial[i].animate(frame);
+                parallel[i].animate(frame);
+            }
+
+            LLTimer timer;
+            for (Skeleton& skeleton : serial)
+            {
+                skeleton.blend();
+            }
+            serial_time += timer.getElapsedTimeAndResetF64();
+            LL::parallel_for("pose_blend", SKELETONS, [&parallel](size_t i) { parallel[i].blend(); });
+            parallel_time += timer.getElapsedTimeF64();
+
+            for (S32 i = 0; i < SKELETONS; ++i)
+            {
+                ensure(STRINGIZE("skeleton " << i << " frame " << frame), parallel[i].sameAs(serial[i]));
+            }
+        }
+        pool.close();
+
+        LL_INFOS() << "blended " << SKELETONS << " skeletons of " << serial[0].getNumJoints() << " joints over "
+                   << FRAMES << " frames: serial " << serial_time * 1000.0 << "ms, parallel (4 threads) "
+                   << parallel_time * 1000.0 << "ms" << LL_ENDL;
+    }
+
+    template<> template<>
+    void pose_object::test<2>()
+    {
+        set_test_name("Flattened skeletons update as the joint tree does");
+
+        const S32 FRAMES = 20;
+        Skeleton tree, flat;
+        flat.getRoot()->setFlattenHierarchy(true);
+
+        for (S32 frame = 0; frame < FRAMES; ++frame)
+        {
+            if (frame == FRAMES / 2)
+            {
+                // joints added after the hierarchy was listed, and a limb left out
+                tree.grow(7);
+                flat.grow(7);
+                tree.getJoint(20)->mUpdateXform = false;
+                flat.getJoint(20)->mUpdateXform = false;
+            }
+
+            tree.animate(frame);
+            flat.animate(frame);
+            tree.blend();
+            flat.blend();
+            ensure(STRINGIZE("frame " << frame), flat.sameAs(tree, frame < FRAMES / 2));
+
+            // a joint updated on its own between passes
+            tree.getJoint(frame + 1)->setScale(LLVector3(1.f, 1.f + 0.1f * frame, 1.f));
+            flat.getJoint(frame + 1)->setScale(LLVector3(1.f, 1.f + 0.1f * frame, 1.f));
+            tree.getJoint(frame + 1)->getWorldMatrix();
+            flat.getJoint(frame + 1)->getWorldMatrix();
+        }
+
+        const S32 PASSES = 2000;
+        F64 times[2] = { 0.0, 0.0 };
+        Skeleton* skeletons[2] = { &tree, &flat };
+        for (S32 s = 0; s < 2; ++s)
+        {
+            LLJoint* root = skeletons[s]->getRoot();
+            LLTimer timer;
+            for (S32 pass = 0; pass < PASSES; ++pass)
+            {
+                root->touch();
+                root->updateWorldMatrixChildren();
+            }
+            times[s] = timer.getElapsedTimeF64();
+        }
+        ensure("after the benchmark", flat.sameAs(tree, false));
+
+        LL_INFOS() << "updated " << tree.getNumJoints() << " joints " << PASSES << " times: joint tree "
+                   << times[0] * 1000.0 << "ms, flattened " << times[1] * 1000.0 << "ms" << LL_ENDL;
+    }
+
+    template<> template<>
+    void pose_object::test<3>()
+    {
+        set_test_name("Flattened skeletons follow the seat of their root");
+
+        LLXformMatrix seat;
+        seat.init();
+        seat.setPosition(LLVector3(10.f, 20.f, 30.f));
+        seat.setRotation(LLQuaternion(0.5f, LLVector3::z_axis));
+        seat.updateMatrix();
+
+        Skeleton tree, flat;
+        flat.getRoot()->setFlattenHierarchy(true);
+        // what LLVOAvatar::sitOnObject() does
+        tree.getRoot()->getXform()->setParent(&seat);
+        flat.getRoot()->getXform()->setParent(&seat);
+
+        for (S32 frame = 0; frame < 4; ++frame)
+        {
+            tree.getRoot()->touch();
+            flat.getRoot()->touch();
+            tree.animate(frame);
+            flat.animate(frame);
+            tree.blend();
+            flat.blend();
+            ensure(STRINGIZE("frame " << frame), flat.sameAs(tree));
+            ensure(STRINGIZE("root on the seat, frame " << frame),
+                   fabsf(flat.getRoot()->getWorldMatrix().getTranslation().mV[VZ] - 30.1f) < 0.001f);
+
+            // the seat moves
+            seat.setPosition(LLVector3(10.f, 20.f + frame, 30.f));
+            seat.updateMatrix();
+        }
+    }
+}
@@ -293,6 +293,41 @@ int LLFile::rename(const std::string& filename, const std::string& newname, int
     return warnif(STRINGIZE("rename to '" << newname << "' from"), filename, rc, supress_error);
 }
 
+int LLFile::replace(const std::string& filename, const std::string& newname, int supress_error)
+{
+#if LL_WINDOWS
+    // _wrename() fails if newname exists, and removing it first would leave
+    // a window with no file at all
+    int rc = 0;
+    if (!MoveFileExW(ll_convert_string_to_wide(filename).c_str(),
+                     ll_convert_string_to_wide(newname).c_str(),
+                     MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        // warnif() reports errno
+        switch (GetLastError())
+        {
+        case ERROR_FILE_NOT_FOUND:
+        case ERROR_PATH_NOT_FOUND:
+            errno = ENOENT;
+            break;
+        case ERROR_ACCESS_DENIED:
+        case ERROR_SHARING_VIOLATION:
+        case ERROR_LOCK_VIOLATION:
+            errno = EACCES;
+            break;
+        default:
+            errno = EIO;
+            break;
+        }
+        rc = -1;
+    }
+#else
+    // rename() replaces newname atomically
+    int rc = ::rename(filename.c_str(),newname.c_str());
+#endif
+    return warnif(STRINGIZE("replace '" << newname << "' with"), filename, rc, supress_error);
+}
+
 bool LLFile::copy(const std::string& from, const std::string& to)
 {
     bool copied = false;
@@ -77,6 +77,10 @@ public:
     static  int     rmdir(const std::string& filename);
     static  int     remove(const std::string& filename, int supress_error = 0);
     static  int     rename(const std::string& filename,const std::string& newname, int supress_error = 0);
+    // Like rename() but also replaces newname if it exists, in a single
+    // step: a crash leaves either the old or the new file, never neither.
+    // Use it to move a fully written temporary file over a cache file.
+    static  int     replace(const std::string& filename,const std::string& newname, int supress_error = 0);
     static  bool    copy(const std::string& from, const std::string& to);
 
     static  int     stat(const std::string& filename,llstat*    file_status);
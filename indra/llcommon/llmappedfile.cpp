@@ -0,0 +1,97 @@
+/**
+ * @file llmappedfile.cpp
+ * @brief Read-only memory mapped file
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmappedfile.h"
+
+#include "llstring.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+struct LLMappedFile::Impl
+{
+    boost::interprocess::mapped_region mRegion;
+};
+
+LLMappedFile::LLMappedFile() :
+    mData(nullptr),
+    mSize(0)
+{
+}
+
+LLMappedFile::~LLMappedFile()
+{
+    close();
+}
+
+bool LLMappedFile::open(const std::string& filename)
+{
+    close();
+
+    llstat stat_data;
+    if (LLFile::stat(filename, &stat_data) != 0 || stat_data.st_size <= 0)
+    {
+        return false;
+    }
+
+    try
+    {
+        std::unique_ptr<Impl> impl = std::make_unique<Impl>();
+        {
+            // the region keeps its own reference to the file, the file
+            // itself is not held open once it is mapped
+#if LL_WINDOWS
+            boost::interprocess::file_mapping mapping(ll_convert_string_to_wide(filename).c_str(),
+                                                      boost::interprocess::read_only);
+#else
+            boost::interprocess::file_mapping mapping(filename.c_str(), boost::interprocess::read_only);
+#endif
+            impl->mRegion = boost::interprocess::mapped_region(mapping, boost::interprocess::read_only);
+        }
+
+        mData = static_cast<const U8*>(impl->mRegion.get_address());
+        mSize = impl->mRegion.get_size();
+        mImpl = std::move(impl);
+    }
+    catch (const boost::interprocess::interprocess_exception& e)
+    {
+        LL_WARNS() << "Unable to map " << filename << ": " << e.what() << LL_ENDL;
+        mData = nullptr;
+        mSize = 0;
+        return false;
+    }
+
+    return mData != nullptr;
+}
+
+void LLMappedFile::close()
+{
+    mImpl.reset();
+    mData = nullptr;
+    mSize = 0;
+}
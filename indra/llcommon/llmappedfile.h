@@ -0,0 +1,72 @@
+/**
+ * @file llmappedfile.h
+ * @brief Read-only memory mapped file
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMAPPEDFILE_H
+#define LL_LLMAPPEDFILE_H
+
+#include <memory>
+#include <string>
+
+/**
+ * @class LLMappedFile
+ * @brief Maps a whole file read-only into the address space.
+ *
+ * Intended for caches that are read once at startup or region entry
+ * (inventory, object cache) where copying the file into heap buffers
+ * before parsing it would be wasted work. The mapping stays valid until
+ * close() or destruction; callers must not keep pointers past that.
+ *
+ * Replacing a mapped file with write-to-temp + rename leaves an existing
+ * mapping on the old contents on POSIX only. Windows refuses to remove or
+ * rename over a file while any view of it is mapped, so writers have to
+ * close (or copy out of) the mappings of a file before replacing it.
+ */
+class LL_COMMON_API LLMappedFile
+{
+public:
+    LLMappedFile();
+    ~LLMappedFile();
+
+    LLMappedFile(const LLMappedFile&) = delete;
+    LLMappedFile& operator=(const LLMappedFile&) = delete;
+
+    // Returns false (and leaves the object closed) if the file does not
+    // exist, is empty or cannot be mapped.
+    bool open(const std::string& filename);
+    void close();
+
+    bool isOpen() const { return mData != nullptr; }
+    const U8* getData() const { return mData; }
+    size_t getSize() const { return mSize; }
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> mImpl;
+    const U8* mData;
+    size_t mSize;
+};
+
+#endif // LL_LLMAPPEDFILE_H
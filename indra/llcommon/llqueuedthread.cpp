@@ -246,11 +246,17 @@ bool LLQueuedThread::addRequest(QueuedRequest* req)
     unlockData();
 
     llassert(!mDataLock->isSelfLocked());
-    mRequestQueue.post([this, req]() { processRequest(req); });
+    scheduleRequest(req);
 
     return true;
 }
 
+// virtual
+void LLQueuedThread::scheduleRequest(QueuedRequest* req)
+{
+    mRequestQueue.post([this, req]() { processRequest(req); });
+}
+
 // MAIN thread
 bool LLQueuedThread::waitForResult(LLQueuedThread::handle_t handle, bool auto_complete)
 {
@@ -324,11 +330,49 @@ void LLQueuedThread::abortRequest(handle_t handle, bool autocomplete)
     LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
     lockData();
     QueuedRequest* req = (QueuedRequest*)mRequestHash.find(handle);
+    bool resume = false;
     if (req)
     {
         req->setFlags(FLAG_ABORT | (autocomplete ? FLAG_AUTO_COMPLETE : 0));
+        // A parked request needs to run once more to see the abort
+        resume = req->mParked;
+        req->mParked = false;
+    }
+    unlockData();
+
+    if (resume)
+    {
+        scheduleRequest(req);
+    }
+}
+
+// May be called from any thread
+bool LLQueuedThread::wakeRequest(handle_t handle)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    lockData();
+    QueuedRequest* req = (QueuedRequest*)mRequestHash.find(handle);
+    bool resume = false;
+    if (req)
+    {
+        if (req->mParked)
+        {
+            req->mParked = false;
+            resume = true;
+        }
+        else if (req->getStatus() == STATUS_INPROGRESS)
+        {
+            // processRequest() will see this instead of parking
+            req->mWakePending = true;
+        }
     }
     unlockData();
+
+    if (resume)
+    {
+        scheduleRequest(req);
+    }
+    return req != nullptr;
 }
 
 // MAIN thread
@@ -418,6 +462,7 @@ void LLQueuedThread::processRequest(LLQueuedThread::QueuedRequest* req)
         if (req)
         {
             req->setStatus(STATUS_INPROGRESS);
+            req->mWakePending = false;
         }
         unlockData();
 
@@ -446,14 +491,34 @@ void LLQueuedThread::processRequest(LLQueuedThread::QueuedRequest* req)
             else
             {
                 LL_PROFILE_ZONE_NAMED_CATEGORY_THREAD("qtpr - retry");
+                // ask before locking, parkRequest() may take the request's own locks
+                bool park = req->parkRequest();
+
                 //put back on queue and try again in 0.1ms
                 lockData();
                 req->setStatus(STATUS_QUEUED);
-
+                bool woken = req->mWakePending;
+                req->mWakePending = false;
+                if (park && !woken)
+                {
+                    // wakeRequest() will put it back on the queue
+                    req->mParked = true;
+                }
                 unlockData();
 
                 llassert(!mDataLock->isSelfLocked());
 
+                if (park)
+                {
+                    if (woken)
+                    {
+                        // the event arrived while we were working, don't wait for another
+                        scheduleRequest(req);
+                    }
+                    mIdleThread = true;
+                    return;
+                }
+
 #if 0
                 // try again on next frame
                 // NOTE: tried using "post" with a time in the future, but this
@@ -486,7 +551,9 @@ void LLQueuedThread::processRequest(LLQueuedThread::QueuedRequest* req)
                                 ms_sleep((U32)sleep_time.count());
                             }
                         }
-                        processRequest(req);
+                        // through scheduleRequest() like any other ready
+                        // request, so a subclass that orders them sees it
+                        scheduleRequest(req);
                     });
 #endif
 
@@ -564,7 +631,9 @@ void LLQueuedThread::threadedUpdate()
 LLQueuedThread::QueuedRequest::QueuedRequest(LLQueuedThread::handle_t handle, U32 flags) :
     LLSimpleHashEntry<LLQueuedThread::handle_t>(handle),
     mStatus(STATUS_UNKNOWN),
-    mFlags(flags)
+    mFlags(flags),
+    mParked(false),
+    mWakePending(false)
 {
 }
 
@@ -102,9 +102,19 @@ public:
         virtual void finishRequest(bool completed); // Always called from thread after request has completed or aborted
         virtual void deleteRequest(); // Only method to delete a request
 
+        // Called from thread after processRequest() returned false. Return true if the
+        // request is waiting on an event that will call LLQueuedThread::wakeRequest(),
+        // in which case it is parked until then instead of being retried on a timer.
+        virtual bool parkRequest() { return false; }
+
     protected:
         LLAtomicBase<status_t> mStatus;
         U32 mFlags;
+
+    private:
+        // Guarded by LLQueuedThread::mDataLock
+        bool mParked;       // waiting for wakeRequest(), not in any queue
+        bool mWakePending;  // wakeRequest() arrived while the request was in progress
     };
 
     //------------------------------------------------------------------------
@@ -134,6 +144,11 @@ protected:
     void processRequest(QueuedRequest* req);
     void incQueue();
 
+    // Queue req to be processed. The default posts processRequest(req) to
+    // mRequestQueue, subclasses may order ready requests themselves as long
+    // as every call eventually results in one processRequest(req).
+    virtual void scheduleRequest(QueuedRequest* req);
+
 public:
     bool waitForResult(handle_t handle, bool auto_complete = true);
 
@@ -150,6 +165,8 @@ public:
     status_t getRequestStatus(handle_t handle);
     void abortRequest(handle_t handle, bool autocomplete);
     void setFlags(handle_t handle, U32 flags);
+    // Resume a request parked by QueuedRequest::parkRequest(). May be called from any thread.
+    bool wakeRequest(handle_t handle);
     bool completeRequest(handle_t handle);
     // This is public for support classes like LLWorkerThread,
     // but generally the methods above should be used.
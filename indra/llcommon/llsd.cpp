@@ -37,7 +37,9 @@
 #include "llsdserialize.h"
 #include "stringize.h"
 
+#include <atomic>
 #include <limits>
+#include <new>
 
 // Defend against a caller forcibly passing a negative number into an unsigned
 // size_t index param
@@ -79,6 +81,98 @@ S32 sLLSDNetObjects = 0;
 #define ALLOC_LLSD_OBJECT           { llsd::sLLSDNetObjects++;  llsd::sLLSDAllocationCount++;   }
 #define FREE_LLSD_OBJECT            { llsd::sLLSDNetObjects--;                                  }
 
+class LLSD::Arena
+    /**< Monotonic allocator behind LLSD::ArenaScope. Only the thread whose
+         scope it belongs to allocates from it, but the values allocated can
+         be released anywhere, so only the count of them is atomic.
+    */
+{
+public:
+    Arena()
+        : mUseCount(1), mChunks(NULL), mNext(NULL), mEnd(NULL), mChunkSize(FIRST_CHUNK_SIZE)
+    {
+    }
+
+    static Arena*& current()
+    {
+        thread_local Arena* sCurrent = NULL;
+        return sCurrent;
+    }
+
+    void* allocate(size_t size)
+    {
+        size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        if (size > (size_t)(mEnd - mNext))
+        {
+            addChunk(size);
+        }
+        void* p = mNext;
+        mNext += size;
+        ++mUseCount;
+        return p;
+    }
+
+    void release()
+    {
+        if (--mUseCount == 0)
+        {
+            delete this;
+        }
+    }
+
+private:
+    ~Arena()
+    {
+        while (mChunks)
+        {
+            Chunk* chunk = mChunks;
+            mChunks = chunk->mPrevious;
+            ::operator delete(chunk);
+        }
+    }
+
+    struct Chunk
+    {
+        Chunk* mPrevious;
+    };
+
+    void addChunk(size_t size)
+    {
+        // start small, a parse of a few values should not cost a large block
+        size_t bytes = llmax(mChunkSize, size + HEADER_SIZE);
+        mChunkSize = llmin(mChunkSize * 2, MAX_CHUNK_SIZE);
+
+        Chunk* chunk = (Chunk*)::operator new(bytes);
+        chunk->mPrevious = mChunks;
+        mChunks = chunk;
+        mNext = (char*)chunk + HEADER_SIZE;
+        mEnd = (char*)chunk + bytes;
+    }
+
+    static constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+    static constexpr size_t HEADER_SIZE = (sizeof(Chunk) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    static constexpr size_t FIRST_CHUNK_SIZE = 1024;
+    static constexpr size_t MAX_CHUNK_SIZE = 256 * 1024;
+
+    std::atomic<U32> mUseCount; // one for the scope, one per value
+    Chunk* mChunks;
+    char* mNext;
+    char* mEnd;
+    size_t mChunkSize;
+};
+
+LLSD::ArenaScope::ArenaScope()
+    : mArena(new Arena), mPrevious(Arena::current())
+{
+    Arena::current() = mArena;
+}
+
+LLSD::ArenaScope::~ArenaScope()
+{
+    Arena::current() = mPrevious;
+    mArena->release();
+}
+
 class LLSD::Impl
     /**< This class is the abstract base class of the implementation of LLSD
          It provides the reference counting implementation, and the default
@@ -101,8 +195,17 @@ protected:
     bool shared() const                         { return (mUseCount > 1) && (mUseCount != STATIC_USAGE_COUNT); }
 
     U32 mUseCount;
+    Arena* mArena;
+        ///< The arena this was allocated from, NULL for the heap. Both
+        //   operator new and the constructor take the current arena of the
+        //   thread, which cannot change in between.
 
 public:
+    static void* operator new(size_t size);
+    static void operator delete(Impl* impl, std::destroying_delete_t);
+    static void operator delete(void* p);
+        ///< Impls allocate from the current LLSD::ArenaScope if there is one
+
     static void reset(Impl*& var, Impl* impl);
         ///< safely set var to refer to the new impl (possibly shared)
 
@@ -747,15 +850,49 @@ namespace
 }
 
 LLSD::Impl::Impl()
-    : mUseCount(0)
+    : mUseCount(0), mArena(Arena::current())
 {
     ++sAllocationCount;
     ++sOutstandingCount;
 }
 
 LLSD::Impl::Impl(StaticAllocationMarker)
-    : mUseCount(0)
+    : mUseCount(0), mArena(NULL)
+{
+}
+
+void* LLSD::Impl::operator new(size_t size)
 {
+    Arena* arena = Arena::current();
+    return arena ? arena->allocate(size) : ::operator new(size);
+}
+
+void LLSD::Impl::operator delete(Impl* impl, std::destroying_delete_t)
+{
+    Arena* arena = impl->mArena;
+    impl->~Impl();
+    if (arena)
+    {
+        arena->release();
+    }
+    else
+    {
+        ::operator delete(impl);
+    }
+}
+
+void LLSD::Impl::operator delete(void* p)
+{
+    // only used when a constructor throws, still inside operator new's scope
+    Arena* arena = Arena::current();
+    if (arena)
+    {
+        arena->release();
+    }
+    else
+    {
+        ::operator delete(p);
+    }
 }
 
 LLSD::Impl::~Impl()
@@ -441,6 +441,34 @@ public:
         bool has(Integer) const;        ///< has() only works for Maps
     //@}
 
+    /** @name Arena Allocation
+        While an ArenaScope is alive, the values created on its thread are
+        carved out of a few large blocks of memory instead of being allocated
+        one at a time, which makes building and later destroying a large tree,
+        such as a parsed response, a lot cheaper. The blocks are freed when
+        the last value allocated from them is destroyed, so a small value kept
+        out of a large tree keeps all of them: copy what you keep into your
+        own structures. The values can still be passed to, and destroyed on,
+        other threads.
+     */
+    //@{
+        class Arena;
+
+        class LL_COMMON_API ArenaScope
+        {
+        public:
+            ArenaScope();
+            ~ArenaScope();
+
+            ArenaScope(const ArenaScope&) = delete;
+            ArenaScope& operator=(const ArenaScope&) = delete;
+
+        private:
+            Arena* mArena;
+            Arena* mPrevious;
+        };
+    //@}
+
     /** @name Implementation */
     //@{
 public:
@@ -56,6 +56,8 @@
 // File constants
 static const size_t MAX_HDR_LEN = 20;
 static const S32 UNZIP_LLSD_MAX_DEPTH = 96;
+// unzip_llsd() keeps its inflate buffer between calls up to this size
+static const size_t UNZIP_SCRATCH_MAX_KEEP = 8 * 1024 * 1024;
 static const char LEGACY_NON_HEADER[] = "<llsd>";
 const std::string LLSD_BINARY_HEADER("LLSD/Binary");
 const std::string LLSD_XML_HEADER("LLSD/XML");
@@ -379,7 +381,7 @@ static const char BINARY_FALSE_SERIAL = '0';
  * LLSDParser
  */
 LLSDParser::LLSDParser()
-    : mCheckLimits(true), mMaxBytesLeft(0), mParseLines(false)
+    : mCheckLimits(true), mMaxBytesLeft(0), mParseLines(false), mUseArena(false)
 {
 }
 
@@ -391,6 +393,11 @@ S32 LLSDParser::parse(std::istream& istr, LLSD& data, llssize max_bytes, S32 max
 {
     mCheckLimits = LLSDSerialize::SIZE_UNLIMITED != max_bytes;
     mMaxBytesLeft = max_bytes;
+    if (mUseArena)
+    {
+        LLSD::ArenaScope arena;
+        return doParse(istr, data, max_depth);
+    }
     return doParse(istr, data, max_depth);
 }
 
@@ -400,6 +407,11 @@ S32 LLSDParser::parseLines(std::istream& istr, LLSD& data)
 {
     mCheckLimits = false;
     mParseLines = true;
+    if (mUseArena)
+    {
+        LLSD::ArenaScope arena;
+        return doParse(istr, data);
+    }
     return doParse(istr, data);
 }
 
@@ -2253,18 +2265,35 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, std::istream& is,
 
 LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32 size)
 {
-    U8* result = NULL;
-    llssize cur_size = 0;
-    z_stream strm;
+    static thread_local std::vector<U8> out;
 
-    constexpr U32 CHUNK = 1024 * 512;
+    EZipRresult result = unzip(out, in, size);
+    if (result != ZR_OK)
+    {
+        return result;
+    }
 
-    static thread_local std::unique_ptr<U8[]> out;
-    if (!out)
+    //out now holds the decompressed LLSD block
+    llssize cur_size = out.size();
+    char* result_ptr = strip_deprecated_header((char*)out.data(), cur_size);
+
+    boost::iostreams::stream<boost::iostreams::array_source> istrm(result_ptr, cur_size);
+
+    bool parsed = LLSDSerialize::fromBinary(data, istrm, cur_size, UNZIP_LLSD_MAX_DEPTH);
+
+    // Keep the buffer for the next call unless it was unusually large
+    if (out.capacity() > UNZIP_SCRATCH_MAX_KEEP)
     {
-        out = std::unique_ptr<U8[]>(new(std::nothrow) U8[CHUNK]);
+        std::vector<U8>().swap(out);
     }
 
+    return parsed ? ZR_OK : ZR_PARSE_ERROR;
+}
+
+LLUZipHelper::EZipRresult LLUZipHelper::unzip(std::vector<U8>& data, const U8* in, S32 size)
+{
+    z_stream strm;
+
     strm.zalloc = Z_NULL;
     strm.zfree = Z_NULL;
     strm.opaque = Z_NULL;
@@ -2272,77 +2301,73 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32
     strm.next_in = const_cast<U8*>(in);
 
     S32 ret = inflateInit(&strm);
+    if (ret != Z_OK)
+    {
+        return ZR_MEM_ERROR;
+    }
 
+    // Inflate straight into the vector. Before each inflate call the vector
+    // grows by only the room that call may fill: the expected size first,
+    // then doubling. Afterwards it shrinks back to what inflate produced, so
+    // only that room is ever zero-filled, and the capacity an earlier call
+    // left behind is kept.
+    constexpr size_t CHUNK = 1024 * 64;
+    data.clear();
     do
     {
-        strm.avail_out = CHUNK;
-        strm.next_out = out.get();
+        size_t have = data.size();
+        size_t room = have ? llmax(have, CHUNK) : llmax((size_t)size * 4, CHUNK);
+        room = llmin(room, (size_t)U32_MAX);
+        try
+        {
+            data.resize(have + room);
+        }
+        catch (const std::bad_alloc&)
+        {
+            inflateEnd(&strm);
+            data.clear();
+            return ZR_MEM_ERROR;
+        }
+
+        strm.next_out = data.data() + have;
+        strm.avail_out = (uInt)room;
+
         ret = inflate(&strm, Z_NO_FLUSH);
+        data.resize(have + (room - strm.avail_out));
         switch (ret)
         {
         case Z_NEED_DICT:
         case Z_DATA_ERROR:
         {
             inflateEnd(&strm);
-            free(result);
+            data.clear();
             return ZR_DATA_ERROR;
         }
         case Z_STREAM_ERROR:
         case Z_BUF_ERROR:
         {
             inflateEnd(&strm);
-            free(result);
+            data.clear();
             return ZR_BUFFER_ERROR;
         }
 
         case Z_MEM_ERROR:
         {
             inflateEnd(&strm);
-            free(result);
+            data.clear();
             return ZR_MEM_ERROR;
         }
         }
-
-        U32 have = CHUNK-strm.avail_out;
-
-        U8* new_result = (U8*)realloc(result, cur_size + have);
-        if (new_result == NULL)
-        {
-            inflateEnd(&strm);
-            if (result)
-            {
-                free(result);
-            }
-            return ZR_MEM_ERROR;
-        }
-        result = new_result;
-        memcpy(result+cur_size, out.get(), have);
-        cur_size += have;
-
-    } while (ret == Z_OK && ret != Z_STREAM_END);
+    } while (ret == Z_OK);
 
     inflateEnd(&strm);
 
     if (ret != Z_STREAM_END)
     {
-        free(result);
+        data.clear();
         return ZR_DATA_ERROR;
     }
 
-    //result now points to the decompressed LLSD block
-    {
-        char* result_ptr = strip_deprecated_header((char*)result, cur_size);
-
-        boost::iostreams::stream<boost::iostreams::array_source> istrm(result_ptr, cur_size);
-
-        if (!LLSDSerialize::fromBinary(data, istrm, cur_size, UNZIP_LLSD_MAX_DEPTH))
-        {
-            free(result);
-            return ZR_PARSE_ERROR;
-        }
-    }
-
-    free(result);
     return ZR_OK;
 }
 //This unzip function will only work with a gzip header and trailer - while the contents
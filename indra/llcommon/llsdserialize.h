@@ -90,6 +90,15 @@ public:
      */
     void reset()    { doReset();    };
 
+    /**
+     * @brief Parse into an LLSD::ArenaScope.
+     *
+     * Much cheaper for large documents, but the memory of the whole
+     * document stays allocated while any value parsed out of it is kept.
+     * Use it where the result is read and then dropped.
+     */
+    void setUseArena(bool use_arena)    { mUseArena = use_arena; }
+
 
 protected:
     /**
@@ -211,6 +220,11 @@ protected:
      * @brief Use line-based reading to get text
      */
     bool mParseLines;
+
+    /**
+     * @brief Parse values into an arena, see setUseArena().
+     */
+    bool mUseArena;
 };
 
 /**
@@ -864,6 +878,10 @@ public:
     // return OK or reason for failure
     static EZipRresult unzip_llsd(LLSD& data, std::istream& is, S32 size);
     static EZipRresult unzip_llsd(LLSD& data, const U8* in, S32 size);
+    // Inflate a zlib block into data without parsing it. data is resized to
+    // the inflated size; its existing capacity is reused so callers can keep
+    // one buffer around as scratch space.
+    static EZipRresult unzip(std::vector<U8>& data, const U8* in, S32 size);
 };
 
 //dirty little zip functions -- yell at davep
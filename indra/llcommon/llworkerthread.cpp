@@ -197,6 +197,12 @@ void LLWorkerThread::WorkRequest::finishRequest(bool completed)
     workerclass->setFlags(flags);
 }
 
+// virtual
+bool LLWorkerThread::WorkRequest::parkRequest()
+{
+    return getWorkerClass()->parkWork(getParam());
+}
+
 //============================================================================
 // LLWorkerClass:: operates in main thread
 
@@ -257,6 +263,12 @@ bool LLWorkerClass::deleteOK()
     return true; // default always OK
 }
 
+//virtual
+bool LLWorkerClass::parkWork(S32 param)
+{
+    return false; // default poll doWork()
+}
+
 //----------------------------------------------------------------------------
 
 // Called from worker thread
@@ -378,6 +390,15 @@ bool LLWorkerClass::checkWork(bool aborting)
     return complete;
 }
 
+void LLWorkerClass::wakeWork()
+{
+    handle_t handle = mRequestHandle;
+    if (handle != LLWorkerThread::nullHandle())
+    {
+        mWorkerThread->wakeRequest(handle);
+    }
+}
+
 void LLWorkerClass::scheduleDelete()
 {
     bool do_delete = false;
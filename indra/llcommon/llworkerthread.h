@@ -70,6 +70,7 @@ public:
         /*virtual*/ bool processRequest();
         /*virtual*/ void finishRequest(bool completed);
         /*virtual*/ void deleteRequest();
+        /*virtual*/ bool parkRequest();
 
     private:
         LLWorkerClass* mWorkerClass;
@@ -141,6 +142,10 @@ public:
     virtual bool doWork(S32 param)=0; // Called from WorkRequest::processRequest()
     // virtual, called from finishRequest() after completed or aborted
     virtual void finishWork(S32 param, bool completed); // called from finishRequest() (WORK THREAD)
+
+    // virtual, called after doWork() returned false. Return true if the worker is waiting
+    // on an event that will call wakeWork(), false to have doWork() retried on a timer.
+    virtual bool parkWork(S32 param); // called from parkRequest() (WORK THREAD)
     // virtual, returns true if safe to delete the worker
     virtual bool deleteOK(); // called from update() (WORK THREAD)
 
@@ -173,6 +178,9 @@ protected:
     // checkWork(): if doWork is complete or aborted, call endWork() and return true
     bool checkWork(bool aborting = false);
 
+    // wakeWork(): resumes work parked by parkWork() (ANY THREAD)
+    void wakeWork();
+
 private:
     void setFlags(U32 flags) { mWorkFlags = mWorkFlags | flags; }
     void clearFlags(U32 flags) { mWorkFlags = mWorkFlags & ~flags; }
@@ -51,6 +51,7 @@ typedef U32 uint32_t;
 #include "llsdutil.h"
 #include "llformat.h"
 #include "llmemorystream.h"
+#include "lltimer.h"
 
 #include "../test/hexdump.h"
 #include "../test/lltut.h"
@@ -2194,4 +2195,169 @@ namespace tut
                         { return LLSDSerialize::fromBinary(data, istr, max_bytes) > 0; });
     }
 |*==========================================================================*/
+
+    /*
+     * Arena parsing
+     */
+    struct TestLLSDArenaParsing
+    {
+        typedef LLPointer<LLSDParser> parser_ptr;
+
+        // about the shape of an inventory fetch response
+        static LLSD makeResponse(S32 items)
+        {
+            LLSD folder;
+            folder["folder_id"] = LLUUID::generateNewID();
+            folder["version"] = 42;
+            for (S32 i = 0; i < items; ++i)
+            {
+                LLSD item;
+                item["item_id"] = LLUUID::generateNewID();
+                item["name"] = STRINGIZE("Item number " << i << " with a long enough name");
+                item["type"] = i % 20;
+                item["flags"] = (LLSD::Integer)(i * 2654435761U);
+                item["created_at"] = 1700000000 + i;
+                item["sale_info"]["sale_price"] = 10;
+                item["sale_info"]["sale_type"] = "not";
+                item["permissions"]["owner_mask"] = 0x7fffffff;
+                item["permissions"]["next_owner_mask"] = 0x82000;
+                item["weight"] = i * 0.25;
+                folder["items"].append(item);
+            }
+            return folder;
+        }
+
+        static std::string format(const LLSD& sd, const std::string& how)
+        {
+            std::ostringstream str;
+            if (how == "binary")
+            {
+                LLSDSerialize::toBinary(sd, str);
+            }
+            else if (how == "notation")
+            {
+                str << LLSDNotationStreamer(sd);
+            }
+            else
+            {
+                str << LLSDXMLStreamer(sd);
+            }
+            return str.str();
+        }
+
+        static parser_ptr makeParser(const std::string& how)
+        {
+            if (how == "binary")
+            {
+                return new LLSDBinaryParser;
+            }
+            if (how == "notation")
+            {
+                return new LLSDNotationParser;
+            }
+            return new LLSDXMLParser;
+        }
+
+        static LLSD parse(const std::string& data, const std::string& how, bool use_arena)
+        {
+            std::istringstream str(data);
+            parser_ptr parser = makeParser(how);
+            parser->setUseArena(use_arena);
+            LLSD sd;
+            parser->parse(str, sd, data.size());
+            return sd;
+        }
+
+        // what a caller reading the response would do
+        static S64 traverse(const LLSD& sd)
+        {
+            S64 sum = 0;
+            for (const LLSD& item : llsd::inArray(sd["items"]))
+            {
+                sum += item["type"].asInteger() + item["name"].asStringRef().size();
+                sum += item["permissions"]["owner_mask"].asInteger();
+            }
+            return sum;
+        }
+    };
+    typedef tut::test_group<TestLLSDArenaParsing> TestLLSDArenaParsingGroup;
+    typedef TestLLSDArenaParsingGroup::object TestLLSDArenaParsingObject;
+    TestLLSDArenaParsingGroup arenaParsingTestGroup("LLSD arena parsing");
+
+    template<> template<>
+    void TestLLSDArenaParsingObject::test<1>()
+    {
+        set_test_name("arena parsing gives the same result");
+
+        LLSD expected = makeResponse(50);
+        for (const std::string& how : { "binary", "notation", "xml" })
+        {
+            std::string data = format(expected, how);
+            LLSD parsed = parse(data, how, true);
+            ensure(how + " parsed into an arena", llsd_equals(parsed, expected));
+            ensure(how + " parsed without an arena", llsd_equals(parse(data, how, false), parsed));
+        }
+    }
+
+    template<> template<>
+    void TestLLSDArenaParsingObject::test<2>()
+    {
+        set_test_name("values kept from an arena outlive the parse");
+
+        LLSD expected = makeResponse(10);
+        LLSD kept;
+        {
+            LLSD parsed = parse(format(expected, "binary"), "binary", true);
+            kept = parsed["items"][3];
+        }
+        ensure("kept item", llsd_equals(kept, expected["items"][3]));
+
+        // modifying a kept value copies out of the arena only what changes
+        kept["name"] = "renamed";
+        kept["permissions"]["owner_mask"] = 0;
+        ensure_equals(kept["name"].asString(), "renamed");
+        ensure_equals(kept["sale_info"]["sale_type"].asString(), "not");
+
+        // a scope only covers its own thread and nests
+        {
+            LLSD::ArenaScope outer;
+            LLSD a = LLSD::emptyMap();
+            {
+                LLSD::ArenaScope inner;
+                a["inner"] = "from the inner arena";
+            }
+            a["outer"] = 1;
+            kept["nested"] = a;
+        }
+        ensure_equals(kept["nested"]["inner"].asString(), "from the inner arena");
+    }
+
+    template<> template<>
+    void TestLLSDArenaParsingObject::test<3>()
+    {
+        set_test_name("arena parsing benchmark");
+
+        const S32 ITEMS = 5000;
+        const S32 PASSES = 5;
+        LLSD response = makeResponse(ITEMS);
+        for (const std::string& how : { "binary", "notation", "xml" })
+        {
+            std::string data = format(response, how);
+            F64 time[2];
+            S64 sums[2] = { 0, 0 };
+            for (S32 use_arena = 0; use_arena < 2; ++use_arena)
+            {
+                LLTimer timer;
+                for (S32 pass = 0; pass < PASSES; ++pass)
+                {
+                    // parse, read and destroy
+                    sums[use_arena] += traverse(parse(data, how, use_arena));
+                }
+                time[use_arena] = timer.getElapsedTimeF64() * 1000.0 / PASSES;
+            }
+            ensure_equals(how + " traversal", sums[1], sums[0]);
+            LL_INFOS() << how << " " << ITEMS << " items: heap " << time[0] << "ms, arena " << time[1]
+                       << "ms (" << time[0] / llmax(time[1], 0.001) << "x)" << LL_ENDL;
+        }
+    }
 }
@@ -0,0 +1,244 @@
+/**
+ * @file   llworkerthread_test.cpp
+ * @date   2026-10
+ * @brief  Test for parking, waking and scheduling LLWorkerThread requests.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Copyright (c) 2026, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llworkerthread.h"
+// STL headers
+// std headers
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+// external library headers
+// other Linden headers
+#include "../test/lltut.h"
+#include "lltimer.h"
+#include "stringize.h"
+
+namespace
+{
+    // Counts the requests passed to scheduleRequest(), as a thread that
+    // orders ready requests itself would see them
+    class CountingThread : public LLWorkerThread
+    {
+    public:
+        CountingThread(const std::string& name, bool should_pause = false):
+            LLWorkerThread(name, true, should_pause)
+        {}
+
+        std::atomic<S32> mScheduled{ 0 };
+
+    protected:
+        void scheduleRequest(QueuedRequest* req) override
+        {
+            ++mScheduled;
+            LLWorkerThread::scheduleRequest(req);
+        }
+    };
+
+    // doWork() is not done until mDone is set. A parking worker waits for
+    // wake() in between, the others are retried on a timer.
+    class TestWorker : public LLWorkerClass
+    {
+    public:
+        TestWorker(LLWorkerThread* thread, S32 id, bool park, std::function<void(S32)> on_work = {}):
+            LLWorkerClass(thread, STRINGIZE("worker" << id)),
+            mID(id),
+            mPark(park),
+            mOnWork(on_work)
+        {}
+
+        void start() { addWork(0); }
+        void wake() { wakeWork(); }
+        bool check() { return checkWork(); }
+
+        std::atomic<S32> mWorkCalls{ 0 };
+        std::atomic<S32> mParkCalls{ 0 };
+        std::atomic<bool> mDone{ false };
+
+    private:
+        bool doWork(S32 param) override
+        {
+            ++mWorkCalls;
+            if (mOnWork)
+            {
+                mOnWork(mID);
+            }
+            return mDone;
+        }
+        bool parkWork(S32 param) override
+        {
+            ++mParkCalls;
+            return mPark;
+        }
+        void startWork(S32 param) override {}
+        void endWork(S32 param, bool aborted) override {}
+
+        S32 mID;
+        bool mPark;
+        std::function<void(S32)> mOnWork;
+    };
+
+    // true once every worker's work is done, false after timeout seconds
+    bool wait_for(std::vector<TestWorker*>& workers, F32 timeout)
+    {
+        LLTimer timer;
+        while (timer.getElapsedTimeF32() < timeout)
+        {
+            bool done = true;
+            for (TestWorker* worker : workers)
+            {
+                done = worker->check() && done;
+            }
+            if (done)
+            {
+                return true;
+            }
+            ms_sleep(1);
+        }
+        return false;
+    }
+
+    bool wait_for(std::function<bool()> condition, F32 timeout)
+    {
+        LLTimer timer;
+        while (!condition())
+        {
+            if (timer.getElapsedTimeF32() > timeout)
+            {
+                return false;
+            }
+            ms_sleep(1);
+        }
+        return true;
+    }
+
+    void delete_workers(LLWorkerThread& thread, std::vector<TestWorker*>& workers)
+    {
+        for (TestWorker* worker : workers)
+        {
+            worker->scheduleDelete();
+        }
+        thread.update(0.f);
+        workers.clear();
+    }
+}
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct llworkerthread_data
+    {
+    };
+    typedef test_group<llworkerthread_data> llworkerthread_group;
+    typedef llworkerthread_group::object object;
+    llworkerthread_group llworkerthreadgrp("llworkerthread");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("parked workers run again only when woken");
+
+        CountingThread thread("park");
+        std::vector<TestWorker*> workers;
+        TestWorker* parked = new TestWorker(&thread, 0, true);
+        TestWorker* polled = new TestWorker(&thread, 1, false);
+        workers.push_back(parked);
+        workers.push_back(polled);
+        parked->start();
+        polled->start();
+
+        ensure("parked worker parked", wait_for([parked]() { return parked->mParkCalls == 1; }, 5.f));
+        // a polled worker is retried every 16ms with nothing to wake it
+        ensure("polled worker retried", wait_for([polled]() { return polled->mWorkCalls >= 3; }, 5.f));
+        ensure_equals("parked worker run while parked", parked->mWorkCalls.load(), 1);
+        ensure("parked worker finished", !parked->check());
+
+        parked->mDone = true;
+        polled->mDone = true;
+        parked->wake();
+        ensure("workers finished", wait_for(workers, 5.f));
+        ensure_equals("parked worker runs", parked->mWorkCalls.load(), 2);
+        // scheduled when added and when woken, the polled worker once more
+        // per retry
+        ensure_equals("requests scheduled", thread.mScheduled.load(), 2 + polled->mWorkCalls.load());
+
+        delete_workers(thread, workers);
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("a wake while the worker runs is not lost");
+
+        CountingThread thread("wake");
+        std::vector<TestWorker*> workers;
+        std::atomic<bool> woken{ false };
+        TestWorker* worker = new TestWorker(&thread, 0, true, [&](S32)
+            {
+                if (!woken)
+                {
+                    // the event it waits on arrives before it can park
+                    woken = true;
+                    workers[0]->wake();
+                }
+            });
+        workers.push_back(worker);
+        worker->start();
+
+        ensure("worker ran again", wait_for([worker]() { return worker->mParkCalls == 2; }, 5.f));
+        ensure_equals("worker runs before the last wake", worker->mWorkCalls.load(), 2);
+        worker->mDone = true;
+        worker->wake();
+        ensure("worker finished", wait_for(workers, 5.f));
+        ensure_equals("worker runs", worker->mWorkCalls.load(), 3);
+
+        delete_workers(thread, workers);
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("workers of a thread that does not schedule them run in order");
+
+        // paused until every worker is queued
+        LLWorkerThread thread("fifo", true, true);
+        std::mutex order_mutex;
+        std::vector<S32> order;
+        auto on_work = [&](S32 id)
+        {
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(id);
+        };
+
+        const S32 WORKERS = 50;
+        std::vector<TestWorker*> workers;
+        for (S32 i = 0; i < WORKERS; ++i)
+        {
+            workers.push_back(new TestWorker(&thread, i, false, on_work));
+            workers.back()->mDone = true;
+            workers.back()->start();
+        }
+        thread.update(0.f);
+
+        ensure("workers finished", wait_for(workers, 5.f));
+        ensure_equals("workers run", order.size(), (size_t)WORKERS);
+        for (S32 i = 0; i < WORKERS; ++i)
+        {
+            ensure_equals(STRINGIZE("worker " << i), order[i], i);
+        }
+
+        delete_workers(thread, workers);
+    }
+}
@@ -0,0 +1,81 @@
+/**
+ * @file   threadpool_test.cpp
+ * @date   2026-10-16
+ * @brief  Test for threadpool.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Copyright (c) 2026, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "threadpool.h"
+// STL headers
+#include <set>
+#include <vector>
+// std headers
+#include <atomic>
+#include <mutex>
+#include <thread>
+// external library headers
+// other Linden headers
+#include "../test/lltut.h"
+#include "stringize.h"
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct threadpool_data
+    {
+    };
+    typedef test_group<threadpool_data> threadpool_group;
+    typedef threadpool_group::object object;
+    threadpool_group threadpoolgrp("threadpool");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("parallel_for without a pool");
+        std::vector<int> seen(100, 0);
+        LL::parallel_for("no such pool", seen.size(), [&seen](size_t i){ ++seen[i]; });
+        for (size_t i = 0; i < seen.size(); ++i)
+        {
+            ensure_equals(STRINGIZE("item " << i), seen[i], 1);
+        }
+        // nothing to do is fine too
+        LL::parallel_for("no such pool", 0, [](size_t){ fail("called with no items"); });
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("parallel_for on a pool");
+        LL::ThreadPool pool("parallel_for", 3);
+        pool.start();
+
+        for (size_t count : { 1, 2, 7, 1000 })
+        {
+            std::vector<std::atomic<int>> seen(count);
+            std::mutex mutex;
+            std::set<std::thread::id> threads;
+            LL::parallel_for("parallel_for", count,
+                             [&](size_t i)
+                             {
+                                 ++seen[i];
+                                 std::lock_guard<std::mutex> lock(mutex);
+                                 threads.insert(std::this_thread::get_id());
+                             });
+            for (size_t i = 0; i < count; ++i)
+            {
+                ensure_equals(STRINGIZE(count << " items, item " << i), seen[i].load(), 1);
+            }
+            ensure(STRINGIZE(count << " items ran on too many threads"), threads.size() <= llmin(count, size_t(4)));
+        }
+
+        pool.close();
+    }
+} // namespace tut
@@ -25,6 +25,10 @@
 
 #include <boost/fiber/algo/round_robin.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 /*****************************************************************************
 *   Custom fiber scheduler for worker threads
 *****************************************************************************/
@@ -205,3 +209,78 @@ size_t LL::ThreadPoolBase::getWidth(const std::string& name, size_t dft)
         return getConfiguredWidth(name, dft);
     }
 }
+
+/*****************************************************************************
+*   parallel_for()
+*****************************************************************************/
+namespace
+{
+    // Shared by the caller of parallel_for() and the helper tasks it posts.
+    // A helper that only starts after everything is done (the pool was busy)
+    // finds no index left and never touches mWork, which may be gone by then.
+    struct ParallelFor
+    {
+        ParallelFor(size_t count, const std::function<void(size_t)>& work):
+            mCount(count),
+            mWork(work)
+        {}
+
+        void run()
+        {
+            size_t done = 0;
+            for (size_t i = mNext++; i < mCount; i = mNext++)
+            {
+                mWork(i);
+                ++done;
+            }
+            if (done && (mDone += done) == mCount)
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mFinished.notify_all();
+            }
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mFinished.wait(lock, [this]{ return mDone == mCount; });
+        }
+
+        const size_t mCount;
+        const std::function<void(size_t)>& mWork;
+        std::atomic<size_t> mNext{ 0 };
+        std::atomic<size_t> mDone{ 0 };
+        std::mutex mMutex;
+        std::condition_variable mFinished;
+    };
+} // anonymous namespace
+
+void LL::parallel_for(const std::string& pool, size_t count,
+                      const std::function<void(size_t)>& work)
+{
+    if (! count)
+    {
+        return;
+    }
+
+    auto state{ std::make_shared<ParallelFor>(count, work) };
+
+    // one helper per pool thread, but no more than there are items the
+    // calling thread won't get to first
+    auto instance{ ThreadPoolBase::getInstance(pool) };
+    auto queue{ WorkQueue::getInstance(pool) };
+    if (instance && queue)
+    {
+        size_t helpers = std::min(instance->getWidth(), count - 1);
+        for (size_t i = 0; i < helpers; ++i)
+        {
+            if (! queue->post([state]{ state->run(); }))
+            {
+                break;
+            }
+        }
+    }
+
+    state->run();
+    state->wait();
+}
@@ -15,6 +15,7 @@
 
 #include "threadpool_fwd.h"
 #include "workqueue.h"
+#include <functional>               // std::function
 #include <memory>                   // std::unique_ptr
 #include <string>
 #include <thread>
@@ -136,6 +137,21 @@ namespace LL
     /// ThreadPool is shorthand for using the simpler WorkQueue
     using ThreadPool = ThreadPoolUsing<WorkQueue>;
 
+    /**
+     * parallel_for() calls work(i) for every i in [0, count) and returns once
+     * all those calls have returned. The calls are spread over the calling
+     * thread and the threads of the named ThreadPool: every thread takes the
+     * next index not yet taken until none are left, so a thread that finishes
+     * early picks up the work the others have not started.
+     *
+     * The calling thread takes part, so this completes even when the pool is
+     * busy, closed or does not exist (then everything runs on the caller).
+     * There is no ordering between the calls; work must be safe to run
+     * concurrently with itself and must not throw.
+     */
+    void parallel_for(const std::string& pool, size_t count,
+                      const std::function<void(size_t)>& work);
+
 } // namespace LL
 
 #endif /* ! defined(LL_THREADPOOL_H) */
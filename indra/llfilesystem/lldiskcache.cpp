@@ -36,6 +36,8 @@
 #include "lldir.h"
 #include <boost/filesystem.hpp>
 #include <chrono>
+#include <random>
+#include <unordered_set>
 
 #include "lldiskcache.h"
 
@@ -49,11 +51,65 @@
   */
 static const std::string CACHE_FILENAME_PREFIX("sl_cache");
 
+/**
+ * The name of the index journal inside the cache folder. Deliberately
+ * does not start with CACHE_FILENAME_PREFIX so that the journal is never
+ * mistaken for a cached asset by the directory scans below.
+ */
+static const std::string JOURNAL_FILENAME("index.journal");
+
+/**
+ * Journal file header - bump the version if the layout changes and old
+ * journals will be discarded (and the index rebuilt) at startup:
+ *   magic (4) | version (4) | generation (4) | reserved (4)
+ * The generation is picked at random every time the journal is compacted
+ * so that an instance sharing the cache can tell that the file it appends
+ * to was replaced by another instance.
+ */
+static const U32 JOURNAL_MAGIC = 0x43444c53; // 'SLDC'
+static const U32 JOURNAL_VERSION = 2;
+static const size_t JOURNAL_HEADER_SIZE = 16;
+
+/**
+ * Each journal record is a fixed size so that a torn record at the end
+ * of the journal (crash mid-write) is easy to detect and ignore:
+ *   op (1) | asset type (1) | reserved (6) | id (16) | size (8) | time (8)
+ */
+static const size_t JOURNAL_RECORD_SIZE = 40;
+
+/**
+ * Compact the journal once it holds this many times more records than
+ * there are entries in the index (plus a minimum so small caches are not
+ * rewritten constantly)
+ */
+static const U32 JOURNAL_COMPACT_RATIO = 4;
+static const U32 JOURNAL_COMPACT_MIN = 4096;
+
+/**
+ * Reads update the access time in the index every time but only append
+ * a journal record if the previous one is older than this. Purge order
+ * after a restart is therefore accurate to within this many seconds.
+ */
+static const std::time_t JOURNAL_ACCESS_THRESHOLD = 10 * 60;
+
+/**
+ * Size of the stdio buffer of the journal we append to. A whole number
+ * of records so that a flush never ends in the middle of one, which
+ * keeps the records of instances appending to the same journal apart.
+ */
+static const size_t JOURNAL_BUFFER_SIZE = JOURNAL_RECORD_SIZE * 100;
+
 std::string LLDiskCache::sCacheDir;
 
 LLDiskCache::LLDiskCache(const std::string& cache_dir,
                          const uintmax_t max_size_bytes,
                          const bool enable_cache_debug_info) :
+    mTotalBytes(0),
+    mJournal(nullptr),
+    mJournalBuffer(JOURNAL_BUFFER_SIZE),
+    mJournalRecords(0),
+    mJournalOffset(0),
+    mJournalGeneration(0),
     mMaxSizeBytes(max_size_bytes),
     mEnableCacheDebugInfo(enable_cache_debug_info)
 {
@@ -61,8 +117,43 @@ LLDiskCache::LLDiskCache(const std::string& cache_dir,
     LLFile::mkdir(cache_dir);
 }
 
-// WARNING: purge() is called by LLPurgeDiskCacheThread. As such it must
-// NOT touch any LLDiskCache data without introducing and locking a mutex!
+void LLDiskCache::initSingleton()
+{
+    LLMutexLock lock(&mIndexMutex);
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    bool clean = loadJournal();
+    if (!clean)
+    {
+        // No journal, an old format or the last session did not shut
+        // down cleanly - the files on disk are the only source of truth
+        LL_INFOS() << "Disk cache index was not closed cleanly, rebuilding it from " << sCacheDir << LL_ENDL;
+        rebuildIndexFromDir();
+    }
+
+    // Always start the session with a compact journal. If this fails we
+    // carry on without one and the next startup will rescan the folder.
+    compactJournal();
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+    LL_INFOS() << "Disk cache index has " << mIndex.size() << " files, " << mTotalBytes << " bytes ("
+               << (clean ? "journal" : "rescan") << ", " << execute_time << " ms)" << LL_ENDL;
+}
+
+void LLDiskCache::cleanupSingleton()
+{
+    LLMutexLock lock(&mIndexMutex);
+    closeJournal();
+}
+
+// WARNING: purge() is called by LLPurgeDiskCacheThread. Any access to the
+// index must hold mIndexMutex.
+
+// The index only decides which files to delete; the files themselves are
+// deleted after the lock is released so that readers and writers on other
+// threads are never blocked behind filesystem work.
 
 // Interaction through the filesystem itself should be safe. Let’s say thread
 // A is accessing the cache file for reading/writing and thread B is trimming
@@ -86,9 +177,10 @@ LLDiskCache::LLDiskCache(const std::string& cache_dir,
 // about to get deleted. boost::filesystem::remove does whatever it is doing
 // before actually deleting the file. If A opens the file before the file is
 // actually gone, the OS call from B to delete the file will fail since the OS
-// will prevent this. B continues with the next file. If the file is already
-// gone before A finally gets to open it, this operation will fail and the
-// asset will have to be re-requested.
+// will prevent this. B continues with the next file and puts the entry back
+// in the index so it is considered again by the next purge. If the file is
+// already gone before A finally gets to open it, this operation will fail and
+// the asset will have to be re-requested.
 void LLDiskCache::purge()
 {
     if (mEnableCacheDebugInfo)
@@ -96,87 +188,89 @@ void LLDiskCache::purge()
         LL_INFOS() << "Total dir size before purge is " << dirFileSize(sCacheDir) << LL_ENDL;
     }
 
-    boost::system::error_code ec;
     auto start_time = std::chrono::high_resolution_clock::now();
 
-    typedef std::pair<std::time_t, std::pair<uintmax_t, std::string>> file_info_t;
-    std::vector<file_info_t> file_info;
-
-#if LL_WINDOWS
-    std::wstring cache_path(utf8str_to_utf16str(sCacheDir));
-#else
-    std::string cache_path(sCacheDir);
-#endif
-    if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
+    // Another viewer instance sharing the cache journals the files it
+    // writes and deletes too, so replaying its records keeps the index
+    // complete. The folder is only scanned if the journal is gone or
+    // can not be read.
+    bool rescan = false;
+    const std::time_t now = std::time(nullptr);
     {
-        boost::filesystem::directory_iterator iter(cache_path, ec);
-        while (iter != boost::filesystem::directory_iterator() && !ec.failed())
-        {
-            if (boost::filesystem::is_regular_file(*iter, ec) && !ec.failed())
-            {
-#if LL_WINDOWS
-                if (utf16str_to_utf8str((*iter).path().wstring()).find(CACHE_FILENAME_PREFIX) != std::string::npos)
-#else
-                if ((*iter).path().string().find(CACHE_FILENAME_PREFIX) != std::string::npos)
-#endif
-                {
-                    uintmax_t file_size = boost::filesystem::file_size(*iter, ec);
-                    if (ec.failed())
-                    {
-                        continue;
-                    }
-#if LL_WINDOWS
-                    const std::string file_path = utf16str_to_utf8str((*iter).path().wstring());
-#else
-                    const std::string file_path = (*iter).path().string();
-#endif
-                    const std::time_t file_time = boost::filesystem::last_write_time(*iter, ec);
-                    if (ec.failed())
-                    {
-                        continue;
-                    }
-
-                    file_info.push_back(file_info_t(file_time, { file_size, file_path }));
-                }
-            }
-            iter.increment(ec);
-        }
+        LLMutexLock lock(&mIndexMutex);
+        rescan = !mergeJournal();
     }
-
-    std::sort(file_info.begin(), file_info.end(), [](file_info_t& x, file_info_t& y)
+    if (rescan)
     {
-        return x.first > y.first;
-    });
-
-    LL_INFOS() << "Purging cache to a maximum of " << mMaxSizeBytes << " bytes" << LL_ENDL;
+        scanned_files_t files;
+        scanCacheDir(files);
+
+        LLMutexLock lock(&mIndexMutex);
+        reconcileIndex(files, now);
+        compactJournal();
+        LL_INFOS() << "Disk cache index reconciled with " << files.size() << " files in " << sCacheDir
+                   << ", index has " << mIndex.size() << " files, " << mTotalBytes << " bytes" << LL_ENDL;
+    }
 
-    std::vector<bool> file_removed;
-    if (mEnableCacheDebugInfo)
+    struct purge_info_t
     {
-        file_removed.reserve(file_info.size());
-    }
+        LLUUID mID;
+        IndexEntry mEntry;
+    };
+    std::vector<purge_info_t> file_info;
+    size_t num_files = 0;
     uintmax_t file_size_total = 0;
-    for (file_info_t& entry : file_info)
+
     {
-        file_size_total += entry.second.first;
+        LLMutexLock lock(&mIndexMutex);
 
-        bool should_remove = file_size_total > mMaxSizeBytes;
-        if (mEnableCacheDebugInfo)
+        num_files = mIndex.size();
+        while (mTotalBytes > mMaxSizeBytes && !mLRU.empty())
         {
-            file_removed.push_back(should_remove);
+            const LLUUID id = mLRU.begin()->second;
+            index_map_t::const_iterator it = mIndex.find(id);
+            llassert(it != mIndex.end());
+            file_info.push_back({ id, it->second });
+            removeEntry(id);
         }
-        if (should_remove)
+        file_size_total = mTotalBytes;
+
+        if (mJournalRecords > mIndex.size() * JOURNAL_COMPACT_RATIO + JOURNAL_COMPACT_MIN)
         {
+            compactJournal();
+        }
+        else if (mJournal)
+        {
+            fflush(mJournal);
+        }
+    }
+
+    LL_INFOS() << "Purging cache to a maximum of " << mMaxSizeBytes << " bytes" << LL_ENDL;
+
+    boost::system::error_code ec;
+    std::vector<bool> file_removed;
+    file_removed.reserve(file_info.size());
+    for (const purge_info_t& entry : file_info)
+    {
+        const std::string file_path = metaDataToFilepath(entry.mID, entry.mEntry.mType);
 #if LL_WINDOWS
-            boost::filesystem::remove(utf8str_to_utf16str(entry.second.second), ec);
+        boost::filesystem::remove(utf8str_to_utf16str(file_path), ec);
 #else
-            boost::filesystem::remove(entry.second.second, ec);
+        boost::filesystem::remove(file_path, ec);
 #endif
-            if (ec.failed())
-            {
+        file_removed.push_back(!ec.failed());
+        if (ec.failed())
+        {
 #if !LL_WINDOWS
-                LL_WARNS() << "Failed to delete cache file " << entry.second.second << ": " << ec.message() << LL_ENDL;
+            LL_WARNS() << "Failed to delete cache file " << file_path << ": " << ec.message() << LL_ENDL;
 #endif
+            // Most likely in use - put it back unless somebody rewrote it
+            // in the meantime, in which case the new entry is correct
+            LLMutexLock lock(&mIndexMutex);
+            if (mIndex.find(entry.mID) == mIndex.end())
+            {
+                setEntry(entry.mID, entry.mEntry.mType, entry.mEntry.mSize, entry.mEntry.mAccessTime);
+                appendJournal(JOURNAL_WRITE, entry.mID, entry.mEntry.mType, entry.mEntry.mSize, entry.mEntry.mAccessTime);
             }
         }
     }
@@ -190,23 +284,23 @@ void LLDiskCache::purge()
         // Logging thousands of file results can take hundreds of milliseconds
         for (size_t i = 0; i < file_info.size(); ++i)
         {
-            const file_info_t& entry = file_info[i];
-            const bool removed = file_removed[i];
-            const std::string action = removed ? "DELETE:" : "KEEP:";
+            const purge_info_t& entry = file_info[i];
+            const std::string action = file_removed[i] ? "DELETE:" : "FAILED:";
 
             // have to do this because of LL_INFO/LL_END weirdness
             std::ostringstream line;
 
             line << action << "  ";
-            line << entry.first << "  ";
-            line << entry.second.first << "  ";
-            line << entry.second.second;
+            line << entry.mEntry.mAccessTime << "  ";
+            line << entry.mEntry.mSize << "  ";
+            line << entry.mID;
             line << " (" << file_size_total << "/" << mMaxSizeBytes << ")";
             LL_INFOS() << line.str() << LL_ENDL;
         }
 
         LL_INFOS() << "Total dir size after purge is " << dirFileSize(sCacheDir) << LL_ENDL;
-        LL_INFOS() << "Cache purge took " << execute_time << " ms to execute for " << file_info.size() << " files" << LL_ENDL;
+        LL_INFOS() << "Cache purge took " << execute_time << " ms to execute for " << num_files << " files, "
+                   << file_info.size() << " evicted" << LL_ENDL;
     }
 }
 
@@ -219,8 +313,14 @@ const std::string LLDiskCache::getCacheInfo()
 {
     std::ostringstream cache_info;
 
+    uintmax_t total_bytes = 0;
+    {
+        LLMutexLock lock(&mIndexMutex);
+        total_bytes = mTotalBytes;
+    }
+
     F32 max_in_mb = (F32)mMaxSizeBytes / (1024.0f * 1024.0f);
-    F32 percent_used = ((F32)dirFileSize(sCacheDir) / (F32)mMaxSizeBytes) * 100.0f;
+    F32 percent_used = ((F32)total_bytes / (F32)mMaxSizeBytes) * 100.0f;
 
     cache_info << std::fixed;
     cache_info << std::setprecision(1);
@@ -269,6 +369,10 @@ void LLDiskCache::clearCache()
             iter.increment(ec);
         }
     }
+
+    LLMutexLock lock(&mIndexMutex);
+    clearIndex();
+    compactJournal();
 }
 
 void LLDiskCache::removeOldVFSFiles()
@@ -358,6 +462,541 @@ uintmax_t LLDiskCache::dirFileSize(const std::string& dir)
     return total_file_size;
 }
 
+// static
+void LLDiskCache::recordFileWrite(const LLUUID& id, LLAssetType::EType at, uintmax_t size)
+{
+    if (!instanceExists())
+    {
+        return;
+    }
+    LLDiskCache& self = instance();
+    const std::time_t now = std::time(nullptr);
+
+    LLMutexLock lock(&self.mIndexMutex);
+    self.setEntry(id, at, size, now);
+    self.appendJournal(JOURNAL_WRITE, id, at, size, now);
+}
+
+// static
+void LLDiskCache::recordFileAccess(const LLUUID& id, LLAssetType::EType at)
+{
+    if (!instanceExists())
+    {
+        return;
+    }
+    LLDiskCache& self = instance();
+    const std::time_t now = std::time(nullptr);
+
+    {
+        LLMutexLock lock(&self.mIndexMutex);
+        index_map_t::iterator it = self.mIndex.find(id);
+        if (it != self.mIndex.end())
+        {
+            const std::time_t last_access = it->second.mAccessTime;
+            self.touchEntry(id, now);
+            if (now - last_access > JOURNAL_ACCESS_THRESHOLD)
+            {
+                self.appendJournal(JOURNAL_ACCESS, id, at, 0, now);
+            }
+            return;
+        }
+    }
+
+    // Written by something that bypassed LLFileSystem - pick it up now so
+    // the purge knows about it. The file is looked at without the lock.
+    std::string file_path = metaDataToFilepath(id, at);
+    boost::system::error_code ec;
+#if LL_WINDOWS
+    uintmax_t file_size = boost::filesystem::file_size(utf8str_to_utf16str(file_path), ec);
+#else
+    uintmax_t file_size = boost::filesystem::file_size(file_path, ec);
+#endif
+    if (ec.failed())
+    {
+        return;
+    }
+
+    LLMutexLock lock(&self.mIndexMutex);
+    if (self.mIndex.find(id) == self.mIndex.end())
+    {
+        self.setEntry(id, at, file_size, now);
+        self.appendJournal(JOURNAL_WRITE, id, at, file_size, now);
+    }
+}
+
+// static
+void LLDiskCache::recordFileRemove(const LLUUID& id)
+{
+    if (!instanceExists())
+    {
+        return;
+    }
+    LLDiskCache& self = instance();
+
+    LLMutexLock lock(&self.mIndexMutex);
+    self.removeEntry(id);
+}
+
+// static
+void LLDiskCache::recordFileRename(const LLUUID& old_id, const LLUUID& new_id, LLAssetType::EType new_at)
+{
+    if (!instanceExists())
+    {
+        return;
+    }
+    LLDiskCache& self = instance();
+    const std::time_t now = std::time(nullptr);
+
+    LLMutexLock lock(&self.mIndexMutex);
+    index_map_t::const_iterator it = self.mIndex.find(old_id);
+    if (it == self.mIndex.end())
+    {
+        return;
+    }
+    const uintmax_t size = it->second.mSize;
+    self.removeEntry(old_id);
+    self.setEntry(new_id, new_at, size, now);
+    self.appendJournal(JOURNAL_WRITE, new_id, new_at, size, now);
+}
+
+void LLDiskCache::setEntry(const LLUUID& id, LLAssetType::EType at, uintmax_t size, std::time_t access_time)
+{
+    index_map_t::iterator it = mIndex.find(id);
+    if (it != mIndex.end())
+    {
+        mLRU.erase(std::make_pair(it->second.mAccessTime, id));
+        mTotalBytes -= it->second.mSize;
+        it->second = { at, size, access_time };
+    }
+    else
+    {
+        mIndex.emplace(id, IndexEntry{ at, size, access_time });
+    }
+    mLRU.emplace(access_time, id);
+    mTotalBytes += size;
+}
+
+void LLDiskCache::touchEntry(const LLUUID& id, std::time_t access_time)
+{
+    index_map_t::iterator it = mIndex.find(id);
+    if (it != mIndex.end() && it->second.mAccessTime != access_time)
+    {
+        mLRU.erase(std::make_pair(it->second.mAccessTime, id));
+        it->second.mAccessTime = access_time;
+        mLRU.emplace(access_time, id);
+    }
+}
+
+bool LLDiskCache::removeEntry(const LLUUID& id)
+{
+    index_map_t::iterator it = mIndex.find(id);
+    if (it == mIndex.end())
+    {
+        return false;
+    }
+    mLRU.erase(std::make_pair(it->second.mAccessTime, id));
+    mTotalBytes -= it->second.mSize;
+    appendJournal(JOURNAL_REMOVE, id, it->second.mType, 0, 0);
+    mIndex.erase(it);
+    return true;
+}
+
+void LLDiskCache::clearIndex()
+{
+    mIndex.clear();
+    mLRU.clear();
+    mTotalBytes = 0;
+}
+
+std::string LLDiskCache::getJournalPath() const
+{
+    return sCacheDir + gDirUtilp->getDirDelimiter() + JOURNAL_FILENAME;
+}
+
+// static
+bool LLDiskCache::readJournalHeader(LLFILE* journal, U32& generation)
+{
+    U32 header[JOURNAL_HEADER_SIZE / sizeof(U32)] = { 0 };
+    if (fread(header, sizeof(header), 1, journal) != 1 ||
+        header[0] != JOURNAL_MAGIC || header[1] != JOURNAL_VERSION || header[2] == 0)
+    {
+        return false;
+    }
+    generation = header[2];
+    return true;
+}
+
+bool LLDiskCache::loadJournal()
+{
+    clearIndex();
+    mJournalGeneration = 0;
+    mJournalOffset = 0;
+    mJournalRecords = 0;
+
+    LLUniqueFile journal(LLFile::fopen(getJournalPath(), "rb"));
+    if (!journal)
+    {
+        return false;
+    }
+
+    U32 generation = 0;
+    if (!readJournalHeader(journal, generation))
+    {
+        LL_WARNS() << "Ignoring disk cache journal with unknown format" << LL_ENDL;
+        return false;
+    }
+    mJournalGeneration = generation;
+    mJournalOffset = JOURNAL_HEADER_SIZE;
+
+    U8 last_op = 0;
+    if (!replayJournal(journal, last_op, nullptr))
+    {
+        LL_WARNS() << "Corrupt disk cache journal record" << LL_ENDL;
+        return false;
+    }
+
+    // Anything after the close marker, or a torn record at the end,
+    // means the journal is not a complete picture of the folder
+    llstat stat_data;
+    return last_op == JOURNAL_CLOSE
+        && LLFile::stat(getJournalPath(), &stat_data) == 0
+        && (uintmax_t)stat_data.st_size == mJournalOffset;
+}
+
+bool LLDiskCache::replayJournal(LLFILE* journal, U8& last_op, std::unordered_set<LLUUID>* written)
+{
+    // The records are applied to the index only - nothing is appended
+    // to the journal for them
+    LLFILE* appending = mJournal;
+    mJournal = nullptr;
+
+    bool success = true;
+    U8 record[JOURNAL_RECORD_SIZE];
+    while (success && fread(record, JOURNAL_RECORD_SIZE, 1, journal) == 1)
+    {
+        LLUUID id;
+        U64 size;
+        S64 time;
+        memcpy(id.mData, record + 8, UUID_BYTES);
+        memcpy(&size, record + 24, sizeof(size));
+        memcpy(&time, record + 32, sizeof(time));
+        const LLAssetType::EType at = (LLAssetType::EType)(S8)record[1];
+
+        // A record can be replayed again later (merging reads back this
+        // instance's own appends) so access times never move backwards
+        index_map_t::const_iterator it = mIndex.find(id);
+        switch (record[0])
+        {
+            case JOURNAL_WRITE:
+                setEntry(id, at, (uintmax_t)size,
+                         it != mIndex.end() ? llmax(it->second.mAccessTime, (std::time_t)time) : (std::time_t)time);
+                if (written)
+                {
+                    written->insert(id);
+                }
+                break;
+            case JOURNAL_ACCESS:
+                if (it != mIndex.end() && it->second.mAccessTime < (std::time_t)time)
+                {
+                    touchEntry(id, (std::time_t)time);
+                }
+                break;
+            case JOURNAL_REMOVE:
+                removeEntry(id);
+                break;
+            case JOURNAL_CLOSE:
+                break;
+            default:
+                success = false;
+                continue;
+        }
+        last_op = record[0];
+        mJournalOffset += JOURNAL_RECORD_SIZE;
+    }
+
+    // A torn record at the end is left for the next merge: it may be
+    // another instance's append in progress
+    mJournalRecords = (U32)((mJournalOffset - JOURNAL_HEADER_SIZE) / JOURNAL_RECORD_SIZE);
+    mJournal = appending;
+    return success;
+}
+
+bool LLDiskCache::mergeJournal()
+{
+    if (!mJournal)
+    {
+        // Journaling failed this session, there is nothing to merge into
+        return true;
+    }
+    fflush(mJournal);
+
+    const std::string journal_path = getJournalPath();
+    LLUniqueFile journal(LLFile::fopen(journal_path, "rb"));
+    U32 generation = 0;
+    if (!journal || !readJournalHeader(journal, generation))
+    {
+        LL_WARNS() << "Disk cache journal " << journal_path << " is missing or unreadable" << LL_ENDL;
+        return false;
+    }
+
+    U8 last_op = 0;
+    if (generation == mJournalGeneration)
+    {
+        // Still the journal we append to - replay what was appended since
+        // the last merge, by us or by other instances
+        return fseek(journal, (long)mJournalOffset, SEEK_SET) == 0
+            && replayJournal(journal, last_op, nullptr);
+    }
+
+    // Another instance compacted the journal. Replay its snapshot and
+    // what was appended since, then append to the new file from now on
+    // and add the entries only this instance knows of.
+    std::unordered_set<LLUUID> written;
+    mJournalOffset = JOURNAL_HEADER_SIZE;
+    if (!replayJournal(journal, last_op, &written))
+    {
+        return false;
+    }
+
+    LLFile::close(mJournal);
+    mJournal = openJournal(journal_path);
+    if (!mJournal)
+    {
+        return false;
+    }
+    mJournalGeneration = generation;
+
+    for (const index_map_t::value_type& entry : mIndex)
+    {
+        if (written.find(entry.first) == written.end())
+        {
+            appendJournal(JOURNAL_WRITE, entry.first, entry.second.mType, entry.second.mSize, entry.second.mAccessTime);
+        }
+    }
+    return true;
+}
+
+LLFILE* LLDiskCache::openJournal(const std::string& journal_path)
+{
+    LLFILE* journal = LLFile::fopen(journal_path, "ab");
+    if (journal)
+    {
+        setvbuf(journal, mJournalBuffer.data(), _IOFBF, mJournalBuffer.size());
+    }
+    return journal;
+}
+
+void LLDiskCache::rebuildIndexFromDir()
+{
+    clearIndex();
+
+    scanned_files_t files;
+    scanCacheDir(files);
+    for (const ScannedFile& file : files)
+    {
+        setEntry(file.mID, LLAssetType::AT_NONE, file.mSize, file.mWriteTime);
+    }
+}
+
+// static
+void LLDiskCache::scanCacheDir(scanned_files_t& files)
+{
+    // sl_cache_<uuid>_0.asset - see metaDataToFilepath()
+    const std::string id_prefix = CACHE_FILENAME_PREFIX + "_";
+
+    boost::system::error_code ec;
+#if LL_WINDOWS
+    std::wstring cache_path(utf8str_to_utf16str(sCacheDir));
+#else
+    std::string cache_path(sCacheDir);
+#endif
+    if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
+    {
+        boost::filesystem::directory_iterator iter(cache_path, ec);
+        while (iter != boost::filesystem::directory_iterator() && !ec.failed())
+        {
+            if (boost::filesystem::is_regular_file(*iter, ec) && !ec.failed())
+            {
+#if LL_WINDOWS
+                const std::string file_name = utf16str_to_utf8str((*iter).path().filename().wstring());
+#else
+                const std::string file_name = (*iter).path().filename().string();
+#endif
+                LLUUID id;
+                if (file_name.compare(0, id_prefix.size(), id_prefix) == 0 &&
+                    id.set(file_name.substr(id_prefix.size(), UUID_STR_LENGTH - 1), false))
+                {
+                    uintmax_t file_size = boost::filesystem::file_size(*iter, ec);
+                    std::time_t file_time = 0;
+                    if (!ec.failed())
+                    {
+                        file_time = boost::filesystem::last_write_time(*iter, ec);
+                    }
+                    if (!ec.failed())
+                    {
+                        files.push_back({ id, file_size, file_time });
+                    }
+                }
+            }
+            iter.increment(ec);
+        }
+    }
+}
+
+void LLDiskCache::reconcileIndex(const scanned_files_t& files, std::time_t scan_time)
+{
+    std::unordered_set<LLUUID> on_disk;
+    on_disk.reserve(files.size());
+    for (const ScannedFile& file : files)
+    {
+        on_disk.insert(file.mID);
+        index_map_t::const_iterator it = mIndex.find(file.mID);
+        if (it == mIndex.end())
+        {
+            setEntry(file.mID, LLAssetType::AT_NONE, file.mSize, file.mWriteTime);
+            appendJournal(JOURNAL_WRITE, file.mID, LLAssetType::AT_NONE, file.mSize, file.mWriteTime);
+        }
+        else if (it->second.mSize != file.mSize)
+        {
+            // rewritten by another instance
+            const IndexEntry entry = it->second;
+            const std::time_t access_time = llmax(entry.mAccessTime, file.mWriteTime);
+            setEntry(file.mID, entry.mType, file.mSize, access_time);
+            appendJournal(JOURNAL_WRITE, file.mID, entry.mType, file.mSize, access_time);
+        }
+    }
+
+    // Entries newer than the scan may be files it did not get to see
+    std::vector<LLUUID> gone;
+    for (const index_map_t::value_type& entry : mIndex)
+    {
+        if (entry.second.mAccessTime < scan_time && on_disk.find(entry.first) == on_disk.end())
+        {
+            gone.push_back(entry.first);
+        }
+    }
+    for (const LLUUID& id : gone)
+    {
+        removeEntry(id);
+    }
+}
+
+bool LLDiskCache::compactJournal()
+{
+    const std::string journal_path = getJournalPath();
+    const std::string temp_path = journal_path + ".tmp";
+
+    LLFILE* temp = LLFile::fopen(temp_path, "wb");
+    if (!temp)
+    {
+        LL_WARNS() << "Unable to create disk cache journal " << temp_path << LL_ENDL;
+        return false;
+    }
+
+    U32 generation = 0;
+    std::random_device random;
+    while (generation == 0 || generation == mJournalGeneration)
+    {
+        generation = random();
+    }
+
+    const U32 header[JOURNAL_HEADER_SIZE / sizeof(U32)] = { JOURNAL_MAGIC, JOURNAL_VERSION, generation, 0 };
+    bool success = fwrite(header, sizeof(header), 1, temp) == 1;
+
+    // Oldest first so that replaying the snapshot rebuilds the same LRU order
+    LLFILE* appending = mJournal;
+    mJournal = temp;
+    for (const lru_set_t::value_type& lru : mLRU)
+    {
+        const IndexEntry& entry = mIndex[lru.second];
+        appendJournal(JOURNAL_WRITE, lru.second, entry.mType, entry.mSize, entry.mAccessTime);
+    }
+
+    if (mJournal)
+    {
+        success = !ferror(temp) && success;
+        success = LLFile::close(temp) == 0 && success;
+    }
+    else
+    {
+        // appendJournal() closes the file when a write fails
+        success = false;
+    }
+    mJournal = appending;
+
+    if (success)
+    {
+        // Everything we appended is in the snapshot. No close marker: if the
+        // journal can not be reopened the next startup has to rescan.
+        if (mJournal)
+        {
+            LLFile::close(mJournal);
+            mJournal = nullptr;
+        }
+        success = LLFile::replace(temp_path, journal_path) == 0;
+    }
+
+    if (!success)
+    {
+        LL_WARNS() << "Unable to write disk cache journal " << journal_path << LL_ENDL;
+        LLFile::remove(temp_path, ENOENT);
+        // The old journal is still there, carry on appending to it
+        if (!mJournal && mJournalGeneration != 0)
+        {
+            mJournal = openJournal(journal_path);
+        }
+        return false;
+    }
+
+    mJournalGeneration = generation;
+    mJournalOffset = JOURNAL_HEADER_SIZE + mIndex.size() * JOURNAL_RECORD_SIZE;
+    mJournalRecords = (U32)mIndex.size();
+    mJournal = openJournal(journal_path);
+    return mJournal != nullptr;
+}
+
+void LLDiskCache::appendJournal(EJournalOp op, const LLUUID& id, LLAssetType::EType at, uintmax_t size, std::time_t time)
+{
+    if (!mJournal)
+    {
+        return;
+    }
+
+    U8 record[JOURNAL_RECORD_SIZE] = { 0 };
+    const U64 size64 = (U64)size;
+    const S64 time64 = (S64)time;
+    record[0] = op;
+    record[1] = (U8)(S8)at;
+    memcpy(record + 8, id.mData, UUID_BYTES);
+    memcpy(record + 24, &size64, sizeof(size64));
+    memcpy(record + 32, &time64, sizeof(time64));
+
+    if (fwrite(record, JOURNAL_RECORD_SIZE, 1, mJournal) == 1)
+    {
+        ++mJournalRecords;
+    }
+    else
+    {
+        // Stop journaling for this session - the missing close marker
+        // will force a rescan at the next startup
+        LLFile::close(mJournal);
+        mJournal = nullptr;
+    }
+}
+
+void LLDiskCache::closeJournal()
+{
+    if (mJournal)
+    {
+        appendJournal(JOURNAL_CLOSE, LLUUID::null, LLAssetType::AT_NONE, 0, 0);
+        if (mJournal)
+        {
+            LLFile::close(mJournal);
+            mJournal = nullptr;
+        }
+    }
+}
+
 LLPurgeDiskCacheThread::LLPurgeDiskCacheThread() :
     LLThread("PurgeDiskCacheThread", nullptr)
 {
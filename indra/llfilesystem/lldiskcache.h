@@ -24,10 +24,28 @@
                     identify this as a Viewer asset file
  * 2/ The time of last access for a file can be updated instantly
  *    for file reads and automatically as part of the file writes.
- * 3/ The purge algorithm collects a list of all files in the
- *    directory, sorts them by date of last access (write) and then
- *    deletes any files based on age until the total size of all
- *    the files is less than the maximum size specified.
+ * 3/ The metadata for every file in the cache (ID, asset type,
+ *    size and time of last access) is also kept in an in-memory
+ *    index that LLFileSystem keeps up to date as files are written,
+ *    read, renamed and removed. Every change to the index is also
+ *    appended to a small binary journal file in the cache folder so
+ *    the index can be restored at startup without scanning the cache.
+ *    The journal is compacted (rewritten as a snapshot of the index)
+ *    at startup and whenever it grows too large relative to the index.
+ *    A clean shutdown appends a marker to the journal; if the marker is
+ *    missing at startup (crash, or another viewer instance was using the
+ *    cache), the index is reconciled with a single directory scan.
+ *    Viewer instances sharing the cache append to the same journal, and
+ *    before each purge the records the other instances appended (or
+ *    the snapshot one of them compacted the journal to) are replayed
+ *    into the index, so files written by other instances are purged
+ *    too. The folder is only scanned again if the journal is gone or
+ *    can not be read.
+ * 3a/ The purge algorithm walks the index in order of last access
+ *    and deletes the oldest files until the total size of all the
+ *    files is less than the maximum size specified. This costs time
+ *    in proportion to the number of files evicted rather than the
+ *    number of files in the cache.
  * 4/ An LLSingleton idiom is used since there will only ever be
  *    a single cache and we want to access it from numerous places.
  * 5/ Performance on my modest system seems very acceptable. For
@@ -63,6 +81,15 @@
 #define _LLDISKCACHE
 
 #include "llsingleton.h"
+#include "llmutex.h"
+#include "lluuid.h"
+#include "llassettype.h"
+
+#include <ctime>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class LLDiskCache :
     public LLParamSingleton<LLDiskCache>
@@ -96,6 +123,18 @@ class LLDiskCache :
 
         virtual ~LLDiskCache() = default;
 
+        /**
+         * Restore the index from the journal (or rebuild it from the cache
+         * folder if the journal is missing or was not closed cleanly) and
+         * open the journal for appending.
+         */
+        void initSingleton() override;
+
+        /**
+         * Append the clean shutdown marker and close the journal.
+         */
+        void cleanupSingleton() override;
+
     public:
         /**
          * Construct a filename and path to it based on the file meta data
@@ -133,7 +172,105 @@ class LLDiskCache :
 
         void removeOldVFSFiles();
 
+        /**
+         * Index maintenance hooks called by LLFileSystem. These are static
+         * and do nothing if the disk cache singleton has not been created
+         * (tests, tools) so callers need not check. They are thread safe.
+         */
+        static void recordFileWrite(const LLUUID& id, LLAssetType::EType at, uintmax_t size);
+        static void recordFileAccess(const LLUUID& id, LLAssetType::EType at);
+        static void recordFileRemove(const LLUUID& id);
+        static void recordFileRename(const LLUUID& old_id, const LLUUID& new_id, LLAssetType::EType new_at);
+
     private:
+        /**
+         * The metadata we keep for every file in the cache. The file
+         * path can be rebuilt from the ID (see metaDataToFilepath()).
+         */
+        struct IndexEntry
+        {
+            LLAssetType::EType mType;
+            uintmax_t mSize;
+            std::time_t mAccessTime;
+        };
+
+        typedef std::unordered_map<LLUUID, IndexEntry> index_map_t;
+        typedef std::set<std::pair<std::time_t, LLUUID>> lru_set_t;
+
+        /**
+         * Journal record operations. Values are written to disk so
+         * do not renumber them.
+         */
+        enum EJournalOp : U8
+        {
+            JOURNAL_WRITE  = 1,
+            JOURNAL_ACCESS = 2,
+            JOURNAL_REMOVE = 3,
+            JOURNAL_CLOSE  = 4
+        };
+
+        /**
+         * Index helpers - all of these expect mIndexMutex to be held.
+         */
+        void setEntry(const LLUUID& id, LLAssetType::EType at, uintmax_t size, std::time_t access_time);
+        void touchEntry(const LLUUID& id, std::time_t access_time);
+        bool removeEntry(const LLUUID& id);
+        void clearIndex();
+
+        /**
+         * A cache file found by scanCacheDir()
+         */
+        struct ScannedFile
+        {
+            LLUUID mID;
+            uintmax_t mSize;
+            std::time_t mWriteTime;
+        };
+        typedef std::vector<ScannedFile> scanned_files_t;
+
+        /**
+         * List the cache files in the cache folder. Touches only the
+         * filesystem so it is called without mIndexMutex held.
+         */
+        static void scanCacheDir(scanned_files_t& files);
+
+        /**
+         * Bring the index in line with a scan of the cache folder that
+         * started at scan_time: files the index does not know of are
+         * added and entries older than the scan whose file is gone are
+         * dropped. Expects mIndexMutex to be held.
+         */
+        void reconcileIndex(const scanned_files_t& files, std::time_t scan_time);
+
+        /**
+         * Journal helpers - all of these expect mIndexMutex to be held.
+         */
+        bool loadJournal();
+        void rebuildIndexFromDir();
+        bool compactJournal();
+        void appendJournal(EJournalOp op, const LLUUID& id, LLAssetType::EType at, uintmax_t size, std::time_t time);
+        void closeJournal();
+        std::string getJournalPath() const;
+        LLFILE* openJournal(const std::string& journal_path);
+        static bool readJournalHeader(LLFILE* journal, U32& generation);
+
+        /**
+         * Apply the journal records from the current position of journal
+         * to the end to the index, advancing mJournalOffset past each one.
+         * The ids of the entries written are added to written if it is not
+         * null. Returns false if a record is corrupt.
+         */
+        bool replayJournal(LLFILE* journal, U8& last_op, std::unordered_set<LLUUID>* written);
+
+        /**
+         * Replay what other viewer instances sharing the cache have added
+         * to the journal since the last merge. Returns false if the
+         * journal is missing or can not be read, in which case only a
+         * scan of the folder can bring the index up to date.
+         * Expects mIndexMutex to be held.
+         */
+        bool mergeJournal();
+
         /**
          * Utility function to gather the total size the files in a given
          * directory. Primarily used here to determine the directory size
@@ -142,6 +279,60 @@ class LLDiskCache :
         uintmax_t dirFileSize(const std::string& dir);
 
     private:
+        /**
+         * Guards the index, the LRU ordering and the journal. Held only
+         * while the in-memory structures are updated - never while files
+         * in the cache are being read, written or deleted.
+         */
+        LLMutex mIndexMutex;
+
+        /**
+         * Metadata for every file in the cache, keyed by asset ID
+         */
+        index_map_t mIndex;
+
+        /**
+         * (last access time, ID) for every entry in mIndex. The oldest
+         * entries are at the front which is where the purge starts.
+         */
+        lru_set_t mLRU;
+
+        /**
+         * The sum of the sizes of all the files in mIndex
+         */
+        uintmax_t mTotalBytes;
+
+        /**
+         * The open journal file (appending) or nullptr if the journal
+         * could not be opened - the index still works without it but
+         * will need a directory scan at the next startup.
+         */
+        LLFILE* mJournal;
+
+        /**
+         * stdio buffer of mJournal, see JOURNAL_BUFFER_SIZE
+         */
+        std::vector<char> mJournalBuffer;
+
+        /**
+         * Number of records in the journal, by this or other instances.
+         * Used to decide when to compact it again.
+         */
+        U32 mJournalRecords;
+
+        /**
+         * How far into the journal file the records have been applied
+         * to the index. The next merge replays from here.
+         */
+        uintmax_t mJournalOffset;
+
+        /**
+         * The generation in the header of the journal we append to. If
+         * the file in the cache folder has another one, another instance
+         * has compacted it.
+         */
+        U32 mJournalGeneration;
+
         /**
          * The maximum size of the cache in bytes. After purge is called, the
          * total size of the cache files in the cache directory will be
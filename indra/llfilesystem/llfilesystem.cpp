@@ -67,6 +67,7 @@ LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_
         if (exists)
         {
             updateFileAccessTime(filename);
+            LLDiskCache::recordFileAccess(mFileID, mFileType);
         }
     }
 }
@@ -91,7 +92,12 @@ bool LLFileSystem::removeFile(const LLUUID& file_id, const LLAssetType::EType fi
 {
     const std::string filename = LLDiskCache::metaDataToFilepath(file_id, file_type);
 
-    LLFile::remove(filename.c_str(), suppress_error);
+    // A file that could not be removed (most likely in use) stays in the
+    // index so that the purge still sees it
+    if (LLFile::remove(filename.c_str(), suppress_error) == 0 || !LLFile::isfile(filename))
+    {
+        LLDiskCache::recordFileRemove(file_id);
+    }
 
     return true;
 }
@@ -114,6 +120,10 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
         //return false;
         LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_file_id << " reason: " << strerror(errno) << LL_ENDL;
     }
+    else
+    {
+        LLDiskCache::recordFileRename(old_file_id, new_file_id, new_file_type);
+    }
 
     return true;
 }
@@ -183,6 +193,7 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
     const std::string filename = LLDiskCache::metaDataToFilepath(mFileID, mFileType);
 
     bool success = false;
+    std::streamoff file_size = 0;
 
     if (mMode == APPEND)
     {
@@ -192,6 +203,7 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
             ofs.write((const char*)buffer, bytes);
 
             mPosition = (S32)ofs.tellp();
+            file_size = mPosition;
 
             success = true;
         }
@@ -205,6 +217,8 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
             ofs.seekp(mPosition, std::ios::beg);
             ofs.write((const char*)buffer, bytes);
             mPosition += bytes;
+            ofs.seekp(0, std::ios::end);
+            file_size = ofs.tellp();
             success = true;
         }
         else
@@ -215,6 +229,7 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
             {
                 ofs.write((const char*)buffer, bytes);
                 mPosition += bytes;
+                file_size = mPosition;
                 success = true;
             }
         }
@@ -227,11 +242,18 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
             ofs.write((const char*)buffer, bytes);
 
             mPosition += bytes;
+            file_size = bytes;
 
             success = true;
         }
     }
 
+    if (success)
+    {
+        // keep the disk cache index up to date for the purge
+        LLDiskCache::recordFileWrite(mFileID, mFileType, (uintmax_t)llmax(file_size, (std::streamoff)0));
+    }
+
     return success;
 }
 
@@ -249,6 +249,9 @@ public:
     // Multiply this raw image by the given color
     void tint( const LLColor3& color );
 
+    // Multiply the color channels by alpha. Does nothing unless there are 4 components.
+    void premultiplyAlpha();
+
     // Copy operations
 
     //duplicate this raw image if refCount > 1.
@@ -42,6 +42,11 @@ LLImageJ2CImpl* fallbackCreateLLImageJ2CImpl();
 LLImageCompressionTester* LLImageJ2C::sTesterp = NULL ;
 const std::string sTesterName("ImageCompressionTester");
 
+S32 LLImageJ2C::sMaxDecodeThreads = 1;
+S32 LLImageJ2C::sMinPixelsPerDecodeThread = 512 * 512;
+S32 LLImageJ2C::sDecodeCores = 0;
+std::atomic<S32> LLImageJ2C::sActiveDecodes(0);
+
 //static
 std::string LLImageJ2C::getEngineInfo()
 {
@@ -51,6 +56,29 @@ std::string LLImageJ2C::getEngineInfo()
     return impl->getEngineInfo();
 }
 
+//static
+void LLImageJ2C::setDecodeThreads(S32 max_threads, S32 min_pixels_per_thread, S32 cores)
+{
+    sMaxDecodeThreads = llmax(max_threads, 1);
+    sMinPixelsPerDecodeThread = llmax(min_pixels_per_thread, 1);
+    sDecodeCores = llmax(cores, 0);
+}
+
+//static
+S32 LLImageJ2C::getDecodeThreads(S32 width, S32 height)
+{
+    S64 pixels = (S64)width * height;
+    S64 threads = pixels / sMinPixelsPerDecodeThread;
+    S64 max_threads = sMaxDecodeThreads;
+    if (sDecodeCores > 0)
+    {
+        // the caller is counted in sActiveDecodes, so a full decode pool
+        // leaves each decode one thread and never oversubscribes the cores
+        max_threads = llmin(max_threads, (S64)(sDecodeCores / llmax(sActiveDecodes.load(), 1)));
+    }
+    return (S32)llclamp(threads, (S64)1, max_threads);
+}
+
 LLImageJ2C::LLImageJ2C() :  LLImageFormatted(IMG_CODEC_J2C),
                             mMaxBytes(0),
                             mRawDiscardLevel(-1),
@@ -175,7 +203,9 @@ bool LLImageJ2C::decodeChannels(LLImageRaw *raw_imagep, F32 decode_time, S32 fir
         {
             // Update the raw discard level
             updateRawDiscardLevel();
+            ++sActiveDecodes;
             res = mImpl->decodeImpl(*this, *raw_imagep, decode_time, first_channel, max_channel_count);
+            --sActiveDecodes;
         }
     }
 
@@ -31,6 +31,8 @@
 #include "llassettype.h"
 #include "llmetricperformancetester.h"
 
+#include <atomic>
+
 // JPEG2000 : compression rate used in j2c conversion.
 const F32 DEFAULT_COMPRESSION_RATE = 1.f/8.f;
 
@@ -78,6 +80,14 @@ public:
 
     static std::string getEngineInfo();
 
+    // Intra-image decode parallelism.  A single decode may use up to
+    // max_threads threads, but only one per min_pixels_per_thread pixels
+    // at the decoded resolution so small images stay on the calling thread.
+    // If cores is nonzero, the decodes running at once share that many
+    // cores, so extra threads are only handed out while few are running.
+    static void setDecodeThreads(S32 max_threads, S32 min_pixels_per_thread, S32 cores = 0);
+    static S32 getDecodeThreads(S32 width, S32 height);
+
 protected:
     friend class LLImageJ2CImpl;
     friend class LLImageJ2COJ;
@@ -99,6 +109,11 @@ protected:
 
     // Image compression/decompression tester
     static LLImageCompressionTester* sTesterp;
+
+    static S32 sMaxDecodeThreads;
+    static S32 sMinPixelsPerDecodeThread;
+    static S32 sDecodeCores;
+    static std::atomic<S32> sActiveDecodes;
 };
 
 // Derive from this class to implement JPEG2000 decoding
@@ -0,0 +1,1072 @@
+/**
+ * @file llimagekernels.cpp
+ * @brief Pixel loops shared by LLImageBase and LLImageRaw, with SSE2 versions.
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimagekernels.h"
+
+#include "llmath.h"
+
+#include <boost/preprocessor.hpp>
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#define LL_IMAGE_SIMD 1
+#elif defined(__ARM_NEON)
+#include <sse2neon.h>
+#define LL_IMAGE_SIMD 1
+#else
+#define LL_IMAGE_SIMD 0
+#endif
+
+static bool sUseSIMD = LL_IMAGE_SIMD;
+
+void LLImageKernels::setUseSIMD(bool use_simd)
+{
+    sUseSIMD = use_simd && LL_IMAGE_SIMD;
+}
+
+bool LLImageKernels::getUseSIMD()
+{
+    return sUseSIMD;
+}
+
+//..................................................................................
+//..................................................................................
+// Helper macrose's for generate cycle unwrap templates
+//..................................................................................
+#define _UNROL_GEN_TPL_arg_0(arg)
+#define _UNROL_GEN_TPL_arg_1(arg) arg
+
+#define _UNROL_GEN_TPL_comma_0
+#define _UNROL_GEN_TPL_comma_1 BOOST_PP_COMMA()
+//..................................................................................
+#define _UNROL_GEN_TPL_ARGS_macro(z,n,seq) \
+    BOOST_PP_CAT(_UNROL_GEN_TPL_arg_, BOOST_PP_MOD(n, 2))(BOOST_PP_SEQ_ELEM(n, seq)) BOOST_PP_CAT(_UNROL_GEN_TPL_comma_, BOOST_PP_AND(BOOST_PP_MOD(n, 2), BOOST_PP_NOT_EQUAL(BOOST_PP_INC(n), BOOST_PP_SEQ_SIZE(seq))))
+
+#define _UNROL_GEN_TPL_ARGS(seq) \
+    BOOST_PP_REPEAT(BOOST_PP_SEQ_SIZE(seq), _UNROL_GEN_TPL_ARGS_macro, seq)
+//..................................................................................
+
+#define _UNROL_GEN_TPL_TYPE_ARGS_macro(z,n,seq) \
+    BOOST_PP_SEQ_ELEM(n, seq) BOOST_PP_CAT(_UNROL_GEN_TPL_comma_, BOOST_PP_AND(BOOST_PP_MOD(n, 2), BOOST_PP_NOT_EQUAL(BOOST_PP_INC(n), BOOST_PP_SEQ_SIZE(seq))))
+
+#define _UNROL_GEN_TPL_TYPE_ARGS(seq) \
+    BOOST_PP_REPEAT(BOOST_PP_SEQ_SIZE(seq), _UNROL_GEN_TPL_TYPE_ARGS_macro, seq)
+//..................................................................................
+#define _UNROLL_GEN_TPL_foreach_ee(z, n, seq) \
+    executor<n>(_UNROL_GEN_TPL_ARGS(seq));
+
+#define _UNROLL_GEN_TPL(name, args_seq, operation, spec) \
+    template<> struct name<spec> { \
+    private: \
+        template<S32 _idx> inline void executor(_UNROL_GEN_TPL_TYPE_ARGS(args_seq)) { \
+            BOOST_PP_SEQ_ENUM(operation) ; \
+        } \
+    public: \
+        inline void operator()(_UNROL_GEN_TPL_TYPE_ARGS(args_seq)) { \
+            BOOST_PP_REPEAT(spec, _UNROLL_GEN_TPL_foreach_ee, args_seq) \
+        } \
+};
+//..................................................................................
+#define _UNROLL_GEN_TPL_foreach_seq_macro(r, data, elem) \
+    _UNROLL_GEN_TPL(BOOST_PP_SEQ_ELEM(0, data), BOOST_PP_SEQ_ELEM(1, data), BOOST_PP_SEQ_ELEM(2, data), elem)
+
+#define UNROLL_GEN_TPL(name, args_seq, operation, spec_seq) \
+    /*general specialization - should not be implemented!*/ \
+    template<U8> struct name { inline void operator()(_UNROL_GEN_TPL_TYPE_ARGS(args_seq)) { /*static_assert(!"Should not be instantiated.");*/  } }; \
+    BOOST_PP_SEQ_FOR_EACH(_UNROLL_GEN_TPL_foreach_seq_macro, (name)(args_seq)(operation), spec_seq)
+//..................................................................................
+//..................................................................................
+
+
+//..................................................................................
+// Generated unrolling loop templates with specializations
+//..................................................................................
+//example: for(c = 0; c < ch; ++c) comp[c] = cx[0] = 0;
+UNROLL_GEN_TPL(uroll_zeroze_cx_comp, (S32 *)(cx)(S32 *)(comp), (cx[_idx] = comp[_idx] = 0), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] >>= 4;
+UNROLL_GEN_TPL(uroll_comp_rshftasgn_constval, (S32 *)(comp)(const S32)(cval), (comp[_idx] >>= cval), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] = (cx[c] >> 5) * yap;
+UNROLL_GEN_TPL(uroll_comp_asgn_cx_rshft_cval_all_mul_val, (S32 *)(comp)(S32 *)(cx)(const S32)(cval)(S32)(val), (comp[_idx] = (cx[_idx] >> cval) * val), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] += (cx[c] >> 5) * Cy;
+UNROLL_GEN_TPL(uroll_comp_plusasgn_cx_rshft_cval_all_mul_val, (S32 *)(comp)(S32 *)(cx)(const S32)(cval)(S32)(val), (comp[_idx] += (cx[_idx] >> cval) * val), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] += pix[c] * info.xapoints[x];
+UNROLL_GEN_TPL(uroll_inp_plusasgn_pix_mul_val, (S32 *)(comp)(const U8 *)(pix)(S32)(val), (comp[_idx] += pix[_idx] * val), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) cx[c] = pix[c] * info.xapoints[x];
+UNROLL_GEN_TPL(uroll_inp_asgn_pix_mul_val, (S32 *)(comp)(const U8 *)(pix)(S32)(val), (comp[_idx] = pix[_idx] * val), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] = ((cx[c] * info.yapoints[y]) + (comp[c] * (256 - info.yapoints[y]))) >> 16;
+UNROLL_GEN_TPL(uroll_comp_asgn_cx_mul_apoint_plus_comp_mul_inv_apoint_allshifted_16_r, (S32 *)(comp)(S32 *)(cx)(S32)(apoint), (comp[_idx] = ((cx[_idx] * apoint) + (comp[_idx] * (256 - apoint))) >> 16), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] = (comp[c] + pix[c] * info.yapoints[y]) >> 8;
+UNROLL_GEN_TPL(uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r, (S32 *)(comp)(const U8 *)(pix)(S32)(apoint), (comp[_idx] = (comp[_idx] + pix[_idx] * apoint) >> 8), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] = ((comp[c]*(256 - info.xapoints[x])) + ((cx[c] * info.xapoints[x]))) >> 12;
+UNROLL_GEN_TPL(uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r, (S32 *)(comp)(S32)(apoint)(S32 *)(cx), (comp[_idx] = ((comp[_idx] * (256-apoint)) + (cx[_idx] * apoint)) >> 12), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) *dptr++ = comp[c]&0xff;
+UNROLL_GEN_TPL(uroll_uref_dptr_inc_asgn_comp_and_ff, (U8 *&)(dptr)(S32 *)(comp), (*dptr++ = comp[_idx]&0xff), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) *dptr++ = (sptr[info.xpoints[x]*ch + c])&0xff;
+UNROLL_GEN_TPL(uroll_uref_dptr_inc_asgn_sptr_apoint_plus_idx_alland_ff, (U8 *&)(dptr)(const U8 *)(sptr)(S32)(apoint), (*dptr++ = sptr[apoint + _idx]&0xff), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) *dptr++ = (comp[c]>>10)&0xff;
+UNROLL_GEN_TPL(uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff, (U8 *&)(dptr)(S32 *)(comp)(const S32)(cval), (*dptr++ = (comp[_idx]>>cval)&0xff), (1)(3)(4));
+//..................................................................................
+
+
+template<U8 ch>
+struct scale_info
+{
+public:
+    std::vector<S32> xpoints;
+    std::vector<const U8*> ystrides;
+    std::vector<S32> xapoints, yapoints;
+    S32 xup_yup;
+
+public:
+    //unrolling loop types declaration
+    typedef uroll_zeroze_cx_comp<ch>                                                        uroll_zeroze_cx_comp_t;
+    typedef uroll_comp_rshftasgn_constval<ch>                                               uroll_comp_rshftasgn_constval_t;
+    typedef uroll_comp_asgn_cx_rshft_cval_all_mul_val<ch>                                   uroll_comp_asgn_cx_rshft_cval_all_mul_val_t;
+    typedef uroll_comp_plusasgn_cx_rshft_cval_all_mul_val<ch>                               uroll_comp_plusasgn_cx_rshft_cval_all_mul_val_t;
+    typedef uroll_inp_plusasgn_pix_mul_val<ch>                                              uroll_inp_plusasgn_pix_mul_val_t;
+    typedef uroll_inp_asgn_pix_mul_val<ch>                                                  uroll_inp_asgn_pix_mul_val_t;
+    typedef uroll_comp_asgn_cx_mul_apoint_plus_comp_mul_inv_apoint_allshifted_16_r<ch>      uroll_comp_asgn_cx_mul_apoint_plus_comp_mul_inv_apoint_allshifted_16_r_t;
+    typedef uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r<ch>                     uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r_t;
+    typedef uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r<ch>      uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r_t;
+    typedef uroll_uref_dptr_inc_asgn_comp_and_ff<ch>                                        uroll_uref_dptr_inc_asgn_comp_and_ff_t;
+    typedef uroll_uref_dptr_inc_asgn_sptr_apoint_plus_idx_alland_ff<ch>                     uroll_uref_dptr_inc_asgn_sptr_apoint_plus_idx_alland_ff_t;
+    typedef uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff<ch>                             uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff_t;
+
+public:
+    scale_info(const U8 *src, U32 srcW, U32 srcH, U32 dstW, U32 dstH, U32 srcStride)
+        : xup_yup((dstW >= srcW) + ((dstH >= srcH) << 1))
+    {
+        calc_x_points(srcW, dstW);
+        calc_y_strides(src, srcStride, srcH, dstH);
+        calc_aa_points(srcW, dstW, xup_yup&1, xapoints);
+        calc_aa_points(srcH, dstH, xup_yup&2, yapoints);
+    }
+
+private:
+    //...........................................................................................
+    void calc_x_points(U32 srcW, U32 dstW)
+    {
+        xpoints.resize(dstW+1);
+
+        S32 val = dstW >= srcW ? 0x8000 * srcW / dstW - 0x8000 : 0;
+        S32 inc = (srcW << 16) / dstW;
+
+        for(U32 i = 0, j = 0; i < dstW; ++i, ++j, val += inc)
+        {
+            xpoints[j] = llmax(0, val >> 16);
+        }
+    }
+    //...........................................................................................
+    void calc_y_strides(const U8 *src, U32 srcStride, U32 srcH, U32 dstH)
+    {
+        ystrides.resize(dstH+1);
+
+        S32 val = dstH >= srcH ? 0x8000 * srcH / dstH - 0x8000 : 0;
+        S32 inc = (srcH << 16) / dstH;
+
+        for(U32 i = 0, j = 0; i < dstH; ++i, ++j, val += inc)
+        {
+            ystrides[j] = src + llmax(0, val >> 16) * srcStride;
+        }
+    }
+    //...........................................................................................
+    void calc_aa_points(U32 srcSz, U32 dstSz, bool scale_up, std::vector<S32> &vp)
+    {
+        vp.resize(dstSz);
+
+        if(scale_up)
+        {
+            S32 val = 0x8000 * srcSz / dstSz - 0x8000;
+            S32 inc = (srcSz << 16) / dstSz;
+            U32 pos;
+
+            for(U32 i = 0, j = 0; i < dstSz; ++i, ++j, val += inc)
+            {
+                pos = val >> 16;
+
+                if (pos >= (srcSz - 1))
+                    vp[j] = 0;
+                else
+                    vp[j] = (val >> 8) - ((val >> 8) & 0xffffff00);
+            }
+        }
+        else
+        {
+            S32 inc = (srcSz << 16) / dstSz;
+            S32 Cp = ((dstSz << 14) / srcSz) + 1;
+            S32 ap;
+
+            for(U32 i = 0, j = 0, val = 0; i < dstSz; ++i, ++j, val += inc)
+            {
+                ap = ((0x100 - ((val >> 8) & 0xff)) * Cp) >> 8;
+                vp[j] = ap | (Cp << 16);
+            }
+        }
+    }
+};
+
+
+#if LL_IMAGE_SIMD
+//..................................................................................
+// SSE2 helpers. All of the arithmetic below is done at the same width and in
+// the same order as the scalar code so the results match it bit for bit.
+//..................................................................................
+
+// 4 bytes -> 4 S32 lanes, each value in the low half of its lane for madd
+static inline __m128i load_px4_epi32(const U8* pix)
+{
+    S32 v;
+    memcpy(&v, pix, sizeof(v));
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero);
+}
+
+// pix[c] * val for 4 channels. val must be in [0, 32767].
+static inline __m128i mul_px4(const U8* pix, S32 val)
+{
+    return _mm_madd_epi16(load_px4_epi32(pix), _mm_set1_epi32(val));
+}
+
+// Low 32 bits of a[c] * val (SSE2 has no _mm_mullo_epi32)
+static inline __m128i mullo_epi32(__m128i a, S32 val)
+{
+    const __m128i v = _mm_set1_epi32(val);
+    __m128i even = _mm_mul_epu32(a, v);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), v);
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// Horizontal box filter of one source row for one destination pixel
+static inline __m128i accumulate_row4(const U8* pix, S32 xap, S32 Cx)
+{
+    __m128i cx = mul_px4(pix, xap);
+    pix += 4;
+
+    S32 i;
+    for (i = (1 << 14) - xap; i > Cx; i -= Cx)
+    {
+        cx = _mm_add_epi32(cx, mul_px4(pix, Cx));
+        pix += 4;
+    }
+
+    if (i > 0)
+    {
+        cx = _mm_add_epi32(cx, mul_px4(pix, i));
+    }
+    return cx;
+}
+
+// The "scale x/y - down" branch of bilinear_scale<4>() below, with the four
+// channels of a pixel held in one register instead of cx[4] and comp[4].
+static void bilinear_scale_down4_sse2(const scale_info<4>& info, U8* dst, U32 dstW, U32 dstH, U32 srcStride, U32 dstStride)
+{
+    const __m128i mask_ff = _mm_set1_epi32(0xff);
+
+    for (U32 y = 0; y < dstH; y++)
+    {
+        const S32 Cy = info.yapoints[y] >> 16;
+        const S32 yap = info.yapoints[y] & 0xffff;
+
+        U8* dptr = dst + (y * dstStride);
+        for (U32 x = 0; x < dstW; x++)
+        {
+            const S32 Cx = info.xapoints[x] >> 16;
+            const S32 xap = info.xapoints[x] & 0xffff;
+
+            const U8* sptr = info.ystrides[y] + info.xpoints[x] * 4;
+
+            __m128i cx = accumulate_row4(sptr, xap, Cx);
+            sptr += srcStride;
+            __m128i comp = mullo_epi32(_mm_srai_epi32(cx, 5), yap);
+
+            S32 j;
+            for (j = (1 << 14) - yap; j > Cy; j -= Cy)
+            {
+                cx = accumulate_row4(sptr, xap, Cx);
+                sptr += srcStride;
+                comp = _mm_add_epi32(comp, mullo_epi32(_mm_srai_epi32(cx, 5), Cy));
+            }
+
+            if (j > 0)
+            {
+                cx = accumulate_row4(sptr, xap, Cx);
+                comp = _mm_add_epi32(comp, mullo_epi32(_mm_srai_epi32(cx, 5), j));
+            }
+
+            __m128i out = _mm_and_si128(_mm_srai_epi32(comp, 23), mask_ff);
+            out = _mm_packs_epi32(out, out);
+            out = _mm_packus_epi16(out, out);
+            S32 rgba = _mm_cvtsi128_si32(out);
+            memcpy(dptr, &rgba, sizeof(rgba));
+            dptr += 4;
+        }
+    }
+}
+#endif // LL_IMAGE_SIMD
+
+template<U8 ch>
+inline void bilinear_scale(
+    const U8 *src, U32 srcW, U32 srcH, U32 srcStride
+    , U8 *dst, U32 dstW, U32 dstH, U32 dstStride
+    )
+{
+    typedef scale_info<ch> scale_info_t;
+
+    scale_info_t info(src, srcW, srcH, dstW, dstH, srcStride);
+
+#if LL_IMAGE_SIMD
+    if constexpr (4 == ch)
+    {
+        // RGBA downscale, by far the most common case (texture discard
+        // and thumbnails)
+        if (0 == info.xup_yup && sUseSIMD)
+        {
+            bilinear_scale_down4_sse2(info, dst, dstW, dstH, srcStride, dstStride);
+            return;
+        }
+    }
+#endif
+
+    const U8 *sptr;
+    U8 *dptr;
+    U32 x, y;
+    const U8 *pix;
+
+    S32 cx[ch], comp[ch];
+
+
+    if(3 == info.xup_yup)
+    { //scale x/y - up
+        for(y = 0; y < dstH; ++y)
+        {
+            dptr = dst + (y * dstStride);
+            sptr = info.ystrides[y];
+
+            if(0 < info.yapoints[y])
+            {
+                for(x = 0; x < dstW; ++x)
+                {
+                    //for(c = 0; c < ch; ++c) cx[c] = comp[c] = 0;
+                    typename scale_info_t::uroll_zeroze_cx_comp_t()(cx, comp);
+
+                    if(0 < info.xapoints[x])
+                    {
+                        pix = info.ystrides[y] + info.xpoints[x] * ch;
+
+                        //for(c = 0; c < ch; ++c) comp[c] = pix[c] * (256 - info.xapoints[x]);
+                        typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, 256 - info.xapoints[x]);
+
+                        pix += ch;
+
+                        //for(c = 0; c < ch; ++c) comp[c] += pix[c] * info.xapoints[x];
+                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, info.xapoints[x]);
+
+                        pix += srcStride;
+
+                        //for(c = 0; c < ch; ++c) cx[c] = pix[c] * info.xapoints[x];
+                        typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, info.xapoints[x]);
+
+                        pix -= ch;
+
+                        //for(c = 0; c < ch; ++c) {
+                        //  cx[c] += pix[c] * (256 - info.xapoints[x]);
+                        //  comp[c] = ((cx[c] * info.yapoints[y]) + (comp[c] * (256 - info.yapoints[y]))) >> 16;
+                        //  *dptr++ = comp[c]&0xff;
+                        //}
+                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, 256 - info.xapoints[x]);
+                        typename scale_info_t::uroll_comp_asgn_cx_mul_apoint_plus_comp_mul_inv_apoint_allshifted_16_r_t()(comp, cx, info.yapoints[y]);
+                        typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_and_ff_t()(dptr, comp);
+                    }
+                    else
+                    {
+                        pix = info.ystrides[y] + info.xpoints[x] * ch;
+
+                        //for(c = 0; c < ch; ++c) comp[c] = pix[c] * (256 - info.yapoints[y]);
+                        typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, 256-info.yapoints[y]);
+
+                        pix += srcStride;
+
+                        //for(c = 0; c < ch; ++c) {
+                        //  comp[c] = (comp[c] + pix[c] * info.yapoints[y]) >> 8;
+                        //  *dptr++ = comp[c]&0xff;
+                        //}
+                        typename scale_info_t::uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r_t()(comp, pix, info.yapoints[y]);
+                        typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_and_ff_t()(dptr, comp);
+                    }
+                }
+            }
+            else
+            {
+                for(x = 0; x < dstW; ++x)
+                {
+                    if(0 < info.xapoints[x])
+                    {
+                        pix = info.ystrides[y] + info.xpoints[x] * ch;
+
+                        //for(c = 0; c < ch; ++c) {
+                        //  comp[c] = pix[c] * (256 - info.xapoints[x]);
+                        //  comp[c] = (comp[c] + pix[c] * info.xapoints[x]) >> 8;
+                        //  *dptr++ = comp[c]&0xff;
+                        //}
+                        typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, 256 - info.xapoints[x]);
+                        typename scale_info_t::uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r_t()(comp, pix, info.xapoints[x]);
+                        typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_and_ff_t()(dptr, comp);
+                    }
+                    else
+                    {
+                        //for(c = 0; c < ch; ++c) *dptr++ = (sptr[info.xpoints[x]*ch + c])&0xff;
+                        typename scale_info_t::uroll_uref_dptr_inc_asgn_sptr_apoint_plus_idx_alland_ff_t()(dptr, sptr, info.xpoints[x]*ch);
+                    }
+                }
+            }
+        }
+    }
+    else if(info.xup_yup == 1)
+    { //scaling down vertically
+        S32 Cy, j;
+        S32 yap;
+
+        for(y = 0; y < dstH; y++)
+        {
+            Cy = info.yapoints[y] >> 16;
+            yap = info.yapoints[y] & 0xffff;
+
+            dptr = dst + (y * dstStride);
+
+            for(x = 0; x < dstW; x++)
+            {
+                pix = info.ystrides[y] + info.xpoints[x] * ch;
+
+                //for(c = 0; c < ch; ++c) comp[c] = pix[c] * yap;
+                typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, yap);
+
+                pix += srcStride;
+
+                for(j = (1 << 14) - yap; j > Cy; j -= Cy, pix += srcStride)
+                {
+                    //for(c = 0; c < ch; ++c) comp[c] += pix[c] * Cy;
+                    typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, Cy);
+                }
+
+                if(j > 0)
+                {
+                    //for(c = 0; c < ch; ++c) comp[c] += pix[c] * j;
+                    typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, j);
+                }
+
+                if(info.xapoints[x] > 0)
+                {
+                    pix = info.ystrides[y] + info.xpoints[x]*ch + ch;
+                    //for(c = 0; c < ch; ++c) cx[c] = pix[c] * yap;
+                    typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, yap);
+
+                    pix += srcStride;
+                    for(j = (1 << 14) - yap; j > Cy; j -= Cy)
+                    {
+                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cy;
+                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cy);
+                        pix += srcStride;
+                    }
+
+                    if(j > 0)
+                    {
+                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * j;
+                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, j);
+                    }
+
+                    //for(c = 0; c < ch; ++c) comp[c] = ((comp[c]*(256 - info.xapoints[x])) + ((cx[c] * info.xapoints[x]))) >> 12;
+                    typename scale_info_t::uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r_t()(comp, info.xapoints[x], cx);
+                }
+                else
+                {
+                    //for(c = 0; c < ch; ++c) comp[c] >>= 4;
+                    typename scale_info_t::uroll_comp_rshftasgn_constval_t()(comp, 4);
+                }
+
+                //for(c = 0; c < ch; ++c) *dptr++ = (comp[c]>>10)&0xff;
+                typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff_t()(dptr, comp, 10);
+            }
+        }
+    }
+    else if(info.xup_yup == 2)
+    { // scaling down horizontally
+        S32 Cx, j;
+        S32 xap;
+
+        for(y = 0; y < dstH; y++)
+        {
+            dptr = dst + (y * dstStride);
+
+            for(x = 0; x < dstW; x++)
+            {
+                Cx = info.xapoints[x] >> 16;
+                xap = info.xapoints[x] & 0xffff;
+
+                pix = info.ystrides[y] + info.xpoints[x] * ch;
+
+                //for(c = 0; c < ch; ++c) comp[c] = pix[c] * xap;
+                typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, xap);
+
+                pix+=ch;
+                for(j = (1 << 14) - xap; j > Cx; j -= Cx)
+                {
+                    //for(c = 0; c < ch; ++c) comp[c] += pix[c] * Cx;
+                    typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, Cx);
+                    pix+=ch;
+                }
+
+                if(j > 0)
+                {
+                    //for(c = 0; c < ch; ++c) comp[c] += pix[c] * j;
+                    typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, j);
+                }
+
+                if(info.yapoints[y] > 0)
+                {
+                    pix = info.ystrides[y] + info.xpoints[x]*ch + srcStride;
+                    //for(c = 0; c < ch; ++c) cx[c] = pix[c] * xap;
+                    typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, xap);
+
+                    pix+=ch;
+                    for(j = (1 << 14) - xap; j > Cx; j -= Cx)
+                    {
+                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cx;
+                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cx);
+                        pix+=ch;
+                    }
+
+                    if(j > 0)
+                    {
+                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * j;
+                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, j);
+                    }
+
+                    //for(c = 0; c < ch; ++c) comp[c] = ((comp[c] * (256 - info.yapoints[y])) + ((cx[c] * info.yapoints[y]))) >> 12;
+                    typename scale_info_t::uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r_t()(comp, info.yapoints[y], cx);
+                }
+                else
+                {
+                    //for(c = 0; c < ch; ++c) comp[c] >>= 4;
+                    typename scale_info_t::uroll_comp_rshftasgn_constval_t()(comp, 4);
+                }
+
+                //for(c = 0; c < ch; ++c) *dptr++ = (comp[c]>>10)&0xff;
+                typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff_t()(dptr, comp, 10);
+            }
+        }
+    }
+    else
+    { //scale x/y - down
+        S32 Cx, Cy, i, j;
+        S32 xap, yap;
+
+        for(y = 0; y < dstH; y++)
+        {
+            Cy = info.yapoints[y] >> 16;
+            yap = info.yapoints[y] & 0xffff;
+
+            dptr = dst + (y * dstStride);
+            for(x = 0; x < dstW; x++)
+            {
+                Cx = info.xapoints[x] >> 16;
+                xap = info.xapoints[x] & 0xffff;
+
+                sptr = info.ystrides[y] + info.xpoints[x] * ch;
+                pix = sptr;
+                sptr += srcStride;
+
+                //for(c = 0; c < ch; ++c) cx[c] = pix[c] * xap;
+                typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, xap);
+
+                pix+=ch;
+                for(i = (1 << 14) - xap; i > Cx; i -= Cx)
+                {
+                    //for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cx;
+                    typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cx);
+                    pix+=ch;
+                }
+
+                if(i > 0)
+                {
+                    //for(c = 0; c < ch; ++c) cx[c] += pix[c] * i;
+                    typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, i);
+                }
+
+                //for(c = 0; c < ch; ++c) comp[c] = (cx[c] >> 5) * yap;
+                typename scale_info_t::uroll_comp_asgn_cx_rshft_cval_all_mul_val_t()(comp, cx, 5, yap);
+
+                for(j = (1 << 14) - yap; j > Cy; j -= Cy)
+                {
+                    pix = sptr;
+                    sptr += srcStride;
+
+                    //for(c = 0; c < ch; ++c) cx[c] = pix[c] * xap;
+                    typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, xap);
+
+                    pix+=ch;
+                    for(i = (1 << 14) - xap; i > Cx; i -= Cx)
+                    {
+                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cx;
+                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cx);
+                        pix+=ch;
+                    }
+
+                    if(i > 0)
+                    {
+                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * i;
+                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, i);
+                    }
+
+                    //for(c = 0; c < ch; ++c) comp[c] += (cx[c] >> 5) * Cy;
+                    typename scale_info_t::uroll_comp_plusasgn_cx_rshft_cval_all_mul_val_t()(comp, cx, 5, Cy);
+                }
+
+                if(j > 0)
+                {
+                    pix = sptr;
+                    sptr += srcStride;
+
+                    //for(c = 0; c < ch; ++c) cx[c] = pix[c] * xap;
+                    typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, xap);
+
+                    pix+=ch;
+                    for(i = (1 << 14) - xap; i > Cx; i -= Cx)
+                    {
+                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cx;
+                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cx);
+                        pix+=ch;
+                    }
+
+                    if(i > 0)
+                    {
+                        //for(c = 0; c < ch; ++c) cx[c] += pix[c] * i;
+                        typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, i);
+                    }
+
+                    //for(c = 0; c < ch; ++c) comp[c] += (cx[c] >> 5) * j;
+                    typename scale_info_t::uroll_comp_plusasgn_cx_rshft_cval_all_mul_val_t()(comp, cx, 5, j);
+                }
+
+                //for(c = 0; c < ch; ++c) *dptr++ = (comp[c]>>23)&0xff;
+                typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff_t()(dptr, comp, 23);
+            }
+        }
+    } //else
+}
+
+void LLImageKernels::bilinearScale(const U8* src, U32 srcW, U32 srcH, U32 srcCh, U32 srcStride,
+                                   U8* dst, U32 dstW, U32 dstH, U32 dstCh, U32 dstStride)
+{
+    llassert(srcCh == dstCh);
+
+    switch(srcCh)
+    {
+    case 1:
+        bilinear_scale<1>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
+        break;
+    case 3:
+        bilinear_scale<3>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
+        break;
+    case 4:
+        bilinear_scale<4>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
+        break;
+    default:
+        llassert(!"Implement if need");
+        break;
+    }
+
+}
+
+//---------------------------------------------------------------------------
+// Mip generation
+//---------------------------------------------------------------------------
+
+static void avg4_colors4(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
+{
+    dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
+    dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
+    dst[2] = (U8)(((U32)(a[2]) + b[2] + c[2] + d[2])>>2);
+    dst[3] = (U8)(((U32)(a[3]) + b[3] + c[3] + d[3])>>2);
+}
+
+static void avg4_colors3(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
+{
+    dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
+    dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
+    dst[2] = (U8)(((U32)(a[2]) + b[2] + c[2] + d[2])>>2);
+}
+
+static void avg4_colors2(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
+{
+    dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
+    dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
+}
+
+// Box filters 'count' mip pixels of one row. in0 and in1 are the two source rows.
+static void generate_mip_row(const U8* in0, const U8* in1, U8* data, S32 count, S32 nchannels)
+{
+    for (S32 w=0; w<count; w++)
+    {
+        switch(nchannels)
+        {
+          case 4:
+            avg4_colors4(in0, in0+4, in1, in1+4, data);
+            break;
+          case 3:
+            avg4_colors3(in0, in0+3, in1, in1+3, data);
+            break;
+          case 2:
+            avg4_colors2(in0, in0+2, in1, in1+2, data);
+            break;
+          case 1:
+            *(U8*)data = (U8)(((U32)(in0[0]) + in0[1] + in1[0] + in1[1])>>2);
+            break;
+          default:
+            LL_ERRS() << "generateMmip called with bad num channels" << LL_ENDL;
+        }
+        in0 += nchannels*2;
+        in1 += nchannels*2;
+        data += nchannels;
+    }
+}
+
+#if LL_IMAGE_SIMD
+// Vertical sum of 16 bytes from each row, as two registers of 8 U16
+static inline void sum_rows_epi16(const U8* in0, const U8* in1, __m128i& lo, __m128i& hi)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = _mm_loadu_si128((const __m128i*)in0);
+    __m128i b = _mm_loadu_si128((const __m128i*)in1);
+    lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+    hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+}
+
+// 4 channels: 16 source bytes per row -> 2 mip pixels in 8 U16 lanes
+static inline __m128i mip_half4(const U8* in0, const U8* in1)
+{
+    __m128i lo, hi;
+    sum_rows_epi16(in0, in1, lo, hi);
+    // lo holds source pixels 0 and 1, hi pixels 2 and 3
+    __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+    return _mm_srli_epi16(sum, 2);
+}
+
+// 2 channels: 16 source bytes per row -> 4 mip pixels in 8 U16 lanes
+static inline __m128i mip_half2(const U8* in0, const U8* in1)
+{
+    __m128i lo, hi;
+    sum_rows_epi16(in0, in1, lo, hi);
+    // Each 32 bit lane is one source pixel, add odd lanes onto even ones
+    lo = _mm_add_epi16(lo, _mm_srli_epi64(lo, 32));
+    hi = _mm_add_epi16(hi, _mm_srli_epi64(hi, 32));
+    lo = _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 3, 2, 0));
+    hi = _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 3, 2, 0));
+    return _mm_srli_epi16(_mm_unpacklo_epi64(lo, hi), 2);
+}
+
+// 1 channel: 16 source bytes per row -> 8 mip pixels in 8 U16 lanes
+static inline __m128i mip_half1(const U8* in0, const U8* in1)
+{
+    const __m128i mask_lo = _mm_set1_epi16(0x00ff);
+    __m128i a = _mm_loadu_si128((const __m128i*)in0);
+    __m128i b = _mm_loadu_si128((const __m128i*)in1);
+    __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, mask_lo), _mm_srli_epi16(a, 8)),
+                                _mm_add_epi16(_mm_and_si128(b, mask_lo), _mm_srli_epi16(b, 8)));
+    return _mm_srli_epi16(sum, 2);
+}
+
+// Writes 16 bytes of mip data per step. Returns the number of pixels done,
+// generate_mip_row() does the rest.
+static S32 generate_mip_row_sse2(const U8* in0, const U8* in1, U8* data, S32 count, S32 nchannels)
+{
+    S32 step;
+    switch (nchannels)
+    {
+    case 4: step = 4; break;
+    case 2: step = 8; break;
+    case 1: step = 16; break;
+    default: return 0;
+    }
+
+    S32 w = 0;
+    for (; w + step <= count; w += step)
+    {
+        __m128i lo, hi;
+        switch (nchannels)
+        {
+        case 4:
+            lo = mip_half4(in0, in1);
+            hi = mip_half4(in0 + 16, in1 + 16);
+            break;
+        case 2:
+            lo = mip_half2(in0, in1);
+            hi = mip_half2(in0 + 16, in1 + 16);
+            break;
+        default:
+            lo = mip_half1(in0, in1);
+            hi = mip_half1(in0 + 16, in1 + 16);
+            break;
+        }
+        _mm_storeu_si128((__m128i*)data, _mm_packus_epi16(lo, hi));
+        in0 += 32;
+        in1 += 32;
+        data += 16;
+    }
+    return w;
+}
+#endif // LL_IMAGE_SIMD
+
+void LLImageKernels::generateMip(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels)
+{
+    llassert(width > 0 && height > 0);
+    U8* data = mipdata;
+    const S32 in_row = width*2*nchannels;
+    for (S32 h=0; h<height; h++)
+    {
+        const U8* in0 = indata;
+        const U8* in1 = indata + in_row;
+        S32 done = 0;
+#if LL_IMAGE_SIMD
+        if (sUseSIMD)
+        {
+            done = generate_mip_row_sse2(in0, in1, data, width, nchannels);
+        }
+#endif
+        generate_mip_row(in0 + done*nchannels*2, in1 + done*nchannels*2, data + done*nchannels, width - done, nchannels);
+        data += width*nchannels;
+        indata += in_row*2; // skip odd lines
+    }
+}
+
+//---------------------------------------------------------------------------
+// Channel conversion and compositing
+//---------------------------------------------------------------------------
+
+// Calculates (U8)(255*(a/255.f)*(b/255.f) + 0.5f).  Thanks, Jim Blinn!
+static inline U8 fast_fractional_mult(U8 a, U8 b)
+{
+    U32 i = a * b + 128;
+    return U8((i + (i>>8)) >> 8);
+}
+
+#if LL_IMAGE_SIMD
+// Same as fast_fractional_mult() on 8 U16 lanes
+static inline __m128i fast_fractional_mult_epi16(__m128i a, __m128i b)
+{
+    __m128i i = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(i, _mm_srli_epi16(i, 8)), 8);
+}
+
+// 4 RGBA pixels -> 12 packed RGB bytes in the low bytes of the result
+static inline __m128i pack_rgb12(__m128i v)
+{
+    const __m128i mask_rgb = _mm_set1_epi32(0x00ffffff);
+    const __m128i mask_even = _mm_set_epi32(0, -1, 0, -1);
+    const __m128i mask_lo64 = _mm_set_epi32(0, 0, -1, -1);
+    v = _mm_and_si128(v, mask_rgb);
+    // 6 bytes in each 64 bit lane
+    v = _mm_or_si128(_mm_and_si128(v, mask_even), _mm_slli_epi64(_mm_srli_epi64(v, 32), 24));
+    // close the 2 byte gap between the lanes
+    return _mm_or_si128(_mm_and_si128(v, mask_lo64), _mm_srli_si128(_mm_andnot_si128(mask_lo64, v), 2));
+}
+
+// The first 12 bytes of v as 4 RGB pixels -> 4 RGBX pixels with X = 0
+static inline __m128i unpack_rgb12(__m128i v)
+{
+    const __m128i mask_even = _mm_set_epi32(0, 0x00ffffff, 0, 0x00ffffff);
+    const __m128i mask_odd = _mm_set_epi32(0x00ffffff, 0, 0x00ffffff, 0);
+    // 6 bytes in each 64 bit lane
+    v = _mm_unpacklo_epi64(v, _mm_srli_si128(v, 6));
+    return _mm_or_si128(_mm_and_si128(v, mask_even), _mm_and_si128(_mm_slli_epi64(v, 8), mask_odd));
+}
+
+static inline void store_rgb12(U8* dst, __m128i v)
+{
+    _mm_storel_epi64((__m128i*)dst, v);
+    S32 tail = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+    memcpy(dst + 8, &tail, sizeof(tail));
+}
+
+// Alpha of each of 4 RGBA pixels copied to all 4 bytes of its pixel
+static inline __m128i splat_alpha(__m128i v)
+{
+    __m128i a = _mm_srli_epi32(v, 24);
+    a = _mm_or_si128(a, _mm_slli_epi32(a, 8));
+    return _mm_or_si128(a, _mm_slli_epi32(a, 16));
+}
+#endif // LL_IMAGE_SIMD
+
+void LLImageKernels::copy4onto3(const U8* src_data, U8* dst_data, S32 pixels)
+{
+    S32 i = 0;
+#if LL_IMAGE_SIMD
+    if (sUseSIMD)
+    {
+        // 8 pixels, 32 bytes in, 24 bytes out
+        for (; i + 8 <= pixels; i += 8)
+        {
+            __m128i lo = pack_rgb12(_mm_loadu_si128((const __m128i*)src_data));
+            __m128i hi = pack_rgb12(_mm_loadu_si128((const __m128i*)(src_data + 16)));
+            _mm_storeu_si128((__m128i*)dst_data, _mm_or_si128(lo, _mm_slli_si128(hi, 12)));
+            _mm_storel_epi64((__m128i*)(dst_data + 16), _mm_srli_si128(hi, 4));
+            src_data += 32;
+            dst_data += 24;
+        }
+    }
+#endif
+    for( ; i<pixels; i++ )
+    {
+        dst_data[0] = src_data[0];
+        dst_data[1] = src_data[1];
+        dst_data[2] = src_data[2];
+        src_data += 4;
+        dst_data += 3;
+    }
+}
+
+void LLImageKernels::copy3onto4(const U8* src_data, U8* dst_data, S32 pixels)
+{
+    S32 i = 0;
+#if LL_IMAGE_SIMD
+    if (sUseSIMD)
+    {
+        const __m128i alpha = _mm_set1_epi32(0xff000000);
+        // 4 pixels, 12 bytes in, 16 bytes out. The load reads 16 bytes so
+        // stop while there are still 6 source pixels left.
+        for (; i + 6 <= pixels; i += 4)
+        {
+            __m128i v = unpack_rgb12(_mm_loadu_si128((const __m128i*)src_data));
+            _mm_storeu_si128((__m128i*)dst_data, _mm_or_si128(v, alpha));
+            src_data += 12;
+            dst_data += 16;
+        }
+    }
+#endif
+    for( ; i<pixels; i++ )
+    {
+        dst_data[0] = src_data[0];
+        dst_data[1] = src_data[1];
+        dst_data[2] = src_data[2];
+        dst_data[3] = 255;
+        src_data += 3;
+        dst_data += 4;
+    }
+}
+
+void LLImageKernels::composite4onto3(const U8* src_data, U8* dst_data, S32 pixels)
+{
+    S32 i = 0;
+#if LL_IMAGE_SIMD
+    if (sUseSIMD)
+    {
+        // The blend below gives dst for alpha 0 and src for alpha 255, so
+        // unlike the scalar loop there is no need to special case them.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ff = _mm_set1_epi16(255);
+        // 4 pixels, reading 16 bytes of dst so stop while there are still
+        // 6 dst pixels left.
+        for (; i + 6 <= pixels; i += 4)
+        {
+            __m128i s = _mm_loadu_si128((const __m128i*)src_data);
+            __m128i d = unpack_rgb12(_mm_loadu_si128((const __m128i*)dst_data));
+            __m128i a = splat_alpha(s);
+
+            __m128i a_lo = _mm_unpacklo_epi8(a, zero);
+            __m128i a_hi = _mm_unpackhi_epi8(a, zero);
+            __m128i lo = _mm_add_epi16(fast_fractional_mult_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(ff, a_lo)),
+                                       fast_fractional_mult_epi16(_mm_unpacklo_epi8(s, zero), a_lo));
+            __m128i hi = _mm_add_epi16(fast_fractional_mult_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(ff, a_hi)),
+                                       fast_fractional_mult_epi16(_mm_unpackhi_epi8(s, zero), a_hi));
+
+            store_rgb12(dst_data, pack_rgb12(_mm_packus_epi16(lo, hi)));
+            src_data += 16;
+            dst_data += 12;
+        }
+    }
+#endif
+    for( ; i<pixels; i++ )
+    {
+        U8 alpha = src_data[3];
+        if( alpha )
+        {
+            if( 255 == alpha )
+            {
+                dst_data[0] = src_data[0];
+                dst_data[1] = src_data[1];
+                dst_data[2] = src_data[2];
+            }
+            else
+            {
+
+                U8 transparency = 255 - alpha;
+                dst_data[0] = fast_fractional_mult( dst_data[0], transparency ) + fast_fractional_mult( src_data[0], alpha );
+                dst_data[1] = fast_fractional_mult( dst_data[1], transparency ) + fast_fractional_mult( src_data[1], alpha );
+                dst_data[2] = fast_fractional_mult( dst_data[2], transparency ) + fast_fractional_mult( src_data[2], alpha );
+            }
+        }
+
+        src_data += 4;
+        dst_data += 3;
+    }
+}
+
+void LLImageKernels::premultiplyAlpha(U8* data, S32 pixels)
+{
+    S32 i = 0;
+#if LL_IMAGE_SIMD
+    if (sUseSIMD)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        // Multiply alpha by 255 (a no-op) rather than masking it back in
+        const __m128i mask_rgb = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+        const __m128i alpha_ff = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+        for (; i + 4 <= pixels; i += 4)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)data);
+            __m128i a = splat_alpha(v);
+
+            __m128i a_lo = _mm_or_si128(_mm_and_si128(_mm_unpacklo_epi8(a, zero), mask_rgb), alpha_ff);
+            __m128i a_hi = _mm_or_si128(_mm_and_si128(_mm_unpackhi_epi8(a, zero), mask_rgb), alpha_ff);
+            __m128i lo = fast_fractional_mult_epi16(_mm_unpacklo_epi8(v, zero), a_lo);
+            __m128i hi = fast_fractional_mult_epi16(_mm_unpackhi_epi8(v, zero), a_hi);
+
+            _mm_storeu_si128((__m128i*)data, _mm_packus_epi16(lo, hi));
+            data += 16;
+        }
+    }
+#endif
+    for( ; i<pixels; i++ )
+    {
+        U8 alpha = data[3];
+        data[0] = fast_fractional_mult( data[0], alpha );
+        data[1] = fast_fractional_mult( data[1], alpha );
+        data[2] = fast_fractional_mult( data[2], alpha );
+        data += 4;
+    }
+}
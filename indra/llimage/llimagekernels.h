@@ -0,0 +1,66 @@
+/**
+ * @file llimagekernels.h
+ * @brief Pixel loops shared by LLImageBase and LLImageRaw, with SSE2 versions.
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGEKERNELS_H
+#define LL_LLIMAGEKERNELS_H
+
+// The tight per-pixel loops behind LLImageRaw scaling, channel conversion,
+// compositing and mip generation. Each kernel has a scalar version and, where
+// the target has SSE2 (or NEON through sse2neon), a vectorized version that
+// produces exactly the same bytes. The scalar versions are the reference:
+// see tests/llimagekernels_test.cpp.
+namespace LLImageKernels
+{
+    // Turn the vectorized paths on or off. On by default; used by the tests
+    // and benchmarks to run the scalar reference. Not meant to be flipped
+    // while images are being processed on other threads.
+    void setUseSIMD(bool use_simd);
+    bool getUseSIMD();
+
+    // Bilinear resample, averaging all the covered source pixels when
+    // shrinking. Src and dst must have the same number of components
+    // (1, 3 or 4).
+    void bilinearScale(const U8* src, U32 srcW, U32 srcH, U32 srcCh, U32 srcStride,
+                       U8* dst, U32 dstW, U32 dstH, U32 dstCh, U32 dstStride);
+
+    // 2x2 box filter. width and height are the dimensions of mipdata,
+    // indata must be twice as wide and twice as high.
+    void generateMip(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels);
+
+    // Drop the alpha channel: 4 components in, 3 out.
+    void copy4onto3(const U8* src, U8* dst, S32 pixels);
+
+    // Add an opaque alpha channel: 3 components in, 4 out.
+    void copy3onto4(const U8* src, U8* dst, S32 pixels);
+
+    // Blend 4 component src over 3 component dst using src alpha.
+    void composite4onto3(const U8* src, U8* dst, S32 pixels);
+
+    // Multiply the color channels of 4 component data by alpha, in place.
+    void premultiplyAlpha(U8* data, S32 pixels);
+}
+
+#endif // LL_LLIMAGEKERNELS_H
@@ -0,0 +1,296 @@
+/**
+ * @file llimagekernels_test.cpp
+ * @brief Checks the SSE2 image kernels against the scalar ones and times both.
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+// Class to test
+#include "../llimagekernels.h"
+// For timer class
+#include "../llcommon/lltimer.h"
+// Tut header
+#include "../test/lltut.h"
+
+#include <vector>
+
+namespace tut
+{
+    struct imagekernels_test
+    {
+        imagekernels_test()
+        :   mSeed(0x2545f491)
+        {
+        }
+
+        ~imagekernels_test()
+        {
+            LLImageKernels::setUseSIMD(true);
+        }
+
+        // Small LCG so that any failure is reproducible
+        std::vector<U8> randomBytes(size_t count)
+        {
+            std::vector<U8> bytes(count);
+            for (U8& byte : bytes)
+            {
+                mSeed = mSeed * 1664525 + 1013904223;
+                byte = U8(mSeed >> 24);
+            }
+            return bytes;
+        }
+
+        // Run op with the scalar kernels and then the SSE2 ones and check
+        // they wrote the same bytes. op fills in the vector it is given.
+        template<typename OP>
+        void ensureSameResult(const std::string& what, OP op)
+        {
+            std::vector<U8> scalar, simd;
+            LLImageKernels::setUseSIMD(false);
+            op(scalar);
+            LLImageKernels::setUseSIMD(true);
+            op(simd);
+            ensure_equals(what + " size", simd.size(), scalar.size());
+            for (size_t i = 0; i < scalar.size(); ++i)
+            {
+                if (simd[i] != scalar[i])
+                {
+                    ensure_equals(what + " byte " + std::to_string(i), S32(simd[i]), S32(scalar[i]));
+                }
+            }
+        }
+
+        // Seconds per call of op, scalar then SSE2
+        template<typename OP>
+        void benchmark(const std::string& what, S32 iterations, OP op)
+        {
+            F64 seconds[2];
+            for (S32 pass = 0; pass < 2; ++pass)
+            {
+                LLImageKernels::setUseSIMD(pass != 0);
+                LLTimer timer;
+                for (S32 i = 0; i < iterations; ++i)
+                {
+                    op();
+                }
+                seconds[pass] = timer.getElapsedTimeF64() / iterations;
+            }
+            LL_INFOS("ImageKernels") << what << ": scalar " << seconds[0] * 1000.0 << " ms, simd "
+                                     << seconds[1] * 1000.0 << " ms, "
+                                     << (seconds[1] > 0.0 ? seconds[0] / seconds[1] : 0.0) << "x" << LL_ENDL;
+        }
+
+        U32 mSeed;
+    };
+
+    typedef test_group<imagekernels_test> imagekernels_t;
+    typedef imagekernels_t::object imagekernels_object_t;
+    tut::imagekernels_t tut_imagekernels("LLImageKernels");
+
+    template<> template<>
+    void imagekernels_object_t::test<1>()
+    {
+        set_test_name("bilinearScale");
+
+        // Down, up and mixed, including sizes that are not multiples of the
+        // SIMD width and ratios that are not whole numbers
+        const S32 sizes[][4] = {
+            { 512, 512, 256, 256 },
+            { 512, 512, 37, 129 },
+            { 333, 77, 64, 16 },
+            { 64, 64, 65, 63 },
+            { 63, 65, 64, 64 },
+            { 17, 9, 256, 128 },
+            { 1024, 8, 1, 1 },
+            { 3, 3, 2, 2 },
+        };
+        const S32 channels[] = { 1, 3, 4 };
+
+        for (const auto& size : sizes)
+        {
+            for (S32 ch : channels)
+            {
+                const S32 src_w = size[0], src_h = size[1], dst_w = size[2], dst_h = size[3];
+                std::vector<U8> src = randomBytes(src_w * src_h * ch);
+                ensureSameResult(llformat("bilinearScale %dx%dx%d -> %dx%d", src_w, src_h, ch, dst_w, dst_h),
+                    [&](std::vector<U8>& dst)
+                    {
+                        dst.assign(dst_w * dst_h * ch, 0);
+                        LLImageKernels::bilinearScale(src.data(), src_w, src_h, ch, src_w * ch,
+                                                      dst.data(), dst_w, dst_h, ch, dst_w * ch);
+                    });
+            }
+        }
+    }
+
+    template<> template<>
+    void imagekernels_object_t::test<2>()
+    {
+        set_test_name("generateMip");
+
+        const S32 sizes[][2] = { { 256, 256 }, { 1, 1 }, { 3, 5 }, { 17, 2 }, { 33, 7 } };
+        for (const auto& size : sizes)
+        {
+            for (S32 ch = 1; ch <= 4; ++ch)
+            {
+                const S32 w = size[0], h = size[1];
+                std::vector<U8> src = randomBytes(w * 2 * h * 2 * ch);
+                ensureSameResult(llformat("generateMip %dx%dx%d", w, h, ch),
+                    [&](std::vector<U8>& dst)
+                    {
+                        dst.assign(w * h * ch, 0);
+                        LLImageKernels::generateMip(src.data(), dst.data(), w, h, ch);
+                    });
+            }
+        }
+    }
+
+    template<> template<>
+    void imagekernels_object_t::test<3>()
+    {
+        set_test_name("channel conversion");
+
+        // Every tail length around the SIMD step sizes
+        for (S32 pixels = 0; pixels < 40; ++pixels)
+        {
+            std::vector<U8> rgba = randomBytes(pixels * 4);
+            std::vector<U8> rgb = randomBytes(pixels * 3);
+
+            ensureSameResult(llformat("copy4onto3 %d", pixels),
+                [&](std::vector<U8>& dst)
+                {
+                    dst.assign(pixels * 3, 0);
+                    LLImageKernels::copy4onto3(rgba.data(), dst.data(), pixels);
+                });
+            ensureSameResult(llformat("copy3onto4 %d", pixels),
+                [&](std::vector<U8>& dst)
+                {
+                    dst.assign(pixels * 4, 0);
+                    LLImageKernels::copy3onto4(rgb.data(), dst.data(), pixels);
+                });
+        }
+    }
+
+    template<> template<>
+    void imagekernels_object_t::test<4>()
+    {
+        set_test_name("composite and premultiply");
+
+        for (S32 pixels = 0; pixels < 40; ++pixels)
+        {
+            std::vector<U8> rgba = randomBytes(pixels * 4);
+            std::vector<U8> rgb = randomBytes(pixels * 3);
+            // Make sure the fully transparent and fully opaque shortcuts in
+            // the scalar loop get exercised
+            for (S32 i = 0; i < pixels; i += 3)
+            {
+                rgba[i * 4 + 3] = (i % 2) ? 255 : 0;
+            }
+
+            ensureSameResult(llformat("composite4onto3 %d", pixels),
+                [&](std::vector<U8>& dst)
+                {
+                    dst = rgb;
+                    LLImageKernels::composite4onto3(rgba.data(), dst.data(), pixels);
+                });
+            ensureSameResult(llformat("premultiplyAlpha %d", pixels),
+                [&](std::vector<U8>& dst)
+                {
+                    dst = rgba;
+                    LLImageKernels::premultiplyAlpha(dst.data(), pixels);
+                });
+        }
+
+        // Every color / alpha combination
+        std::vector<U8> all(256 * 256 * 4);
+        for (S32 i = 0; i < 256 * 256; ++i)
+        {
+            all[i * 4 + 0] = U8(i & 0xff);
+            all[i * 4 + 1] = U8(255 - (i & 0xff));
+            all[i * 4 + 2] = U8(i & 0xff);
+            all[i * 4 + 3] = U8(i >> 8);
+        }
+        ensureSameResult("premultiplyAlpha exhaustive",
+            [&](std::vector<U8>& dst)
+            {
+                dst = all;
+                LLImageKernels::premultiplyAlpha(dst.data(), 256 * 256);
+            });
+        std::vector<U8> under = randomBytes(256 * 256 * 3);
+        ensureSameResult("composite4onto3 exhaustive",
+            [&](std::vector<U8>& dst)
+            {
+                dst = under;
+                LLImageKernels::composite4onto3(all.data(), dst.data(), 256 * 256);
+            });
+    }
+
+    template<> template<>
+    void imagekernels_object_t::test<5>()
+    {
+        set_test_name("benchmark");
+
+        // Not a pass/fail test: logs the time per call of each kernel on a
+        // 1024x1024 image so the two paths can be compared on a given CPU.
+        const S32 SIZE = 1024;
+        const S32 ITERATIONS = 8;
+        std::vector<U8> rgba = randomBytes(SIZE * SIZE * 4);
+        std::vector<U8> rgb = randomBytes(SIZE * SIZE * 3);
+        std::vector<U8> out(SIZE * SIZE * 4);
+        std::vector<U8> out3(SIZE * SIZE * 3);
+
+        benchmark("bilinearScale RGBA 1024 -> 384", ITERATIONS, [&]()
+            {
+                LLImageKernels::bilinearScale(rgba.data(), SIZE, SIZE, 4, SIZE * 4, out.data(), 384, 384, 4, 384 * 4);
+            });
+        benchmark("bilinearScale RGBA 1024 -> 512", ITERATIONS, [&]()
+            {
+                LLImageKernels::bilinearScale(rgba.data(), SIZE, SIZE, 4, SIZE * 4, out.data(), 512, 512, 4, 512 * 4);
+            });
+        benchmark("generateMip RGBA 1024 -> 512", ITERATIONS, [&]()
+            {
+                LLImageKernels::generateMip(rgba.data(), out.data(), SIZE / 2, SIZE / 2, 4);
+            });
+        benchmark("generateMip L 1024 -> 512", ITERATIONS, [&]()
+            {
+                LLImageKernels::generateMip(rgba.data(), out.data(), SIZE / 2, SIZE / 2, 1);
+            });
+        benchmark("copy4onto3 1024x1024", ITERATIONS, [&]()
+            {
+                LLImageKernels::copy4onto3(rgba.data(), out3.data(), SIZE * SIZE);
+            });
+        benchmark("copy3onto4 1024x1024", ITERATIONS, [&]()
+            {
+                LLImageKernels::copy3onto4(rgb.data(), out.data(), SIZE * SIZE);
+            });
+        benchmark("composite4onto3 1024x1024", ITERATIONS, [&]()
+            {
+                LLImageKernels::composite4onto3(rgba.data(), out3.data(), SIZE * SIZE);
+            });
+        benchmark("premultiplyAlpha 1024x1024", ITERATIONS, [&]()
+            {
+                memcpy(out.data(), rgba.data(), SIZE * SIZE * 4);
+                LLImageKernels::premultiplyAlpha(out.data(), SIZE * SIZE);
+            });
+    }
+}
@@ -333,13 +333,20 @@ public:
         return true;
     }
 
-    bool decode(U8* data, U32 dataSize, U32* channels, U8 discard_level)
+    bool decode(U8* data, U32 dataSize, U32* channels, U8 discard_level, S32 threads = 1)
     {
         parameters.flags &= ~OPJ_DPARAMETERS_DUMP_FLAG;
 
         decoder = opj_create_decompress(OPJ_CODEC_J2K);
         opj_setup_decoder(decoder, &parameters);
 
+        // Let OpenJPEG decode code-blocks in parallel, has to be set
+        // before opj_read_header
+        if (threads > 1 && opj_has_thread_support())
+        {
+            opj_codec_set_threads(decoder, threads);
+        }
+
         opj_set_info_handler(decoder, opj_info, this);
         opj_set_warning_handler(decoder, opj_warn, this);
         opj_set_error_handler(decoder, opj_error, this);
@@ -785,7 +792,9 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     U32 image_channels = 0;
     S32 data_size = base.getDataSize();
     S32 max_bytes = (base.getMaxBytes() ? base.getMaxBytes() : data_size);
-    bool decoded = decoder.decode(base.getData(), max_bytes, &image_channels, base.mDiscardLevel);
+    S32 discard = llmax((S32)base.mDiscardLevel, 0);
+    S32 threads = LLImageJ2C::getDecodeThreads(ceildivpow2(base.getWidth(), discard), ceildivpow2(base.getHeight(), discard));
+    bool decoded = decoder.decode(base.getData(), max_bytes, &image_channels, base.mDiscardLevel, threads);
 
     // set correct channel count early so failed decodes don't miss it...
     S32 channels = (S32)image_channels - first_channel;
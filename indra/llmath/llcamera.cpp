@@ -296,6 +296,87 @@ S32 LLCamera::AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVec
     return AABBInFrustumNoFarClip(center, radius, mRegionPlanes);
 }
 
+//structure of arrays version of AABBInFrustum(...) and AABBInFrustumNoFarClip(...).
+//does the same arithmetic in the same order, so every lane gets the result
+//the single box functions would.
+void LLCamera::AABBInFrustum4(const LLCameraAABB4& boxes, S32* results, const LLPlane* planes, U32 skip_plane)
+{
+    if(!planes)
+    {
+        //use agent space
+        planes = mAgentPlanes;
+    }
+
+    U32 outside = 0;
+    U32 partial = 0;
+    LLVector4a scale, rscale, minp, maxp, tmp, d;
+    U32 max_planes = llmin(mPlaneCount, (U32) AGENT_PLANE_USER_CLIP_NUM);       // mAgentPlanes[] size is 7
+    for (U32 i = 0; i < max_planes; i++)
+    {
+        U8 mask = mPlaneMask[i];
+        if ((i != skip_plane) && (mask < PLANE_MASK_NUM))
+        {
+            const LLPlane& p(planes[i]);
+            d.splat(-p[3]);
+
+            LLVector4a dot_min, dot_max;
+            for (U32 j = 0; j < 3; j++)
+            {
+                LLVector4a n;
+                n.splat(p[j]);
+                scale.splat(sFrustumScaler[mask][j]);
+                rscale.setMul(boxes.mRadius[j], scale);
+                minp.setSub(boxes.mCenter[j], rscale);
+                maxp.setAdd(boxes.mCenter[j], rscale);
+                if (j == 0)
+                {
+                    dot_min.setMul(minp, n);
+                    dot_max.setMul(maxp, n);
+                }
+                else
+                {
+                    tmp.setMul(minp, n);
+                    dot_min.add(tmp);
+                    tmp.setMul(maxp, n);
+                    dot_max.add(tmp);
+                }
+            }
+
+            outside |= dot_min.greaterThan(d).getGatheredBits();
+            partial |= dot_max.greaterThan(d).getGatheredBits();
+            if ((outside & 0xf) == 0xf)
+            {
+                break;
+            }
+        }
+    }
+
+    for (U32 i = 0; i < LLCameraAABB4::NUM_BOXES; i++)
+    {
+        results[i] = (outside & (1 << i)) ? 0 : ((partial & (1 << i)) ? 1 : 2);
+    }
+}
+
+void LLCamera::AABBInFrustum4(const LLCameraAABB4& boxes, S32* results, const LLPlane* planes)
+{
+    AABBInFrustum4(boxes, results, planes, AGENT_PLANE_USER_CLIP_NUM);
+}
+
+void LLCamera::AABBInRegionFrustum4(const LLCameraAABB4& boxes, S32* results)
+{
+    AABBInFrustum4(boxes, results, mRegionPlanes, AGENT_PLANE_USER_CLIP_NUM);
+}
+
+void LLCamera::AABBInFrustumNoFarClip4(const LLCameraAABB4& boxes, S32* results, const LLPlane* planes)
+{
+    AABBInFrustum4(boxes, results, planes, AGENT_PLANE_FAR);
+}
+
+void LLCamera::AABBInRegionFrustumNoFarClip4(const LLCameraAABB4& boxes, S32* results)
+{
+    AABBInFrustum4(boxes, results, mRegionPlanes, AGENT_PLANE_FAR);
+}
+
 int LLCamera::sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius)
 {
     LLVector3 dist = sphere_center-mFrustCenter;
@@ -51,6 +51,41 @@ constexpr F32 MIN_FAR_PLANE     = 0.2f;
 constexpr F32 MIN_FIELD_OF_VIEW = 5.0f * DEG_TO_RAD;
 constexpr F32 MAX_FIELD_OF_VIEW = 175.f * DEG_TO_RAD;
 
+// Four axis aligned boxes (center, radius) in structure of arrays form, so
+// that LLCamera can test all of them against a frustum plane at once.
+// Lanes that are not set() are tested too, the caller ignores their result.
+class LLCameraAABB4
+{
+public:
+    enum { NUM_BOXES = 4 };
+
+    LLCameraAABB4()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for (U32 i = 0; i < 3; i++)
+        {
+            mCenter[i].clear();
+            mRadius[i].clear();
+        }
+    }
+
+    void set(U32 i, const LLVector4a& center, const LLVector4a& radius)
+    {
+        for (U32 j = 0; j < 3; j++)
+        {
+            mCenter[j].getF32ptr()[i] = center[j];
+            mRadius[j].getF32ptr()[i] = radius[j];
+        }
+    }
+
+    LLVector4a mCenter[3];  // x, y and z of the four centers
+    LLVector4a mRadius[3];  // x, y and z of the four radii
+};
+
 // An LLCamera is an LLCoorFrame with a view frustum.
 // This means that it has several methods for moving it around
 // that are inherited from the LLCoordFrame() class :
@@ -137,6 +172,8 @@ private:
     U32 mPlaneCount;  //defaults to 6, if setUserClipPlane is called, uses user supplied clip plane in
 
     LLVector3 mWorldPlanePos;       // Position of World Planes (may be offset from camera)
+
+    void AABBInFrustum4(const LLCameraAABB4& boxes, S32* results, const LLPlane* planes, U32 skip_plane);
 public:
     LLVector3 mAgentFrustum[AGENT_FRUSTRUM_NUM];  //8 corners of 6-plane frustum
     F32 mFrustumCornerDist;     //distance to corner of frustum against far clip plane
@@ -202,6 +239,13 @@ public:
     S32 AABBInFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius, const LLPlane* planes = NULL);
     S32 AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius);
 
+    // Same as the functions above for four boxes at a time, results[i] is
+    // exactly what the single box test returns for box i.
+    void AABBInFrustum4(const LLCameraAABB4& boxes, S32* results, const LLPlane* planes = NULL);
+    void AABBInRegionFrustum4(const LLCameraAABB4& boxes, S32* results);
+    void AABBInFrustumNoFarClip4(const LLCameraAABB4& boxes, S32* results, const LLPlane* planes = NULL);
+    void AABBInRegionFrustumNoFarClip4(const LLCameraAABB4& boxes, S32* results);
+
     //does a quick 'n dirty sphere-sphere check
     S32 sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius);
 
@@ -0,0 +1,233 @@
+/**
+ * @file llvertexkernels.cpp
+ * @brief Batched loops that write LLVolumeFace data into vertex buffers.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llvertexkernels.h"
+
+#include "llmath.h"
+#include "llmatrix4a.h"
+#include "v2math.h"
+#include "v4coloru.h"
+
+static bool sUseBatched = true;
+
+void LLVertexKernels::setUseBatched(bool use_batched)
+{
+    sUseBatched = use_batched;
+}
+
+bool LLVertexKernels::getUseBatched()
+{
+    return sUseBatched;
+}
+
+namespace
+{
+    // Every element of a matrix broadcast to its own register, so four
+    // vertices laid out as x, y, z and w registers can be transformed with
+    // the same multiplies and adds, in the same order, as LLMatrix4a does
+    // for one.
+    struct SplatMatrix
+    {
+        LLQuad m[4][4];
+
+        SplatMatrix(const LLMatrix4a& mat)
+        {
+            for (U32 row = 0; row < 4; ++row)
+            {
+                for (U32 col = 0; col < 4; ++col)
+                {
+                    m[row][col] = _mm_set1_ps(mat.mMatrix[row][col]);
+                }
+            }
+        }
+
+        // LLMatrix4a::affineTransform()
+        LLQuad affine(U32 col, LLQuad x, LLQuad y, LLQuad z) const
+        {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][col]), _mm_mul_ps(y, m[1][col])),
+                              _mm_add_ps(_mm_mul_ps(z, m[2][col]), m[3][col]));
+        }
+    };
+
+    LLVector4a tex_index_bits(S32 tex_index)
+    {
+        F32 val;
+        memcpy(&val, &tex_index, sizeof(val));
+
+        LLVector4a bits;
+        bits.set(0.f, 0.f, 0.f, val);
+        return bits;
+    }
+
+    // LLFace's scalar texture coordinate transform
+    void xform(const LLVector2& src, LLVector2& dst, F32 cos_ang, F32 sin_ang, F32 offset_s, F32 offset_t, F32 scale_s, F32 scale_t)
+    {
+        F32 s = src.mV[0] - 0.5f;
+        F32 t = src.mV[1] - 0.5f;
+
+        F32 rs = s * cos_ang + t * sin_ang;
+        F32 rt = -s * sin_ang + t * cos_ang;
+
+        dst.mV[0] = rs * scale_s + (offset_s + 0.5f);
+        dst.mV[1] = rt * scale_t + (offset_t + 0.5f);
+    }
+}
+
+void LLVertexKernels::transformPositions(const LLMatrix4a& mat, const LLVector4a* src, S32 count,
+                                         LLVector4a* dst, S32 dst_count, S32 tex_index)
+{
+    const LLVector4a tex_idx = tex_index_bits(tex_index);
+
+    S32 i = 0;
+    if (sUseBatched)
+    {
+        const SplatMatrix m(mat);
+        const LLQuad w = _mm_castsi128_ps(_mm_set1_epi32(tex_index));
+
+        for (; i + 4 <= count; i += 4)
+        {
+            LLQuad x = src[i], y = src[i + 1], z = src[i + 2], unused = src[i + 3];
+            _MM_TRANSPOSE4_PS(x, y, z, unused);
+
+            LLQuad rx = m.affine(0, x, y, z);
+            LLQuad ry = m.affine(1, x, y, z);
+            LLQuad rz = m.affine(2, x, y, z);
+            LLQuad rw = w;
+            _MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+
+            _mm_store_ps(dst[i].getF32ptr(), rx);
+            _mm_store_ps(dst[i + 1].getF32ptr(), ry);
+            _mm_store_ps(dst[i + 2].getF32ptr(), rz);
+            _mm_store_ps(dst[i + 3].getF32ptr(), rw);
+        }
+    }
+
+    LLVector4Logical mask;
+    mask.clear();
+    mask.setElement<3>();
+
+    for (; i < count; ++i)
+    {
+        LLVector4a res;
+        mat.affineTransform(src[i], res);
+        dst[i].setSelectWithMask(mask, tex_idx, res);
+    }
+
+    if (count > 0 && dst_count > count)
+    {
+        LLVector4a last;
+        mat.affineTransform(src[count - 1], last);
+        for (i = count; i < dst_count; ++i)
+        {
+            dst[i] = last;
+        }
+    }
+}
+
+// LLMatrix4a::rotate() already uses every lane for one vertex, and splitting
+// normals across registers costs more in transposes than it saves, so these
+// two have no batched version.
+void LLVertexKernels::rotateNormals(const LLMatrix4a& mat, const LLVector4a* src, S32 count, LLVector4a* dst)
+{
+    for (S32 i = 0; i < count; ++i)
+    {
+        mat.rotate(src[i], dst[i]);
+    }
+}
+
+void LLVertexKernels::rotateTangents(const LLMatrix4a& mat, const LLVector4a* src, S32 count, LLVector4a* dst)
+{
+    LLVector4Logical mask;
+    mask.clear();
+    mask.setElement<3>();
+
+    for (S32 i = 0; i < count; ++i)
+    {
+        LLVector4a res;
+        mat.rotate(src[i], res);
+        dst[i].setSelectWithMask(mask, src[i], res);
+    }
+}
+
+void LLVertexKernels::transformTexCoords(const LLVector2* src, S32 count, LLVector2* dst,
+                                         F32 cos_ang, F32 sin_ang, F32 offset_s, F32 offset_t, F32 scale_s, F32 scale_t)
+{
+    S32 i = 0;
+    if (sUseBatched)
+    {
+        const LLQuad half = _mm_set1_ps(0.5f);
+        const LLQuad cos4 = _mm_set1_ps(cos_ang);
+        const LLQuad sin4 = _mm_set1_ps(sin_ang);
+        const LLQuad neg_sin4 = _mm_set1_ps(-sin_ang);
+        const LLQuad scale_s4 = _mm_set1_ps(scale_s);
+        const LLQuad scale_t4 = _mm_set1_ps(scale_t);
+        const LLQuad offset_s4 = _mm_set1_ps(offset_s + 0.5f);
+        const LLQuad offset_t4 = _mm_set1_ps(offset_t + 0.5f);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            // <s0, t0, s1, t1>, <s2, t2, s3, t3> to <s0..s3>, <t0..t3>
+            LLQuad lo = _mm_loadu_ps(src[i].mV);
+            LLQuad hi = _mm_loadu_ps(src[i + 2].mV);
+            LLQuad s = _mm_sub_ps(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)), half);
+            LLQuad t = _mm_sub_ps(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)), half);
+
+            LLQuad rs = _mm_add_ps(_mm_mul_ps(s, cos4), _mm_mul_ps(t, sin4));
+            LLQuad rt = _mm_add_ps(_mm_mul_ps(s, neg_sin4), _mm_mul_ps(t, cos4));
+
+            rs = _mm_add_ps(_mm_mul_ps(rs, scale_s4), offset_s4);
+            rt = _mm_add_ps(_mm_mul_ps(rt, scale_t4), offset_t4);
+
+            _mm_storeu_ps(dst[i].mV, _mm_unpacklo_ps(rs, rt));
+            _mm_storeu_ps(dst[i + 2].mV, _mm_unpackhi_ps(rs, rt));
+        }
+    }
+
+    for (; i < count; ++i)
+    {
+        xform(src[i], dst[i], cos_ang, sin_ang, offset_s, offset_t, scale_s, scale_t);
+    }
+}
+
+void LLVertexKernels::fillColors(U32 rgba, S32 count, LLColor4U* dst)
+{
+    S32 i = 0;
+    if (sUseBatched)
+    {
+        const LLQuad color = _mm_castsi128_ps(_mm_set1_epi32(rgba));
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps((F32*) &dst[i], color);
+        }
+    }
+
+    for (; i < count; ++i)
+    {
+        memcpy(dst[i].mV, &rgba, sizeof(rgba));
+    }
+}
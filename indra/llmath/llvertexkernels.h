@@ -0,0 +1,74 @@
+/**
+ * @file llvertexkernels.h
+ * @brief Batched loops that write LLVolumeFace data into vertex buffers.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVERTEXKERNELS_H
+#define LL_LLVERTEXKERNELS_H
+
+class LLMatrix4a;
+class LLVector2;
+class LLVector4a;
+class LLColor4U;
+
+// The per-vertex loops of LLFace::getGeometryVolume(). Each kernel has the
+// one-vertex-at-a-time version the face code used to inline, which is the
+// reference, and where it pays off a batched version that works on four
+// vertices per step with the components split across registers, so there are
+// no per-vertex shuffles or branches. Both produce the same values: see
+// tests/llvertexkernels_test.cpp.
+//
+// LLVector4a arrays must be 16 byte aligned, the others need not be. Nothing
+// is read or written past count (or dst_count).
+namespace LLVertexKernels
+{
+    // Turn the batched versions on or off. On by default; used by the tests
+    // and benchmarks to run the reference. Not meant to be flipped while
+    // geometry is being written on other threads.
+    void setUseBatched(bool use_batched);
+    bool getUseBatched();
+
+    // dst[i] = mat * src[i] with w set to the bits of tex_index (the shaders
+    // read the batched texture index from there). dst is written up to
+    // dst_count; the extra entries repeat the last transformed vertex.
+    void transformPositions(const LLMatrix4a& mat, const LLVector4a* src, S32 count,
+                            LLVector4a* dst, S32 dst_count, S32 tex_index);
+
+    // dst[i] = rotation part of mat applied to src[i].
+    void rotateNormals(const LLMatrix4a& mat, const LLVector4a* src, S32 count, LLVector4a* dst);
+
+    // As rotateNormals() but keeps w of src (the bitangent sign).
+    void rotateTangents(const LLMatrix4a& mat, const LLVector4a* src, S32 count, LLVector4a* dst);
+
+    // Rotate texture coordinates about (0.5, 0.5), then scale and offset them,
+    // the way a texture entry's repeats, offset and rotation apply. src and
+    // dst may be the same array.
+    void transformTexCoords(const LLVector2* src, S32 count, LLVector2* dst,
+                            F32 cos_ang, F32 sin_ang, F32 offset_s, F32 offset_t, F32 scale_s, F32 scale_t);
+
+    // Set count colors to the same packed RGBA value.
+    void fillColors(U32 rgba, S32 count, LLColor4U* dst);
+}
+
+#endif // LL_LLVERTEXKERNELS_H
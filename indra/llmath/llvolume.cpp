@@ -33,6 +33,7 @@
 #endif
 #include <cmath>
 #include <unordered_map>
+#include <string_view>
 
 #include "llerror.h"
 
@@ -1953,6 +1954,7 @@ LLProfile::~LLProfile()
 
 
 S32 LLVolume::sNumMeshPoints = 0;
+bool LLVolume::sUseDirectMeshDecode = true;
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const bool generate_single_face, const bool is_unique)
     : mParams(params)
@@ -2288,10 +2290,441 @@ bool LLVolumeFace::VertexData::compareNormal(const LLVolumeFace::VertexData& rhs
     return retval;
 }
 
+// The parts of one submesh of a mesh LOD that unpackVolumeFaces() uses.
+// The binary fields point into either the LLSD tree or the inflated asset,
+// whichever is being decoded, so they are only valid during the unpack.
+struct LLVolume::MeshFaceFields
+{
+    bool mNoGeometry = false;
+    bool mHasWeights = false;
+    bool mHasNormalizedScale = false;
+
+    const U8* mPosition = nullptr;
+    size_t mPositionSize = 0;
+    const U8* mNormal = nullptr;
+    size_t mNormalSize = 0;
+    const U8* mTangent = nullptr;
+    size_t mTangentSize = 0;
+    const U8* mTexCoord = nullptr;
+    size_t mTexCoordSize = 0;
+    const U8* mTriangles = nullptr;
+    size_t mTrianglesSize = 0;
+    const U8* mWeights = nullptr;
+    size_t mWeightsSize = 0;
+
+    LLVector3 mPositionMin;
+    LLVector3 mPositionMax;
+    LLVector2 mTexCoordMin;
+    LLVector2 mTexCoordMax;
+    LLVector3 mNormalizedScale;
+};
+
+namespace
+{
+    // unpackVolumeFaces() keeps its inflate buffer between calls up to this size
+    constexpr size_t MESH_SCRATCH_MAX_KEEP = 8 * 1024 * 1024;
+
+    // Same limit unzip_llsd() puts on the LLSD parser
+    constexpr S32 MESH_LLSD_MAX_DEPTH = 96;
+
+    // Walks the binary LLSD of an inflated mesh LOD in place (see
+    // LLSDBinaryParser for the format). Every read fails rather than guess
+    // at anything unexpected, in which case the caller hands the asset to
+    // the LLSD parser instead.
+    class LLMeshLODReader
+    {
+    public:
+        LLMeshLODReader(const U8* data, size_t size)
+        :   mCur(data),
+            mEnd(data + size)
+        {
+        }
+
+        size_t bytesLeft() const { return mEnd - mCur; }
+
+        bool readByte(U8& c)
+        {
+            if (mCur >= mEnd)
+            {
+                return false;
+            }
+            c = *mCur++;
+            return true;
+        }
+
+        bool expectByte(U8 expected)
+        {
+            U8 c;
+            return readByte(c) && c == expected;
+        }
+
+        // Network byte order
+        bool readU32(U32& value)
+        {
+            if (bytesLeft() < 4)
+            {
+                return false;
+            }
+            value = ((U32)mCur[0] << 24) | ((U32)mCur[1] << 16) | ((U32)mCur[2] << 8) | (U32)mCur[3];
+            mCur += 4;
+            return true;
+        }
+
+        // Reads a length prefix and checks the bytes are all there
+        bool readLength(U32& length)
+        {
+            return readU32(length) && (S32)length >= 0 && length <= bytesLeft();
+        }
+
+        bool skip(size_t bytes)
+        {
+            if (bytesLeft() < bytes)
+            {
+                return false;
+            }
+            mCur += bytes;
+            return true;
+        }
+
+        bool readKey(std::string_view& key)
+        {
+            U32 length;
+            if (!expectByte('k') || !readLength(length))
+            {
+                return false;
+            }
+            key = std::string_view((const char*)mCur, length);
+            mCur += length;
+            return true;
+        }
+
+        // An LLSD::Binary value, or undefined which asBinary() turns into
+        // an empty one
+        bool readBinary(const U8*& data, size_t& size)
+        {
+            U8 c;
+            if (!readByte(c))
+            {
+                return false;
+            }
+            if (c == '!')
+            {
+                data = nullptr;
+                size = 0;
+                return true;
+            }
+            U32 length;
+            if (c != 'b' || !readLength(length))
+            {
+                return false;
+            }
+            data = length ? mCur : nullptr;
+            size = length;
+            mCur += length;
+            return true;
+        }
+
+        // Any value LLSD::asReal() gives a number for without parsing a string
+        bool readReal(F32& value)
+        {
+            U8 c;
+            if (!readByte(c))
+            {
+                return false;
+            }
+            switch (c)
+            {
+            case '!':
+            case '0':
+                value = 0.f;
+                return true;
+            case '1':
+                value = 1.f;
+                return true;
+            case 'i':
+            {
+                U32 bits;
+                if (!readU32(bits))
+                {
+                    return false;
+                }
+                value = (F32)(F64)(S32)bits;
+                return true;
+            }
+            case 'r':
+            {
+                U32 hi, lo;
+                if (!readU32(hi) || !readU32(lo))
+                {
+                    return false;
+                }
+                U64 bits = ((U64)hi << 32) | lo;
+                F64 real;
+                memcpy(&real, &bits, sizeof(real));
+                value = (F32)real;
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+
+        // Same as LLVector3::setValue() and friends: an array of reals, with
+        // zeros for missing elements or an undefined value
+        bool readVector(F32* values, U32 count)
+        {
+            for (U32 i = 0; i < count; ++i)
+            {
+                values[i] = 0.f;
+            }
+
+            U8 c;
+            if (!readByte(c))
+            {
+                return false;
+            }
+            if (c == '!')
+            {
+                return true;
+            }
+            U32 size;
+            if (c != '[' || !readU32(size))
+            {
+                return false;
+            }
+            for (U32 i = 0; i < size; ++i)
+            {
+                if (i < count ? !readReal(values[i]) : !skipValue(MESH_LLSD_MAX_DEPTH))
+                {
+                    return false;
+                }
+            }
+            return expectByte(']');
+        }
+
+        // { "Min" : [ ... ], "Max" : [ ... ] }
+        bool readDomain(F32* min, F32* max, U32 count)
+        {
+            for (U32 i = 0; i < count; ++i)
+            {
+                min[i] = max[i] = 0.f;
+            }
+
+            U8 c;
+            if (!readByte(c))
+            {
+                return false;
+            }
+            if (c == '!')
+            {
+                return true;
+            }
+            U32 size;
+            if (c != '{' || !readU32(size))
+            {
+                return false;
+            }
+            bool seen_min = false;
+            bool seen_max = false;
+            for (U32 i = 0; i < size; ++i)
+            {
+                std::string_view key;
+                if (!readKey(key))
+                {
+                    return false;
+                }
+                bool ok;
+                if (key == "Min")
+                {
+                    ok = !seen_min && readVector(min, count);
+                    seen_min = true;
+                }
+                else if (key == "Max")
+                {
+                    ok = !seen_max && readVector(max, count);
+                    seen_max = true;
+                }
+                else
+                {
+                    ok = skipValue(MESH_LLSD_MAX_DEPTH);
+                }
+                if (!ok)
+                {
+                    return false;
+                }
+            }
+            return expectByte('}');
+        }
+
+        bool skipValue(S32 depth)
+        {
+            U8 c;
+            if (depth <= 0 || !readByte(c))
+            {
+                return false;
+            }
+            U32 size;
+            switch (c)
+            {
+            case '!':
+            case '0':
+            case '1':
+                return true;
+            case 'i':
+                return skip(4);
+            case 'r':
+            case 'd':
+                return skip(8);
+            case 'u':
+                return skip(16);
+            case 's':
+            case 'l':
+            case 'b':
+                return readLength(size) && skip(size);
+            case '[':
+                if (!readU32(size))
+                {
+                    return false;
+                }
+                for (U32 i = 0; i < size; ++i)
+                {
+                    if (!skipValue(depth - 1))
+                    {
+                        return false;
+                    }
+                }
+                return expectByte(']');
+            case '{':
+                if (!readU32(size))
+                {
+                    return false;
+                }
+                for (U32 i = 0; i < size; ++i)
+                {
+                    std::string_view key;
+                    if (!readKey(key) || !skipValue(depth - 1))
+                    {
+                        return false;
+                    }
+                }
+                return expectByte('}');
+            default:
+                // Notation style strings and anything else unusual
+                return false;
+            }
+        }
+
+    private:
+        const U8* mCur;
+        const U8* mEnd;
+    };
+
+    void get_binary_field(const LLSD& sd, const U8*& data, size_t& size)
+    {
+        const LLSD::Binary& binary = sd.asBinary();
+        data = binary.empty() ? nullptr : binary.data();
+        size = binary.size();
+    }
+
+    // The loops below do the same arithmetic as the per vertex LLVector4a
+    // code in unpackVolumeFacesInternal(), in the same order, so the results
+    // are identical. They just convert the 16 bit values with one
+    // instruction rather than three scalar conversions and a set.
+
+    // xyz, 6 bytes per vertex
+    void dequantize_positions(const U8* in, U32 num_verts, const LLVector4a& range, const LLVector4a& min, LLVector4a* out)
+    {
+        const __m128 max_u16 = _mm_set1_ps(65535.f);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i mask_xyz = _mm_set_epi32(0, -1, -1, -1);
+
+        U32 j = 0;
+        // The 8 byte load also picks up the next vertex's x, so the last
+        // vertex is done separately
+        for (; j + 1 < num_verts; ++j)
+        {
+            __m128i q = _mm_loadl_epi64((const __m128i*)(in + j * 6));
+            q = _mm_and_si128(_mm_unpacklo_epi16(q, zero), mask_xyz);
+            __m128 v = _mm_div_ps(_mm_cvtepi32_ps(q), max_u16);
+            out[j] = _mm_add_ps(_mm_mul_ps(v, range), min);
+        }
+        for (; j < num_verts; ++j)
+        {
+            const U16* v = (const U16*)(in + j * 6);
+            out[j].set((F32)v[0], (F32)v[1], (F32)v[2]);
+            out[j].div(65535.f);
+            out[j].mul(range);
+            out[j].add(min);
+        }
+    }
+
+    // xyz in [-1, 1], 6 bytes per vertex
+    void dequantize_normals(const U8* in, U32 num_verts, LLVector4a* out)
+    {
+        const __m128 max_u16 = _mm_set1_ps(65535.f);
+        const __m128 two = _mm_set1_ps(2.f);
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i mask_xyz = _mm_set_epi32(0, -1, -1, -1);
+
+        U32 j = 0;
+        for (; j + 1 < num_verts; ++j)
+        {
+            __m128i q = _mm_loadl_epi64((const __m128i*)(in + j * 6));
+            q = _mm_and_si128(_mm_unpacklo_epi16(q, zero), mask_xyz);
+            __m128 v = _mm_div_ps(_mm_cvtepi32_ps(q), max_u16);
+            out[j] = _mm_sub_ps(_mm_mul_ps(v, two), one);
+        }
+        for (; j < num_verts; ++j)
+        {
+            const U16* n = (const U16*)(in + j * 6);
+            out[j].set((F32)n[0], (F32)n[1], (F32)n[2]);
+            out[j].div(65535.f);
+            out[j].mul(2.f);
+            out[j].sub(1.f);
+        }
+    }
+
+    // uv, 4 bytes per vertex, two vertices per LLVector4a
+    void dequantize_tex_coords(const U8* in, U32 num_verts, const LLVector4a& range, const LLVector4a& min, LLVector4a* out)
+    {
+        const __m128 max_u16 = _mm_set1_ps(65535.f);
+        const __m128i zero = _mm_setzero_si128();
+
+        U32 j = 0;
+        for (; j + 1 < num_verts; j += 2)
+        {
+            __m128i q = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(in + j * 4)), zero);
+            __m128 v = _mm_div_ps(_mm_cvtepi32_ps(q), max_u16);
+            *out++ = _mm_add_ps(_mm_mul_ps(v, range), min);
+        }
+        if (j < num_verts)
+        {
+            S32 uv;
+            memcpy(&uv, in + j * 4, sizeof(uv));
+            __m128i q = _mm_unpacklo_epi16(_mm_cvtsi32_si128(uv), zero);
+            __m128 v = _mm_div_ps(_mm_cvtepi32_ps(q), max_u16);
+            *out = _mm_add_ps(_mm_mul_ps(v, range), min);
+        }
+    }
+}
+
 bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
 
+    if (sUseDirectMeshDecode)
+    {
+        std::unique_ptr<U8[]> in(new(std::nothrow) U8[size]);
+        if (!in)
+        {
+            LL_WARNS() << "Failed to allocate " << size << " bytes for LoD" << LL_ENDL;
+            return false;
+        }
+        is.read((char*)in.get(), size);
+        return unpackVolumeFaces(in.get(), size);
+    }
+
     //input stream is now pointing at a zlib compressed block of LLSD
     //decompress block
     LLSD mdl;
@@ -2306,6 +2739,44 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 
 bool LLVolume::unpackVolumeFaces(U8* in_data, S32 size)
 {
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    if (sUseDirectMeshDecode)
+    {
+        // Scratch space reused by every LoD decoded on this thread
+        static thread_local std::vector<U8> inflated;
+        static thread_local mesh_face_fields_t faces;
+
+        U32 uzip_result = LLUZipHelper::unzip(inflated, in_data, size);
+        if (uzip_result != LLUZipHelper::ZR_OK)
+        {
+            LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
+            return false;
+        }
+
+        llssize inflated_size = inflated.size();
+        const U8* data = (const U8*)strip_deprecated_header((char*)inflated.data(), inflated_size);
+
+        bool result = false;
+        bool read = readMeshFaceFields(data, inflated_size, faces);
+        if (read)
+        {
+            result = unpackVolumeFacesInternal(faces, true);
+        }
+
+        faces.clear();
+        if (inflated.capacity() > MESH_SCRATCH_MAX_KEEP)
+        {
+            std::vector<U8>().swap(inflated);
+        }
+
+        if (read)
+        {
+            return result;
+        }
+        LL_DEBUGS("MeshStreaming") << "Unexpected LoD layout, decoding it as LLSD instead" << LL_ENDL;
+    }
+
     //input data is now pointing at a zlib compressed block of LLSD
     //decompress block
     LLSD mdl;
@@ -2318,10 +2789,189 @@ bool LLVolume::unpackVolumeFaces(U8* in_data, S32 size)
     return unpackVolumeFacesInternal(mdl);
 }
 
+//static
+bool LLVolume::readMeshFaceFields(const U8* data, size_t size, mesh_face_fields_t& faces)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    LLMeshLODReader reader(data, size);
+
+    U32 face_count;
+    if (!reader.expectByte('[') || !reader.readU32(face_count) || face_count == 0)
+    {
+        return false;
+    }
+    // Each face takes at least 6 bytes, don't let a bad count allocate more
+    if (face_count > reader.bytesLeft() / 6)
+    {
+        return false;
+    }
+    faces.assign(face_count, MeshFaceFields());
+
+    for (MeshFaceFields& face : faces)
+    {
+        U32 key_count;
+        if (!reader.expectByte('{') || !reader.readU32(key_count))
+        {
+            return false;
+        }
+
+        // The LLSD parser keeps the first of two identical keys, don't
+        // bother working out which one matters
+        enum
+        {
+            SEEN_NO_GEOMETRY = 1 << 0,
+            SEEN_POSITION = 1 << 1,
+            SEEN_NORMAL = 1 << 2,
+            SEEN_TANGENT = 1 << 3,
+            SEEN_TEX_COORD = 1 << 4,
+            SEEN_TRIANGLES = 1 << 5,
+            SEEN_WEIGHTS = 1 << 6,
+            SEEN_POSITION_DOMAIN = 1 << 7,
+            SEEN_TEX_COORD_DOMAIN = 1 << 8,
+            SEEN_NORMALIZED_SCALE = 1 << 9
+        };
+        U32 seen = 0;
+
+        for (U32 k = 0; k < key_count; ++k)
+        {
+            std::string_view key;
+            if (!reader.readKey(key))
+            {
+                return false;
+            }
+
+            U32 field = 0;
+            bool ok;
+            if (key == "Position")
+            {
+                field = SEEN_POSITION;
+                ok = reader.readBinary(face.mPosition, face.mPositionSize);
+            }
+            else if (key == "Normal")
+            {
+                field = SEEN_NORMAL;
+                ok = reader.readBinary(face.mNormal, face.mNormalSize);
+            }
+            else if (key == "TexCoord0")
+            {
+                field = SEEN_TEX_COORD;
+                ok = reader.readBinary(face.mTexCoord, face.mTexCoordSize);
+            }
+            else if (key == "TriangleList")
+            {
+                field = SEEN_TRIANGLES;
+                ok = reader.readBinary(face.mTriangles, face.mTrianglesSize);
+            }
+            else if (key == "Tangent")
+            {
+                field = SEEN_TANGENT;
+                ok = reader.readBinary(face.mTangent, face.mTangentSize);
+            }
+            else if (key == "Weights")
+            {
+                field = SEEN_WEIGHTS;
+                face.mHasWeights = true;
+                ok = reader.readBinary(face.mWeights, face.mWeightsSize);
+            }
+            else if (key == "PositionDomain")
+            {
+                field = SEEN_POSITION_DOMAIN;
+                ok = reader.readDomain(face.mPositionMin.mV, face.mPositionMax.mV, 3);
+            }
+            else if (key == "TexCoord0Domain")
+            {
+                field = SEEN_TEX_COORD_DOMAIN;
+                ok = reader.readDomain(face.mTexCoordMin.mV, face.mTexCoordMax.mV, 2);
+            }
+            else if (key == "NormalizedScale")
+            {
+                field = SEEN_NORMALIZED_SCALE;
+                face.mHasNormalizedScale = true;
+                ok = reader.readVector(face.mNormalizedScale.mV, 3);
+            }
+            else
+            {
+                if (key == "NoGeometry")
+                {
+                    field = SEEN_NO_GEOMETRY;
+                    face.mNoGeometry = true;
+                }
+                ok = reader.skipValue(MESH_LLSD_MAX_DEPTH);
+            }
+
+            if (!ok || (seen & field))
+            {
+                return false;
+            }
+            seen |= field;
+        }
+
+        if (!reader.expectByte('}'))
+        {
+            return false;
+        }
+
+        // The vectorized unpack relies on the streams being complete, leave
+        // truncated ones to the LLSD path
+        size_t num_verts = face.mPositionSize / 6;
+        if (!face.mNoGeometry
+            && ((face.mNormalSize && face.mNormalSize < num_verts * 6)
+                || (face.mTexCoordSize && face.mTexCoordSize < num_verts * 4)))
+        {
+            return false;
+        }
+    }
+
+    return reader.expectByte(']');
+}
+
 bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 {
+    mesh_face_fields_t faces(mdl.size());
+
+    for (size_t i = 0; i < faces.size(); ++i)
     {
-        auto face_count = mdl.size();
+        const LLSD& sd = mdl[i];
+        MeshFaceFields& face = faces[i];
+
+        if (sd.has("NoGeometry"))
+        {
+            face.mNoGeometry = true;
+            continue;
+        }
+
+        get_binary_field(sd["Position"], face.mPosition, face.mPositionSize);
+        get_binary_field(sd["Normal"], face.mNormal, face.mNormalSize);
+        get_binary_field(sd["Tangent"], face.mTangent, face.mTangentSize);
+        get_binary_field(sd["TexCoord0"], face.mTexCoord, face.mTexCoordSize);
+        get_binary_field(sd["TriangleList"], face.mTriangles, face.mTrianglesSize);
+
+        face.mPositionMin.setValue(sd["PositionDomain"]["Min"]);
+        face.mPositionMax.setValue(sd["PositionDomain"]["Max"]);
+        face.mTexCoordMin.setValue(sd["TexCoord0Domain"]["Min"]);
+        face.mTexCoordMax.setValue(sd["TexCoord0Domain"]["Max"]);
+
+        face.mHasNormalizedScale = sd.has("NormalizedScale");
+        if (face.mHasNormalizedScale)
+        {
+            face.mNormalizedScale.setValue(sd["NormalizedScale"]);
+        }
+
+        face.mHasWeights = sd.has("Weights");
+        if (face.mHasWeights)
+        {
+            get_binary_field(sd["Weights"], face.mWeights, face.mWeightsSize);
+        }
+    }
+
+    return unpackVolumeFacesInternal(faces, false);
+}
+
+bool LLVolume::unpackVolumeFacesInternal(const mesh_face_fields_t& faces, bool vectorized)
+{
+    {
+        auto face_count = faces.size();
 
         if (face_count == 0)
         { //no faces unpacked, treat as failed decode
@@ -2334,8 +2984,9 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
         for (size_t i = 0; i < face_count; ++i)
         {
             LLVolumeFace& face = mVolumeFaces[i];
+            const MeshFaceFields& fields = faces[i];
 
-            if (mdl[i].has("NoGeometry"))
+            if (fields.mNoGeometry)
             { //face has no geometry, continue
                 face.resizeIndices(3);
                 face.resizeVertices(1);
@@ -2346,14 +2997,8 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 continue;
             }
 
-            const LLSD::Binary& pos = mdl[i]["Position"].asBinary();
-            const LLSD::Binary& norm = mdl[i]["Normal"].asBinary();
-            const LLSD::Binary& tangent = mdl[i]["Tangent"].asBinary();
-            const LLSD::Binary& tc = mdl[i]["TexCoord0"].asBinary();
-            const LLSD::Binary& idx = mdl[i]["TriangleList"].asBinary();
-
             //copy out indices
-            auto num_indices = idx.size() / 2;
+            auto num_indices = fields.mTrianglesSize / 2;
             const S32 indices_to_discard = num_indices % 3;
             if (indices_to_discard > 0)
             {
@@ -2369,20 +3014,16 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 continue;
             }
 
-            if (idx.empty() || face.mNumIndices < 3)
+            if (!fields.mTrianglesSize || face.mNumIndices < 3)
             { //why is there an empty index list?
                 LL_WARNS() << "Empty face present! Face index: " << i << " Total: " << face_count << LL_ENDL;
                 continue;
             }
 
-            U16* indices = (U16*) &(idx[0]);
-            for (U32 j = 0; j < num_indices; ++j)
-            {
-                face.mIndices[j] = indices[j];
-            }
+            memcpy(face.mIndices, fields.mTriangles, num_indices * sizeof(U16));
 
             //copy out vertices
-            U32 num_verts = static_cast<U32>(pos.size())/(3*2);
+            U32 num_verts = static_cast<U32>(fields.mPositionSize)/(3*2);
             face.resizeVertices(num_verts);
 
             if (num_verts > 0 && !face.mPositions)
@@ -2392,24 +3033,19 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 continue;
             }
 
-            LLVector3 minp;
-            LLVector3 maxp;
-            LLVector2 min_tc;
-            LLVector2 max_tc;
+            const LLVector3& minp = fields.mPositionMin;
+            const LLVector3& maxp = fields.mPositionMax;
+            const LLVector2& min_tc = fields.mTexCoordMin;
+            const LLVector2& max_tc = fields.mTexCoordMax;
 
-            minp.setValue(mdl[i]["PositionDomain"]["Min"]);
-            maxp.setValue(mdl[i]["PositionDomain"]["Max"]);
             LLVector4a min_pos, max_pos;
             min_pos.load3(minp.mV);
             max_pos.load3(maxp.mV);
 
-            min_tc.setValue(mdl[i]["TexCoord0Domain"]["Min"]);
-            max_tc.setValue(mdl[i]["TexCoord0Domain"]["Max"]);
-
             //unpack normalized scale/translation
-            if (mdl[i].has("NormalizedScale"))
+            if (fields.mHasNormalizedScale)
             {
-                face.mNormalizedScale.setValue(mdl[i]["NormalizedScale"]);
+                face.mNormalizedScale = fields.mNormalizedScale;
             }
             else
             {
@@ -2428,8 +3064,13 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
             LLVector4a* norm_out = face.mNormals;
             LLVector4a* tc_out = (LLVector4a*) face.mTexCoords;
 
+            if (vectorized)
+            {
+                dequantize_positions(fields.mPosition, num_verts, pos_range, min_pos, pos_out);
+            }
+            else
             {
-                U16* v = (U16*) &(pos[0]);
+                const U16* v = (const U16*) fields.mPosition;
                 for (U32 j = 0; j < num_verts; ++j)
                 {
                     pos_out->set((F32) v[0], (F32) v[1], (F32) v[2]);
@@ -2443,9 +3084,13 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
             }
 
             {
-                if (!norm.empty())
+                if (fields.mNormalSize && vectorized)
                 {
-                    U16* n = (U16*) &(norm[0]);
+                    dequantize_normals(fields.mNormal, num_verts, norm_out);
+                }
+                else if (fields.mNormalSize)
+                {
+                    const U16* n = (const U16*) fields.mNormal;
                     for (U32 j = 0; j < num_verts; ++j)
                     {
                         norm_out->set((F32) n[0], (F32) n[1], (F32) n[2]);
@@ -2468,10 +3113,10 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 
 #if 0 // keep this code for now in case we decide to add support for on-the-wire tangents
             {
-                if (!tangent.empty())
+                if (fields.mTangentSize)
                 {
                     face.allocateTangents(face.mNumVertices);
-                    U16* t = (U16*)&(tangent[0]);
+                    const U16* t = (const U16*) fields.mTangent;
 
                     // NOTE: tangents coming from the asset may not be mikkt space, but they should always be used by the GLTF shaders to
                     // maintain compliance with the GLTF spec
@@ -2495,9 +3140,13 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 #endif
 
             {
-                if (!tc.empty())
+                if (fields.mTexCoordSize && vectorized)
+                {
+                    dequantize_tex_coords(fields.mTexCoord, num_verts, tc_range, min_tc4, tc_out);
+                }
+                else if (fields.mTexCoordSize)
                 {
-                    U16* t = (U16*) &(tc[0]);
+                    const U16* t = (const U16*) fields.mTexCoord;
                     for (U32 j = 0; j < num_verts; j+=2)
                     {
                         if (j < num_verts-1)
@@ -2528,7 +3177,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 }
             }
 
-            if (mdl[i].has("Weights"))
+            if (fields.mHasWeights)
             {
                 face.allocateWeights(num_verts);
                 if (!face.mWeights && num_verts)
@@ -2539,12 +3188,13 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     continue;
                 }
 
-                const LLSD::Binary& weights = mdl[i]["Weights"].asBinary();
+                const U8* weights = fields.mWeights;
+                const size_t weights_size = fields.mWeightsSize;
 
                 U32 idx = 0;
 
                 U32 cur_vertex = 0;
-                while (idx < weights.size() && cur_vertex < num_verts)
+                while (idx < weights_size && cur_vertex < num_verts)
                 {
                     const U8 END_INFLUENCES = 0xFF;
                     U8 joint = weights[idx++];
@@ -2554,7 +3204,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     U32 joints[4] = {0,0,0,0};
                     LLVector4 joints_with_weights(0,0,0,0);
 
-                    while (joint != END_INFLUENCES && idx < weights.size())
+                    while (joint != END_INFLUENCES && idx < weights_size)
                     {
                         U16 influence = weights[idx++];
                         influence |= ((U16) weights[idx++] << 8);
@@ -2591,7 +3241,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     cur_vertex++;
                 }
 
-                if (cur_vertex != num_verts || idx != weights.size())
+                if (cur_vertex != num_verts || idx != weights_size)
                 {
                     LL_WARNS() << "Vertex weight count does not match vertex count!" << LL_ENDL;
                 }
@@ -1114,8 +1114,19 @@ protected:
 public:
     bool unpackVolumeFaces(std::istream& is, S32 size);
     bool unpackVolumeFaces(U8* in_data, S32 size);
+
+    // When true (the default) mesh LODs are decoded straight from the
+    // inflated asset instead of going through an LLSD tree. The LLSD path
+    // is kept as the fallback for layouts the direct decoder does not
+    // recognize, and as the reference the tests compare against.
+    static bool sUseDirectMeshDecode;
 private:
+    struct MeshFaceFields;
+    typedef std::vector<MeshFaceFields> mesh_face_fields_t;
+
     bool unpackVolumeFacesInternal(const LLSD& mdl);
+    bool unpackVolumeFacesInternal(const mesh_face_fields_t& faces, bool vectorized);
+    static bool readMeshFaceFields(const U8* data, size_t size, mesh_face_fields_t& faces);
 
 public:
     virtual void setMeshAssetLoaded(bool loaded);
@@ -0,0 +1,145 @@
+/**
+ * @file llcamera_test.cpp
+ * @date 2026-10
+ * @brief Test cases for the LLCamera frustum culling functions.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include "../llcamera.h"
+
+namespace
+{
+    // Camera at the origin looking down +x, frustum corners laid out the
+    // way LLViewerCamera::updateFrustumPlanes() does it.
+    void make_camera(LLCamera& camera)
+    {
+        const F32 n = 1.f, nh = 0.5f, f = 128.f, fh = 64.f;
+        LLVector3 frust[8] =
+        {
+            LLVector3(n,  nh, -nh), LLVector3(n, -nh, -nh), LLVector3(n, -nh, nh), LLVector3(n,  nh, nh),
+            LLVector3(f,  fh, -fh), LLVector3(f, -fh, -fh), LLVector3(f, -fh, fh), LLVector3(f,  fh, fh)
+        };
+        camera.calcAgentFrustumPlanes(frust);
+        camera.calcRegionFrustumPlanes(LLVector3(16.f, -32.f, 0.f), f);
+    }
+
+    F32 next_random(U32& seed, F32 lo, F32 hi)
+    {
+        seed = seed * 1664525 + 1013904223;
+        return lo + (hi - lo) * (F32)(seed >> 8) / (F32)(1 << 24);
+    }
+
+    // Runs the batched and the single box versions of one of the tests over
+    // a set of random boxes and counts the results that differ.
+    template <typename BATCH, typename SINGLE>
+    S32 count_mismatches(U32 seed, S32 counts[3], BATCH batch, SINGLE single)
+    {
+        S32 mismatches = 0;
+        for (U32 i = 0; i < 1000; i++)
+        {
+            LLCameraAABB4 boxes;
+            LLVector4a center[LLCameraAABB4::NUM_BOXES], radius[LLCameraAABB4::NUM_BOXES];
+            for (U32 j = 0; j < LLCameraAABB4::NUM_BOXES; j++)
+            {
+                center[j].set(next_random(seed, -40.f, 200.f), next_random(seed, -120.f, 120.f), next_random(seed, -120.f, 120.f));
+                F32 size = next_random(seed, 0.f, 1.f);
+                size = size * size * 48.f;
+                radius[j].set(size * next_random(seed, 0.25f, 1.f), size * next_random(seed, 0.25f, 1.f), size * next_random(seed, 0.25f, 1.f));
+                boxes.set(j, center[j], radius[j]);
+            }
+
+            S32 results[LLCameraAABB4::NUM_BOXES];
+            batch(boxes, results);
+            for (U32 j = 0; j < LLCameraAABB4::NUM_BOXES; j++)
+            {
+                S32 expected = single(center[j], radius[j]);
+                counts[expected]++;
+                if (results[j] != expected)
+                {
+                    mismatches++;
+                }
+            }
+        }
+        return mismatches;
+    }
+}
+
+namespace tut
+{
+    struct camera_data
+    {
+    };
+    typedef test_group<camera_data> camera_test;
+    typedef camera_test::object camera_object;
+    tut::camera_test tc("LLCamera");
+
+    template<> template<>
+    void camera_object::test<1>()
+    {
+        set_test_name("Batched AABB frustum tests match the single box tests");
+
+        LLCamera camera;
+        make_camera(camera);
+
+        S32 counts[3] = { 0, 0, 0 };
+        ensure_equals("AABBInFrustum4", count_mismatches(1, counts,
+            [&](const LLCameraAABB4& b, S32* r) { camera.AABBInFrustum4(b, r); },
+            [&](const LLVector4a& c, const LLVector4a& s) { return camera.AABBInFrustum(c, s); }), 0);
+        ensure_equals("AABBInFrustumNoFarClip4", count_mismatches(2, counts,
+            [&](const LLCameraAABB4& b, S32* r) { camera.AABBInFrustumNoFarClip4(b, r); },
+            [&](const LLVector4a& c, const LLVector4a& s) { return camera.AABBInFrustumNoFarClip(c, s); }), 0);
+        ensure_equals("AABBInRegionFrustum4", count_mismatches(3, counts,
+            [&](const LLCameraAABB4& b, S32* r) { camera.AABBInRegionFrustum4(b, r); },
+            [&](const LLVector4a& c, const LLVector4a& s) { return camera.AABBInRegionFrustum(c, s); }), 0);
+        ensure_equals("AABBInRegionFrustumNoFarClip4", count_mismatches(4, counts,
+            [&](const LLCameraAABB4& b, S32* r) { camera.AABBInRegionFrustumNoFarClip4(b, r); },
+            [&](const LLVector4a& c, const LLVector4a& s) { return camera.AABBInRegionFrustumNoFarClip(c, s); }), 0);
+
+        // make sure the boxes cover all the cases
+        ensure("some boxes outside", counts[0] > 0);
+        ensure("some boxes partly inside", counts[1] > 0);
+        ensure("some boxes inside", counts[2] > 0);
+    }
+
+    template<> template<>
+    void camera_object::test<2>()
+    {
+        set_test_name("Batched AABB frustum test with a user clip plane");
+
+        LLCamera camera;
+        make_camera(camera);
+        LLPlane clip(LLVector3(0.f, 0.f, 10.f), LLVector3(0.f, 0.f, 1.f));
+        camera.setUserClipPlane(clip);
+
+        S32 counts[3] = { 0, 0, 0 };
+        ensure_equals("AABBInFrustum4", count_mismatches(5, counts,
+            [&](const LLCameraAABB4& b, S32* r) { camera.AABBInFrustum4(b, r); },
+            [&](const LLVector4a& c, const LLVector4a& s) { return camera.AABBInFrustum(c, s); }), 0);
+        ensure_equals("AABBInFrustumNoFarClip4", count_mismatches(6, counts,
+            [&](const LLCameraAABB4& b, S32* r) { camera.AABBInFrustumNoFarClip4(b, r); },
+            [&](const LLVector4a& c, const LLVector4a& s) { return camera.AABBInFrustumNoFarClip(c, s); }), 0);
+    }
+}
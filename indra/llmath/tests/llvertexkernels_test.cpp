@@ -0,0 +1,254 @@
+/**
+ * @file llvertexkernels_test.cpp
+ * @date 2026-10
+ * @brief Test cases and benchmark for the batched vertex kernels.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include "../llvertexkernels.h"
+#include "../llmath.h"
+#include "../llmatrix4a.h"
+#include "../v2math.h"
+#include "../v4coloru.h"
+#include "lltimer.h"
+
+#include <vector>
+
+namespace
+{
+    typedef std::vector<LLVector4a> vec4a_list_t;
+
+    // the counts a face can have, every tail length and a few full batches
+    const S32 COUNTS[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 13, 64, 257 };
+
+    F32 next_random(U32& seed, F32 lo, F32 hi)
+    {
+        seed = seed * 1664525 + 1013904223;
+        return lo + (hi - lo) * (F32)(seed >> 8) / (F32)(1 << 24);
+    }
+
+    void make_matrix(U32& seed, LLMatrix4a& mat)
+    {
+        for (U32 i = 0; i < 4; ++i)
+        {
+            mat.mMatrix[i].set(next_random(seed, -2.f, 2.f), next_random(seed, -2.f, 2.f),
+                               next_random(seed, -2.f, 2.f), next_random(seed, -2.f, 2.f));
+        }
+    }
+
+    vec4a_list_t make_vectors(U32& seed, S32 count)
+    {
+        vec4a_list_t vectors(count);
+        for (LLVector4a& v : vectors)
+        {
+            v.set(next_random(seed, -100.f, 100.f), next_random(seed, -100.f, 100.f),
+                  next_random(seed, -100.f, 100.f), next_random(seed, -1.f, 1.f) < 0.f ? -1.f : 1.f);
+        }
+        return vectors;
+    }
+
+    std::vector<LLVector2> make_tex_coords(U32& seed, S32 count)
+    {
+        std::vector<LLVector2> tex_coords(count);
+        for (LLVector2& tc : tex_coords)
+        {
+            tc.set(next_random(seed, -4.f, 4.f), next_random(seed, -4.f, 4.f));
+        }
+        return tex_coords;
+    }
+
+    bool same_bits(const vec4a_list_t& a, const vec4a_list_t& b)
+    {
+        return a.size() == b.size() && (a.empty() || !memcmp(a.data(), b.data(), a.size() * sizeof(LLVector4a)));
+    }
+
+    // The reference scalar transform may be contracted into fused
+    // multiply-adds on some targets, the batched one never is.
+    bool close_enough(const std::vector<LLVector2>& a, const std::vector<LLVector2>& b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            for (U32 j = 0; j < 2; ++j)
+            {
+                if (fabsf(a[i].mV[j] - b[i].mV[j]) > 1e-6f * llmax(1.f, fabsf(a[i].mV[j])))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Runs one kernel with the batched versions off, then on, and returns the
+    // time per call of each in microseconds.
+    template <typename KERNEL>
+    void time_kernel(const char* name, S32 count, KERNEL kernel)
+    {
+        const U32 CALLS = 200;
+        F64 time[2];
+        for (U32 batched = 0; batched < 2; ++batched)
+        {
+            LLVertexKernels::setUseBatched(batched);
+            kernel();
+            LLTimer timer;
+            for (U32 i = 0; i < CALLS; ++i)
+            {
+                kernel();
+            }
+            time[batched] = timer.getElapsedTimeF64() * 1000000.0 / CALLS;
+        }
+        LL_INFOS() << name << " " << count << " vertices: per vertex " << time[0] << "us, batched " << time[1]
+                   << "us (" << time[0] / llmax(time[1], 0.001) << "x)" << LL_ENDL;
+    }
+}
+
+namespace tut
+{
+    struct vertexkernels_data
+    {
+        ~vertexkernels_data()
+        {
+            LLVertexKernels::setUseBatched(true);
+        }
+    };
+    typedef test_group<vertexkernels_data> vertexkernels_test;
+    typedef vertexkernels_test::object vertexkernels_object;
+    tut::vertexkernels_test tvk("LLVertexKernels");
+
+    template<> template<>
+    void vertexkernels_object::test<1>()
+    {
+        set_test_name("Batched position, normal and tangent transforms match the per vertex ones");
+
+        U32 seed = 1;
+        for (S32 count : COUNTS)
+        {
+            LLMatrix4a mat;
+            make_matrix(seed, mat);
+            vec4a_list_t src = make_vectors(seed, count);
+            S32 dst_count = (count + 3) & ~3;
+            S32 tex_index = count % 7;
+
+            vec4a_list_t out[2];
+            for (U32 batched = 0; batched < 2; ++batched)
+            {
+                LLVertexKernels::setUseBatched(batched);
+                out[batched].resize(dst_count);
+                LLVertexKernels::transformPositions(mat, src.data(), count, out[batched].data(), dst_count, tex_index);
+            }
+            ensure(STRINGIZE("positions, " << count << " vertices"), same_bits(out[0], out[1]));
+            if (count > 0)
+            {
+                S32 w;
+                memcpy(&w, out[1][0].getF32ptr() + 3, sizeof(w));
+                ensure_equals(STRINGIZE("texture index, " << count << " vertices"), w, tex_index);
+            }
+
+            for (U32 batched = 0; batched < 2; ++batched)
+            {
+                LLVertexKernels::setUseBatched(batched);
+                out[batched].resize(count);
+                LLVertexKernels::rotateNormals(mat, src.data(), count, out[batched].data());
+            }
+            ensure(STRINGIZE("normals, " << count << " vertices"), same_bits(out[0], out[1]));
+
+            for (U32 batched = 0; batched < 2; ++batched)
+            {
+                LLVertexKernels::setUseBatched(batched);
+                LLVertexKernels::rotateTangents(mat, src.data(), count, out[batched].data());
+            }
+            ensure(STRINGIZE("tangents, " << count << " vertices"), same_bits(out[0], out[1]));
+            for (S32 i = 0; i < count; ++i)
+            {
+                ensure_equals("tangent sign kept", out[1][i][3], src[i][3]);
+            }
+        }
+    }
+
+    template<> template<>
+    void vertexkernels_object::test<2>()
+    {
+        set_test_name("Batched texture coordinate transform and color fill match the per vertex ones");
+
+        U32 seed = 2;
+        for (S32 count : COUNTS)
+        {
+            std::vector<LLVector2> src = make_tex_coords(seed, count);
+            F32 angle = next_random(seed, -F_PI, F_PI);
+            F32 os = next_random(seed, -1.f, 1.f), ot = next_random(seed, -1.f, 1.f);
+            F32 ms = next_random(seed, -4.f, 4.f), mt = next_random(seed, -4.f, 4.f);
+
+            std::vector<LLVector2> out[2];
+            for (U32 batched = 0; batched < 2; ++batched)
+            {
+                LLVertexKernels::setUseBatched(batched);
+                out[batched].resize(count);
+                LLVertexKernels::transformTexCoords(src.data(), count, out[batched].data(), cosf(angle), sinf(angle), os, ot, ms, mt);
+            }
+            ensure(STRINGIZE("tex coords, " << count << " vertices"), close_enough(out[0], out[1]));
+
+            // in place, as LLFace does after planar projection
+            std::vector<LLVector2> in_place = src;
+            LLVertexKernels::transformTexCoords(in_place.data(), count, in_place.data(), cosf(angle), sinf(angle), os, ot, ms, mt);
+            ensure(STRINGIZE("tex coords in place, " << count << " vertices"), in_place == out[1]);
+
+            // one past the end must be left alone
+            std::vector<LLColor4U> colors(count + 1, LLColor4U(1, 2, 3, 4));
+            LLColor4U color(200, 100, 50, 25);
+            LLVertexKernels::fillColors(color.asRGBA(), count, colors.data());
+            for (S32 i = 0; i < count; ++i)
+            {
+                ensure("color filled", colors[i] == color);
+            }
+            ensure("color past the end kept", colors[count] == LLColor4U(1, 2, 3, 4));
+        }
+    }
+
+    template<> template<>
+    void vertexkernels_object::test<3>()
+    {
+        set_test_name("Vertex kernel benchmark");
+
+        // about the size of a sculpty or a dense mesh face
+        const S32 COUNT = 4096;
+        U32 seed = 3;
+        LLMatrix4a mat;
+        make_matrix(seed, mat);
+        vec4a_list_t src = make_vectors(seed, COUNT);
+        vec4a_list_t dst(COUNT);
+        std::vector<LLVector2> tc_src = make_tex_coords(seed, COUNT);
+        std::vector<LLVector2> tc_dst(COUNT);
+        std::vector<LLColor4U> colors(COUNT);
+
+        time_kernel("transformPositions", COUNT, [&]() { LLVertexKernels::transformPositions(mat, src.data(), COUNT, dst.data(), COUNT, 3); });
+        time_kernel("transformTexCoords", COUNT, [&]() { LLVertexKernels::transformTexCoords(tc_src.data(), COUNT, tc_dst.data(), 0.8f, 0.6f, 0.25f, -0.5f, 2.f, 3.f); });
+        time_kernel("fillColors", COUNT, [&]() { LLVertexKernels::fillColors(0x80402010, COUNT, colors.data()); });
+    }
+}
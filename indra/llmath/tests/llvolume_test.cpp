@@ -0,0 +1,247 @@
+/**
+ * @file llvolume_test.cpp
+ * @date 2026-10
+ * @brief Test cases for decoding mesh LODs into LLVolume.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include "../llvolume.h"
+#include "llsdserialize.h"
+#include "llsdutil.h"
+
+#include <sstream>
+
+namespace
+{
+    LLSD::Binary make_u16_stream(U32 count, U32 seed)
+    {
+        LLSD::Binary out(count * 2);
+        for (U32 i = 0; i < count; ++i)
+        {
+            seed = seed * 1664525 + 1013904223;
+            U16 value = (U16)(seed >> 16);
+            out[i * 2] = (U8)(value & 0xFF);
+            out[i * 2 + 1] = (U8)(value >> 8);
+        }
+        return out;
+    }
+
+    LLSD make_domain(const LLSD& min, const LLSD& max)
+    {
+        LLSD domain;
+        domain["Min"] = min;
+        domain["Max"] = max;
+        return domain;
+    }
+
+    LLSD make_face(U32 num_verts, U32 num_triangles, U32 seed)
+    {
+        LLSD face;
+        face["Position"] = make_u16_stream(num_verts * 3, seed);
+        face["Normal"] = make_u16_stream(num_verts * 3, seed + 1);
+        face["TexCoord0"] = make_u16_stream(num_verts * 2, seed + 2);
+
+        LLSD::Binary indices(num_triangles * 6);
+        for (U32 i = 0; i < num_triangles * 3; ++i)
+        {
+            U16 index = (U16)((i * 7 + seed) % num_verts);
+            indices[i * 2] = (U8)(index & 0xFF);
+            indices[i * 2 + 1] = (U8)(index >> 8);
+        }
+        face["TriangleList"] = indices;
+
+        face["PositionDomain"] = make_domain(llsd::array(-0.5, -0.25, -1.0), llsd::array(0.5, 0.75, 1.0));
+        face["TexCoord0Domain"] = make_domain(llsd::array(0.0, -1.0), llsd::array(2.0, 1.0));
+        return face;
+    }
+
+    // Every face variant the decoder has to handle
+    LLSD make_lod()
+    {
+        LLSD lod = LLSD::emptyArray();
+
+        lod.append(make_face(64, 80, 1));
+
+        // Odd vertex count, so the last texture coordinate is on its own
+        LLSD odd = make_face(33, 40, 2);
+        odd["NormalizedScale"] = llsd::array(2.0, 0.5, 1.0);
+        lod.append(odd);
+
+        // Rigged, with a mix of influence counts
+        LLSD rigged = make_face(16, 12, 3);
+        LLSD::Binary weights;
+        for (U32 v = 0; v < 16; ++v)
+        {
+            U32 influences = v % 5;
+            for (U32 i = 0; i < influences; ++i)
+            {
+                weights.push_back((U8)(i + v));
+                weights.push_back((U8)(v * 37 + i));
+                weights.push_back((U8)(0x40 + i * 0x20));
+            }
+            if (influences < 4)
+            {
+                weights.push_back(0xFF);
+            }
+        }
+        rigged["Weights"] = weights;
+        lod.append(rigged);
+
+        LLSD empty;
+        empty["NoGeometry"] = true;
+        lod.append(empty);
+
+        // Keys the decoder does not use, integer domains and no normals
+        LLSD extra = make_face(20, 10, 4);
+        extra.erase("Normal");
+        extra["Extra"] = llsd::map("Nested", llsd::array(1, "two", 3.0));
+        extra["PositionDomain"] = make_domain(llsd::array(-1, -2, -3), llsd::array(1, 2, 3));
+        lod.append(extra);
+
+        return lod;
+    }
+
+    LLPointer<LLVolume> make_volume(U8 sculpt_type)
+    {
+        LLVolumeParams params;
+        params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+        params.setSculptID(LLUUID("c0b2e4d6-1a3f-4b5c-8d7e-9f0a1b2c3d4e"), sculpt_type);
+        return new LLVolume(params, 1.f);
+    }
+
+    bool decode(LLVolume* volume, const std::string& asset, bool direct)
+    {
+        bool saved = LLVolume::sUseDirectMeshDecode;
+        LLVolume::sUseDirectMeshDecode = direct;
+        bool result = volume->unpackVolumeFaces((U8*)asset.data(), (S32)asset.size());
+        LLVolume::sUseDirectMeshDecode = saved;
+        return result;
+    }
+
+    template <typename T>
+    bool same_array(const T* a, const T* b, S32 count)
+    {
+        if (!a || !b)
+        {
+            return a == b;
+        }
+        return memcmp(a, b, count * sizeof(T)) == 0;
+    }
+}
+
+namespace tut
+{
+    struct llvolume_data
+    {
+        void ensure_same_faces(const LLVolume* expected, const LLVolume* actual)
+        {
+            ensure_equals("face count", actual->getNumVolumeFaces(), expected->getNumVolumeFaces());
+            for (S32 i = 0; i < expected->getNumVolumeFaces(); ++i)
+            {
+                const LLVolumeFace& a = expected->getVolumeFace(i);
+                const LLVolumeFace& b = actual->getVolumeFace(i);
+                std::string face = "face " + std::to_string(i) + " ";
+
+                ensure_equals(face + "vertex count", b.mNumVertices, a.mNumVertices);
+                ensure_equals(face + "index count", b.mNumIndices, a.mNumIndices);
+                ensure(face + "positions", same_array(a.mPositions, b.mPositions, a.mNumVertices));
+                ensure(face + "normals", same_array(a.mNormals, b.mNormals, a.mNumVertices));
+                ensure(face + "texture coordinates", same_array(a.mTexCoords, b.mTexCoords, a.mNumVertices));
+                ensure(face + "indices", same_array(a.mIndices, b.mIndices, a.mNumIndices));
+                ensure(face + "weights", same_array(a.mWeights, b.mWeights, a.mNumVertices));
+                ensure(face + "tangents", same_array(a.mTangents, b.mTangents, a.mNumVertices));
+                ensure(face + "extents", same_array(a.mExtents, b.mExtents, 2));
+                ensure(face + "texture coordinate extents", same_array(a.mTexCoordExtents, b.mTexCoordExtents, 2));
+                ensure_equals(face + "normalized scale", b.mNormalizedScale, a.mNormalizedScale);
+            }
+        }
+    };
+    typedef test_group<llvolume_data> llvolume_test;
+    typedef llvolume_test::object llvolume_object;
+    tut::llvolume_test tut_llvolume_test("LLVolume");
+
+    template<> template<>
+    void llvolume_object::test<1>()
+    {
+        set_test_name("Direct mesh decode matches the LLSD decode");
+
+        LLSD lod = make_lod();
+        std::string asset = zip_llsd(lod);
+
+        for (U8 sculpt_type : { (U8)LL_SCULPT_TYPE_MESH, (U8)(LL_SCULPT_TYPE_MESH | LL_SCULPT_FLAG_MIRROR) })
+        {
+            LLPointer<LLVolume> expected = make_volume(sculpt_type);
+            LLPointer<LLVolume> actual = make_volume(sculpt_type);
+            ensure("LLSD decode", decode(expected, asset, false));
+            ensure("direct decode", decode(actual, asset, true));
+            ensure_same_faces(expected, actual);
+        }
+    }
+
+    template<> template<>
+    void llvolume_object::test<2>()
+    {
+        set_test_name("Unrecognized layouts fall back to the LLSD decode");
+
+        // A string where a real is expected is left to the LLSD parser
+        LLSD lod = make_lod();
+        lod[0]["NormalizedScale"] = llsd::array("1.5", 1.0, 1.0);
+        std::string asset = zip_llsd(lod);
+
+        LLPointer<LLVolume> expected = make_volume(LL_SCULPT_TYPE_MESH);
+        LLPointer<LLVolume> actual = make_volume(LL_SCULPT_TYPE_MESH);
+        ensure("LLSD decode", decode(expected, asset, false));
+        ensure("direct decode", decode(actual, asset, true));
+        ensure_same_faces(expected, actual);
+        ensure_equals("parsed scale", actual->getVolumeFace(0).mNormalizedScale.mV[VX], 1.5f);
+    }
+
+    template<> template<>
+    void llvolume_object::test<3>()
+    {
+        set_test_name("Stream decode and bad assets");
+
+        LLSD lod = make_lod();
+        std::string asset = zip_llsd(lod);
+
+        LLPointer<LLVolume> expected = make_volume(LL_SCULPT_TYPE_MESH);
+        LLPointer<LLVolume> actual = make_volume(LL_SCULPT_TYPE_MESH);
+        ensure("LLSD decode", decode(expected, asset, false));
+        std::istringstream stream(asset);
+        ensure("stream decode", actual->unpackVolumeFaces(stream, (S32)asset.size()));
+        ensure_same_faces(expected, actual);
+
+        std::string truncated = asset.substr(0, asset.size() / 2);
+        LLPointer<LLVolume> volume = make_volume(LL_SCULPT_TYPE_MESH);
+        ensure("truncated asset, LLSD decode", !decode(volume, truncated, false));
+        ensure("truncated asset, direct decode", !decode(volume, truncated, true));
+
+        LLSD no_faces = LLSD::emptyArray();
+        std::string empty = zip_llsd(no_faces);
+        ensure("no faces, LLSD decode", !decode(volume, empty, false));
+        ensure("no faces, direct decode", !decode(volume, empty, true));
+    }
+}
@@ -152,6 +152,15 @@ public:
     void updateMatrix(bool update_bounds = true);
     void getMinMax(LLVector3& min,LLVector3& max) const;
 
+    // What updateMatrix(false) does, for a world position and rotation the
+    // caller computed the same way update() would have.
+    void setWorldTransform(const LLVector3& pos, const LLQuaternion& rot)
+    {
+        mWorldPosition = pos;
+        mWorldRotation = rot;
+        mWorldMatrix.initAll(mScale, mWorldRotation, mWorldPosition);
+    }
+
 protected:
     LLMatrix4   mWorldMatrix;
     LLVector3   mMin;
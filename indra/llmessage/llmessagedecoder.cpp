@@ -0,0 +1,282 @@
+/**
+ * @file llmessagedecoder.cpp
+ * @brief Base of the typed template message decoders.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmessagedecoder.h"
+
+#if __FreeBSD__
+#include <arpa/inet.h>
+#endif
+
+//static
+bool LLMessageDecoder::matchesTemplate(const MessageLayout& layout, const LLMessageTemplate& msg_template)
+{
+    if (strcmp(layout.mName, msg_template.mName)
+        || layout.mNumber != msg_template.mMessageNumber
+        || layout.mNumBlocks != (S32)msg_template.mMemberBlocks.size())
+    {
+        return false;
+    }
+
+    // the template keeps blocks and variables in the order they are sent
+    S32 b = 0;
+    for (const LLMessageBlock* block : msg_template.mMemberBlocks)
+    {
+        const BlockLayout& block_layout = layout.mBlocks[b++];
+        if (strcmp(block_layout.mName, block->mName)
+            || block_layout.mType != block->mType
+            || (block->mType == MBT_MULTIPLE && block_layout.mNumber != block->mNumber)
+            || block_layout.mNumVariables != (S32)block->mMemberVariables.size())
+        {
+            return false;
+        }
+
+        S32 v = 0;
+        for (const LLMessageVariable* variable : block->mMemberVariables)
+        {
+            const VariableLayout& variable_layout = block_layout.mVariables[v++];
+            if (strcmp(variable_layout.mName, variable->getName())
+                || variable_layout.mType != variable->getType()
+                || variable_layout.mSize != variable->getSize())
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//static
+void LLMessageDecoder::copyBody(const LLMsgData& data, const MessageLayout& layout, std::vector<U8>& body)
+{
+    LLMessageStringTable* names = LLMessageStringTable::getInstance();
+    body.clear();
+    for (S32 b = 0; b < layout.mNumBlocks; ++b)
+    {
+        const BlockLayout& block_layout = layout.mBlocks[b];
+        char* block_name = names->getString(block_layout.mName);
+
+        // the generic decode keys block i by its name + i, and the first
+        // one knows how many there are
+        LLMsgData::msg_blk_data_map_t::const_iterator iter = data.mMemberBlocks.find(block_name);
+        S32 count = iter != data.mMemberBlocks.end() ? iter->second->mBlockNumber : 0;
+        if (block_layout.mType == MBT_VARIABLE)
+        {
+            count = llclamp(count, 0, 255);
+            body.push_back((U8)count);
+        }
+        else
+        {
+            count = block_layout.mNumber;
+        }
+
+        for (S32 i = 0; i < count; ++i)
+        {
+            iter = data.mMemberBlocks.find(block_name + i);
+            const LLMsgBlkData* block = iter != data.mMemberBlocks.end() ? iter->second : NULL;
+            for (S32 v = 0; v < block_layout.mNumVariables; ++v)
+            {
+                const VariableLayout& variable_layout = block_layout.mVariables[v];
+                const U8* value = NULL;
+                S32 size = 0;
+                if (block)
+                {
+                    LLMsgBlkData::msg_var_data_map_t::const_iterator var = block->mMemberVarData.find(names->getString(variable_layout.mName));
+                    if (var != block->mMemberVarData.end() && var->getData())
+                    {
+                        value = (const U8*)var->getData();
+                        size = var->getSize();
+                    }
+                }
+
+                S32 field_size = variable_layout.mSize;
+                if (variable_layout.mType == MVT_VARIABLE)
+                {
+                    // mSize is the size of the length in front of the data
+                    size = llmin(size, field_size == 1 ? 0xFF : field_size == 2 ? 0xFFFF : S32_MAX);
+                    U8 prefix[4];
+                    if (field_size == 1)
+                    {
+                        prefix[0] = (U8)size;
+                    }
+                    else if (field_size == 2)
+                    {
+                        U16 size16 = (U16)size;
+                        htolememcpy(prefix, &size16, MVT_U16, 2);
+                    }
+                    else
+                    {
+                        htolememcpy(prefix, &size, MVT_U32, 4);
+                    }
+                    body.insert(body.end(), prefix, prefix + field_size);
+                    field_size = size;
+                }
+
+                size_t pos = body.size();
+                body.resize(pos + field_size, 0);
+                if (value)
+                {
+                    // the generic decode swapped fixed size values to host order
+                    EMsgVariableType type = size == field_size ? variable_layout.mType : MVT_FIXED;
+                    htolememcpy(&body[pos], value, type, llmin(size, field_size));
+                }
+            }
+        }
+    }
+}
+
+bool LLMessageDecoder::getMessageBody(const LLMessageSystem* msg, const MessageLayout& layout, const U8*& body, S32& size)
+{
+    const LLMessageTemplate* msg_template = NULL;
+    if (!msg->getMessageBody(msg_template, body, size) || strcmp(msg_template->mName, layout.mName))
+    {
+        return false;
+    }
+    // only a registered decoder has been checked against the template
+    if (msg_template->isDecodedOnDemand())
+    {
+        return true;
+    }
+
+    const LLMsgData* data = msg->getMessageData();
+    if (!data)
+    {
+        return false;
+    }
+    copyBody(*data, layout, mGenericBody);
+    body = mGenericBody.data();
+    size = (S32)mGenericBody.size();
+    return true;
+}
+
+//static
+bool LLMessageDecoder::registerDecoder(LLMessageSystem* msg, const MessageLayout& layout)
+{
+    LLMessageTemplate* msg_template = msg->getTemplate(layout.mName);
+    if (!msg_template)
+    {
+        LL_WARNS("Messaging") << layout.mName << " is not a known message name!" << LL_ENDL;
+        return false;
+    }
+    if (!matchesTemplate(layout, *msg_template))
+    {
+        LL_WARNS("Messaging") << "Message template layout of " << layout.mName
+                              << " does not match the one its decoder was built for" << LL_ENDL;
+        return false;
+    }
+    msg_template->setDecodeOnDemand(true);
+    return true;
+}
+
+//static
+F32 LLMessageDecoder::readF32(const U8* p)
+{
+    F32 value = read<F32>(p, MVT_F32);
+    if (!llfinite(value))
+    {
+        LL_WARNS() << "non-finite F32 in message" << LL_ENDL;
+        value = 0.f;
+    }
+    return value;
+}
+
+//static
+F64 LLMessageDecoder::readF64(const U8* p)
+{
+    F64 value = read<F64>(p, MVT_F64);
+    if (!llfinite(value))
+    {
+        LL_WARNS() << "non-finite F64 in message" << LL_ENDL;
+        value = 0.0;
+    }
+    return value;
+}
+
+//static
+LLVector3 LLMessageDecoder::readVector3(const U8* p)
+{
+    LLVector3 vec;
+    htolememcpy(vec.mV, p, MVT_LLVector3, sizeof(vec.mV));
+    if (!vec.isFinite())
+    {
+        LL_WARNS() << "non-finite LLVector3 in message" << LL_ENDL;
+        vec.zeroVec();
+    }
+    return vec;
+}
+
+//static
+LLVector3d LLMessageDecoder::readVector3d(const U8* p)
+{
+    LLVector3d vec;
+    htolememcpy(vec.mdV, p, MVT_LLVector3d, sizeof(vec.mdV));
+    if (!vec.isFinite())
+    {
+        LL_WARNS() << "non-finite LLVector3d in message" << LL_ENDL;
+        vec.zeroVec();
+    }
+    return vec;
+}
+
+//static
+LLVector4 LLMessageDecoder::readVector4(const U8* p)
+{
+    LLVector4 vec;
+    htolememcpy(vec.mV, p, MVT_LLVector4, sizeof(vec.mV));
+    if (!vec.isFinite())
+    {
+        LL_WARNS() << "non-finite LLVector4 in message" << LL_ENDL;
+        vec.zeroVec();
+    }
+    return vec;
+}
+
+//static
+LLQuaternion LLMessageDecoder::readQuat(const U8* p)
+{
+    // only x, y and z are sent, see LLQuaternion::packToVector3()
+    LLVector3 vec;
+    htolememcpy(vec.mV, p, MVT_LLQuaternion, sizeof(vec.mV));
+
+    LLQuaternion quat;
+    if (vec.isFinite())
+    {
+        quat.unpackFromVector3(vec);
+    }
+    else
+    {
+        LL_WARNS() << "non-finite LLQuaternion in message" << LL_ENDL;
+        quat.loadIdentity();
+    }
+    return quat;
+}
+
+//static
+U16 LLMessageDecoder::readIPPort(const U8* p)
+{
+    return ntohs(read<U16>(p, MVT_IP_PORT));
+}
@@ -0,0 +1,179 @@
+/**
+ * @file llmessagedecoder.h
+ * @brief Base of the typed template message decoders.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESSAGEDECODER_H
+#define LL_LLMESSAGEDECODER_H
+
+#include "llmath.h"
+#include "llmessagetemplate.h"
+#include "llquaternion.h"
+#include "lluuid.h"
+#include "message.h"
+#include "v3dmath.h"
+#include "v3math.h"
+#include "v4math.h"
+
+#include <vector>
+
+// The generic template reader copies every variable of a message into an
+// LLMsgData of maps keyed by name before the handler runs, and the handler
+// then looks each value up again by name. For the busiest messages
+// scripts/generate_message_decoders.py writes a subclass of this one per
+// message (llmessagedecoders.h, in the build directory) that knows the
+// layout at compile time: decode() finds where each block starts in the
+// received packet in one pass, and the typed getters read values straight
+// out of the packet.
+//
+// The packet is only valid while the message handler runs, and so is a
+// decoded message. A message whose decoder is registered skips the generic
+// decode; the generic getters still work in its handler, they decode the
+// message on first use. A decoder that was not registered, e.g. because the
+// loaded template does not match it, reads the message from its generic
+// decode instead, so handlers only ever read through the decoder.
+class LLMessageDecoder
+{
+public:
+    // The layout a decoder was generated for, to check against the template
+    // the message system loads at run time.
+    struct VariableLayout
+    {
+        const char* mName;
+        EMsgVariableType mType;
+        S32 mSize;
+    };
+
+    struct BlockLayout
+    {
+        const char* mName;
+        EMsgBlockType mType;
+        S32 mNumber;
+        const VariableLayout* mVariables;
+        S32 mNumVariables;
+    };
+
+    struct MessageLayout
+    {
+        const char* mName;
+        U32 mNumber;
+        const BlockLayout* mBlocks;
+        S32 mNumBlocks;
+    };
+
+    // True if layout describes msg_template exactly.
+    static bool matchesTemplate(const MessageLayout& layout, const LLMessageTemplate& msg_template);
+
+    // Lays the generic decode of a message out in body the way layout says
+    // it is sent. Variables data does not have are zeros, and blocks it
+    // does not have are left out of Variable blocks.
+    static void copyBody(const LLMsgData& data, const MessageLayout& layout, std::vector<U8>& body);
+
+protected:
+    LLMessageDecoder() = default;
+
+    // a decoded message points into mGenericBody
+    LLMessageDecoder(const LLMessageDecoder&) = delete;
+    LLMessageDecoder& operator=(const LLMessageDecoder&) = delete;
+
+    // Body of the message msg is handling, after the packet header and
+    // message number, if it is the message layout describes. The packet has
+    // it unless the decoder was not registered; then it is copied out of
+    // the generic decode into mGenericBody.
+    bool getMessageBody(const LLMessageSystem* msg, const MessageLayout& layout, const U8*& body, S32& size);
+
+    static bool registerDecoder(LLMessageSystem* msg, const MessageLayout& layout);
+
+    // A missing count of a Variable block at the end of a message means no
+    // blocks, as it does for the generic reader.
+    static S32 readBlockCount(const U8* body, S32 size, S32& pos)
+    {
+        return pos < size ? body[pos++] : 0;
+    }
+
+    static bool skipFixed(S32 size, S32& pos, S32 bytes)
+    {
+        pos += bytes;
+        return pos <= size;
+    }
+
+    static bool skipVariable(const U8* body, S32 size, S32& pos, S32 prefix_size)
+    {
+        if (pos + prefix_size > size)
+        {
+            return false;
+        }
+        S32 length = readVariableSize(body + pos, prefix_size);
+        pos += prefix_size;
+        if (length < 0 || length > size - pos)
+        {
+            return false;
+        }
+        pos += length;
+        return true;
+    }
+
+    static S32 readVariableSize(const U8* p, S32 prefix_size)
+    {
+        switch (prefix_size)
+        {
+        case 1:
+            return *p;
+        case 2:
+            return read<U16>(p, MVT_U16);
+        default:
+            return read<U32>(p, MVT_U32);
+        }
+    }
+
+    template <typename T>
+    static T read(const U8* p, EMsgVariableType type)
+    {
+        T value;
+        htolememcpy(&value, p, type, sizeof(T));
+        return value;
+    }
+
+    // These zero non-finite values, as the generic getters do.
+    static F32 readF32(const U8* p);
+    static F64 readF64(const U8* p);
+    static LLVector3 readVector3(const U8* p);
+    static LLVector3d readVector3d(const U8* p);
+    static LLVector4 readVector4(const U8* p);
+    static LLQuaternion readQuat(const U8* p);
+
+    static LLUUID readUUID(const U8* p)
+    {
+        LLUUID id;
+        memcpy(id.mData, p, UUID_BYTES);
+        return id;
+    }
+
+    static U16 readIPPort(const U8* p);
+
+private:
+    std::vector<U8> mGenericBody;
+};
+
+#endif // LL_LLMESSAGEDECODER_H
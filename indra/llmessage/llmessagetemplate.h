@@ -286,6 +286,7 @@ public:
         mMaxDecodeTimePerMsg(0.f),
         mBanFromTrusted(false),
         mBanFromUntrusted(false),
+        mDecodeOnDemand(false),
         mHandlerFunc(NULL),
         mUserData(NULL)
     {
@@ -371,6 +372,18 @@ public:
         return false;
     }
 
+    // Set for messages whose handler reads them through an LLMessageDecoder:
+    // the reader leaves the generic decode until a generic getter needs it.
+    void setDecodeOnDemand(bool on_demand)
+    {
+        mDecodeOnDemand = on_demand;
+    }
+
+    bool isDecodedOnDemand() const
+    {
+        return mDecodeOnDemand;
+    }
+
     bool isUdpBanned() const
     {
         return mDeprecation == MD_UDPBLACKLISTED;
@@ -413,6 +426,8 @@ public:
     bool                                    mBanFromUntrusted;
 
 private:
+    bool                                    mDecodeOnDemand;
+
     // message handler function (this is set by each application)
     void                                    (*mHandlerFunc)(LLMessageSystem *msgsystem, void **user_data);
     void                                    **mUserData;
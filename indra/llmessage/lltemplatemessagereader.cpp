@@ -47,6 +47,8 @@ LLTemplateMessageReader::LLTemplateMessageReader(message_template_number_map_t&
     mReceiveSize(0),
     mCurrentRMessageTemplate(NULL),
     mCurrentRMessageData(NULL),
+    mCurrentRBuffer(NULL),
+    mMessageDataInvalid(false),
     mMessageNumbers(number_template_map)
 {
 }
@@ -65,6 +67,28 @@ void LLTemplateMessageReader::clearMessage()
     mCurrentRMessageTemplate = NULL;
     delete mCurrentRMessageData;
     mCurrentRMessageData = NULL;
+    mCurrentRBuffer = NULL;
+    mMessageDataInvalid = false;
+}
+
+// Messages decoded on demand only build the generic data if one of the
+// generic getters is used. Their handler is already running by then, so a
+// message that fails to decode is only warned about, and the getters read
+// it as empty instead of crashing.
+bool LLTemplateMessageReader::haveMessageData()
+{
+    if (!mCurrentRMessageData && mCurrentRBuffer && !mMessageDataInvalid)
+    {
+        if (!decodeMessageData(mCurrentRBuffer, mCurrentRSender, false))
+        {
+            LL_WARNS("Messaging") << "Invalid message " << getMessageName()
+                                  << " from " << mCurrentRSender << LL_ENDL;
+            delete mCurrentRMessageData;
+            mCurrentRMessageData = NULL;
+            mMessageDataInvalid = true;
+        }
+    }
+    return mCurrentRMessageData != NULL;
 }
 
 void LLTemplateMessageReader::getData(const char *blockname, const char *varname, void *datap, S32 size, S32 blocknum, S32 max_size)
@@ -76,9 +100,17 @@ void LLTemplateMessageReader::getData(const char *blockname, const char *varname
         return;
     }
 
-    if (!mCurrentRMessageData)
+    if (!haveMessageData())
     {
-        LL_ERRS() << "Invalid mCurrentMessageData in getData!" << LL_ENDL;
+        if (!mMessageDataInvalid)
+        {
+            LL_ERRS() << "Invalid mCurrentMessageData in getData!" << LL_ENDL;
+        }
+        // strings are cleared by getString()
+        if (size > 0)
+        {
+            memset(datap, 0, size);
+        }
         return;
     }
 
@@ -164,10 +196,14 @@ S32 LLTemplateMessageReader::getNumberOfBlocks(const char *blockname)
         return -1;
     }
 
-    if (!mCurrentRMessageData)
+    if (!haveMessageData())
     {
-        LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
-        return -1;
+        if (!mMessageDataInvalid)
+        {
+            LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
+        }
+        // no blocks to read
+        return 0;
     }
 
     char *bnamep = (char *)blockname;
@@ -191,9 +227,12 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, const char *varname)
         return LL_MESSAGE_ERROR;
     }
 
-    if (!mCurrentRMessageData)
-    {   // This is a serious error - crash
-        LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
+    if (!haveMessageData())
+    {
+        if (!mMessageDataInvalid)
+        {   // This is a serious error - crash
+            LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
+        }
         return LL_MESSAGE_ERROR;
     }
 
@@ -239,9 +278,12 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, S32 blocknum, const
         return LL_MESSAGE_ERROR;
     }
 
-    if (!mCurrentRMessageData)
-    {   // This is a serious error - crash
-        LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
+    if (!haveMessageData())
+    {
+        if (!mMessageDataInvalid)
+        {   // This is a serious error - crash
+            LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
+        }
         return LL_MESSAGE_ERROR;
     }
 
@@ -538,18 +580,9 @@ void LLTemplateMessageReader::logRanOffEndOfPacket( const LLHost& host, const S3
     gMessageSystem->callExceptionFunc(MX_RAN_OFF_END_OF_PACKET);
 }
 
-static LLTrace::BlockTimerStatHandle FTM_PROCESS_MESSAGES("Process Messages");
-
-// decode a given message
-bool LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender, bool custom )
+// build the generic data of the message in buffer
+bool LLTemplateMessageReader::decodeMessageData(const U8* buffer, const LLHost& sender, bool custom)
 {
-    LL_RECORD_BLOCK_TIME(FTM_PROCESS_MESSAGES);
-
-    llassert( mReceiveSize >= 0 );
-    llassert( mCurrentRMessageTemplate);
-    llassert( !mCurrentRMessageData );
-    delete mCurrentRMessageData; // just to make sure
-
     // The offset tells us how may bytes to skip after the end of the
     // message name.
     U8 offset = buffer[PHL_OFFSET];
@@ -714,6 +747,35 @@ bool LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender,
         return false;
     }
 
+    return true;
+}
+
+static LLTrace::BlockTimerStatHandle FTM_PROCESS_MESSAGES("Process Messages");
+
+// decode a given message
+bool LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender, bool custom )
+{
+    LL_RECORD_BLOCK_TIME(FTM_PROCESS_MESSAGES);
+
+    llassert( mReceiveSize >= 0 );
+    llassert( mCurrentRMessageTemplate);
+    llassert( !mCurrentRMessageData );
+    delete mCurrentRMessageData; // just to make sure
+    mCurrentRMessageData = NULL;
+
+    mCurrentRBuffer = buffer;
+    mCurrentRSender = sender;
+    mMessageDataInvalid = false;
+
+    // a message read through an LLMessageDecoder checks its own layout
+    if (custom || !mCurrentRMessageTemplate->isDecodedOnDemand())
+    {
+        if (!decodeMessageData(buffer, sender, custom))
+        {
+            return false;
+        }
+    }
+
     if (!custom)
     {
         static LLTimer decode_timer;
@@ -837,7 +899,9 @@ bool LLTemplateMessageReader::isUdpBanned() const
 //virtual
 void LLTemplateMessageReader::copyToBuilder(LLMessageBuilder& builder) const
 {
-    if(NULL == mCurrentRMessageTemplate)
+    // the generic data may not have been needed until now
+    if(NULL == mCurrentRMessageTemplate
+       || !const_cast<LLTemplateMessageReader*>(this)->haveMessageData())
     {
         return;
     }
@@ -849,3 +913,23 @@ LLMessageTemplate* LLTemplateMessageReader::getTemplate()
     return mCurrentRMessageTemplate;
 }
 
+const U8* LLTemplateMessageReader::getMessageBody(S32& size) const
+{
+    if (!mCurrentRBuffer || !mCurrentRMessageTemplate)
+    {
+        return NULL;
+    }
+    S32 pos = LL_PACKET_ID_SIZE + (S32)(mCurrentRMessageTemplate->mFrequency) + mCurrentRBuffer[PHL_OFFSET];
+    size = llmax(mReceiveSize - pos, 0);
+    return mCurrentRBuffer + pos;
+}
+
+const LLMsgData* LLTemplateMessageReader::getMessageData()
+{
+    if (mReceiveSize == -1 || !haveMessageData())
+    {
+        return NULL;
+    }
+    return mCurrentRMessageData;
+}
+
@@ -27,6 +27,7 @@
 #ifndef LL_LLTEMPLATEMESSAGEREADER_H
 #define LL_LLTEMPLATEMESSAGEREADER_H
 
+#include "llhost.h"
 #include "llmessagereader.h"
 
 #include <map>
@@ -109,6 +110,14 @@ public:
     bool decodeData(const U8* buffer, const LLHost& sender, bool custom = false );
     LLMessageTemplate* getTemplate();
 
+    // The message being handled as received, after the packet header and
+    // message number, for LLMessageDecoder. NULL outside of decodeData().
+    const U8* getMessageBody(S32& size) const;
+
+    // The generic decode of the message being handled, decoding it now if
+    // it was decoded on demand. NULL if there is no message.
+    const LLMsgData* getMessageData();
+
 private:
 
     void getData(const char *blockname, const char *varname, void *datap,
@@ -117,11 +126,17 @@ private:
     bool decodeTemplate(const U8* buffer, S32 buffer_size,  // inputs
                         LLMessageTemplate** msg_template, bool custom = false ); // outputs
 
+    bool decodeMessageData(const U8* buffer, const LLHost& sender, bool custom);
+    bool haveMessageData();
+
     void logRanOffEndOfPacket( const LLHost& host, const S32 where, const S32 wanted );
 
     S32 mReceiveSize;
     LLMessageTemplate* mCurrentRMessageTemplate;
     LLMsgData* mCurrentRMessageData;
+    const U8* mCurrentRBuffer;
+    LLHost mCurrentRSender;
+    bool mMessageDataInvalid;   // its decode on demand failed
     message_template_number_map_t& mMessageNumbers;
 };
 
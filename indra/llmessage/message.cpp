@@ -2942,6 +2942,31 @@ void LLMessageSystem::setHandlerFuncFast(const char *name, void (*handler_func)(
     }
 }
 
+LLMessageTemplate* LLMessageSystem::getTemplate(const char* name) const
+{
+    return get_ptr_in_map(mMessageTemplates, LLMessageStringTable::getInstance()->getString(name));
+}
+
+bool LLMessageSystem::getMessageBody(const LLMessageTemplate*& msg_template, const U8*& body, S32& size) const
+{
+    if (mMessageReader != mTemplateMessageReader)
+    {
+        return false;
+    }
+    msg_template = mTemplateMessageReader->getTemplate();
+    body = mTemplateMessageReader->getMessageBody(size);
+    return msg_template && body;
+}
+
+const LLMsgData* LLMessageSystem::getMessageData() const
+{
+    if (mMessageReader != mTemplateMessageReader)
+    {
+        return NULL;
+    }
+    return mTemplateMessageReader->getMessageData();
+}
+
 bool LLMessageSystem::callHandler(const char *name,
         bool trustedSource, LLMessageSystem* msg)
 {
@@ -386,6 +386,19 @@ public:
         setHandlerFuncFast(LLMessageStringTable::getInstance()->getString(name), handler_func, user_data);
     }
 
+    // The loaded template of a message, NULL if there is none.
+    LLMessageTemplate* getTemplate(const char* name) const;
+
+    // The message being handled as it was received, for LLMessageDecoder:
+    // its template and the bytes after the message number. False unless it
+    // came in as a template (UDP) message.
+    bool    getMessageBody(const LLMessageTemplate*& msg_template, const U8*& body, S32& size) const;
+
+    // The generic decode of the message being handled, for LLMessageDecoder.
+    // A message that skipped it is decoded now. NULL unless it came in as a
+    // template message.
+    const LLMsgData* getMessageData() const;
+
     // Set a callback function for a message system exception.
     void setExceptionFunc(EMessageException exception, msg_exception_callback func, void* data = NULL);
     // Call the specified exception func, and return true if a
@@ -0,0 +1,253 @@
+/**
+ * @file llmessagedecoder_test.cpp
+ * @date 2026-10
+ * @brief Test cases for the generated template message decoders.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llmessagedecoder.h"
+#include "llmessagedecoders.h"
+
+#include "../test/lltut.h"
+
+#include <vector>
+
+namespace
+{
+    typedef std::vector<U8> body_t;
+
+    void append_u16(body_t& body, U16 value)
+    {
+        body.push_back(value & 0xFF);
+        body.push_back(value >> 8);
+    }
+
+    void append_uuid(body_t& body, const LLUUID& id)
+    {
+        body.insert(body.end(), id.mData, id.mData + UUID_BYTES);
+    }
+
+    char* name(const char* str)
+    {
+        return LLMessageStringTable::getInstance()->getString(str);
+    }
+
+    // CoarseLocationUpdate as message_template.msg has it
+    LLMessageTemplate* make_coarse_location_template(EMsgVariableType you_type)
+    {
+        LLMessageTemplate* msg_template = new LLMessageTemplate("CoarseLocationUpdate",
+            LLMessageDecoders::CoarseLocationUpdate::MESSAGE_NUMBER, MFT_MEDIUM);
+
+        LLMessageBlock* block = new LLMessageBlock("Location", MBT_VARIABLE);
+        block->addVariable(name("X"), MVT_U8, 1);
+        block->addVariable(name("Y"), MVT_U8, 1);
+        block->addVariable(name("Z"), MVT_U8, 1);
+        msg_template->addBlock(block);
+
+        block = new LLMessageBlock("Index", MBT_SINGLE);
+        block->addVariable(name("You"), you_type, 2);
+        block->addVariable(name("Prey"), MVT_S16, 2);
+        msg_template->addBlock(block);
+
+        block = new LLMessageBlock("AgentData", MBT_VARIABLE);
+        block->addVariable(name("AgentID"), MVT_LLUUID, UUID_BYTES);
+        msg_template->addBlock(block);
+
+        return msg_template;
+    }
+
+    // adds block instance i of block_name to data the way the template
+    // reader does
+    LLMsgBlkData* add_block(LLMsgData& data, const char* block_name, S32 i, S32 count)
+    {
+        LLMsgBlkData* block = new LLMsgBlkData(name(block_name), count);
+        block->mName += i;
+        data.addBlock(block);
+        return block;
+    }
+}
+
+namespace tut
+{
+    struct messagedecoder_data
+    {
+    };
+    typedef test_group<messagedecoder_data> messagedecoder_test;
+    typedef messagedecoder_test::object messagedecoder_object;
+    tut::messagedecoder_test tmd("LLMessageDecoder");
+
+    template<> template<>
+    void messagedecoder_object::test<1>()
+    {
+        set_test_name("Fixed size variables of single and variable blocks");
+
+        LLUUID agent1("11111111-2222-3333-4444-555555555555");
+        LLUUID agent2("66666666-7777-8888-9999-aaaaaaaaaaaa");
+
+        body_t body;
+        body.push_back(2);
+        body.push_back(10); body.push_back(20); body.push_back(30);
+        body.push_back(40); body.push_back(50); body.push_back(60);
+        append_u16(body, 1);
+        append_u16(body, (U16)-1);
+        body.push_back(2);
+        append_uuid(body, agent1);
+        append_uuid(body, agent2);
+
+        LLMessageDecoders::CoarseLocationUpdate msg;
+        ensure("decoded", msg.decode(body.data(), (S32)body.size()));
+        ensure_equals("Location blocks", msg.getNumberOfLocationBlocks(), 2);
+        ensure_equals("first X", msg.getLocation(0).getX(), 10);
+        ensure_equals("first Z", msg.getLocation(0).getZ(), 30);
+        ensure_equals("second Y", msg.getLocation(1).getY(), 50);
+        ensure_equals("Index blocks", msg.getNumberOfIndexBlocks(), 1);
+        ensure_equals("You", msg.getIndex().getYou(), 1);
+        ensure_equals("Prey", msg.getIndex().getPrey(), -1);
+        ensure_equals("AgentData blocks", msg.getNumberOfAgentDataBlocks(), 2);
+        ensure_equals("first AgentID", msg.getAgentData(0).getAgentID(), agent1);
+        ensure_equals("second AgentID", msg.getAgentData(1).getAgentID(), agent2);
+
+        // a variable block count missing at the end means no blocks
+        body.resize(1 + 2 * 3 + 4);
+        ensure("decoded without the last block count", msg.decode(body.data(), (S32)body.size()));
+        ensure_equals("no AgentData blocks", msg.getNumberOfAgentDataBlocks(), 0);
+
+        // every shorter body is cut off inside a block
+        for (S32 size = 0; size < (S32)body.size(); ++size)
+        {
+            ensure(STRINGIZE("cut short at " << size), !msg.decode(body.data(), size));
+        }
+    }
+
+    template<> template<>
+    void messagedecoder_object::test<2>()
+    {
+        set_test_name("Variable size variables");
+
+        const U8 data[] = { 1, 2, 3, 4, 5 };
+
+        body_t body;
+        body.push_back('L');
+        append_u16(body, sizeof(data));
+        body.insert(body.end(), data, data + sizeof(data));
+
+        LLMessageDecoders::LayerData msg;
+        ensure("decoded", msg.decode(body.data(), (S32)body.size()));
+        ensure_equals("Type", msg.getLayerID().getType(), 'L');
+        ensure_equals("Data size", msg.getLayerData().getDataSize(), (S32)sizeof(data));
+        ensure("Data", !memcmp(msg.getLayerData().getData(), data, sizeof(data)));
+
+        for (S32 size = 0; size < (S32)body.size(); ++size)
+        {
+            ensure(STRINGIZE("cut short at " << size), !msg.decode(body.data(), size));
+        }
+
+        // a length running past the end of the packet
+        body[1] = 0xFF;
+        ensure("length past the end", !msg.decode(body.data(), (S32)body.size()));
+    }
+
+    template<> template<>
+    void messagedecoder_object::test<3>()
+    {
+        set_test_name("Decoders are checked against the template loaded at run time");
+
+        const LLMessageDecoder::MessageLayout& layout = LLMessageDecoders::CoarseLocationUpdate::getLayout();
+
+        LLMessageTemplate* msg_template = make_coarse_location_template(MVT_S16);
+        ensure("matching template", LLMessageDecoder::matchesTemplate(layout, *msg_template));
+        delete msg_template;
+
+        msg_template = make_coarse_location_template(MVT_U16);
+        ensure("variable type changed", !LLMessageDecoder::matchesTemplate(layout, *msg_template));
+        ensure("different message", !LLMessageDecoder::matchesTemplate(LLMessageDecoders::LayerData::getLayout(), *msg_template));
+        delete msg_template;
+    }
+
+    template<> template<>
+    void messagedecoder_object::test<4>()
+    {
+        set_test_name("A decoder that is not registered reads the generic decode");
+
+        LLUUID agent("11111111-2222-3333-4444-555555555555");
+        U8 x = 10, y = 20, z = 30;
+        S16 you = 1;
+
+        LLMsgData data(name("CoarseLocationUpdate"));
+        for (S32 i = 0; i < 2; ++i)
+        {
+            LLMsgBlkData* block = add_block(data, "Location", i, 2);
+            block->addVariable(name("X"), MVT_U8);
+            block->addData(name("X"), &x, 1, MVT_U8);
+            block->addVariable(name("Y"), MVT_U8);
+            block->addData(name("Y"), &y, 1, MVT_U8);
+            // no Z in the second block
+            if (!i)
+            {
+                block->addVariable(name("Z"), MVT_U8);
+                block->addData(name("Z"), &z, 1, MVT_U8);
+            }
+        }
+        LLMsgBlkData* block = add_block(data, "Index", 0, 1);
+        block->addVariable(name("You"), MVT_S16);
+        block->addData(name("You"), &you, 2, MVT_S16);
+        block = add_block(data, "AgentData", 0, 1);
+        block->addVariable(name("AgentID"), MVT_LLUUID);
+        block->addData(name("AgentID"), agent.mData, UUID_BYTES, MVT_LLUUID);
+
+        body_t body;
+        LLMessageDecoder::copyBody(data, LLMessageDecoders::CoarseLocationUpdate::getLayout(), body);
+
+        LLMessageDecoders::CoarseLocationUpdate msg;
+        ensure("decoded", msg.decode(body.data(), (S32)body.size()));
+        ensure_equals("Location blocks", msg.getNumberOfLocationBlocks(), 2);
+        ensure_equals("first Z", msg.getLocation(0).getZ(), 30);
+        ensure_equals("second Y", msg.getLocation(1).getY(), 20);
+        ensure_equals("missing Z", msg.getLocation(1).getZ(), 0);
+        ensure_equals("You", msg.getIndex().getYou(), 1);
+        ensure_equals("missing Prey", msg.getIndex().getPrey(), 0);
+        ensure_equals("AgentData blocks", msg.getNumberOfAgentDataBlocks(), 1);
+        ensure_equals("AgentID", msg.getAgentData(0).getAgentID(), agent);
+
+        // variable size data gets its length back
+        const U8 patch[] = { 1, 2, 3, 4, 5 };
+        U8 type = 'L';
+        LLMsgData layer(name("LayerData"));
+        block = add_block(layer, "LayerID", 0, 1);
+        block->addVariable(name("Type"), MVT_U8);
+        block->addData(name("Type"), &type, 1, MVT_U8);
+        block = add_block(layer, "LayerData", 0, 1);
+        block->addVariable(name("Data"), MVT_VARIABLE);
+        block->addData(name("Data"), patch, sizeof(patch), MVT_VARIABLE);
+
+        LLMessageDecoder::copyBody(layer, LLMessageDecoders::LayerData::getLayout(), body);
+
+        LLMessageDecoders::LayerData layer_msg;
+        ensure("LayerData decoded", layer_msg.decode(body.data(), (S32)body.size()));
+        ensure_equals("Type", layer_msg.getLayerID().getType(), 'L');
+        ensure_equals("Data size", layer_msg.getLayerData().getDataSize(), (S32)sizeof(patch));
+        ensure("Data", !memcmp(layer_msg.getLayerData().getData(), patch, sizeof(patch)));
+    }
+}
@@ -1016,6 +1016,9 @@ LLVertexBuffer::LLVertexBuffer(U32 typemask)
 // list of mapped buffers
 // NOTE: must not be LLPointer<LLVertexBuffer> to avoid breaking non-ref-counted LLVertexBuffer instances
 static std::vector<LLVertexBuffer*> sMappedBuffers;
+// guards sMappedBuffers and the mapped region lists, face geometry may be
+// written (and so mapped) from several threads at once
+static std::mutex sMappedBuffersMutex;
 
 //static
 void LLVertexBuffer::flushBuffers()
@@ -1281,6 +1284,7 @@ bool expand_region(LLVertexBuffer::MappedRegion& region, U32 start, U32 end)
 U8* LLVertexBuffer::mapVertexBuffer(LLVertexBuffer::AttributeType type, U32 index, S32 count)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+    std::lock_guard<std::mutex> lock(sMappedBuffersMutex);
     _mapBuffer();
 
     if (count == -1)
@@ -1318,6 +1322,7 @@ U8* LLVertexBuffer::mapVertexBuffer(LLVertexBuffer::AttributeType type, U32 inde
 U8* LLVertexBuffer::mapIndexBuffer(U32 index, S32 count)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+    std::lock_guard<std::mutex> lock(sMappedBuffersMutex);
     _mapBuffer();
 
     if (count == -1)
@@ -164,6 +164,7 @@
 #include "llworkerthread.h"
 #include "lltexturecache.h"
 #include "lltexturefetch.h"
+#include "lltexturefetchtrace.h"
 #include "llimageworker.h"
 #include "llevents.h"
 
@@ -657,6 +658,7 @@ LLAppViewer::LLAppViewer()
     mReportedCrash(false),
     mNumSessions(0),
     mGeneralThreadPool(nullptr),
+    mFrameThreadPool(nullptr),
     mPurgeCache(false),
     mPurgeCacheOnExit(false),
     mPurgeUserDataOnExit(false),
@@ -1269,6 +1271,8 @@ bool LLAppViewer::init()
     LLViewerCamera::createInstance();
     LL::GLTFSceneManager::createInstance();
 
+    // Texture fetch trace recording and replay, see TextureFetchTraceRecord
+    LLTextureFetchTrace::initClass();
 
 #if LL_WINDOWS
     if (!mSecondInstance)
@@ -2080,6 +2084,8 @@ bool LLAppViewer::cleanup()
         gDirUtilp->deleteDirAndContents(user_path);
     }
 
+    LLTextureFetchTrace::cleanupClass();
+
     // Delete workers first
     // shotdown all worker threads before deleting them in case of co-dependencies
     mAppCoreHttp.requestStop();
@@ -2091,6 +2097,10 @@ bool LLAppViewer::cleanup()
     {
         mGeneralThreadPool->close();
     }
+    if (mFrameThreadPool)
+    {
+        mFrameThreadPool->close();
+    }
 
     sTextureFetch->shutDownTextureCacheThread() ;
     LLLFSThread::sLocal->shutdown();
@@ -2122,6 +2132,8 @@ bool LLAppViewer::cleanup()
     sPurgeDiskCacheThread = NULL;
     delete mGeneralThreadPool;
     mGeneralThreadPool = NULL;
+    delete mFrameThreadPool;
+    mFrameThreadPool = NULL;
 
     if (LLFastTimerView::sAnalyzePerformance)
     {
@@ -2256,6 +2268,12 @@ bool LLAppViewer::initThreads()
     threadCounts["ImageDecode"] = image_decode_count;
     gSavedSettings.setLLSD("ThreadPoolSizes", threadCounts);
 
+    // let a large image spread its decode over a few cores so it doesn't
+    // hold up the end of a burst on one thread, but never more than the
+    // ImageDecode pool would leave it with every decode thread busy
+    S32 threads_per_image = llclamp((S32)gSavedSettings.getU32("ImageDecodeThreadsPerImage"), 1, cores);
+    LLImageJ2C::setDecodeThreads(threads_per_image, (S32)gSavedSettings.getU32("ImageDecodeMinPixelsPerThread"), cores);
+
     // Image decoding
     LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true);
     LLAppViewer::sTextureCache = new LLTextureCache(enable_threads && true);
@@ -2266,6 +2284,11 @@ bool LLAppViewer::initThreads()
     // general task background thread (LLPerfStats, etc)
     LLAppViewer::instance()->initGeneralThread();
 
+    // helpers for work the main thread waits on every frame (culling). The
+    // main thread does its share too, so leave a core for everything else.
+    mFrameThreadPool = new LL::ThreadPool("FrameTasks", llclamp(cores - 2, 1, 8));
+    mFrameThreadPool->start();
+
     LLAppViewer::sPurgeDiskCacheThread = new LLPurgeDiskCacheThread();
 
     if (LLTrace::BlockTimer::sLog || LLTrace::BlockTimer::sMetricLog)
@@ -4329,7 +4352,7 @@ U32 LLAppViewer::getObjectCacheVersion()
 {
     // Viewer object cache version, change if object update
     // format changes. JC
-    const U32 INDRA_OBJECT_CACHE_VERSION = 17;
+    const U32 INDRA_OBJECT_CACHE_VERSION = 18;
 
     return INDRA_OBJECT_CACHE_VERSION;
 }
@@ -4988,6 +5011,8 @@ void LLAppViewer::idle()
             }
             {
                 LL_RECORD_BLOCK_TIME(FTM_REGION_UPDATE);
+                const F32 max_pending_update_time = .002f; // 2ms
+                gObjectList.processPendingUpdates(max_pending_update_time);
                 const F32 max_region_update_time = .001f; // 1ms
                 LLWorld::getInstance()->updateRegions(max_region_update_time);
             }
@@ -5080,8 +5105,10 @@ void LLAppViewer::idle()
 
     LLWorld::getInstance()->updateVisibilities();
     {
+        const F32 max_pending_update_time = .002f; // 2ms
         const F32 max_region_update_time = .001f; // 1ms
         LL_RECORD_BLOCK_TIME(FTM_REGION_UPDATE);
+        gObjectList.processPendingUpdates(max_pending_update_time);
         LLWorld::getInstance()->updateRegions(max_region_update_time);
     }
 
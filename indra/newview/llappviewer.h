@@ -333,6 +333,7 @@ private:
     static LLTextureFetch* sTextureFetch;
     static LLPurgeDiskCacheThread* sPurgeDiskCacheThread;
     LL::ThreadPool* mGeneralThreadPool;
+    LL::ThreadPool* mFrameThreadPool;
 
     S32 mNumSessions;
 
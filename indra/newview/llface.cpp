@@ -34,6 +34,7 @@
 #include "llvolume.h"
 #include "m3math.h"
 #include "llmatrix4a.h"
+#include "llvertexkernels.h"
 #include "v3color.h"
 
 #include "lldefs.h"
@@ -762,50 +763,6 @@ static void xform(LLVector2 &tex_coord, F32 cosAng, F32 sinAng, F32 offS, F32 of
     tex_coord.mV[1] = t;
 }
 
-// Transform the texture coordinates for this face.
-static void xform4a(LLVector4a &tex_coord, const LLVector4a& trans, const LLVector4Logical& mask, const LLVector4a& rot0, const LLVector4a& rot1, const LLVector4a& offset, const LLVector4a& scale)
-{
-    //tex coord is two coords, <s0, t0, s1, t1>
-    LLVector4a st;
-
-    // Texture transforms are done about the center of the face.
-    st.setAdd(tex_coord, trans);
-
-    // Handle rotation
-    LLVector4a rot_st;
-
-    // <s0 * cosAng, s0*-sinAng, s1*cosAng, s1*-sinAng>
-    LLVector4a s0;
-    s0.splat(st, 0);
-    LLVector4a s1;
-    s1.splat(st, 2);
-    LLVector4a ss;
-    ss.setSelectWithMask(mask, s1, s0);
-
-    LLVector4a a;
-    a.setMul(rot0, ss);
-
-    // <t0*sinAng, t0*cosAng, t1*sinAng, t1*cosAng>
-    LLVector4a t0;
-    t0.splat(st, 1);
-    LLVector4a t1;
-    t1.splat(st, 3);
-    LLVector4a tt;
-    tt.setSelectWithMask(mask, t1, t0);
-
-    LLVector4a b;
-    b.setMul(rot1, tt);
-
-    st.setAdd(a,b);
-
-    // Then scale
-    st.mul(scale);
-
-    // Then offset
-    tex_coord.setAdd(st, offset);
-}
-
-
 bool less_than_max_mag(const LLVector4a& vec)
 {
     LLVector4a MAX_MAG;
@@ -1649,38 +1606,8 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
                         else
                         {
                             LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("ggv - texgen 2");
-                            F32* dst = (F32*) tex_coords0.get();
-                            LLVector4a* src = (LLVector4a*) vf.mTexCoords;
-
-                            LLVector4a trans;
-                            trans.splat(-0.5f);
-
-                            LLVector4a rot0;
-                            rot0.set(cos_ang, -sin_ang, cos_ang, -sin_ang);
-
-                            LLVector4a rot1;
-                            rot1.set(sin_ang, cos_ang, sin_ang, cos_ang);
-
-                            LLVector4a scale;
-                            scale.set(ms, mt, ms, mt);
-
-                            LLVector4a offset;
-                            offset.set(os+0.5f, ot+0.5f, os+0.5f, ot+0.5f);
-
-                            LLVector4Logical mask;
-                            mask.clear();
-                            mask.setElement<2>();
-                            mask.setElement<3>();
-
-                            S32 count = num_vertices/2 + num_vertices%2;
-
-                            for (S32 i = 0; i < count; i++)
-                            {
-                                LLVector4a res = *src++;
-                                xform4a(res, trans, mask, rot0, rot1, offset, scale);
-                                res.store4a(dst);
-                                dst += 4;
-                            }
+                            LLVertexKernels::transformTexCoords(vf.mTexCoords, num_vertices, tex_coords0.get(),
+                                                                cos_ang, sin_ang, os, ot, ms, mt);
                         }
                     }
                     else
@@ -1719,8 +1646,9 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
                             *tex_coords0++ = tc;
                         }
                     }
-                    else if (xforms != XFORM_NONE)
+                    else
                     {
+                        LLVector2* dst = tex_coords0.get();
                         for (S32 i = 0; i < num_vertices; i++)
                         {
                             LLVector2 tc(vf.mTexCoords[i]);
@@ -1730,23 +1658,12 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
                             vec.mul(scalea);
                             planarProjection(tc, norm, center, vec);
 
-                            xform(tc, cos_ang, sin_ang, os, ot, ms, mt);
-
-                            *tex_coords0++ = tc;
+                            dst[i] = tc;
                         }
-                    }
-                    else
-                    {
-                        for (S32 i = 0; i < num_vertices; i++)
-                        {
-                            LLVector2 tc(vf.mTexCoords[i]);
-                            LLVector4a& norm = vf.mNormals[i];
-                            LLVector4a& center = *(vf.mCenter);
-                            LLVector4a vec = vf.mPositions[i];
-                            vec.mul(scalea);
-                            planarProjection(tc, norm, center, vec);
 
-                            *tex_coords0++ = tc;
+                        if (xforms != XFORM_NONE)
+                        {
+                            LLVertexKernels::transformTexCoords(dst, num_vertices, dst, cos_ang, sin_ang, os, ot, ms, mt);
                         }
                     }
                 }
@@ -1826,6 +1743,7 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
                         if (texgen == LLTextureEntry::TEX_GEN_PLANAR)
                         {
                             LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("tgd - planar");
+                            LLVector2* tcs = dst.get();
                             for (S32 i = 0; i < num_vertices; i++)
                             {
                                 LLVector2 tc(vf.mTexCoords[i]);
@@ -1837,42 +1755,46 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
 
                                 planarProjection(tc, norm, center, vec);
 
-                                if (tex_mode && mTextureMatrix)
+                                tcs[i] = tc;
+                            }
+
+                            // transform the projected coordinates in a second pass
+                            if (tex_mode && mTextureMatrix)
+                            {
+                                for (S32 i = 0; i < num_vertices; i++)
                                 {
-                                    LLVector3 tmp(tc.mV[0], tc.mV[1], 0.f);
+                                    LLVector3 tmp(tcs[i].mV[0], tcs[i].mV[1], 0.f);
                                     tmp = tmp * *mTextureMatrix;
-                                    tc.mV[0] = tmp.mV[0];
-                                    tc.mV[1] = tmp.mV[1];
-                                }
-                                else if (do_xform)
-                                {
-                                    xform(tc, cos_ang, sin_ang, os, ot, ms, mt);
+                                    tcs[i].set(tmp.mV[0], tmp.mV[1]);
                                 }
-
-                                *dst++ = tc;
+                            }
+                            else if (do_xform)
+                            {
+                                LLVertexKernels::transformTexCoords(tcs, num_vertices, tcs, cos_ang, sin_ang, os, ot, ms, mt);
                             }
                         }
                         else
                         {
                             LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("tgd - transform");
 
-                            for (S32 i = 0; i < num_vertices; i++)
+                            // pick the transform once per face rather than per vertex
+                            LLVector2* tcs = dst.get();
+                            if (tex_mode && mTextureMatrix)
                             {
-                                LLVector2 tc(vf.mTexCoords[i]);
-
-                                if (tex_mode && mTextureMatrix)
+                                for (S32 i = 0; i < num_vertices; i++)
                                 {
-                                    LLVector3 tmp(tc.mV[0], tc.mV[1], 0.f);
+                                    LLVector3 tmp(vf.mTexCoords[i].mV[0], vf.mTexCoords[i].mV[1], 0.f);
                                     tmp = tmp * *mTextureMatrix;
-                                    tc.mV[0] = tmp.mV[0];
-                                    tc.mV[1] = tmp.mV[1];
-                                }
-                                else if (do_xform)
-                                {
-                                    xform(tc, cos_ang, sin_ang, os, ot, ms, mt);
+                                    tcs[i].set(tmp.mV[0], tmp.mV[1]);
                                 }
-
-                                *dst++ = tc;
+                            }
+                            else if (do_xform)
+                            {
+                                LLVertexKernels::transformTexCoords(vf.mTexCoords, num_vertices, tcs, cos_ang, sin_ang, os, ot, ms, mt);
+                            }
+                            else
+                            {
+                                memcpy(tcs, vf.mTexCoords, num_vertices * sizeof(LLVector2));
                             }
                         }
                     }
@@ -1885,6 +1807,7 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
 
                     mVObjp->getVolume()->genTangents(face_index);
 
+                    const bool is_active = mDrawablep->isActive();
                     for (S32 i = 0; i < num_vertices; i++)
                     {
                         LLVector4a tangent = vf.mTangents[i];
@@ -1901,7 +1824,7 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
                         mat_normal.rotate(t, binormal);
 
                         //VECTORIZE THIS
-                        if (mDrawablep->isActive())
+                        if (is_active)
                         {
                             LLVector3 t;
                             t.set(binormal.getF32ptr());
@@ -1922,61 +1845,16 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
 
         if (rebuild_pos)
         {
-            LLVector4a* src = vf.mPositions;
-
-            //_mm_prefetch((char*)src, _MM_HINT_T0);
-
-            LLVector4a* end = src+num_vertices;
-            //LLVector4a* end_64 = end-4;
-
             llassert(num_vertices > 0);
 
             mVertexBuffer->getVertexStrider(vert, mGeomIndex, mGeomCount);
 
-
-            F32* dst = (F32*) vert.get();
-            F32* end_f32 = dst+mGeomCount*4;
-
-            //_mm_prefetch((char*)dst, _MM_HINT_NTA);
-            //_mm_prefetch((char*)src, _MM_HINT_NTA);
-
-            //_mm_prefetch((char*)dst, _MM_HINT_NTA);
-
-
-            LLVector4a res0; //,res1,res2,res3;
-
-            LLVector4a texIdx;
-
             S32 index = mTextureIndex < FACE_DO_NOT_BATCH_TEXTURES ? mTextureIndex : 0;
 
-            F32 val = 0.f;
-            S32* vp = (S32*) &val;
-            *vp = index;
-
             llassert(index < LLGLSLShader::sIndexedTextureChannels);
 
-            LLVector4Logical mask;
-            mask.clear();
-            mask.setElement<3>();
-
-            texIdx.set(0,0,0,val);
-
-            LLVector4a tmp;
-
-
-            while (src < end)
-            {
-                mat_vert.affineTransform(*src++, res0);
-                tmp.setSelectWithMask(mask, texIdx, res0);
-                tmp.store4a((F32*) dst);
-                dst += 4;
-            }
-
-            while (dst < end_f32)
-            {
-                res0.store4a((F32*) dst);
-                dst += 4;
-            }
+            LLVertexKernels::transformPositions(mat_vert, vf.mPositions, num_vertices,
+                                                (LLVector4a*) vert.get(), mGeomCount, index);
         }
 
         if (rebuild_normal)
@@ -1984,44 +1862,17 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
             LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("getGeometryVolume - normal");
 
             mVertexBuffer->getNormalStrider(norm, mGeomIndex, mGeomCount);
-            F32* normals = (F32*) norm.get();
-            LLVector4a* src = vf.mNormals;
-            LLVector4a* end = src+num_vertices;
-
-            while (src < end)
-            {
-                LLVector4a normal;
-                mat_normal.rotate(*src++, normal);
-                normal.store4a(normals);
-                normals += 4;
-            }
+            LLVertexKernels::rotateNormals(mat_normal, vf.mNormals, num_vertices, (LLVector4a*) norm.get());
         }
 
         if (rebuild_tangent)
         {
             LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("getGeometryVolume - tangent");
             mVertexBuffer->getTangentStrider(tangent, mGeomIndex, mGeomCount);
-            F32* tangents = (F32*) tangent.get();
 
             mVObjp->getVolume()->genTangents(face_index);
 
-            LLVector4Logical mask;
-            mask.clear();
-            mask.setElement<3>();
-
-            LLVector4a* src = vf.mTangents;
-            LLVector4a* end = vf.mTangents +num_vertices;
-
-            while (src < end)
-            {
-                LLVector4a tangent_out;
-                mat_normal.rotate(*src, tangent_out);
-                tangent_out.setSelectWithMask(mask, *src, tangent_out);
-                tangent_out.store4a(tangents);
-
-                src++;
-                tangents += 4;
-            }
+            LLVertexKernels::rotateTangents(mat_normal, vf.mTangents, num_vertices, (LLVector4a*) tangent.get());
         }
 
         if (rebuild_weights && vf.mWeights)
@@ -2037,25 +1888,8 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
             LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("getGeometryVolume - color");
             mVertexBuffer->getColorStrider(colors, mGeomIndex, mGeomCount);
 
-            LLVector4a src;
-
-            U32 vec[4];
-            vec[0] = vec[1] = vec[2] = vec[3] = color.asRGBA();
-
-            src.loadua((F32*) vec);
-
-            F32* dst = (F32*) colors.get();
-            S32 num_vecs = num_vertices/4;
-            if (num_vertices%4 > 0)
-            {
-                ++num_vecs;
-            }
-
-            for (S32 i = 0; i < num_vecs; i++)
-            {
-                src.store4a(dst);
-                dst += 4;
-            }
+            // whole groups of four, the padding included, as before
+            LLVertexKernels::fillColors(color.asRGBA(), (num_vertices + 3) & ~3, colors.get());
         }
 
         if (rebuild_emissive)
@@ -2071,30 +1905,9 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
                 glow = (U8)llclamp((S32)(tep->getGlow() * 255), 0, 255);
             }
 
-            LLVector4a src;
-
-
             LLColor4U glow4u = LLColor4U(0,0,0,glow);
 
-            U32 glow32 = glow4u.asRGBA();
-
-            U32 vec[4];
-            vec[0] = vec[1] = vec[2] = vec[3] = glow32;
-
-            src.loadua((F32*) vec);
-
-            F32* dst = (F32*) emissive.get();
-            S32 num_vecs = num_vertices/4;
-            if (num_vertices%4 > 0)
-            {
-                ++num_vecs;
-            }
-
-            for (S32 i = 0; i < num_vecs; i++)
-            {
-                src.store4a(dst);
-                dst += 4;
-            }
+            LLVertexKernels::fillColors(glow4u.asRGBA(), (num_vertices + 3) & ~3, emissive.get());
         }
     }
 
@@ -2117,6 +1930,39 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
     return true;
 }
 
+bool LLFace::prepareGeometryVolume(S32 face_index, bool force_rebuild)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_FACE;
+
+    LLVolume* volume = mVObjp.notNull() ? mVObjp->getVolume() : nullptr;
+    const LLTextureEntry* tep = mVObjp.notNull() ? mVObjp->getTE(face_index) : nullptr;
+    if (!volume || !tep || mVertexBuffer.isNull() ||
+        face_index < 0 || face_index >= volume->getNumVolumeFaces())
+    {
+        return false;
+    }
+
+    // the selection highlight buffer is created, cloned and freed with GL calls
+    if (mVertexBufferGLTF.notNull() || (tep->isSelected() && tep->getGLTFRenderMaterial()))
+    {
+        return false;
+    }
+
+    // same conditions under which getGeometryVolume() calls genTangents()
+    bool full_rebuild = force_rebuild || mDrawablep->isState(LLDrawable::REBUILD_VOLUME);
+    bool rebuild_pos = full_rebuild || mDrawablep->isState(LLDrawable::REBUILD_POSITION);
+    bool rebuild_tcoord = full_rebuild || mDrawablep->isState(LLDrawable::REBUILD_TCOORD);
+    bool rebuild_tangent = rebuild_pos && mVertexBuffer->hasDataType(LLVertexBuffer::TYPE_TANGENT);
+
+    if (rebuild_tangent ||
+        (rebuild_tcoord && (tep->getBumpmap() || tep->getTexGen() != LLTextureEntry::TEX_GEN_DEFAULT)))
+    {
+        volume->genTangents(face_index);
+    }
+
+    return true;
+}
+
 void LLFace::renderIndexed()
 {
     if (mVertexBuffer.notNull())
@@ -163,6 +163,11 @@ public:
                             bool force_rebuild = false,
                             bool no_debug_assert = false,
                             bool rebuild_for_gltf = false);
+    // Does the parts of getGeometryVolume() that touch state shared with
+    // other faces (volume tangents, the GLTF selection buffer) so that
+    // getGeometryVolume() can then run off the main thread. Returns false
+    // if this face still has to be rebuilt on the main thread.
+    bool prepareGeometryVolume(S32 face_index, bool force_rebuild);
 
     // For avatar
     U16          getGeometryAvatar(
@@ -0,0 +1,491 @@
+/**
+ * @file llinventorycachefile.cpp
+ * @brief Binary, memory mapped inventory cache
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorycachefile.h"
+
+#include "llfile.h"
+#include "llpermissions.h"
+#include "llsaleinfo.h"
+#include "llviewerinventory.h"
+
+#include <unordered_map>
+
+static const char INV_CACHE_MAGIC[4] = { 'S', 'L', 'I', 'C' };
+const U32 LLInventoryCacheFile::FORMAT_VERSION = 2;
+
+// All sections start on this alignment so records can be used in place
+static const size_t SECTION_ALIGNMENT = 8;
+
+static const U32 NULL_UUID_INDEX = 0;
+
+struct LLInventoryCacheFile::Header
+{
+    char mMagic[4];
+    U32 mFormatVersion;
+    S32 mInvCacheVersion;
+    U32 mUUIDCount;
+    U32 mCategoryCount;
+    U32 mItemCount;
+    U32 mStringPoolSize;
+    U32 mReserved;
+    U64 mUUIDOffset;
+    U64 mStringOffset;
+    U64 mCategoryOffset;
+    U64 mItemOffset;
+};
+
+struct LLInventoryCacheFile::StringRef
+{
+    U32 mOffset;
+    U32 mLength;
+};
+
+struct LLInventoryCacheFile::CategoryRecord
+{
+    U32 mID;
+    U32 mParentID;
+    U32 mOwnerID;
+    U32 mThumbnailID;
+    StringRef mName;
+    S32 mVersion;
+    S8 mPreferredType;
+    U8 mPad[3];
+};
+
+struct LLInventoryCacheFile::ItemRecord
+{
+    U32 mID;
+    U32 mParentID;
+    U32 mAssetID;
+    U32 mThumbnailID;
+
+    // permissions block
+    U32 mCreatorID;
+    U32 mOwnerID;
+    U32 mLastOwnerID;
+    U32 mGroupID;
+    U32 mMaskBase;
+    U32 mMaskOwner;
+    U32 mMaskGroup;
+    U32 mMaskEveryone;
+    U32 mMaskNextOwner;
+
+    // sale block
+    S32 mSalePrice;
+    U8 mSaleType;
+
+    S8 mInventoryType;
+    // S16 so that AT_UNKNOWN (255) and AT_NONE (-1) both survive
+    S16 mAssetType;
+
+    U32 mFlags;
+    S32 mCreationDate;
+    StringRef mName;
+    StringRef mDescription;
+};
+
+namespace
+{
+    // Builds the uuid table and string pool while the records are written
+    class LLInventoryCacheWriter
+    {
+    public:
+        LLInventoryCacheWriter()
+        {
+            mUUIDs.push_back(LLUUID::null);
+            mUUIDIndex[LLUUID::null] = NULL_UUID_INDEX;
+        }
+
+        U32 addUUID(const LLUUID& id)
+        {
+            auto inserted = mUUIDIndex.emplace(id, (U32)mUUIDs.size());
+            if (inserted.second)
+            {
+                mUUIDs.push_back(id);
+            }
+            return inserted.first->second;
+        }
+
+        void addString(const std::string& str, U32& offset, U32& length)
+        {
+            offset = (U32)mStrings.size();
+            length = (U32)str.size();
+            mStrings.append(str);
+        }
+
+        std::vector<LLUUID> mUUIDs;
+        std::unordered_map<LLUUID, U32> mUUIDIndex;
+        std::string mStrings;
+    };
+
+    size_t align_section(size_t offset)
+    {
+        return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+
+    bool write_section(LLFILE* fp, size_t& offset, const void* data, size_t size)
+    {
+        static const U8 padding[SECTION_ALIGNMENT] = { 0 };
+        const size_t aligned = align_section(offset);
+        if (aligned != offset && fwrite(padding, 1, aligned - offset, fp) != aligned - offset)
+        {
+            return false;
+        }
+        offset = aligned;
+        if (size && fwrite(data, 1, size, fp) != size)
+        {
+            return false;
+        }
+        offset += size;
+        return true;
+    }
+}
+
+LLInventoryCacheFile::LLInventoryCacheFile() :
+    mObsolete(false)
+{
+    // These are written to disk as is - bump FORMAT_VERSION if they change
+    static_assert(sizeof(Header) == 64, "inventory cache header layout changed");
+    static_assert(sizeof(CategoryRecord) == 32, "inventory cache category layout changed");
+    static_assert(sizeof(ItemRecord) == 84, "inventory cache item layout changed");
+}
+
+// static
+bool LLInventoryCacheFile::save(const std::string& filename,
+                                S32 inv_cache_version,
+                                const cat_array_t& categories,
+                                const item_array_t& items)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    LLInventoryCacheWriter writer;
+
+    std::vector<CategoryRecord> cat_records;
+    cat_records.reserve(categories.size());
+    for (const LLPointer<LLViewerInventoryCategory>& cat : categories)
+    {
+        if (cat->getVersion() == LLViewerInventoryCategory::VERSION_UNKNOWN)
+        {
+            continue;
+        }
+
+        CategoryRecord record = {};
+        record.mID = writer.addUUID(cat->getUUID());
+        record.mParentID = writer.addUUID(cat->getParentUUID());
+        record.mOwnerID = writer.addUUID(cat->getOwnerID());
+        record.mThumbnailID = writer.addUUID(cat->getThumbnailUUID());
+        writer.addString(cat->getName(), record.mName.mOffset, record.mName.mLength);
+        record.mVersion = cat->getVersion();
+        record.mPreferredType = (S8)cat->getPreferredType();
+        cat_records.push_back(record);
+    }
+
+    std::vector<ItemRecord> item_records;
+    item_records.reserve(items.size());
+    for (const LLPointer<LLViewerInventoryItem>& item : items)
+    {
+        // Use the item's own fields, not the ones of a link target
+        const LLPermissions& perm = item->LLInventoryItem::getPermissions();
+        const LLSaleInfo& sale_info = item->LLInventoryItem::getSaleInfo();
+
+        ItemRecord record = {};
+        record.mID = writer.addUUID(item->getUUID());
+        record.mParentID = writer.addUUID(item->getParentUUID());
+        record.mAssetID = writer.addUUID(item->LLInventoryItem::getAssetUUID());
+        record.mThumbnailID = writer.addUUID(item->LLInventoryItem::getThumbnailUUID());
+
+        record.mCreatorID = writer.addUUID(perm.getCreator());
+        record.mOwnerID = writer.addUUID(perm.getOwner());
+        record.mLastOwnerID = writer.addUUID(perm.getLastOwner());
+        record.mGroupID = writer.addUUID(perm.getGroup());
+        record.mMaskBase = perm.getMaskBase();
+        record.mMaskOwner = perm.getMaskOwner();
+        record.mMaskGroup = perm.getMaskGroup();
+        record.mMaskEveryone = perm.getMaskEveryone();
+        record.mMaskNextOwner = perm.getMaskNextOwner();
+
+        record.mSalePrice = sale_info.getSalePrice();
+        record.mSaleType = (U8)sale_info.getSaleType();
+
+        // Same as the LLSD cache: a type this viewer has no name for is
+        // stored as unknown, which invalidates the parent folder on load
+        LLAssetType::EType asset_type = item->getActualType();
+        if (LLAssetType::BADLOOKUP == LLAssetType::lookup(asset_type))
+        {
+            asset_type = LLAssetType::AT_UNKNOWN;
+        }
+        record.mAssetType = (S16)asset_type;
+        record.mInventoryType = (S8)item->LLInventoryItem::getInventoryType();
+        record.mFlags = item->LLInventoryItem::getFlags();
+        record.mCreationDate = (S32)item->LLInventoryItem::getCreationDate();
+        writer.addString(item->LLInventoryItem::getName(), record.mName.mOffset, record.mName.mLength);
+        writer.addString(item->LLInventoryItem::getActualDescription(), record.mDescription.mOffset, record.mDescription.mLength);
+        item_records.push_back(record);
+    }
+
+    Header header = {};
+    memcpy(header.mMagic, INV_CACHE_MAGIC, sizeof(header.mMagic));
+    header.mFormatVersion = FORMAT_VERSION;
+    header.mInvCacheVersion = inv_cache_version;
+    header.mUUIDCount = (U32)writer.mUUIDs.size();
+    header.mCategoryCount = (U32)cat_records.size();
+    header.mItemCount = (U32)item_records.size();
+    header.mStringPoolSize = (U32)writer.mStrings.size();
+    header.mUUIDOffset = align_section(sizeof(Header));
+    header.mStringOffset = align_section(header.mUUIDOffset + writer.mUUIDs.size() * sizeof(LLUUID));
+    header.mCategoryOffset = align_section(header.mStringOffset + writer.mStrings.size());
+    header.mItemOffset = align_section(header.mCategoryOffset + cat_records.size() * sizeof(CategoryRecord));
+
+    const std::string temp_filename = filename + ".tmp";
+    LLFILE* fp = LLFile::fopen(temp_filename, "wb");
+    if (!fp)
+    {
+        LL_WARNS("Inventory") << "Unable to save inventory to: " << temp_filename << LL_ENDL;
+        return false;
+    }
+
+    size_t offset = 0;
+    bool success = write_section(fp, offset, &header, sizeof(Header))
+        && write_section(fp, offset, writer.mUUIDs.data(), writer.mUUIDs.size() * sizeof(LLUUID))
+        && write_section(fp, offset, writer.mStrings.data(), writer.mStrings.size())
+        && write_section(fp, offset, cat_records.data(), cat_records.size() * sizeof(CategoryRecord))
+        && write_section(fp, offset, item_records.data(), item_records.size() * sizeof(ItemRecord));
+    llassert(!success || offset == header.mItemOffset + item_records.size() * sizeof(ItemRecord));
+    success = (LLFile::close(fp) == 0) && success;
+
+    if (success)
+    {
+        success = (LLFile::replace(temp_filename, filename) == 0);
+    }
+
+    if (!success)
+    {
+        LL_WARNS("Inventory") << "Failed to save inventory to: " << filename << LL_ENDL;
+        LLFile::remove(temp_filename, ENOENT);
+        return false;
+    }
+
+    LL_INFOS("Inventory") << "Inventory saved: " << cat_records.size() << " categories, " << item_records.size()
+                          << " items, " << writer.mUUIDs.size() << " unique ids, " << offset << " bytes." << LL_ENDL;
+    return true;
+}
+
+bool LLInventoryCacheFile::open(const std::string& filename, S32 inv_cache_version)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    close();
+
+    if (!mFile.open(filename))
+    {
+        return false;
+    }
+
+    const size_t file_size = mFile.getSize();
+    const Header* header = getHeader();
+    if (file_size < sizeof(Header) || memcmp(header->mMagic, INV_CACHE_MAGIC, sizeof(header->mMagic)) != 0)
+    {
+        LL_WARNS("Inventory") << "Inventory cache " << filename << " is not a binary inventory cache" << LL_ENDL;
+        close();
+        return false;
+    }
+
+    if (header->mFormatVersion != FORMAT_VERSION || header->mInvCacheVersion != inv_cache_version)
+    {
+        LL_WARNS("Inventory") << "Inventory cache is out of date" << LL_ENDL;
+        close();
+        mObsolete = true;
+        return false;
+    }
+
+    auto section_fits = [file_size](U64 offset, U64 count, size_t record_size)
+    {
+        return (offset % SECTION_ALIGNMENT) == 0
+            && offset <= file_size
+            && count <= (file_size - offset) / record_size;
+    };
+
+    if (header->mUUIDCount == 0
+        || !section_fits(header->mUUIDOffset, header->mUUIDCount, sizeof(LLUUID))
+        || !section_fits(header->mStringOffset, header->mStringPoolSize, 1)
+        || !section_fits(header->mCategoryOffset, header->mCategoryCount, sizeof(CategoryRecord))
+        || !section_fits(header->mItemOffset, header->mItemCount, sizeof(ItemRecord)))
+    {
+        LL_WARNS("Inventory") << "Inventory cache " << filename << " is truncated or damaged" << LL_ENDL;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void LLInventoryCacheFile::close()
+{
+    mFile.close();
+    mObsolete = false;
+}
+
+size_t LLInventoryCacheFile::getCategoryCount() const
+{
+    return mFile.isOpen() ? getHeader()->mCategoryCount : 0;
+}
+
+size_t LLInventoryCacheFile::getItemCount() const
+{
+    return mFile.isOpen() ? getHeader()->mItemCount : 0;
+}
+
+const LLInventoryCacheFile::Header* LLInventoryCacheFile::getHeader() const
+{
+    return reinterpret_cast<const Header*>(mFile.getData());
+}
+
+LLUUID LLInventoryCacheFile::getUUID(U32 index) const
+{
+    LLUUID id;
+    const Header* header = getHeader();
+    if (index != NULL_UUID_INDEX && index < header->mUUIDCount)
+    {
+        memcpy(id.mData, mFile.getData() + header->mUUIDOffset + (size_t)index * UUID_BYTES, UUID_BYTES);
+    }
+    return id;
+}
+
+bool LLInventoryCacheFile::getString(const StringRef& ref, std::string& str) const
+{
+    const Header* header = getHeader();
+    if (ref.mOffset > header->mStringPoolSize || ref.mLength > header->mStringPoolSize - ref.mOffset)
+    {
+        return false;
+    }
+    str.assign((const char*)mFile.getData() + header->mStringOffset + ref.mOffset, ref.mLength);
+    return true;
+}
+
+void LLInventoryCacheFile::readCategories(size_t begin, size_t end, cat_array_t& categories) const
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    if (!mFile.isOpen())
+    {
+        return;
+    }
+
+    const Header* header = getHeader();
+    const CategoryRecord* records = reinterpret_cast<const CategoryRecord*>(mFile.getData() + header->mCategoryOffset);
+    end = llmin(end, (size_t)header->mCategoryCount);
+
+    std::string name;
+    for (size_t i = begin; i < end; ++i)
+    {
+        const CategoryRecord& record = records[i];
+        if (!getString(record.mName, name))
+        {
+            continue;
+        }
+
+        LLPointer<LLViewerInventoryCategory> cat = new LLViewerInventoryCategory(getUUID(record.mID),
+                                                                                getUUID(record.mParentID),
+                                                                                (LLFolderType::EType)record.mPreferredType,
+                                                                                name,
+                                                                                getUUID(record.mOwnerID));
+        cat->setThumbnailUUID(getUUID(record.mThumbnailID));
+        cat->setVersion(record.mVersion);
+        categories.push_back(cat);
+    }
+}
+
+void LLInventoryCacheFile::readItems(size_t begin, size_t end, item_array_t& items, changed_items_t& cats_to_update) const
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    if (!mFile.isOpen())
+    {
+        return;
+    }
+
+    const Header* header = getHeader();
+    const ItemRecord* records = reinterpret_cast<const ItemRecord*>(mFile.getData() + header->mItemOffset);
+    end = llmin(end, (size_t)header->mItemCount);
+
+    std::string name;
+    std::string desc;
+    for (size_t i = begin; i < end; ++i)
+    {
+        const ItemRecord& record = records[i];
+
+        const LLUUID item_id = getUUID(record.mID);
+        if (item_id.isNull() || !getString(record.mName, name) || !getString(record.mDescription, desc))
+        {
+            continue;
+        }
+
+        const LLUUID parent_id = getUUID(record.mParentID);
+        const LLAssetType::EType asset_type = (LLAssetType::EType)record.mAssetType;
+        if (asset_type == LLAssetType::AT_UNKNOWN)
+        {
+            cats_to_update.insert(parent_id);
+            continue;
+        }
+
+        // Same fix ups as LLInventoryItem::fromLLSD()
+        LLInventoryType::EType inv_type = (LLInventoryType::EType)record.mInventoryType;
+        if (LLInventoryType::IT_NONE == inv_type || !inventory_and_asset_types_match(inv_type, asset_type))
+        {
+            inv_type = LLInventoryType::defaultForAssetType(asset_type);
+        }
+
+        LLPermissions perm;
+        perm.init(getUUID(record.mCreatorID),
+                  getUUID(record.mOwnerID),
+                  getUUID(record.mLastOwnerID),
+                  getUUID(record.mGroupID));
+        perm.setMaskBase(record.mMaskBase);
+        perm.setMaskOwner(record.mMaskOwner);
+        perm.setMaskEveryone(record.mMaskEveryone);
+        perm.setMaskGroup(record.mMaskGroup);
+        perm.setMaskNext(record.mMaskNextOwner);
+        perm.fix();
+
+        LLPointer<LLViewerInventoryItem> item = new LLViewerInventoryItem(item_id,
+                                                                         parent_id,
+                                                                         perm,
+                                                                         getUUID(record.mAssetID),
+                                                                         asset_type,
+                                                                         inv_type,
+                                                                         name,
+                                                                         desc,
+                                                                         LLSaleInfo((LLSaleInfo::EForSale)record.mSaleType, record.mSalePrice),
+                                                                         record.mFlags,
+                                                                         (time_t)record.mCreationDate);
+        item->setThumbnailUUID(getUUID(record.mThumbnailID));
+        // Items loaded from the LLSD cache were never marked complete
+        item->setComplete(false);
+        items.push_back(item);
+    }
+}
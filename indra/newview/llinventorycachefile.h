@@ -0,0 +1,116 @@
+/**
+ * @file llinventorycachefile.h
+ * @brief Binary, memory mapped inventory cache
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYCACHEFILE_H
+#define LL_LLINVENTORYCACHEFILE_H
+
+#include "llmappedfile.h"
+#include "llpointer.h"
+#include "lluuid.h"
+
+#include <set>
+#include <vector>
+
+class LLViewerInventoryCategory;
+class LLViewerInventoryItem;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLInventoryCacheFile
+//
+// Reads and writes the on-disk inventory cache in a versioned binary layout
+// that is memory mapped on load. Categories and items are built straight
+// from fixed width records with no LLSD in between:
+//
+//   header      magic, format version, inventory cache version, section
+//               offsets and counts
+//   uuids       table of unique UUIDs; records refer to them by index
+//               (index 0 is always the null UUID). Creator, owner, group
+//               and parent ids repeat a lot so this is much smaller than
+//               storing them inline.
+//   strings     pool of names and descriptions; records refer to them by
+//               offset and length
+//   categories  one fixed width record per category
+//   items       one fixed width record per item, including permission and
+//               sale info blocks
+//
+// Records can be read in any order and any range, so a load can be split
+// across threads by record range.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLInventoryCacheFile
+{
+public:
+    typedef std::vector<LLPointer<LLViewerInventoryCategory> > cat_array_t;
+    typedef std::vector<LLPointer<LLViewerInventoryItem> > item_array_t;
+    typedef std::set<LLUUID> changed_items_t;
+
+    // Bump if the record layout changes. Independent of the inventory
+    // cache version which describes the content rather than the layout.
+    static const U32 FORMAT_VERSION;
+
+    LLInventoryCacheFile();
+
+    // Writes to a temporary file next to filename and renames it into
+    // place, so a failed save leaves the old file intact. The old file must
+    // not be mapped on Windows, where it cannot be replaced while it is.
+    // Like the notation LLSD cache, categories with an unknown version are
+    // not saved.
+    static bool save(const std::string& filename,
+                     S32 inv_cache_version,
+                     const cat_array_t& categories,
+                     const item_array_t& items);
+
+    // Maps the file and validates the header. Returns false if the file is
+    // missing, damaged or was written with a different format or inventory
+    // cache version; isObsolete() tells the last two apart from the others.
+    bool open(const std::string& filename, S32 inv_cache_version);
+    void close();
+
+    bool isObsolete() const { return mObsolete; }
+    size_t getCategoryCount() const;
+    size_t getItemCount() const;
+
+    // Append the records in [begin, end) to the output array. Safe to call
+    // concurrently for disjoint ranges. Damaged records are skipped.
+    void readCategories(size_t begin, size_t end, cat_array_t& categories) const;
+    // Items of an asset type this viewer does not know are not returned;
+    // their parent folders are added to cats_to_update instead.
+    void readItems(size_t begin, size_t end, item_array_t& items, changed_items_t& cats_to_update) const;
+
+private:
+    struct Header;
+    struct StringRef;
+    struct CategoryRecord;
+    struct ItemRecord;
+
+    const Header* getHeader() const;
+    LLUUID getUUID(U32 index) const;
+    bool getString(const StringRef& ref, std::string& str) const;
+
+    LLMappedFile mFile;
+    bool mObsolete;
+};
+
+#endif // LL_LLINVENTORYCACHEFILE_H
@@ -0,0 +1,719 @@
+/**
+ * @file llinventorycacheloader.cpp
+ * @brief Multithreaded loading of the inventory cache files.
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorycacheloader.h"
+
+#include "lldir.h"
+#include "llfile.h"
+#include "llfoldertype.h"
+#include "llmemorystream.h"
+#include "llpermissions.h"
+#include "llsaleinfo.h"
+#include "llsdserialize.h"
+#include "llsys.h"
+#include "lltimer.h"
+#include "llviewerinventory.h"
+#include "workqueue.h"
+
+#include <future>
+#include <zlib.h>
+
+static const std::string sTesterName("InventoryCacheLoad");
+
+// Records per binary load job. Small enough to spread a large inventory
+// over all the pool threads, large enough to keep the posting cheap.
+static const size_t CATEGORIES_PER_JOB = 4096;
+static const size_t ITEMS_PER_JOB = 16384;
+
+// Inflated bytes handed to each notation parse job
+static const S32 NOTATION_BLOCK_SIZE = 1024 * 1024;
+
+namespace
+{
+    typedef LLInventoryCacheLoader::cat_array_t cat_array_t;
+    typedef LLInventoryCacheLoader::item_array_t item_array_t;
+    typedef LLInventoryCacheLoader::changed_items_t changed_items_t;
+
+    // What one job produced, merged in job order by the calling thread
+    struct LoadChunk
+    {
+        cat_array_t mCategories;
+        item_array_t mItems;
+        changed_items_t mCatsToUpdate;
+        F64 mSeconds = 0.0;
+    };
+
+    struct NotationChunk : public LoadChunk
+    {
+        std::string mText;
+        bool mFirst = false;
+        // Cache version line seen at the top of the first chunk
+        bool mVersionOK = false;
+        // Parsing stopped in this chunk; later chunks must be ignored
+        bool mStopped = false;
+        // Stopped before the cache was proven current
+        bool mObsolete = false;
+    };
+
+    // Runs work on the "General" pool, or right here if the pool is not
+    // available. Waiting on the returned future is the caller's business.
+    std::future<void> post_general(const std::function<void()>& work)
+    {
+        auto task = std::make_shared<std::packaged_task<void()>>(work);
+        std::future<void> result = task->get_future();
+
+        LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+        if (!general_queue || !general_queue->post([task]() { (*task)(); }))
+        {
+            (*task)();
+        }
+        return result;
+    }
+
+    // Waits for every job before looking at any result so that nothing is
+    // still running against the caller's data when we return. Returns false
+    // if any of the jobs threw.
+    bool wait_all(std::vector<std::future<void>>& jobs)
+    {
+        for (auto& job : jobs)
+        {
+            job.wait();
+        }
+
+        bool success = true;
+        for (auto& job : jobs)
+        {
+            try
+            {
+                job.get();
+            }
+            catch (...)
+            {
+                LOG_UNHANDLED_EXCEPTION("inventory cache load job");
+                success = false;
+            }
+        }
+        return success;
+    }
+
+    // The dictionaries used while building categories and items are lazily
+    // created singletons. Create them here, on the main thread, before any
+    // job can race to do it.
+    void init_dictionaries()
+    {
+        LLAssetType::lookup(LLAssetType::AT_NONE);
+        LLInventoryType::lookup(LLInventoryType::IT_NONE);
+        LLFolderType::lookup(LLFolderType::FT_NONE);
+    }
+
+    void merge_chunk(LoadChunk& chunk,
+                     cat_array_t& categories,
+                     item_array_t& items,
+                     changed_items_t& cats_to_update)
+    {
+        categories.insert(categories.end(), chunk.mCategories.begin(), chunk.mCategories.end());
+        items.insert(items.end(), chunk.mItems.begin(), chunk.mItems.end());
+        cats_to_update.insert(chunk.mCatsToUpdate.begin(), chunk.mCatsToUpdate.end());
+    }
+
+    // Same rules as the serial line by line reader: the first line must be
+    // the current cache version, a parse failure ends the load but keeps
+    // what was read so far.
+    void parse_notation_chunk(NotationChunk& chunk, S32 inv_cache_version)
+    {
+        LL_PROFILE_ZONE_NAMED("inventory cache parse");
+        LLTimer timer;
+
+        LLPointer<LLSDParser> parser = new LLSDNotationParser();
+        bool need_version = chunk.mFirst;
+        const char* text = chunk.mText.data();
+        const size_t text_size = chunk.mText.size();
+        size_t start = 0;
+        while (start < text_size)
+        {
+            size_t end = chunk.mText.find('\n', start);
+            if (end == std::string::npos)
+            {
+                end = text_size;
+            }
+            const S32 length = (S32)(end - start);
+            const char* line = text + start;
+            start = end + 1;
+
+            LLSD s_item;
+            LLMemoryStream stream((const U8*)line, length);
+            if (parser->parse(stream, s_item, length) == LLSDParser::PARSE_FAILURE)
+            {
+                LL_WARNS("Inventory") << "Parsing inventory cache failed" << LL_ENDL;
+                chunk.mStopped = true;
+                break;
+            }
+
+            if (s_item.has("inv_cache_version"))
+            {
+                if (s_item["inv_cache_version"].asInteger() == inv_cache_version)
+                {
+                    chunk.mVersionOK |= need_version;
+                    need_version = false;
+                    continue;
+                }
+                LL_WARNS("Inventory") << "Inventory cache is out of date" << LL_ENDL;
+                chunk.mStopped = true;
+                chunk.mObsolete = need_version;
+                break;
+            }
+
+            if (need_version && (s_item.has("cat_id") || s_item.has("item_id")))
+            {
+                chunk.mStopped = true;
+                chunk.mObsolete = true;
+                break;
+            }
+
+            if (s_item.has("cat_id"))
+            {
+                LLPointer<LLViewerInventoryCategory> inv_cat = new LLViewerInventoryCategory(LLUUID::null);
+                if (inv_cat->importLLSD(s_item))
+                {
+                    chunk.mCategories.push_back(inv_cat);
+                }
+            }
+            else if (s_item.has("item_id"))
+            {
+                LLPointer<LLViewerInventoryItem> inv_item = new LLViewerInventoryItem;
+                if (inv_item->fromLLSD(s_item))
+                {
+                    if (inv_item->getUUID().isNull())
+                    {
+                        LL_DEBUGS("Inventory") << "Ignoring inventory with null item id: "
+                            << inv_item->getName() << LL_ENDL;
+                    }
+                    else if (inv_item->getType() == LLAssetType::AT_UNKNOWN)
+                    {
+                        chunk.mCatsToUpdate.insert(inv_item->getParentUUID());
+                    }
+                    else
+                    {
+                        chunk.mItems.push_back(inv_item);
+                    }
+                }
+            }
+        }
+
+        // Free the text as soon as possible, a large cache inflates to a
+        // few hundred megabytes
+        std::string().swap(chunk.mText);
+        chunk.mSeconds = timer.getElapsedTimeF64();
+    }
+
+    // State shared between the inflate job and the parse jobs it posts
+    struct NotationLoad
+    {
+        std::string mFilename;
+        S32 mCacheVersion = 0;
+        bool mOpened = false;
+        F64 mDecompressSeconds = 0.0;
+        std::vector<std::shared_ptr<NotationChunk>> mChunks;
+        std::vector<std::future<void>> mParseJobs;
+    };
+
+    void post_notation_chunk(const std::shared_ptr<NotationLoad>& load, std::string&& text)
+    {
+        auto chunk = std::make_shared<NotationChunk>();
+        chunk->mText = std::move(text);
+        chunk->mFirst = load->mChunks.empty();
+        load->mChunks.push_back(chunk);
+
+        const S32 cache_version = load->mCacheVersion;
+        load->mParseJobs.push_back(post_general([chunk, cache_version]()
+            {
+                parse_notation_chunk(*chunk, cache_version);
+            }));
+    }
+
+    // Inflates the file a block at a time and posts a parse job for every
+    // block, cut after the last complete line. gzread() passes plain files
+    // through unchanged.
+    void inflate_notation_file(const std::shared_ptr<NotationLoad>& load)
+    {
+        LL_PROFILE_ZONE_NAMED("inventory cache inflate");
+        LLTimer timer;
+        F64 posting_seconds = 0.0;
+
+#if LL_WINDOWS
+        llutf16string utf16filename = utf8str_to_utf16str(load->mFilename);
+        gzFile src = gzopen_w(utf16filename.c_str(), "rb");
+#else
+        gzFile src = gzopen(load->mFilename.c_str(), "rb");
+#endif
+        if (!src)
+        {
+            return;
+        }
+        load->mOpened = true;
+        gzbuffer(src, 256 * 1024);
+
+        std::string text;
+        while (true)
+        {
+            const size_t carried = text.size();
+            text.resize(carried + NOTATION_BLOCK_SIZE);
+            const S32 bytes = gzread(src, &text[carried], NOTATION_BLOCK_SIZE);
+            if (bytes <= 0)
+            {
+                if (bytes < 0)
+                {
+                    LL_WARNS("Inventory") << "Unable to inflate " << load->mFilename << LL_ENDL;
+                }
+                text.resize(carried);
+                break;
+            }
+            text.resize(carried + bytes);
+
+            const size_t last_eol = text.rfind('\n');
+            if (last_eol == std::string::npos)
+            {
+                // A single line longer than a block, keep reading
+                continue;
+            }
+
+            std::string remainder = text.substr(last_eol + 1);
+            text.resize(last_eol + 1);
+
+            F64 post_start = timer.getElapsedTimeF64();
+            post_notation_chunk(load, std::move(text));
+            posting_seconds += timer.getElapsedTimeF64() - post_start;
+
+            text = std::move(remainder);
+        }
+        gzclose(src);
+
+        if (!text.empty())
+        {
+            F64 post_start = timer.getElapsedTimeF64();
+            post_notation_chunk(load, std::move(text));
+            posting_seconds += timer.getElapsedTimeF64() - post_start;
+        }
+
+        // Without a pool the parse jobs ran inline, do not count them
+        load->mDecompressSeconds = timer.getElapsedTimeF64() - posting_seconds;
+    }
+}
+
+// static
+bool LLInventoryCacheLoader::loadBinaryFile(const std::string& filename,
+                                            S32 inv_cache_version,
+                                            cat_array_t& categories,
+                                            item_array_t& items,
+                                            changed_items_t& cats_to_update,
+                                            bool& is_cache_obsolete)
+{
+    LL_PROFILE_ZONE_NAMED("inventory load from binary file");
+    LLTimer total_timer;
+
+    LLInventoryCacheFile cache_file;
+    if (!cache_file.open(filename, inv_cache_version))
+    {
+        is_cache_obsolete = cache_file.isObsolete();
+        return false;
+    }
+    is_cache_obsolete = false;
+
+    LL_INFOS("Inventory") << "loading inventory from: (" << filename << ")" << LL_ENDL;
+
+    init_dictionaries();
+
+    // The mapping stays valid until cache_file goes out of scope, which
+    // is after every job has finished.
+    const size_t category_count = cache_file.getCategoryCount();
+    const size_t item_count = cache_file.getItemCount();
+    std::vector<std::shared_ptr<LoadChunk>> chunks;
+    std::vector<std::future<void>> jobs;
+    for (size_t begin = 0; begin < category_count; begin += CATEGORIES_PER_JOB)
+    {
+        const size_t end = llmin(begin + CATEGORIES_PER_JOB, category_count);
+        auto chunk = std::make_shared<LoadChunk>();
+        chunks.push_back(chunk);
+        jobs.push_back(post_general([&cache_file, chunk, begin, end]()
+            {
+                LL_PROFILE_ZONE_NAMED("inventory cache read categories");
+                LLTimer timer;
+                chunk->mCategories.reserve(end - begin);
+                cache_file.readCategories(begin, end, chunk->mCategories);
+                chunk->mSeconds = timer.getElapsedTimeF64();
+            }));
+    }
+    for (size_t begin = 0; begin < item_count; begin += ITEMS_PER_JOB)
+    {
+        const size_t end = llmin(begin + ITEMS_PER_JOB, item_count);
+        auto chunk = std::make_shared<LoadChunk>();
+        chunks.push_back(chunk);
+        jobs.push_back(post_general([&cache_file, chunk, begin, end]()
+            {
+                LL_PROFILE_ZONE_NAMED("inventory cache read items");
+                LLTimer timer;
+                chunk->mItems.reserve(end - begin);
+                cache_file.readItems(begin, end, chunk->mItems, chunk->mCatsToUpdate);
+                chunk->mSeconds = timer.getElapsedTimeF64();
+            }));
+    }
+
+    if (!wait_all(jobs))
+    {
+        // Treat it as an unreadable cache, the server will send everything
+        return false;
+    }
+
+    F64 parse_seconds = 0.0;
+    {
+        LL_PROFILE_ZONE_NAMED("inventory cache merge");
+        categories.reserve(categories.size() + category_count);
+        items.reserve(items.size() + item_count);
+        for (auto& chunk : chunks)
+        {
+            merge_chunk(*chunk, categories, items, cats_to_update);
+            parse_seconds += chunk->mSeconds;
+        }
+    }
+
+    if (LLInventoryCacheLoadTester* tester = LLInventoryCacheLoadTester::getTester())
+    {
+        tester->recordLoad("binary", category_count, item_count, jobs.size(),
+                           0.f, (F32)parse_seconds, total_timer.getElapsedTimeF32());
+    }
+    return true;
+}
+
+// static
+bool LLInventoryCacheLoader::loadNotationFile(const std::string& filename,
+                                              S32 inv_cache_version,
+                                              cat_array_t& categories,
+                                              item_array_t& items,
+                                              changed_items_t& cats_to_update,
+                                              bool& is_cache_obsolete)
+{
+    LL_PROFILE_ZONE_NAMED("inventory load from file");
+    LLTimer total_timer;
+
+    if (filename.empty())
+    {
+        LL_ERRS("Inventory") << "filename is Null!" << LL_ENDL;
+        return false;
+    }
+    LL_INFOS("Inventory") << "loading inventory from: (" << filename << ")" << LL_ENDL;
+
+    init_dictionaries();
+
+    auto load = std::make_shared<NotationLoad>();
+    load->mFilename = filename;
+    load->mCacheVersion = inv_cache_version;
+
+    // The inflate job must not wait for the parse jobs it posts (the pool
+    // may have a single thread) so we wait for it here, then for them.
+    std::vector<std::future<void>> inflate_job;
+    inflate_job.push_back(post_general([load]() { inflate_notation_file(load); }));
+    bool success = wait_all(inflate_job);
+    success = wait_all(load->mParseJobs) && success;
+
+    if (!load->mOpened)
+    {
+        LL_INFOS("Inventory") << "unable to load inventory from: " << filename << LL_ENDL;
+        return false;
+    }
+
+    is_cache_obsolete = true; // Obsolete until proven current
+    if (!success)
+    {
+        return false;
+    }
+
+    F64 parse_seconds = 0.0;
+    {
+        LL_PROFILE_ZONE_NAMED("inventory cache merge");
+        for (auto& chunk : load->mChunks)
+        {
+            if (chunk->mFirst)
+            {
+                is_cache_obsolete = !chunk->mVersionOK;
+            }
+            if (is_cache_obsolete || chunk->mObsolete)
+            {
+                is_cache_obsolete = true;
+                break;
+            }
+            merge_chunk(*chunk, categories, items, cats_to_update);
+            parse_seconds += chunk->mSeconds;
+            if (chunk->mStopped)
+            {
+                break;
+            }
+        }
+    }
+
+    if (LLInventoryCacheLoadTester* tester = LLInventoryCacheLoadTester::getTester())
+    {
+        tester->recordLoad("notation", categories.size(), items.size(), load->mParseJobs.size() + 1,
+                           (F32)load->mDecompressSeconds, (F32)parse_seconds,
+                           total_timer.getElapsedTimeF32());
+    }
+    return !is_cache_obsolete;
+}
+
+//----------------------------------------------------------------------------
+// LLInventoryCacheLoadTester
+//----------------------------------------------------------------------------
+
+LLInventoryCacheLoadTester::LLInventoryCacheLoadTester()
+:   LLMetricPerformanceTesterBasic(sTesterName),
+    mCategories(0),
+    mItems(0),
+    mJobs(0),
+    mDecompressTime(0.f),
+    mParseTime(0.f),
+    mTotalTime(0.f)
+{
+    addMetric("Categories");
+    addMetric("Items");
+    addMetric("Jobs");
+    addMetric("Time Decompression (s)");
+    addMetric("Time Parse (s)");
+    addMetric("Time Total (s)");
+}
+
+// static
+LLInventoryCacheLoadTester* LLInventoryCacheLoadTester::getTester()
+{
+    if (LLMetricPerformanceTesterBasic::isMetricLogRequested(sTesterName)
+        && !LLMetricPerformanceTesterBasic::getTester(sTesterName))
+    {
+        new LLInventoryCacheLoadTester();
+    }
+    return (LLInventoryCacheLoadTester*)LLMetricPerformanceTesterBasic::getTester(sTesterName);
+}
+
+void LLInventoryCacheLoadTester::recordLoad(const std::string& format,
+                                            size_t categories,
+                                            size_t items,
+                                            size_t jobs,
+                                            F32 decompress_seconds,
+                                            F32 parse_seconds,
+                                            F32 total_seconds)
+{
+    mFormat = format;
+    mCategories = (S32)categories;
+    mItems = (S32)items;
+    mJobs = (S32)jobs;
+    mDecompressTime = decompress_seconds;
+    mParseTime = parse_seconds;
+    mTotalTime = total_seconds;
+    outputTestResults();
+}
+
+//virtual
+void LLInventoryCacheLoadTester::outputTestRecord(LLSD* sd)
+{
+    std::string currentLabel = getCurrentLabelName();
+
+    (*sd)[currentLabel]["Format"]                 = (LLSD::String)mFormat;
+    (*sd)[currentLabel]["Categories"]             = (LLSD::Integer)mCategories;
+    (*sd)[currentLabel]["Items"]                  = (LLSD::Integer)mItems;
+    (*sd)[currentLabel]["Jobs"]                   = (LLSD::Integer)mJobs;
+    (*sd)[currentLabel]["Time Decompression (s)"] = (LLSD::Real)mDecompressTime;
+    (*sd)[currentLabel]["Time Parse (s)"]         = (LLSD::Real)mParseTime;
+    (*sd)[currentLabel]["Time Total (s)"]         = (LLSD::Real)mTotalTime;
+}
+
+//----------------------------------------------------------------------------
+// Benchmark
+//----------------------------------------------------------------------------
+
+namespace
+{
+    const S32 BENCHMARK_CACHE_VERSION = 1;
+    const S32 BENCHMARK_ITEMS_PER_FOLDER = 50;
+
+    void make_synthetic_inventory(S32 num_items, cat_array_t& categories, item_array_t& items)
+    {
+        const LLUUID owner_id;
+        const LLUUID root_id = LLUUID::generateNewID();
+        categories.push_back(new LLViewerInventoryCategory(root_id, LLUUID::null,
+                                                           LLFolderType::FT_ROOT_INVENTORY,
+                                                           "My Inventory", owner_id));
+        categories.back()->setVersion(1);
+
+        const S32 num_folders = llmax(1, num_items / BENCHMARK_ITEMS_PER_FOLDER);
+        for (S32 i = 0; i < num_folders; ++i)
+        {
+            categories.push_back(new LLViewerInventoryCategory(LLUUID::generateNewID(), root_id,
+                                                               LLFolderType::FT_NONE,
+                                                               llformat("Folder %d", i), owner_id));
+            categories.back()->setVersion(1 + i % 7);
+        }
+
+        // A plausible mix of asset types with their usual inventory types
+        static const std::pair<LLAssetType::EType, LLInventoryType::EType> kinds[] =
+        {
+            { LLAssetType::AT_OBJECT,    LLInventoryType::IT_OBJECT },
+            { LLAssetType::AT_TEXTURE,   LLInventoryType::IT_TEXTURE },
+            { LLAssetType::AT_CLOTHING,  LLInventoryType::IT_WEARABLE },
+            { LLAssetType::AT_NOTECARD,  LLInventoryType::IT_NOTECARD },
+            { LLAssetType::AT_LSL_TEXT,  LLInventoryType::IT_LSL },
+            { LLAssetType::AT_LINK,      LLInventoryType::IT_OBJECT },
+        };
+
+        LLPermissions perm;
+        perm.init(owner_id, owner_id, LLUUID::null, LLUUID::null);
+        perm.initMasks(PERM_ALL, PERM_ALL, PERM_NONE, PERM_NONE, PERM_MOVE | PERM_TRANSFER);
+        const time_t creation_date = time_corrected();
+        for (S32 i = 0; i < num_items; ++i)
+        {
+            const auto& kind = kinds[i % LL_ARRAY_SIZE(kinds)];
+            const LLUUID& parent_id = categories[1 + i % num_folders]->getUUID();
+            items.push_back(new LLViewerInventoryItem(LLUUID::generateNewID(), parent_id, perm,
+                                                      LLUUID::generateNewID(), kind.first, kind.second,
+                                                      llformat("Item %d", i),
+                                                      (i % 3) ? std::string() : std::string("Synthetic item"),
+                                                      LLSaleInfo::DEFAULT, 0, creation_date));
+        }
+    }
+
+    // Same layout as the gzipped notation caches written by older viewers
+    bool save_notation_file(const std::string& filename, const cat_array_t& categories, const item_array_t& items)
+    {
+        const std::string plain_filename = filename + ".txt";
+        {
+            llofstream file(plain_filename.c_str());
+            if (!file.is_open())
+            {
+                return false;
+            }
+
+            LLSD cache_ver;
+            cache_ver["inv_cache_version"] = BENCHMARK_CACHE_VERSION;
+            file << LLSDOStreamer<LLSDNotationFormatter>(cache_ver) << std::endl;
+            for (auto& cat : categories)
+            {
+                file << LLSDOStreamer<LLSDNotationFormatter>(cat->exportLLSD()) << std::endl;
+            }
+            for (auto& item : items)
+            {
+                file << LLSDOStreamer<LLSDNotationFormatter>(item->asLLSD()) << std::endl;
+            }
+            if (file.fail())
+            {
+                return false;
+            }
+        }
+
+        bool success = gzip_file(plain_filename, filename);
+        LLFile::remove(plain_filename, ENOENT);
+        return success;
+    }
+
+    void report_load(const std::string& format, bool loaded, F32 seconds,
+                     const cat_array_t& categories, const item_array_t& items,
+                     size_t expected_categories, size_t expected_items)
+    {
+        if (!loaded)
+        {
+            LL_WARNS("Inventory") << "Inventory cache benchmark: " << format << " load failed" << LL_ENDL;
+            return;
+        }
+
+        LL_INFOS("Inventory") << "Inventory cache benchmark: " << format << " loaded "
+                              << categories.size() << " categories and " << items.size()
+                              << " items in " << seconds << "s" << LL_ENDL;
+        if (categories.size() != expected_categories || items.size() != expected_items)
+        {
+            LL_WARNS("Inventory") << "Inventory cache benchmark: " << format << " expected "
+                                  << expected_categories << " categories and " << expected_items
+                                  << " items" << LL_ENDL;
+        }
+    }
+}
+
+void inventory_cache_benchmark(S32 num_items)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    num_items = llmax(1, num_items);
+    LL_INFOS("Inventory") << "Inventory cache benchmark: building " << num_items << " items" << LL_ENDL;
+
+    cat_array_t source_categories;
+    item_array_t source_items;
+    make_synthetic_inventory(num_items, source_categories, source_items);
+
+    const std::string base_filename = gDirUtilp->getTempFilename();
+    const std::string binary_filename = base_filename + ".inv.bin";
+    const std::string notation_filename = base_filename + ".inv.llsd.gz";
+
+    LLTimer timer;
+    bool saved = LLInventoryCacheFile::save(binary_filename, BENCHMARK_CACHE_VERSION,
+                                            source_categories, source_items);
+    LL_INFOS("Inventory") << "Inventory cache benchmark: binary save "
+                          << (saved ? "took " : "failed after ") << timer.getElapsedTimeF32() << "s" << LL_ENDL;
+
+    timer.reset();
+    saved = save_notation_file(notation_filename, source_categories, source_items);
+    LL_INFOS("Inventory") << "Inventory cache benchmark: notation save "
+                          << (saved ? "took " : "failed after ") << timer.getElapsedTimeF32() << "s" << LL_ENDL;
+
+    const size_t expected_categories = source_categories.size();
+    const size_t expected_items = source_items.size();
+    source_categories.clear();
+    source_items.clear();
+
+    {
+        cat_array_t categories;
+        item_array_t items;
+        changed_items_t cats_to_update;
+        bool is_cache_obsolete = false;
+        timer.reset();
+        bool loaded = LLInventoryCacheLoader::loadBinaryFile(binary_filename, BENCHMARK_CACHE_VERSION,
+                                                             categories, items, cats_to_update,
+                                                             is_cache_obsolete);
+        report_load("binary", loaded, timer.getElapsedTimeF32(), categories, items,
+                    expected_categories, expected_items);
+    }
+
+    {
+        cat_array_t categories;
+        item_array_t items;
+        changed_items_t cats_to_update;
+        bool is_cache_obsolete = false;
+        timer.reset();
+        bool loaded = LLInventoryCacheLoader::loadNotationFile(notation_filename, BENCHMARK_CACHE_VERSION,
+                                                               categories, items, cats_to_update,
+                                                               is_cache_obsolete);
+        report_load("notation", loaded, timer.getElapsedTimeF32(), categories, items,
+                    expected_categories, expected_items);
+    }
+
+    LLFile::remove(binary_filename, ENOENT);
+    LLFile::remove(notation_filename, ENOENT);
+}
@@ -0,0 +1,117 @@
+/**
+ * @file llinventorycacheloader.h
+ * @brief Multithreaded loading of the inventory cache at login
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYCACHELOADER_H
+#define LL_LLINVENTORYCACHELOADER_H
+
+#include "llinventorycachefile.h"
+#include "llmetricperformancetester.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLInventoryCacheLoader
+//
+// Builds the categories and items of an inventory cache file on the
+// "General" thread pool. The calling (main) thread only waits and then
+// gets the results back in file order, so the outcome is the same as a
+// serial load. Insertion into LLInventoryModel stays on the main thread.
+//
+// Binary caches (LLInventoryCacheFile) are split into record ranges.
+// Gzipped notation LLSD caches run as a pipeline: one job inflates the
+// file a block at a time and hands every block (cut at a line boundary)
+// to a parse job, so parsing overlaps decompression.
+//
+// If the pool is not running (early startup, shutdown, tests) all the work
+// is done on the calling thread instead.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLInventoryCacheLoader
+{
+public:
+    typedef LLInventoryCacheFile::cat_array_t cat_array_t;
+    typedef LLInventoryCacheFile::item_array_t item_array_t;
+    typedef LLInventoryCacheFile::changed_items_t changed_items_t;
+
+    // Both return true if the cache was read and is current. On false,
+    // is_cache_obsolete tells a cache of another version (which should be
+    // deleted) from a missing or unreadable one.
+    static bool loadBinaryFile(const std::string& filename,
+                               S32 inv_cache_version,
+                               cat_array_t& categories,
+                               item_array_t& items,
+                               changed_items_t& cats_to_update,
+                               bool& is_cache_obsolete);
+
+    // Reads both gzipped and plain notation LLSD files
+    static bool loadNotationFile(const std::string& filename,
+                                 S32 inv_cache_version,
+                                 cat_array_t& categories,
+                                 item_array_t& items,
+                                 changed_items_t& cats_to_update,
+                                 bool& is_cache_obsolete);
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLInventoryCacheLoadTester
+//
+// Records per stage timings of inventory cache loads. Enable with
+// -logmetrics InventoryCacheLoad; see also the "Benchmark Inventory Cache"
+// item of the Advanced > Cache menu which runs the loaders over a
+// synthetic cache.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLInventoryCacheLoadTester : public LLMetricPerformanceTesterBasic
+{
+public:
+    LLInventoryCacheLoadTester();
+
+    static LLInventoryCacheLoadTester* getTester();
+
+    // One record per load
+    void recordLoad(const std::string& format,
+                    size_t categories,
+                    size_t items,
+                    size_t jobs,
+                    F32 decompress_seconds,
+                    F32 parse_seconds,
+                    F32 total_seconds);
+
+protected:
+    void outputTestRecord(LLSD* sd) override;
+
+private:
+    std::string mFormat;
+    S32 mCategories;
+    S32 mItems;
+    S32 mJobs;
+    F32 mDecompressTime;
+    F32 mParseTime;
+    F32 mTotalTime;
+};
+
+// Writes a synthetic inventory of the given size in both cache formats to
+// the temp folder, loads each back with LLInventoryCacheLoader and logs the
+// timings. Does not touch gInventory.
+void inventory_cache_benchmark(S32 num_items);
+
+#endif // LL_LLINVENTORYCACHELOADER_H
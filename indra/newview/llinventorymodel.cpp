@@ -44,6 +44,8 @@
 #include "llinventorymodelbackgroundfetch.h"
 #include "llinventoryobserver.h"
 #include "llinventorypanel.h"
+#include "llinventorycachefile.h"
+#include "llinventorycacheloader.h"
 #include "llfloaterpreviewtrash.h"
 #include "llnotificationsutil.h"
 #include "llmarketplacefunctions.h"
@@ -90,6 +92,8 @@ S32 LLInventoryModel::sPendingSystemFolders = 0;
 //bool decompress_file(const char* src_filename, const char* dst_filename);
 static const char PRODUCTION_CACHE_FORMAT_STRING[] = "%s.inv.llsd";
 static const char GRID_CACHE_FORMAT_STRING[] = "%s.%s.inv.llsd";
+static const char PRODUCTION_BINARY_CACHE_FORMAT_STRING[] = "%s.inv.bin";
+static const char GRID_BINARY_CACHE_FORMAT_STRING[] = "%s.%s.inv.bin";
 static const char * const LOG_INV("Inventory");
 
 struct InventoryIDPtrLess
@@ -2323,8 +2327,7 @@ bool LLInventoryModel::fetchDescendentsOf(const LLUUID& folder_id) const
     return cat->fetch();
 }
 
-//static
-std::string LLInventoryModel::getInvCacheAddres(const LLUUID& owner_id)
+static std::string get_inv_cache_address(const LLUUID& owner_id, const char* production_format, const char* grid_format)
 {
     std::string inventory_addr;
     std::string owner_id_str;
@@ -2332,7 +2335,7 @@ std::string LLInventoryModel::getInvCacheAddres(const LLUUID& owner_id)
     std::string path(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, owner_id_str));
     if (LLGridManager::getInstance()->isInProductionGrid())
     {
-        inventory_addr = llformat(PRODUCTION_CACHE_FORMAT_STRING, path.c_str());
+        inventory_addr = llformat(production_format, path.c_str());
     }
     else
     {
@@ -2341,11 +2344,23 @@ std::string LLInventoryModel::getInvCacheAddres(const LLUUID& owner_id)
         // if your viewer uses grid names from an untrusted source.
         const std::string& grid_id_str = LLGridManager::getInstance()->getGridId();
         const std::string& grid_id_lower = utf8str_tolower(grid_id_str);
-        inventory_addr = llformat(GRID_CACHE_FORMAT_STRING, path.c_str(), grid_id_lower.c_str());
+        inventory_addr = llformat(grid_format, path.c_str(), grid_id_lower.c_str());
     }
     return inventory_addr;
 }
 
+//static
+std::string LLInventoryModel::getInvCacheAddres(const LLUUID& owner_id)
+{
+    return get_inv_cache_address(owner_id, PRODUCTION_CACHE_FORMAT_STRING, GRID_CACHE_FORMAT_STRING);
+}
+
+//static
+std::string LLInventoryModel::getInvBinaryCacheAddres(const LLUUID& owner_id)
+{
+    return get_inv_cache_address(owner_id, PRODUCTION_BINARY_CACHE_FORMAT_STRING, GRID_BINARY_CACHE_FORMAT_STRING);
+}
+
 void LLInventoryModel::cache(
     const LLUUID& parent_folder_id,
     const LLUUID& agent_id)
@@ -2366,20 +2381,15 @@ void LLInventoryModel::cache(
         items,
         INCLUDE_TRASH,
         can_cache);
-    // Use temporary file to avoid potential conflicts with other
-    // instances (even a 'read only' instance unzips into a file)
-    std::string temp_file = gDirUtilp->getTempFilename();
-    saveToFile(temp_file, categories, items);
-    std::string gzip_filename = getInvCacheAddres(agent_id);
-    gzip_filename.append(".gz");
-    if(gzip_file(temp_file, gzip_filename))
-    {
-        LL_DEBUGS(LOG_INV) << "Successfully compressed " << temp_file << " to " << gzip_filename << LL_ENDL;
-        LLFile::remove(temp_file);
-    }
-    else
+    // The binary cache is written to a temporary file and renamed into
+    // place, so other instances that have it mapped are not affected
+    if (saveToBinaryFile(getInvBinaryCacheAddres(agent_id), categories, items))
     {
-        LL_WARNS(LOG_INV) << "Unable to compress " << temp_file << " into " << gzip_filename << LL_ENDL;
+        // The notation caches of older viewers are only loaded when there
+        // is no binary cache. From now on they would only be out of date.
+        const std::string inventory_filename = getInvCacheAddres(agent_id);
+        LLFile::remove(inventory_filename + ".gz", ENOENT);
+        LLFile::remove(inventory_filename, ENOENT);
     }
 }
 
@@ -2736,37 +2746,23 @@ bool LLInventoryModel::loadSkeleton(
         const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
         std::string gzip_filename(inventory_filename);
         gzip_filename.append(".gz");
-        LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
-        bool remove_inventory_file = false;
-        if (LLAppViewer::instance()->isSecondInstance())
-        {
-            // Safeguard viewer against trying to unpack file twice
-            // ex: user logs into two accounts simultaneously, so two
-            // viewers are trying to unpack library into same file
-            //
-            // Would be better to do it in gunzip_file, but it doesn't
-            // have access to llfilesystem
-            inventory_filename = gDirUtilp->getTempFilename();
-            remove_inventory_file = true;
-        }
-        if(fp)
-        {
-            fclose(fp);
-            fp = NULL;
-            if(gunzip_file(gzip_filename, inventory_filename))
-            {
-                // we only want to remove the inventory file if it was
-                // gzipped before we loaded, and we successfully
-                // gunziped it.
-                remove_inventory_file = true;
-            }
-            else
+        const std::string binary_filename = getInvBinaryCacheAddres(owner_id);
+        bool is_cache_obsolete = false;
+        bool cache_loaded = loadFromBinaryFile(binary_filename, categories, items, categories_to_update, is_cache_obsolete);
+        if (!cache_loaded && !is_cache_obsolete)
+        {
+            // No usable binary cache, fall back to the gzipped notation
+            // LLSD cache written by older viewers. The loader inflates it
+            // in memory so there is no unpacked copy to share with a
+            // second instance.
+            cache_loaded = loadFromFile(gzip_filename, categories, items, categories_to_update, is_cache_obsolete);
+            if (!cache_loaded && !is_cache_obsolete)
             {
-                LL_INFOS(LOG_INV) << "Unable to gunzip " << gzip_filename << LL_ENDL;
+                // Unpacked cache left over by an old viewer
+                cache_loaded = loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete);
             }
         }
-        bool is_cache_obsolete = false;
-        if (loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete))
+        if (cache_loaded)
         {
             LL_PROFILE_ZONE_NAMED("loadFromFile");
             // We were able to find a cache of files. So, use what we
@@ -2951,16 +2947,12 @@ bool LLInventoryModel::loadSkeleton(
             }
         }
 
-        if(remove_inventory_file)
-        {
-            // clean up the gunzipped file.
-            LLFile::remove(inventory_filename);
-        }
         if(is_cache_obsolete && !LLAppViewer::instance()->isSecondInstance())
         {
             // If out of date, remove the gzipped file too.
             LL_WARNS(LOG_INV) << "Inv cache out of date, removing" << LL_ENDL;
-            LLFile::remove(gzip_filename);
+            LLFile::remove(gzip_filename, ENOENT);
+            LLFile::remove(binary_filename, ENOENT);
         }
         categories.clear(); // will unref and delete entries
     }
@@ -3364,109 +3356,27 @@ bool LLInventoryModel::loadFromFile(const std::string& filename,
                                     LLInventoryModel::changed_items_t& cats_to_update,
                                     bool &is_cache_obsolete)
 {
-    LL_PROFILE_ZONE_NAMED("inventory load from file");
-
-    if(filename.empty())
-    {
-        LL_ERRS(LOG_INV) << "filename is Null!" << LL_ENDL;
-        return false;
-    }
-    LL_INFOS(LOG_INV) << "loading inventory from: (" << filename << ")" << LL_ENDL;
-
-    llifstream file(filename.c_str());
-
-    if (!file.is_open())
-    {
-        LL_INFOS(LOG_INV) << "unable to load inventory from: " << filename << LL_ENDL;
-        return false;
-    }
-
-    is_cache_obsolete = true; // Obsolete until proven current
-
-    //U64 lines_count = 0U;
-    std::string line;
-    LLPointer<LLSDParser> parser = new LLSDNotationParser();
-    while (std::getline(file, line))
-    {
-        LLSD s_item;
-        std::istringstream iss(line);
-        if (parser->parse(iss, s_item, line.length()) == LLSDParser::PARSE_FAILURE)
-        {
-            LL_WARNS(LOG_INV)<< "Parsing inventory cache failed" << LL_ENDL;
-            break;
-        }
-
-        if (s_item.has("inv_cache_version"))
-        {
-            S32 version = s_item["inv_cache_version"].asInteger();
-            if (version == sCurrentInvCacheVersion)
-            {
-                // Cache is up to date
-                is_cache_obsolete = false;
-                continue;
-            }
-            else
-            {
-                LL_WARNS(LOG_INV)<< "Inventory cache is out of date" << LL_ENDL;
-                break;
-            }
-        }
-        else if (s_item.has("cat_id"))
-        {
-            if (is_cache_obsolete)
-                break;
-
-            LLPointer<LLViewerInventoryCategory> inv_cat = new LLViewerInventoryCategory(LLUUID::null);
-            if(inv_cat->importLLSD(s_item))
-            {
-                categories.push_back(inv_cat);
-            }
-        }
-        else if (s_item.has("item_id"))
-        {
-            if (is_cache_obsolete)
-                break;
-
-            LLPointer<LLViewerInventoryItem> inv_item = new LLViewerInventoryItem;
-            if( inv_item->fromLLSD(s_item) )
-            {
-                if(inv_item->getUUID().isNull())
-                {
-                    LL_DEBUGS(LOG_INV) << "Ignoring inventory with null item id: "
-                        << inv_item->getName() << LL_ENDL;
-                }
-                else
-                {
-                    if (inv_item->getType() == LLAssetType::AT_UNKNOWN)
-                    {
-                        cats_to_update.insert(inv_item->getParentUUID());
-                    }
-                    else
-                    {
-                        items.push_back(inv_item);
-                    }
-                }
-            }
-        }
-
-//      TODO(brad) - figure out how to reenable this without breaking everything else
-//      static constexpr U64 BATCH_SIZE = 512U;
-//      if ((++lines_count % BATCH_SIZE) == 0)
-//      {
-//          // SL-19968 - make sure message system code gets a chance to run every so often
-//          pump_idle_startup_network();
-//      }
-    }
-
-    file.close();
+    return LLInventoryCacheLoader::loadNotationFile(filename, sCurrentInvCacheVersion,
+                                                    categories, items, cats_to_update,
+                                                    is_cache_obsolete);
+}
 
-    return !is_cache_obsolete;
+// static
+bool LLInventoryModel::loadFromBinaryFile(const std::string& filename,
+                                          LLInventoryModel::cat_array_t& categories,
+                                          LLInventoryModel::item_array_t& items,
+                                          LLInventoryModel::changed_items_t& cats_to_update,
+                                          bool& is_cache_obsolete)
+{
+    return LLInventoryCacheLoader::loadBinaryFile(filename, sCurrentInvCacheVersion,
+                                                  categories, items, cats_to_update,
+                                                  is_cache_obsolete);
 }
 
 // static
-bool LLInventoryModel::saveToFile(const std::string& filename,
-    const cat_array_t& categories,
-    const item_array_t& items)
+bool LLInventoryModel::saveToBinaryFile(const std::string& filename,
+                                        const cat_array_t& categories,
+                                        const item_array_t& items)
 {
     if (filename.empty())
     {
@@ -3476,67 +3386,7 @@ bool LLInventoryModel::saveToFile(const std::string& filename,
 
     LL_INFOS(LOG_INV) << "saving inventory to: (" << filename << ")" << LL_ENDL;
 
-    try
-    {
-        llofstream fileXML(filename.c_str());
-        if (!fileXML.is_open())
-        {
-            LL_WARNS(LOG_INV) << "Failed to open file. Unable to save inventory to: " << filename << LL_ENDL;
-            return false;
-        }
-
-        LLSD cache_ver;
-        cache_ver["inv_cache_version"] = sCurrentInvCacheVersion;
-
-        if (fileXML.fail())
-        {
-            LL_WARNS(LOG_INV) << "Failed to write cache version to file. Unable to save inventory to: " << filename << LL_ENDL;
-            return false;
-        }
-
-        fileXML << LLSDOStreamer<LLSDNotationFormatter>(cache_ver) << std::endl;
-
-        S32 cat_count = 0;
-        for (auto& cat : categories)
-        {
-            if (cat->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
-            {
-                fileXML << LLSDOStreamer<LLSDNotationFormatter>(cat->exportLLSD()) << std::endl;
-                cat_count++;
-            }
-
-            if (fileXML.fail())
-            {
-                LL_WARNS(LOG_INV) << "Failed to write a folder to file. Unable to save inventory to: " << filename << LL_ENDL;
-                return false;
-            }
-        }
-
-        auto it_count = items.size();
-        for (auto& item : items)
-        {
-            fileXML << LLSDOStreamer<LLSDNotationFormatter>(item->asLLSD()) << std::endl;
-
-            if (fileXML.fail())
-            {
-                LL_WARNS(LOG_INV) << "Failed to write an item to file. Unable to save inventory to: " << filename << LL_ENDL;
-                return false;
-            }
-        }
-        fileXML.flush();
-
-        fileXML.close();
-
-        LL_INFOS(LOG_INV) << "Inventory saved: " << (S32)cat_count << " categories, " << (S32)it_count << " items." << LL_ENDL;
-    }
-    catch (...)
-    {
-        LOG_UNHANDLED_EXCEPTION("");
-        LL_INFOS(LOG_INV) << "Failed to save inventory to: (" << filename << ")" << LL_ENDL;
-        return false;
-    }
-
-    return true;
+    return LLInventoryCacheFile::save(filename, sCurrentInvCacheVersion, categories, items);
 }
 
 // message handling functionality
@@ -193,6 +193,7 @@ public:
     void createCommonSystemCategories();
 
     static std::string getInvCacheAddres(const LLUUID& owner_id);
+    static std::string getInvBinaryCacheAddres(const LLUUID& owner_id);
 
     // Call on logout to save a terse representation.
     void cache(const LLUUID& parent_folder_id, const LLUUID& agent_id);
@@ -663,14 +664,23 @@ public:
     // File I/O
     //--------------------------------------------------------------------
 protected:
+    // Notation LLSD cache written by older viewers (gzipped or not), only
+    // read now. Both loaders build the records on the "General" thread
+    // pool, see LLInventoryCacheLoader.
     static bool loadFromFile(const std::string& filename,
                              cat_array_t& categories,
                              item_array_t& items,
                              changed_items_t& cats_to_update,
                              bool& is_cache_obsolete);
-    static bool saveToFile(const std::string& filename,
-                           const cat_array_t& categories,
-                           const item_array_t& items);
+    // Memory mapped binary cache, see LLInventoryCacheFile
+    static bool loadFromBinaryFile(const std::string& filename,
+                                   cat_array_t& categories,
+                                   item_array_t& items,
+                                   changed_items_t& cats_to_update,
+                                   bool& is_cache_obsolete);
+    static bool saveToBinaryFile(const std::string& filename,
+                                 const cat_array_t& categories,
+                                 const item_array_t& items);
 
     //--------------------------------------------------------------------
     // Message handling functionality
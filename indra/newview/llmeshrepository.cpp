@@ -2198,7 +2198,11 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
 
         boost::iostreams::stream<boost::iostreams::array_source> stream(result_ptr, data_size);
 
-        if (!LLSDSerialize::fromBinary(header_data, stream, data_size))
+        // header_data is only read into header below, so the values it
+        // parses into can all go at once
+        LLPointer<LLSDBinaryParser> parser = new LLSDBinaryParser;
+        parser->setUseArena(true);
+        if (!parser->parse(stream, header_data, data_size))
         {
             LL_WARNS(LOG_MESH) << "Mesh header parse error.  Not a valid mesh asset!  ID:  " << mesh_id
                                << LL_ENDL;
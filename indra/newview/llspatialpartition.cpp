@@ -1064,6 +1064,18 @@ public:
         return res;
     }
 
+    virtual void frustumCheckChildren(const OctreeNode* n, S32* results)
+    {
+        AABBInFrustumNoFarClipChildBounds(n, results);
+        for (U32 i = 0; i < n->getChildCount(); i++)
+        {
+            if (results[i] != 0)
+            {
+                results[i] = llmin(results[i], AABBSphereIntersectGroupExtents((LLViewerOctreeGroup*)n->getChild(i)->getListener(0)));
+            }
+        }
+    }
+
     virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group)
     {
         S32 res = AABBInFrustumNoFarClipObjectBounds(group);
@@ -1097,6 +1109,11 @@ public:
         return AABBInFrustumNoFarClipGroupBounds(group);
     }
 
+    virtual void frustumCheckChildren(const OctreeNode* n, S32* results)
+    {
+        AABBInFrustumNoFarClipChildBounds(n, results);
+    }
+
     virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group)
     {
         S32 res = AABBInFrustumNoFarClipObjectBounds(group);
@@ -1115,6 +1132,11 @@ public:
         return AABBInFrustumGroupBounds(group);
     }
 
+    virtual void frustumCheckChildren(const OctreeNode* n, S32* results)
+    {
+        AABBInFrustumChildBounds(n, results);
+    }
+
     virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group)
     {
         return AABBInFrustumObjectBounds(group);
@@ -1141,33 +1163,6 @@ public:
         return false;
     }
 
-    virtual void traverse(const OctreeNode* n)
-    {
-        LLSpatialGroup* group = (LLSpatialGroup*) n->getListener(0);
-
-        if (earlyFail(group))
-        {
-            return;
-        }
-
-        if ((mRes && group->hasState(LLSpatialGroup::SKIP_FRUSTUM_CHECK)) ||
-            mRes == 2)
-        {   //don't need to do frustum check
-            OctreeTraveler::traverse(n);
-        }
-        else
-        {
-            mRes = frustumCheck(group);
-
-            if (mRes)
-            { //at least partially in, run on down
-                OctreeTraveler::traverse(n);
-            }
-
-            mRes = 0;
-        }
-    }
-
     virtual void processGroup(LLViewerOctreeGroup* base_group)
     {
         LLSpatialGroup* group = (LLSpatialGroup*)base_group;
@@ -1424,6 +1419,13 @@ extern bool gCubeSnapshot;
 S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+    prepareCull(camera)->traverse(mOctree);
+
+    return 0;
+}
+
+std::unique_ptr<LLViewerOctreeCull> LLSpatialPartition::prepareCull(LLCamera &camera)
+{
 #if LL_OCTREE_PARANOIA_CHECK
     ((LLSpatialGroup*)mOctree->getListener(0))->checkStates();
 #endif
@@ -1436,21 +1438,16 @@ S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
 
     if (LLPipeline::sShadowRender)
     {
-        LLOctreeCullShadow culler(&camera);
-        culler.traverse(mOctree);
+        return std::make_unique<LLOctreeCullShadow>(&camera);
     }
     else if (mInfiniteFarClip || (!LLPipeline::sUseFarClip && !gCubeSnapshot))
     {
-        LLOctreeCullNoFarClip culler(&camera);
-        culler.traverse(mOctree);
+        return std::make_unique<LLOctreeCullNoFarClip>(&camera);
     }
     else
     {
-        LLOctreeCull culler(&camera);
-        culler.traverse(mOctree);
+        return std::make_unique<LLOctreeCull>(&camera);
     }
-
-    return 0;
 }
 
 void pushVerts(LLDrawInfo* params)
@@ -43,6 +43,7 @@
 #include "llvoavatar.h"
 #include "llfetchedgltfmaterial.h"
 
+#include <memory>
 #include <queue>
 #include <unordered_map>
 
@@ -55,6 +56,7 @@ class LLSpatialBridge;
 class LLSpatialGroup;
 class LLViewerRegion;
 class LLReflectionMap;
+class LLVolume;
 
 void pushVerts(LLFace* face);
 
@@ -417,6 +419,8 @@ public:
     bool visibleObjectsInFrustum(LLCamera& camera);
     /*virtual*/ S32 cull(LLCamera &camera, bool do_occlusion=false); // Cull on arbitrary frustum
     S32 cull(LLCamera &camera, std::vector<LLDrawable *>* results, bool for_select); // Cull on arbitrary frustum
+    // First half of cull(camera): rebound the octree and return the culler to run on it
+    std::unique_ptr<LLViewerOctreeCull> prepareCull(LLCamera &camera);
 
     bool isVisible(const LLVector3& v);
     bool isHUDPartition() ;
@@ -681,10 +685,21 @@ class LLVolumeGeometryManager: public LLGeometryManager
     U32 genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace** faces, U32 face_count, bool distance_sort = false, bool batch_textures = false, bool rigged = false);
     void registerFace(LLSpatialGroup* group, LLFace* facep, U32 type);
 
+    // Between deferGeometry() and fillDeferredGeometry(), face geometry that
+    // genDrawInfo() and rebuildMesh() would write into vertex buffers is
+    // queued instead, then written for all groups at once on the FrameTasks
+    // thread pool. Flushing the buffers to GL stays on the main thread.
+    static void deferGeometry();
+    static void fillDeferredGeometry();
+
 private:
     void allocateFaces(U32 pMaxFaceCount);
     void freeFaces();
 
+    // writes face geometry now, or queues it while deferred
+    static void getGeometryVolume(LLFace* facep, LLVolume* volume, const LLMatrix4& mat_vert, const LLMatrix3& mat_normal,
+                                  U16 index_offset, bool force_rebuild, LLSpatialGroup* rebuild_on_fail);
+
     static int32_t sInstanceCount;
     static LLFace** sFullbrightFaces[2];
     static LLFace** sBumpFaces[2];
@@ -66,6 +66,7 @@
 #include "llmd5.h"
 #include "llmemorystream.h"
 #include "llmessageconfig.h"
+#include "llmessagedecoders.h"
 #include "llmoveview.h"
 #include "llfloaterimcontainer.h"
 #include "llfloaterimnearbychat.h"
@@ -2725,6 +2726,19 @@ void register_viewer_callbacks(LLMessageSystem* msg)
     msg->setHandlerFunc("ObjectUpdateCompressed",               process_compressed_object_update );
     msg->setHandlerFunc("ObjectUpdateCached",                   process_cached_object_update );
     msg->setHandlerFuncFast(_PREHASH_ImprovedTerseObjectUpdate, process_terse_object_update_improved );
+
+    // these handlers read their message with a generated decoder, so
+    // the generic decode can be skipped for them. A decoder that does not
+    // match the loaded template is not registered and reads the generic
+    // decode instead. ObjectUpdate is left out: processUpdateMessage()
+    // still reads full updates with the generic getters, so skipping its
+    // generic decode would only mean decoding it twice.
+    LLMessageDecoders::LayerData::registerDecoder(msg);
+    LLMessageDecoders::ObjectUpdateCompressed::registerDecoder(msg);
+    LLMessageDecoders::ObjectUpdateCached::registerDecoder(msg);
+    LLMessageDecoders::ImprovedTerseObjectUpdate::registerDecoder(msg);
+    LLMessageDecoders::CoarseLocationUpdate::registerDecoder(msg);
+
     msg->setHandlerFunc("SimStats",             process_sim_stats);
     msg->setHandlerFuncFast(_PREHASH_HealthMessage,         process_health_message );
     msg->setHandlerFuncFast(_PREHASH_EconomyData,               process_economy_data);
@@ -34,6 +34,9 @@
 #include "llimagej2c.h" // for version control
 #include "lllfsthread.h"
 #include "llviewercontrol.h"
+#include "workqueue.h"
+
+#include <zlib.h>
 
 // Included to allow LLTextureCache::purgeTextures() to pause watchdog timeout
 #include "llappviewer.h"
@@ -41,11 +44,14 @@
 
 // Cache organization:
 // cache/texture.entries
-//  Unordered array of Entry structs
+//  EntriesInfo header, then one region of Entry structs per shard (see
+//  LLTextureCache::HeaderShard). Entries are unordered within a region.
 // cache/texture.cache
 //  First TEXTURE_CACHE_ENTRY_SIZE bytes of each texture in texture.entries in same order
 // cache/textures/[0-F]/UUID.texture
 //  Actual texture body files
+// cache/textures/decoded/UUID_discard.decoded
+//  Compressed raw images at the discard levels the fetcher decoded
 
 //note: there is no good to define 1024 for TEXTURE_CACHE_ENTRY_SIZE while FIRST_PACKET_SIZE is 600 on sim side.
 const S32 TEXTURE_CACHE_ENTRY_SIZE = FIRST_PACKET_SIZE;//1024;
@@ -268,6 +274,47 @@ private:
     S32 mRawDiscardLevel;
 };
 
+class LLTextureCacheDecodedWorker : public LLTextureCacheWorker
+{
+public:
+    LLTextureCacheDecodedWorker(LLTextureCache* cache, const LLUUID& id, S32 discardlevel, bool needs_aux,
+                                LLTextureCache::DecodedReadResponder* responder)
+            : LLTextureCacheWorker(cache, id, NULL, 0, 0, 0, responder),
+            mDiscardLevel(discardlevel),
+            mNeedsAux(needs_aux),
+            mDecodedResponder(responder)
+    {
+    }
+
+    virtual bool doRead();
+    virtual bool doWrite();
+
+private:
+    S32 mDiscardLevel;
+    bool mNeedsAux;
+    LLTextureCache::DecodedReadResponder* mDecodedResponder; // owned by mResponder
+};
+
+bool LLTextureCacheDecodedWorker::doRead()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    LLPointer<LLImageRaw> raw;
+    LLPointer<LLImageRaw> aux;
+    S32 discard = -1;
+    if (mCache->doReadFromDecodedCache(mID, mDiscardLevel, mNeedsAux, raw, aux, discard))
+    {
+        mDecodedResponder->setDecoded(raw, aux, discard);
+        mDataSize = raw->getDataSize(); // tells finishWork() it succeeded
+    }
+    return true;
+}
+
+bool LLTextureCacheDecodedWorker::doWrite()
+{
+    // written through writeToDecodedCache()
+    return false;
+}
+
 
 //virtual
 void LLTextureCacheWorker::startWork(S32 param)
@@ -795,15 +842,24 @@ LLTextureCache::LLTextureCache(bool threaded)
       mHeaderMutex(),
       mListMutex(),
       mFastCacheMutex(),
-      mHeaderAPRFile(NULL),
       mReadOnly(true), //do not allow to change the texture cache until setReadOnly() is called.
+      mCorruptedCache(false),
       mTexturesSizeTotal(0),
       mDoPurge(false),
+      mDecodedSize(0),
+      mDecodedMaxSize(0),
+      mPurgeShard(sHeaderShardCount),
+      mPurgeShardTarget(0),
       mFastCachep(NULL),
       mFastCachePoolp(NULL),
       mFastCachePadBuffer(NULL)
 {
     mHeaderAPRFilePoolp = new LLVolatileAPRPool(); // is_local = true, because this pool is for headers, headers are under own mutex
+    for (U32 i = 0; i < sHeaderShardCount; ++i)
+    {
+        mShards[i].mIndex = i;
+        mShards[i].mAPRPoolp = new LLVolatileAPRPool(); // under the shard's mutex
+    }
 }
 
 LLTextureCache::~LLTextureCache()
@@ -813,6 +869,10 @@ LLTextureCache::~LLTextureCache()
     delete mFastCachep;
     delete mFastCachePoolp;
     delete mHeaderAPRFilePoolp;
+    for (U32 i = 0; i < sHeaderShardCount; ++i)
+    {
+        delete mShards[i].mAPRPoolp;
+    }
     ll_aligned_free_16(mFastCachePadBuffer);
 }
 
@@ -844,7 +904,14 @@ size_t LLTextureCache::update(F32 max_time_ms)
         responder->completed(success);
     }
 
-    if(!res && timer.getElapsedTimeF32() > MAX_TIME_INTERVAL)
+    if (mCorruptedCache)
+    {
+        // A shard could not write its records. Clearing the cache takes
+        // every shard's lock so it cannot be done from inside a shard.
+        mCorruptedCache = false;
+        clearCorruptedCache();
+    }
+    else if(!res && timer.getElapsedTimeF32() > MAX_TIME_INTERVAL)
     {
         timer.reset() ;
         writeUpdatedEntries() ;
@@ -875,10 +942,21 @@ std::string LLTextureCache::getTextureFileName(const LLUUID& id)
 //debug
 bool LLTextureCache::isInCache(const LLUUID& id)
 {
-    LLMutexLock lock(&mHeaderMutex);
-    id_map_t::const_iterator iter = mHeaderIDMap.find(id);
+    HeaderShard& shard = getShard(id);
+    LLMutexLock lock(&shard.mMutex);
+    return shard.mIDMap.find(id) != shard.mIDMap.end();
+}
 
-    return (iter != mHeaderIDMap.end()) ;
+//debug
+U32 LLTextureCache::getEntries()
+{
+    U32 entries = 0;
+    for (U32 i = 0; i < sHeaderShardCount; ++i)
+    {
+        LLMutexLock lock(&mShards[i].mMutex);
+        entries += (U32)mShards[i].mEntries.size();
+    }
+    return entries;
 }
 
 //debug
@@ -923,7 +1001,7 @@ bool LLTextureCache::isInLocal(const LLUUID& id)
 //////////////////////////////////////////////////////////////////////////////
 
 //static
-F32 LLTextureCache::sHeaderCacheVersion = 1.71f;
+F32 LLTextureCache::sHeaderCacheVersion = 1.72f;
 U32 LLTextureCache::sCacheMaxEntries = 1024 * 1024; //~1 million textures.
 S64 LLTextureCache::sCacheMaxTexturesSize = 0; // no limit
 std::string LLTextureCache::sHeaderCacheEncoderVersion = LLImageJ2C::getEngineInfo();
@@ -940,6 +1018,7 @@ const char* old_textures_dirname = "textures";
 //change the location of the texture cache to prevent from being deleted by old version viewers.
 const char* textures_dirname = "texturecache";
 const char* fast_cache_filename = "FastCache.cache";
+const char* decoded_dirname = "decoded";
 
 void LLTextureCache::setDirNames(ELLPath location)
 {
@@ -949,16 +1028,16 @@ void LLTextureCache::setDirNames(ELLPath location)
     mHeaderDataFileName = gDirUtilp->getExpandedFilename(location, textures_dirname, cache_filename);
     mTexturesDirName = gDirUtilp->getExpandedFilename(location, textures_dirname);
     mFastCacheFileName =  gDirUtilp->getExpandedFilename(location, textures_dirname, fast_cache_filename);
+    mDecodedDirName = gDirUtilp->getExpandedFilename(location, textures_dirname, decoded_dirname);
 }
 
 void LLTextureCache::purgeCache(ELLPath location, bool remove_dir)
 {
-    LLMutexLock lock(&mHeaderMutex);
+    lockAllShards();
 
     if (!mReadOnly)
     {
         setDirNames(location);
-        llassert_always(mHeaderAPRFile == NULL);
 
         //remove the legacy cache if exists
         std::string texture_dir = mTexturesDirName ;
@@ -979,6 +1058,8 @@ void LLTextureCache::purgeCache(ELLPath location, bool remove_dir)
 
     //remove the current texture cache.
     purgeAllTextures(remove_dir);
+
+    unlockAllShards();
 }
 
 //is called in the main thread before initCache(...) is called.
@@ -996,8 +1077,14 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, bool texture_cache
     S64 entries_size = (max_size * 36) / 100; //0.36 * max_size
     S64 max_entries = entries_size / (TEXTURE_CACHE_ENTRY_SIZE + TEXTURE_FAST_CACHE_ENTRY_SIZE);
     sCacheMaxEntries = (S32)(llmin((S64)sCacheMaxEntries, max_entries));
+    // Every shard owns the same number of entries
+    sCacheMaxEntries = llmax(sHeaderShardCount, sCacheMaxEntries - sCacheMaxEntries % sHeaderShardCount);
     entries_size = sCacheMaxEntries * (TEXTURE_CACHE_ENTRY_SIZE + TEXTURE_FAST_CACHE_ENTRY_SIZE);
     max_size -= entries_size;
+    // The decoded tier takes its share of what is left for the bodies
+    F32 decoded_percent = llclamp(gSavedSettings.getF32("TextureDecodedCachePercent"), 0.f, 50.f);
+    mDecodedMaxSize = (S64)(max_size * decoded_percent / 100.f);
+    max_size -= mDecodedMaxSize;
     if (sCacheMaxTexturesSize > 0)
         sCacheMaxTexturesSize = llmin(sCacheMaxTexturesSize, max_size);
     else
@@ -1005,7 +1092,8 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, bool texture_cache
     max_size -= sCacheMaxTexturesSize;
 
     LL_INFOS("TextureCache") << "Headers: " << sCacheMaxEntries
-            << " Textures size: " << sCacheMaxTexturesSize / (1024 * 1024) << " MB" << LL_ENDL;
+            << " Textures size: " << sCacheMaxTexturesSize / (1024 * 1024) << " MB"
+            << " Decoded size: " << mDecodedMaxSize / (1024 * 1024) << " MB" << LL_ENDL;
 
     setDirNames(location);
 
@@ -1034,6 +1122,7 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, bool texture_cache
     }
     readHeaderCache();
     purgeTextures(true); // calc mTexturesSize and make some room in the texture cache if we need it
+    initDecodedCache();
 
     llassert_always(getPending() == 0) ; //should not start accessing the texture cache before initialized.
     openFastCache(true);
@@ -1044,33 +1133,9 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, bool texture_cache
 //----------------------------------------------------------------------------
 // mHeaderMutex must be locked for the following functions!
 
-LLAPRFile* LLTextureCache::openHeaderEntriesFile(bool readonly, S32 offset)
-{
-    llassert_always(mHeaderAPRFile == NULL);
-    apr_int32_t flags = readonly ? APR_READ|APR_BINARY : APR_READ|APR_WRITE|APR_BINARY;
-    mHeaderAPRFile = new LLAPRFile(mHeaderEntriesFileName, flags, mHeaderAPRFilePoolp);
-    if(offset > 0)
-    {
-        mHeaderAPRFile->seek(APR_SET, offset);
-    }
-    return mHeaderAPRFile;
-}
-
-void LLTextureCache::closeHeaderEntriesFile()
-{
-    if(!mHeaderAPRFile)
-    {
-        return ;
-    }
-
-    delete mHeaderAPRFile;
-    mHeaderAPRFile = NULL;
-}
-
 void LLTextureCache::readEntriesHeader()
 {
     // mHeaderEntriesInfo initializes to default values so safe not to read it
-    llassert_always(mHeaderAPRFile == NULL);
     if (LLAPRFile::isExist(mHeaderEntriesFileName, mHeaderAPRFilePoolp))
     {
         LLAPRFile::readEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo),
@@ -1097,12 +1162,12 @@ void LLTextureCache::setEntriesHeader()
     mHeaderEntriesInfo.mVersion = sHeaderCacheVersion;
     mHeaderEntriesInfo.mAdressSize = sHeaderCacheAddressSize;
     strcpy(mHeaderEntriesInfo.mEncoderVersion, sHeaderCacheEncoderVersion.c_str());
-    mHeaderEntriesInfo.mEntries = 0;
+    mHeaderEntriesInfo.mShardSize = getShardSize();
+    memset(mHeaderEntriesInfo.mShardEntries, 0, sizeof(mHeaderEntriesInfo.mShardEntries));
 }
 
 void LLTextureCache::writeEntriesHeader()
 {
-    llassert_always(mHeaderAPRFile == NULL);
     if (!mReadOnly)
     {
         LLAPRFile::writeEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo),
@@ -1110,464 +1175,501 @@ void LLTextureCache::writeEntriesHeader()
     }
 }
 
-//mHeaderMutex is locked before calling this.
-S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create)
+// Always in the same order and after mHeaderMutex so that two threads doing
+// this cannot deadlock. Single shard operations never wait for another lock
+// while they hold their shard's.
+void LLTextureCache::lockAllShards()
 {
-    S32 idx = -1;
+    mHeaderMutex.lock();
+    for (U32 i = 0; i < sHeaderShardCount; ++i)
+    {
+        mShards[i].mMutex.lock();
+    }
+}
 
-    id_map_t::iterator iter1 = mHeaderIDMap.find(id);
-    if (iter1 != mHeaderIDMap.end())
+void LLTextureCache::unlockAllShards()
+{
+    for (U32 i = sHeaderShardCount; i-- > 0; )
     {
-        idx = iter1->second;
+        mShards[i].mMutex.unlock();
+    }
+    mHeaderMutex.unlock();
+}
+
+// All the shards are locked before calling this.
+void LLTextureCache::resetShards()
+{
+    const U32 shard_size = getShardSize();
+    for (U32 i = 0; i < sHeaderShardCount; ++i)
+    {
+        HeaderShard& shard = mShards[i];
+        shard.mBase = (S32)(i * shard_size);
+        shard.mEntries.clear();
+        shard.mFreeList.clear();
+        shard.mIDMap.clear();
+        shard.mLRU.clear();
+        shard.mUpdatedEntries.clear();
+        shard.mBodySize = 0;
     }
+    mTexturesSizeTotal = 0;
+    mPurgeShard = sHeaderShardCount;
+}
+
+//----------------------------------------------------------------------------
+// The shard's mutex must be locked for the following functions!
+
+S32 LLTextureCache::openAndReadEntry(HeaderShard& shard, const LLUUID& id, Entry& entry, bool create)
+{
+    S32 idx = -1;
 
-    if (idx < 0)
+    auto iter1 = shard.mIDMap.find(id);
+    if (iter1 != shard.mIDMap.end())
     {
-        if (create && !mReadOnly)
+        idx = iter1->second;
+        entry = shard.mEntries[idx - shard.mBase];
+        if(entry.mImageSize <= entry.mBodySize)//it happens on 64-bit systems, do not know why
         {
-            if (mHeaderEntriesInfo.mEntries < sCacheMaxEntries)
-            {
-                // Add an entry to the end of the list
-                idx = mHeaderEntriesInfo.mEntries++;
+            LL_WARNS() << "corrupted entry: " << id << " entry image size: " << entry.mImageSize << " entry body size: " << entry.mBodySize << LL_ENDL ;
 
-            }
-            else if (!mFreeList.empty())
-            {
-                idx = *(mFreeList.begin());
-                mFreeList.erase(mFreeList.begin());
-            }
-            else
-            {
-                // Look for a still valid entry in the LRU
-                for (std::set<LLUUID>::iterator iter2 = mLRU.begin(); iter2 != mLRU.end();)
-                {
-                    std::set<LLUUID>::iterator curiter2 = iter2++;
-                    LLUUID oldid = *curiter2;
-                    // Erase entry from LRU regardless
-                    mLRU.erase(curiter2);
-                    // Look up entry and use it if it is valid
-                    id_map_t::iterator iter3 = mHeaderIDMap.find(oldid);
-                    if (iter3 != mHeaderIDMap.end() && iter3->second >= 0)
-                    {
-                        idx = iter3->second;
-                        removeCachedTexture(oldid) ;//remove the existing cached texture to release the entry index.
-                        break;
-                    }
-                }
-                // if (idx < 0) at this point, we will rebuild the LRU
-                //  and retry if called from setHeaderCacheEntry(),
-                //  otherwise this shouldn't happen and will trigger an error
-            }
-            if (idx >= 0)
-            {
-                entry.mID = id ;
-                entry.mImageSize = -1 ; //mark it is a brand-new entry.
-                entry.mBodySize = 0 ;
-            }
+            //erase this entry and the cached texture from the cache.
+            removeEntry(shard, idx, getTextureFileName(id));
+            writeShardEntry(shard, idx);
+            idx = -1 ;
         }
     }
-    else
+    else if (create && !mReadOnly)
     {
-        // Remove this entry from the LRU if it exists
-        mLRU.erase(id);
-        // Read the entry
-        idx_entry_map_t::iterator iter = mUpdatedEntryMap.find(idx) ;
-        if(iter != mUpdatedEntryMap.end())
+        if (shard.mEntries.size() < getShardSize())
         {
-            entry = iter->second ;
+            // Add an entry to the end of the shard
+            idx = shard.mBase + (S32)shard.mEntries.size();
+            shard.mEntries.emplace_back();
+            if (!writeShardEntryCount(shard))
+            {
+                shard.mEntries.pop_back();
+                return -1;
+            }
         }
-        else
+        else if (!shard.mFreeList.empty())
         {
-            readEntryFromHeaderImmediately(idx, entry) ;
+            idx = *(shard.mFreeList.begin());
+            shard.mFreeList.erase(shard.mFreeList.begin());
         }
-        if(entry.mImageSize <= entry.mBodySize)//it happens on 64-bit systems, do not know why
+        else if (!shard.mLRU.empty())
         {
-            LL_WARNS() << "corrupted entry: " << id << " entry image size: " << entry.mImageSize << " entry body size: " << entry.mBodySize << LL_ENDL ;
+            // Recycle the least recently used entry
+            idx = shard.mLRU.begin()->second;
+            removeCachedTexture(shard, idx); //remove the existing cached texture to release the entry index.
+        }
 
-            //erase this entry and the cached texture from the cache.
-            std::string tex_filename = getTextureFileName(id);
-            removeEntry(idx, entry, tex_filename) ;
-            mUpdatedEntryMap.erase(idx) ;
-            idx = -1 ;
+        if (idx >= 0)
+        {
+            entry.mID = id ;
+            entry.mImageSize = -1 ; //mark it is a brand-new entry.
+            entry.mBodySize = 0 ;
+            // Keeps the index reserved until updateEntry() fills it in
+            shard.mEntries[idx - shard.mBase] = entry;
         }
     }
     return idx;
 }
 
-//mHeaderMutex is locked before calling this.
-void LLTextureCache::writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header)
+//update an existing entry time stamp, delay writing.
+void LLTextureCache::updateEntryTimeStamp(HeaderShard& shard, S32 idx, Entry& entry)
 {
-    LLAPRFile* aprfile ;
-    S32 bytes_written ;
-    S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-    if(write_header)
+    if (idx < 0 || mReadOnly)
     {
-        aprfile = openHeaderEntriesFile(false, 0);
-        bytes_written = aprfile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo)) ;
-        if(bytes_written != sizeof(EntriesInfo))
-        {
-            clearCorruptedCache() ; //clear the cache.
-            idx = -1 ;//mark the idx invalid.
-            return ;
-        }
-
-        mHeaderAPRFile->seek(APR_SET, offset);
+        return;
     }
-    else
+
+    Entry& cached = shard.mEntries[idx - shard.mBase];
+    shard.mLRU.erase(std::make_pair(cached.mTime, idx));
+    cached.mTime = (U32)time(NULL);
+    shard.mLRU.insert(std::make_pair(cached.mTime, idx));
+    entry.mTime = cached.mTime;
+
+    // The LRU order only needs to survive a restart when the shard has
+    // to recycle entries, do not pay for the writes before that.
+    const size_t max_entries_without_time_stamp = (size_t)(getShardSize() * 0.75f);
+    if (shard.mEntries.size() >= max_entries_without_time_stamp)
     {
-        aprfile = openHeaderEntriesFile(false, offset);
+        shard.mUpdatedEntries.insert(idx);
     }
-    bytes_written = aprfile->write((void*)&entry, (S32)sizeof(Entry));
-    if(bytes_written != sizeof(Entry))
-    {
-        clearCorruptedCache() ; //clear the cache.
-        idx = -1 ;//mark the idx invalid.
+}
 
-        return ;
+bool LLTextureCache::writeShardEntry(HeaderShard& shard, S32 idx)
+{
+    shard.mUpdatedEntries.erase(idx);
+    if (mReadOnly)
+    {
+        return true;
     }
 
-    closeHeaderEntriesFile();
-    mUpdatedEntryMap.erase(idx) ;
+    S32 offset = (S32)(sizeof(EntriesInfo) + idx * sizeof(Entry));
+    S32 bytes_written = LLAPRFile::writeEx(mHeaderEntriesFileName, &shard.mEntries[idx - shard.mBase],
+                                           offset, (S32)sizeof(Entry), shard.mAPRPoolp);
+    if (bytes_written != sizeof(Entry))
+    {
+        mCorruptedCache = true; // cleared from update()
+        return false;
+    }
+    return true;
 }
 
-//mHeaderMutex is locked before calling this.
-void LLTextureCache::readEntryFromHeaderImmediately(S32& idx, Entry& entry)
+bool LLTextureCache::writeShardEntryCount(HeaderShard& shard)
 {
-    S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-    LLAPRFile* aprfile = openHeaderEntriesFile(true, offset);
-    S32 bytes_read = aprfile->read((void*)&entry, (S32)sizeof(Entry));
-    closeHeaderEntriesFile();
+    if (mReadOnly)
+    {
+        return true;
+    }
 
-    if(bytes_read != sizeof(Entry))
+    U32 count = (U32)shard.mEntries.size();
+    S32 offset = (S32)(offsetof(EntriesInfo, mShardEntries) + shard.mIndex * sizeof(U32));
+    S32 bytes_written = LLAPRFile::writeEx(mHeaderEntriesFileName, &count, offset, (S32)sizeof(U32),
+                                           shard.mAPRPoolp);
+    if (bytes_written != sizeof(U32))
     {
-        clearCorruptedCache() ; //clear the cache.
-        idx = -1 ;//mark the idx invalid.
+        mCorruptedCache = true; // cleared from update()
+        return false;
     }
+    return true;
 }
 
-//mHeaderMutex is locked before calling this.
-//update an existing entry time stamp, delay writing.
-void LLTextureCache::updateEntryTimeStamp(S32 idx, Entry& entry)
+bool LLTextureCache::writeShardEntries(HeaderShard& shard)
 {
-    static const U32 MAX_ENTRIES_WITHOUT_TIME_STAMP = (U32)(LLTextureCache::sCacheMaxEntries * 0.75f) ;
-
-    if(mHeaderEntriesInfo.mEntries < MAX_ENTRIES_WITHOUT_TIME_STAMP)
+    shard.mUpdatedEntries.clear();
+    if (mReadOnly)
     {
-        return ; //there are enough empty entry index space, no need to stamp time.
+        return true;
     }
 
-    if (idx >= 0)
+    if (!shard.mEntries.empty())
     {
-        if (!mReadOnly)
+        S32 offset = (S32)(sizeof(EntriesInfo) + shard.mBase * sizeof(Entry));
+        S32 size = (S32)(shard.mEntries.size() * sizeof(Entry));
+        S32 bytes_written = LLAPRFile::writeEx(mHeaderEntriesFileName, shard.mEntries.data(), offset, size,
+                                               shard.mAPRPoolp);
+        if (bytes_written != size)
         {
-            entry.mTime = (U32)time(NULL);
-            mUpdatedEntryMap[idx] = entry ;
+            mCorruptedCache = true; // cleared from update()
+            return false;
         }
     }
+    return writeShardEntryCount(shard);
 }
 
-//update an existing entry, write to header file immediately.
-bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size)
+void LLTextureCache::writeUpdatedEntries(HeaderShard& shard)
 {
-    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
-    S32 new_body_size = llmax(0, new_data_size - TEXTURE_CACHE_ENTRY_SIZE) ;
-
-    if(new_image_size == entry.mImageSize && new_body_size == entry.mBodySize)
+    if (mReadOnly || shard.mUpdatedEntries.empty())
     {
-        return true ; //nothing changed.
+        return;
     }
-    else
-    {
-        bool purge = false ;
 
-        lockHeaders() ;
-
-        bool update_header = false ;
-        if(entry.mImageSize < 0) //is a brand-new entry
-        {
-            mHeaderIDMap[entry.mID] = idx;
-            mTexturesSizeMap[entry.mID] = new_body_size ;
-            mTexturesSizeTotal += new_body_size ;
-
-            // Update Header
-            update_header = true ;
-        }
-        else if (entry.mBodySize != new_body_size)
+    LLAPRFile aprfile(mHeaderEntriesFileName, APR_READ|APR_WRITE|APR_BINARY, shard.mAPRPoolp);
+    for (S32 idx : shard.mUpdatedEntries)
+    {
+        aprfile.seek(APR_SET, (S32)(sizeof(EntriesInfo) + idx * sizeof(Entry)));
+        S32 bytes_written = aprfile.write(&shard.mEntries[idx - shard.mBase], (S32)sizeof(Entry));
+        if (bytes_written != sizeof(Entry))
         {
-            //already in mHeaderIDMap.
-            mTexturesSizeMap[entry.mID] = new_body_size ;
-            mTexturesSizeTotal -= entry.mBodySize ;
-            mTexturesSizeTotal += new_body_size ;
+            mCorruptedCache = true; // cleared from update()
+            break;
         }
-        entry.mTime = (U32)time(NULL);
-        entry.mImageSize = new_image_size ;
-        entry.mBodySize = new_body_size ;
+    }
+    shard.mUpdatedEntries.clear();
+}
 
-        writeEntryToHeaderImmediately(idx, entry, update_header) ;
+void LLTextureCache::removeCachedTexture(HeaderShard& shard, S32 idx)
+{
+    Entry& entry = shard.mEntries[idx - shard.mBase];
+    shard.mLRU.erase(std::make_pair(entry.mTime, idx));
+    auto iter = shard.mIDMap.find(entry.mID);
+    if (iter != shard.mIDMap.end() && iter->second == idx)
+    {
+        shard.mIDMap.erase(iter);
+    }
+    shard.mBodySize -= entry.mBodySize;
+    mTexturesSizeTotal -= entry.mBodySize;
+    // We are inside the shard's mutex so its pool is safe to use,
+    // but getLocalAPRFilePool() is not safe, it might be in use by worker
+    LLAPRFile::remove(getTextureFileName(entry.mID), shard.mAPRPoolp);
+    entry.mImageSize = -1;
+    entry.mBodySize = 0;
+}
 
-        if (mTexturesSizeTotal > sCacheMaxTexturesSize)
+void LLTextureCache::removeEntry(HeaderShard& shard, S32 idx, const std::string& filename)
+{
+    bool file_maybe_exists = true;  // Always attempt to remove when idx is invalid.
+
+    if(idx >= 0) //valid entry
+    {
+        Entry& entry = shard.mEntries[idx - shard.mBase];
+        if (entry.mBodySize == 0)   // Always attempt to remove when mBodySize > 0.
         {
-            purge = true;
+          // Sanity check. Shouldn't exist when body size is 0.
+          // We are inside the shard's mutex so its pool is safe to use,
+          // but getLocalAPRFilePool() is not safe, it might be in use by worker
+          if (LLAPRFile::isExist(filename, shard.mAPRPoolp))
+          {
+              LL_WARNS("TextureCache") << "Entry has body size of zero but file " << filename << " exists. Deleting this file, too." << LL_ENDL;
+          }
+          else
+          {
+              file_maybe_exists = false;
+          }
         }
 
-        unlockHeaders() ;
-
-        if (purge)
+        shard.mLRU.erase(std::make_pair(entry.mTime, idx));
+        removeFromDecodedCache(entry.mID);
+        auto iter = shard.mIDMap.find(entry.mID);
+        if (iter != shard.mIDMap.end() && iter->second == idx)
         {
-            mDoPurge = true;
+            shard.mIDMap.erase(iter);
         }
+        shard.mBodySize -= entry.mBodySize;
+        mTexturesSizeTotal -= entry.mBodySize;
+
+        entry.mImageSize = -1;
+        entry.mBodySize = 0;
+        shard.mFreeList.insert(idx);
     }
 
-    return false ;
+    if (file_maybe_exists)
+    {
+        LLAPRFile::remove(filename, shard.mAPRPoolp);
+    }
 }
 
-U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
-{
-    U32 num_entries = mHeaderEntriesInfo.mEntries;
+//----------------------------------------------------------------------------
 
-    mHeaderIDMap.clear();
-    mTexturesSizeMap.clear();
-    mFreeList.clear();
-    mTexturesSizeTotal = 0;
+//update an existing entry, write to header file immediately.
+bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    S32 new_body_size = llmax(0, new_data_size - TEXTURE_CACHE_ENTRY_SIZE) ;
 
-    LLAPRFile* aprfile = NULL;
-    if(mUpdatedEntryMap.empty())
+    if(new_image_size == entry.mImageSize && new_body_size == entry.mBodySize)
     {
-        aprfile = openHeaderEntriesFile(true, (S32)sizeof(EntriesInfo));
+        return true ; //nothing changed.
     }
-    else //update the header file first.
+
+    bool purge = false ;
     {
-        aprfile = openHeaderEntriesFile(false, 0);
-        updatedHeaderEntriesFile() ;
-        if(!aprfile)
+        HeaderShard& shard = getShard(entry.mID);
+        LLMutexLock lock(&shard.mMutex);
+
+        S32 slot = idx - shard.mBase;
+        if (slot < 0 || slot >= (S32)shard.mEntries.size() || shard.mEntries[slot].mID != entry.mID)
         {
-            return 0;
+            // Recycled by another worker since we read it
+            LL_WARNS("TextureCache") << "Entry " << idx << " no longer holds " << entry.mID << LL_ENDL;
+            idx = -1;
+            return false;
         }
-        aprfile->seek(APR_SET, (S32)sizeof(EntriesInfo));
-    }
-    for (U32 idx=0; idx<num_entries; idx++)
-    {
-        try
+
+        if (shard.mEntries[slot].mImageSize < 0) //is a brand-new entry
         {
-            Entry entry;
-            S32 bytes_read = aprfile->read((void*)(&entry), (S32)sizeof(Entry));
-            if (bytes_read < sizeof(Entry))
-            {
-                LL_WARNS() << "Corrupted header entries, failed at " << idx << " / " << num_entries << LL_ENDL;
-                return 0;
-            }
-            entries.push_back(entry);
-            //      LL_INFOS() << "ENTRY: " << entry.mTime << " TEX: " << entry.mID << " IDX: " << idx << " Size: " << entry.mImageSize << LL_ENDL;
-            if (entry.mImageSize > entry.mBodySize)
+            auto iter = shard.mIDMap.find(entry.mID);
+            if (iter != shard.mIDMap.end())
             {
-                mHeaderIDMap[entry.mID] = idx;
-                mTexturesSizeMap[entry.mID] = entry.mBodySize;
-                mTexturesSizeTotal += entry.mBodySize;
+                // Another worker added the same texture in the meantime,
+                // give back our entry and update theirs.
+                shard.mFreeList.insert(idx);
+                idx = iter->second;
+                slot = idx - shard.mBase;
             }
             else
             {
-                mFreeList.insert(idx);
+                shard.mIDMap[entry.mID] = idx;
             }
         }
-        catch (std::bad_alloc&)
+
+        Entry& cached = shard.mEntries[slot];
+        if (cached.mImageSize >= 0)
         {
-            // Too little ram yet very large cache?
-            // Should this actually crash viewer?
-            entries.clear();
-            LL_WARNS() << "Bad alloc trying to read texture entries from cache, mFreeList: " << (S32)mFreeList.size()
-                << ", added entries: " << idx << ", total entries: " << num_entries << LL_ENDL;
-            closeHeaderEntriesFile();
-            purgeAllTextures(false);
-            return 0;
+            shard.mLRU.erase(std::make_pair(cached.mTime, idx));
         }
-    }
-    closeHeaderEntriesFile();
-    return num_entries;
-}
+        shard.mBodySize += new_body_size - cached.mBodySize;
+        mTexturesSizeTotal += new_body_size - cached.mBodySize;
 
-void LLTextureCache::writeEntriesAndClose(const std::vector<Entry>& entries)
-{
-    auto num_entries = entries.size();
-    llassert_always(num_entries == mHeaderEntriesInfo.mEntries);
+        cached.mTime = (U32)time(NULL);
+        cached.mImageSize = new_image_size ;
+        cached.mBodySize = new_body_size ;
+        shard.mLRU.insert(std::make_pair(cached.mTime, idx));
+        entry = cached;
 
-    if (!mReadOnly)
-    {
-        LLAPRFile* aprfile = openHeaderEntriesFile(false, (S32)sizeof(EntriesInfo));
-        for (size_t idx=0; idx<num_entries; idx++)
+        if (!writeShardEntry(shard, idx))
         {
-            S32 bytes_written = aprfile->write((void*)(&entries[idx]), (S32)sizeof(Entry));
-            if(bytes_written != sizeof(Entry))
-            {
-                clearCorruptedCache() ; //clear the cache.
-                return ;
-            }
+            idx = -1;
+        }
+
+        if (mTexturesSizeTotal > sCacheMaxTexturesSize)
+        {
+            purge = true;
         }
-        closeHeaderEntriesFile();
     }
-}
 
-void LLTextureCache::writeUpdatedEntries()
-{
-    lockHeaders() ;
-    if (!mReadOnly && !mUpdatedEntryMap.empty())
+    if (purge)
     {
-        openHeaderEntriesFile(false, 0);
-        updatedHeaderEntriesFile() ;
-        closeHeaderEntriesFile();
+        mDoPurge = true;
     }
-    unlockHeaders() ;
+
+    return false ;
 }
 
-//mHeaderMutex is locked and mHeaderAPRFile is created before calling this.
-void LLTextureCache::updatedHeaderEntriesFile()
+void LLTextureCache::writeUpdatedEntries()
 {
-    if (!mReadOnly && !mUpdatedEntryMap.empty() && mHeaderAPRFile)
+    for (U32 i = 0; i < sHeaderShardCount; ++i)
     {
-        //entriesInfo
-        mHeaderAPRFile->seek(APR_SET, 0);
-        S32 bytes_written = mHeaderAPRFile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo)) ;
-        if(bytes_written != sizeof(EntriesInfo))
-        {
-            clearCorruptedCache() ; //clear the cache.
-            return ;
-        }
-
-        //write each updated entry
-        S32 entry_size = (S32)sizeof(Entry) ;
-        S32 prev_idx = -1 ;
-        S32 delta_idx ;
-        for (idx_entry_map_t::iterator iter = mUpdatedEntryMap.begin(); iter != mUpdatedEntryMap.end(); ++iter)
-        {
-            delta_idx = iter->first - prev_idx - 1;
-            prev_idx = iter->first ;
-            if(delta_idx)
-            {
-                mHeaderAPRFile->seek(APR_CUR, delta_idx * entry_size);
-            }
-
-            bytes_written = mHeaderAPRFile->write((void*)(&iter->second), entry_size);
-            if(bytes_written != entry_size)
-            {
-                clearCorruptedCache() ; //clear the cache.
-                return ;
-            }
-        }
-        mUpdatedEntryMap.clear() ;
+        LLMutexLock lock(&mShards[i].mMutex);
+        writeUpdatedEntries(mShards[i]);
     }
 }
+
 //----------------------------------------------------------------------------
 
 // Called from either the main thread or the worker thread
 void LLTextureCache::readHeaderCache()
 {
-    mHeaderMutex.lock();
-
-    mLRU.clear(); // always clear the LRU
+    lockAllShards();
 
+    resetShards();
     readEntriesHeader();
 
+    const U32 shard_size = getShardSize();
+    U32 num_entries = 0;
+    for (U32 i = 0; i < sHeaderShardCount; ++i)
+    {
+        num_entries += mHeaderEntriesInfo.mShardEntries[i];
+    }
+
     if (mHeaderEntriesInfo.mVersion != sHeaderCacheVersion
         || mHeaderEntriesInfo.mAdressSize != sHeaderCacheAddressSize
-        || strcmp(mHeaderEntriesInfo.mEncoderVersion, sHeaderCacheEncoderVersion.c_str()) != 0)
+        || strcmp(mHeaderEntriesInfo.mEncoderVersion, sHeaderCacheEncoderVersion.c_str()) != 0
+        || (mHeaderEntriesInfo.mShardSize != shard_size && num_entries > 0))
     {
+        // The shard layout depends on the maximum number of entries, so a
+        // change of the cache size also invalidates the cache.
         if (!mReadOnly)
         {
             LL_INFOS() << "Texture Cache version mismatch, Purging." << LL_ENDL;
             purgeAllTextures(false);
         }
     }
+    else if (mHeaderEntriesInfo.mShardSize != shard_size)
+    {
+        // Empty cache made for another size
+        setEntriesHeader();
+        writeEntriesHeader();
+    }
     else
     {
-        std::vector<Entry> entries;
-        U32 num_entries = openAndReadEntries(entries);
-        if (num_entries)
+        bool corrupted = false;
+        for (U32 i = 0; i < sHeaderShardCount && !corrupted; ++i)
         {
-            U32 empty_entries = 0;
-            typedef std::pair<U32, S32> lru_data_t;
-            std::set<lru_data_t> lru;
-            std::set<U32> purge_list;
-            for (U32 i=0; i<num_entries; i++)
+            HeaderShard& shard = mShards[i];
+            U32 count = mHeaderEntriesInfo.mShardEntries[i];
+            if (count > shard_size)
             {
-                Entry& entry = entries[i];
-                if (entry.mImageSize <= 0)
-                {
-                    // This will be in the Free List, don't put it in the LRU
-                    ++empty_entries;
-                }
-                else
-                {
-                    lru.insert(std::make_pair(entry.mTime, i));
-                    if (entry.mBodySize > 0)
-                    {
-                        if (entry.mBodySize > entry.mImageSize)
-                        {
-                            // Shouldn't happen, failsafe only
-                            LL_WARNS() << "Bad entry: " << i << ": " << entry.mID << ": BodySize: " << entry.mBodySize << LL_ENDL;
-                            purge_list.insert(i);
-                        }
-                    }
-                }
+                LL_WARNS() << "Corrupted header entries, shard " << i << " has " << count << " entries" << LL_ENDL;
+                corrupted = true;
+                break;
             }
-            if (num_entries - empty_entries > sCacheMaxEntries)
+            if (!count)
             {
-                // Special case: cache size was reduced, need to remove entries
-                U32 entries_to_purge = (num_entries - empty_entries) - sCacheMaxEntries;
-                LL_INFOS() << "Texture Cache Entries: " << num_entries << " Max: " << sCacheMaxEntries << " Empty: " << empty_entries << " Purging: " << entries_to_purge << LL_ENDL;
-                // We can exit the following loop with the given condition, since if we'd reach the end of the lru set we'd have:
-                // purge_list.size() = lru.size() = num_entries - empty_entries = entries_to_purge + sCacheMaxEntries >= entries_to_purge
-                // So, it's certain that iter will never reach lru.end() first.
-                std::set<lru_data_t>::iterator iter = lru.begin();
-                while (purge_list.size() < entries_to_purge)
-                {
-                    purge_list.insert(iter->second);
-                    ++iter;
-                }
+                continue;
             }
 
+            try
             {
-                S32 lru_entries = (S32)((F32)sCacheMaxEntries * TEXTURE_CACHE_LRU_SIZE);
-                for (std::set<lru_data_t>::iterator iter = lru.begin(); iter != lru.end(); ++iter)
-                {
-                    mLRU.insert(entries[iter->second].mID);
-//                  LL_INFOS() << "LRU: " << iter->first << " : " << iter->second << LL_ENDL;
-                    if (--lru_entries <= 0)
-                        break;
-                }
+                shard.mEntries.resize(count);
+            }
+            catch (std::bad_alloc&)
+            {
+                // Too little ram yet very large cache?
+                // Should this actually crash viewer?
+                LL_WARNS() << "Bad alloc trying to read texture entries from cache, shard: " << i
+                    << ", entries: " << count << LL_ENDL;
+                corrupted = true;
+                break;
+            }
+
+            S32 offset = (S32)(sizeof(EntriesInfo) + shard.mBase * sizeof(Entry));
+            S32 size = (S32)(count * sizeof(Entry));
+            if (LLAPRFile::readEx(mHeaderEntriesFileName, shard.mEntries.data(), offset, size, mHeaderAPRFilePoolp) != size)
+            {
+                LL_WARNS() << "Corrupted header entries, failed to read shard " << i << LL_ENDL;
+                corrupted = true;
+                break;
             }
 
-            if (purge_list.size() > 0)
+            bool changed = false;
+            for (U32 j = 0; j < count; ++j)
             {
-                LLTimer timer;
-                for (std::set<U32>::iterator iter = purge_list.begin(); iter != purge_list.end(); ++iter)
+                const S32 idx = shard.mBase + (S32)j;
+                Entry& entry = shard.mEntries[j];
+                if (entry.mImageSize <= entry.mBodySize)
                 {
-                    std::string tex_filename = getTextureFileName(entries[*iter].mID);
-                    removeEntry((S32)*iter, entries[*iter], tex_filename);
+                    // Free entry, don't put it in the LRU
+                    entry.mImageSize = -1;
+                    entry.mBodySize = 0;
+                    shard.mFreeList.insert(idx);
+                    continue;
+                }
 
-                    //make sure that pruning entries doesn't take too much time
-                    if (timer.getElapsedTimeF32() > TEXTURE_PRUNING_MAX_TIME)
-                    {
-                        break;
-                    }
+                if (&getShard(entry.mID) != &shard)
+                {
+                    // Shouldn't happen, failsafe only
+                    LL_WARNS() << "Bad entry: " << idx << ": " << entry.mID << " in shard " << i << LL_ENDL;
+                    entry.mImageSize = -1;
+                    entry.mBodySize = 0;
+                    shard.mFreeList.insert(idx);
+                    changed = true;
+                    continue;
                 }
-                writeEntriesAndClose(entries);
-            }
-            else
+
+                auto inserted = shard.mIDMap.emplace(entry.mID, idx);
+                if (!inserted.second)
+                {
+                    // Duplicate, the later entry wins
+                    const S32 old_idx = inserted.first->second;
+                    Entry& old_entry = shard.mEntries[old_idx - shard.mBase];
+                    shard.mLRU.erase(std::make_pair(old_entry.mTime, old_idx));
+                    shard.mBodySize -= old_entry.mBodySize;
+                    old_entry.mImageSize = -1;
+                    old_entry.mBodySize = 0;
+                    shard.mFreeList.insert(old_idx);
+                    inserted.first->second = idx;
+                    changed = true;
+                }
+                shard.mLRU.insert(std::make_pair(entry.mTime, idx));
+                shard.mBodySize += entry.mBodySize;
+            }
+            mTexturesSizeTotal += shard.mBodySize;
+
+            if (changed)
             {
-                //entries are not changed, nothing here.
+                writeShardEntries(shard);
             }
         }
+
+        if (corrupted)
+        {
+            clearCorruptedCache();
+        }
     }
-    mHeaderMutex.unlock();
+
+    unlockAllShards();
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
-//the header mutex is locked before calling this.
 void LLTextureCache::clearCorruptedCache()
 {
     LL_WARNS() << "the texture cache is corrupted, need to be cleared." << LL_ENDL ;
 
-    closeHeaderEntriesFile();//close possible file handler
+    lockAllShards();
+
     purgeAllTextures(false) ; //clear the cache.
 
     if (!mReadOnly) //regenerate the directory tree if not exists.
@@ -1582,9 +1684,10 @@ void LLTextureCache::clearCorruptedCache()
         }
     }
 
-    return ;
+    unlockAllShards();
 }
 
+//all the shards are locked before calling this (or no worker is running yet).
 void LLTextureCache::purgeAllTextures(bool purge_directories)
 {
     if (!mReadOnly)
@@ -1611,18 +1714,14 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
             PeekMessage(&msg, 0, 0, 0, PM_NOREMOVE | PM_NOYIELD);
 #endif
         }
+        purgeDecodedCache(purge_directories);
         gDirUtilp->deleteFilesInDir(mTexturesDirName, mask); // headers, fast cache
         if (purge_directories)
         {
             LLFile::rmdir(mTexturesDirName);
         }
     }
-    mHeaderIDMap.clear();
-    mTexturesSizeMap.clear();
-    mTexturesSizeTotal = 0;
-    mFreeList.clear();
-    mTexturesSizeTotal = 0;
-    mUpdatedEntryMap.clear();
+    resetShards();
 
     // Info with 0 entries
     setEntriesHeader();
@@ -1631,11 +1730,13 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
     LL_INFOS() << "The entire texture cache is cleared." << LL_ENDL ;
 }
 
-void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
+// Purges one shard at a time, so only the fetches of that shard wait.
+// Returns true if there is more to purge.
+bool LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 {
     if (mReadOnly)
     {
-        return;
+        return false;
     }
 
     if (!mThreaded)
@@ -1643,77 +1744,55 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
         LLAppViewer::instance()->pauseMainloopTimeout();
     }
 
-    // time_limit doesn't account for lock time
-    LLMutexLock lock(&mHeaderMutex);
+    if (mPurgeShard >= sHeaderShardCount)
+    {
+        // Start a new pass. Every shard holds about the same share of the
+        // textures, bring each one under its share of the purged size.
+        S64 cache_size = mTexturesSizeTotal;
+        S64 purged_cache_size = (llmax(cache_size, sCacheMaxTexturesSize) * (S64)((1.f - TEXTURE_CACHE_PURGE_AMOUNT) * 100)) / 100;
+        mPurgeShardTarget = purged_cache_size / sHeaderShardCount;
+        mPurgeShard = 0;
+        LL_DEBUGS("TextureCache") << "Purging from " << cache_size << " to " << purged_cache_size << " bytes" << LL_ENDL;
+    }
 
-    if (mPurgeEntryList.empty())
+    // time_limit doesn't account for lock time
+    LLTimer timer;
+    const S64 purged_cache_size = mPurgeShardTarget * sHeaderShardCount;
+    while (mPurgeShard < sHeaderShardCount && timer.getElapsedTimeF32() < time_limit_sec)
     {
-        // Read the entries list and form list of textures to purge
-        std::vector<Entry> entries;
-        U32 num_entries = openAndReadEntries(entries);
-        if (!num_entries)
-        {
-            return; // nothing to purge
-        }
+        HeaderShard& shard = mShards[mPurgeShard];
+        LLMutexLock lock(&shard.mMutex);
 
-        // Use mTexturesSizeMap to collect UUIDs of textures with bodies
-        typedef std::set<std::pair<U32, S32> > time_idx_set_t;
-        std::set<std::pair<U32, S32> > time_idx_set;
-        for (size_map_t::iterator iter1 = mTexturesSizeMap.begin();
-            iter1 != mTexturesSizeMap.end(); ++iter1)
+        bool shard_done = true;
+        for (time_idx_set_t::iterator iter = shard.mLRU.begin(); iter != shard.mLRU.end(); )
         {
-            if (iter1->second > 0)
+            if (shard.mBodySize < mPurgeShardTarget || mTexturesSizeTotal < purged_cache_size)
             {
-                id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-                if (iter2 != mHeaderIDMap.end())
-                {
-                    S32 idx = iter2->second;
-                    time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
-                }
-                else
-                {
-                    LL_ERRS("TextureCache") << "mTexturesSizeMap / mHeaderIDMap corrupted." << LL_ENDL;
-                }
+                break;
             }
-        }
-
-        S64 cache_size = mTexturesSizeTotal;
-        S64 purged_cache_size = (llmax(cache_size, sCacheMaxTexturesSize) * (S64)((1.f - TEXTURE_CACHE_PURGE_AMOUNT) * 100)) / 100;
-        for (time_idx_set_t::iterator iter = time_idx_set.begin();
-            iter != time_idx_set.end(); ++iter)
-        {
-            S32 idx = iter->second;
-            if (cache_size >= purged_cache_size)
+            if (timer.getElapsedTimeF32() >= time_limit_sec)
             {
-                cache_size -= entries[idx].mBodySize;
-                mPurgeEntryList.push_back(std::pair<S32, Entry>(idx, entries[idx]));
+                shard_done = false;
+                break;
             }
-            else
+
+            const S32 idx = iter->second;
+            ++iter; // removeEntry() erases the current one
+            const Entry& entry = shard.mEntries[idx - shard.mBase];
+            if (entry.mBodySize > 0)
             {
-                break;
+                removeEntry(shard, idx, getTextureFileName(entry.mID));
+                writeShardEntry(shard, idx);
             }
         }
-        LL_DEBUGS("TextureCache") << "Formed Purge list of " << mPurgeEntryList.size() << " entries" << LL_ENDL;
-    }
-    else
-    {
-        // Remove collected entried
-        LLTimer timer;
-        while (!mPurgeEntryList.empty() && timer.getElapsedTimeF32() < time_limit_sec)
+
+        if (shard_done)
         {
-            S32 idx = mPurgeEntryList.back().first;
-            Entry entry = mPurgeEntryList.back().second;
-            mPurgeEntryList.pop_back();
-            // make sure record is still valid
-            id_map_t::iterator iter_header = mHeaderIDMap.find(entry.mID);
-            if (iter_header != mHeaderIDMap.end() && iter_header->second == idx)
-            {
-                std::string tex_filename = getTextureFileName(entry.mID);
-                removeEntry(idx, entry, tex_filename);
-                writeEntryToHeaderImmediately(idx, entry);
-            }
+            ++mPurgeShard;
         }
     }
+
+    return mPurgeShard < sHeaderShardCount;
 }
 
 void LLTextureCache::purgeTextures(bool validate)
@@ -1729,40 +1808,10 @@ void LLTextureCache::purgeTextures(bool validate)
         LLAppViewer::instance()->pauseMainloopTimeout();
     }
 
-    LLMutexLock lock(&mHeaderMutex);
+    lockAllShards();
 
     LL_INFOS() << "TEXTURE CACHE: Purging." << LL_ENDL;
 
-    // Read the entries list
-    std::vector<Entry> entries;
-    U32 num_entries = openAndReadEntries(entries);
-    if (!num_entries)
-    {
-        return; // nothing to purge
-    }
-
-    // Use mTexturesSizeMap to collect UUIDs of textures with bodies
-    typedef std::set<std::pair<U32,S32> > time_idx_set_t;
-    std::set<std::pair<U32,S32> > time_idx_set;
-    for (size_map_t::iterator iter1 = mTexturesSizeMap.begin();
-         iter1 != mTexturesSizeMap.end(); ++iter1)
-    {
-        if (iter1->second > 0)
-        {
-            id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-            if (iter2 != mHeaderIDMap.end())
-            {
-                S32 idx = iter2->second;
-                time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
-//              LL_INFOS() << "TIME: " << entries[idx].mTime << " TEX: " << entries[idx].mID << " IDX: " << idx << " Size: " << entries[idx].mImageSize << LL_ENDL;
-            }
-            else
-            {
-                LL_ERRS() << "mTexturesSizeMap / mHeaderIDMap corrupted." << LL_ENDL ;
-            }
-        }
-    }
-
     // Validate 1/256th of the files on startup
     U32 validate_idx = 0;
     if (validate)
@@ -1775,52 +1824,71 @@ void LLTextureCache::purgeTextures(bool validate)
 
     S64 cache_size = mTexturesSizeTotal;
     S64 purged_cache_size = (llmax(cache_size, sCacheMaxTexturesSize) * (S64)((1.f - TEXTURE_CACHE_PURGE_AMOUNT) * 100)) / 100;
+    S64 shard_purged_size = purged_cache_size / sHeaderShardCount;
     S32 purge_count = 0;
-    for (time_idx_set_t::iterator iter = time_idx_set.begin();
-         iter != time_idx_set.end(); ++iter)
+    size_t num_entries = 0;
+    for (U32 i = 0; i < sHeaderShardCount; ++i)
     {
-        S32 idx = iter->second;
-        bool purge_entry = false;
+        HeaderShard& shard = mShards[i];
+        num_entries += shard.mEntries.size();
 
-        if (cache_size >= purged_cache_size)
-        {
-            purge_entry = true;
-        }
-        else if (validate)
+        // Least recently used first, only the textures with bodies
+        bool changed = false;
+        for (time_idx_set_t::iterator iter = shard.mLRU.begin(); iter != shard.mLRU.end(); )
         {
-            // make sure file exists and is the correct size
-            U32 uuididx = entries[idx].mID.mData[0];
-            if (uuididx == validate_idx)
+            const S32 idx = iter->second;
+            ++iter; // removeEntry() erases the current one
+            const Entry& entry = shard.mEntries[idx - shard.mBase];
+            if (entry.mBodySize <= 0)
             {
-                std::string filename = getTextureFileName(entries[idx].mID);
-                LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entries[idx].mBodySize << LL_ENDL;
-                // mHeaderAPRFilePoolp because this is under header mutex in main thread
-                S32 bodysize = LLAPRFile::size(filename, mHeaderAPRFilePoolp);
-                if (bodysize != entries[idx].mBodySize)
+                continue;
+            }
+
+            bool purge_entry = false;
+            if (mTexturesSizeTotal >= purged_cache_size && shard.mBodySize >= shard_purged_size)
+            {
+                purge_entry = true;
+            }
+            else if (validate)
+            {
+                // make sure file exists and is the correct size
+                U32 uuididx = entry.mID.mData[0];
+                if (uuididx == validate_idx)
                 {
-                    LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entries[idx].mBodySize << filename << LL_ENDL;
-                    purge_entry = true;
+                    std::string filename = getTextureFileName(entry.mID);
+                    LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entry.mBodySize << LL_ENDL;
+                    // mHeaderAPRFilePoolp because this is under header mutex in main thread
+                    S32 bodysize = LLAPRFile::size(filename, mHeaderAPRFilePoolp);
+                    if (bodysize != entry.mBodySize)
+                    {
+                        LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entry.mBodySize << filename << LL_ENDL;
+                        purge_entry = true;
+                    }
                 }
             }
-        }
-        else
-        {
-            break;
+            else
+            {
+                break;
+            }
+
+            if (purge_entry)
+            {
+                purge_count++;
+                std::string filename = getTextureFileName(entry.mID);
+                LL_DEBUGS("TextureCache") << "PURGING: " << filename << LL_ENDL;
+                removeEntry(shard, idx, filename);
+                changed = true;
+            }
         }
 
-        if (purge_entry)
+        if (changed)
         {
-            purge_count++;
-            std::string filename = getTextureFileName(entries[idx].mID);
-            LL_DEBUGS("TextureCache") << "PURGING: " << filename << LL_ENDL;
-            cache_size -= entries[idx].mBodySize;
-            removeEntry(idx, entries[idx], filename) ;
+            LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Writing shard " << i << " entries: " << shard.mEntries.size() << LL_ENDL;
+            writeShardEntries(shard);
         }
     }
 
-    LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Writing Entries: " << num_entries << LL_ENDL;
-
-    writeEntriesAndClose(entries);
+    unlockAllShards();
 
     // *FIX:Mani - watchdog back on.
     LLAppViewer::instance()->resumeMainloopTimeout();
@@ -1866,11 +1934,12 @@ LLTextureCacheWorker* LLTextureCache::getWriter(handle_t handle)
 S32 LLTextureCache::getHeaderCacheEntry(const LLUUID& id, Entry& entry)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
-    LLMutexLock lock(&mHeaderMutex);
-    S32 idx = openAndReadEntry(id, entry, false);
+    HeaderShard& shard = getShard(id);
+    LLMutexLock lock(&shard.mMutex);
+    S32 idx = openAndReadEntry(shard, id, entry, false);
     if (idx >= 0)
     {
-        updateEntryTimeStamp(idx, entry); // updates time
+        updateEntryTimeStamp(shard, idx, entry); // updates time
     }
     return idx;
 }
@@ -1879,24 +1948,18 @@ S32 LLTextureCache::getHeaderCacheEntry(const LLUUID& id, Entry& entry)
 S32 LLTextureCache::setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
-    mHeaderMutex.lock();
-    S32 idx = openAndReadEntry(id, entry, true); // read or create
-    mHeaderMutex.unlock();
-
-    if(idx < 0) // retry once
+    S32 idx;
     {
-        readHeaderCache(); // We couldn't write an entry, so refresh the LRU
-
-        mHeaderMutex.lock();
-        idx = openAndReadEntry(id, entry, true);
-        mHeaderMutex.unlock();
+        HeaderShard& shard = getShard(id);
+        LLMutexLock lock(&shard.mMutex);
+        idx = openAndReadEntry(shard, id, entry, true); // read or create
     }
 
     if (idx >= 0)
     {
         updateEntry(idx, entry, imagesize, datasize);
     }
-    else
+    else if (!mReadOnly)
     {
         LL_WARNS() << "Failed to set cache entry for image: " << id << LL_ENDL;
         // We couldn't write to file, switch to read only mode and clear data
@@ -1986,8 +2049,7 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id,
     {
         // NOTE: Needs to be done on the control thread
         //  (i.e. here)
-        purgeTexturesLazy(TEXTURE_LAZY_PURGE_TIME_LIMIT);
-        mDoPurge = !mPurgeEntryList.empty();
+        mDoPurge = purgeTexturesLazy(TEXTURE_LAZY_PURGE_TIME_LIMIT);
     }
     LLMutexLock lock(&mWorkersMutex);
     LLTextureCacheWorker* worker = new LLTextureCacheRemoteWorker(this, id,
@@ -2003,9 +2065,10 @@ LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& d
 {
     U32 offset;
     {
-        LLMutexLock lock(&mHeaderMutex);
-        id_map_t::const_iterator iter = mHeaderIDMap.find(id);
-        if(iter == mHeaderIDMap.end())
+        HeaderShard& shard = getShard(id);
+        LLMutexLock lock(&shard.mMutex);
+        auto iter = shard.mIDMap.find(id);
+        if(iter == shard.mIDMap.end())
         {
             return NULL; //not in the cache
         }
@@ -2184,6 +2247,485 @@ void LLTextureCache::closeFastCache(bool forced)
     return;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// Decoded tier
+//
+// One file per (id, discard level) in texturecache/decoded:
+//  DecodedHeader, then the zlib compressed raw image data followed by the
+//  aux image data (if any).
+
+#if LL_WINDOWS
+#pragma pack(push,1)
+#endif
+
+struct DecodedHeader
+{
+    U32 mMagic;
+    U32 mDataSize;       // raw + aux bytes once inflated
+    U32 mCompressedSize; // bytes following the header
+    U16 mWidth;
+    U16 mHeight;
+    U16 mAuxWidth;
+    U16 mAuxHeight;
+    S8 mComponents;
+    S8 mAuxComponents;   // 0 if there is no aux image
+    S8 mDiscardLevel;
+    U8 mPad;
+};
+
+#if LL_WINDOWS
+#pragma pack(pop)
+#endif
+
+static const U32 DECODED_CACHE_MAGIC = 0x3144434c; // "LCD1"
+// Smaller images decode quickly enough from the J2C body
+static const S32 DECODED_CACHE_MIN_PIXELS = 64 * 64;
+// Raw copies waiting to be compressed are dropped past this
+static const S32 DECODED_CACHE_MAX_PENDING_WRITES = 32;
+// The tier is trimmed to this fraction of its size when it is full
+static const F32 DECODED_CACHE_TRIM_RATIO = 0.9f;
+
+std::string LLTextureCache::getDecodedFileName(const LLUUID& id, S32 discardlevel)
+{
+    return mDecodedDirName + gDirUtilp->getDirDelimiter() + id.asString() + llformat("_%d.decoded", discardlevel);
+}
+
+// Called in the main thread from initCache(), rebuilds the index from the
+// files left by the previous sessions.
+void LLTextureCache::initDecodedCache()
+{
+    LLMutexLock lock(&mDecodedMutex);
+    mDecodedEntries.clear();
+    mDecodedLRU.clear();
+    mDecodedSize = 0;
+
+    if (!isDecodedCacheEnabled())
+    {
+        if (!mReadOnly && LLFile::isdir(mDecodedDirName))
+        {
+            gDirUtilp->deleteDirAndContents(mDecodedDirName);
+        }
+        return;
+    }
+
+    if (!mReadOnly)
+    {
+        LLFile::mkdir(mDecodedDirName);
+    }
+
+    std::vector<std::string> removed;
+    std::string delem = gDirUtilp->getDirDelimiter();
+    std::vector<std::string> files = gDirUtilp->getFilesInDir(mDecodedDirName);
+    for (const std::string& file : files)
+    {
+        std::string filename = mDecodedDirName + delem + file;
+        // <uuid>_<discard>.decoded
+        std::string idstr = file.substr(0, UUID_STR_LENGTH - 1);
+        S32 discard = -1;
+        llstat stat_data;
+        if (file.size() > UUID_STR_LENGTH && LLUUID::validate(idstr)
+            && sscanf(file.c_str() + UUID_STR_LENGTH, "%d", &discard) == 1
+            && discard >= 0 && discard <= MAX_DISCARD_LEVEL
+            && file == idstr + llformat("_%d.decoded", discard)
+            && LLFile::stat(filename, &stat_data) == 0)
+        {
+            decoded_key_t key(LLUUID(idstr), discard);
+            DecodedEntry& entry = mDecodedEntries[key];
+            entry.mSize = stat_data.st_size;
+            entry.mTime = (U32)stat_data.st_mtime;
+            mDecodedLRU.insert(std::make_pair(entry.mTime, key));
+            mDecodedSize += entry.mSize;
+        }
+        else
+        {
+            // Interrupted write or unknown file
+            removed.push_back(filename);
+        }
+    }
+
+    if (mDecodedSize > mDecodedMaxSize)
+    {
+        trimDecodedCache((S64)(mDecodedMaxSize * DECODED_CACHE_TRIM_RATIO), removed);
+    }
+
+    if (!mReadOnly)
+    {
+        for (const std::string& filename : removed)
+        {
+            LLFile::remove(filename);
+        }
+    }
+
+    LL_INFOS("TextureCache") << "Decoded tier: " << mDecodedEntries.size() << " images, "
+                             << mDecodedSize / (1024 * 1024) << " MB of "
+                             << mDecodedMaxSize / (1024 * 1024) << " MB" << LL_ENDL;
+}
+
+//all the shards are locked before calling this (or no worker is running yet).
+void LLTextureCache::purgeDecodedCache(bool purge_directory)
+{
+    LLMutexLock lock(&mDecodedMutex);
+    mDecodedEntries.clear();
+    mDecodedLRU.clear();
+    mDecodedSize = 0;
+    mDecodedCancelledWrites = mDecodedWrites;
+
+    if (!mReadOnly && LLFile::isdir(mDecodedDirName))
+    {
+        if (purge_directory)
+        {
+            gDirUtilp->deleteDirAndContents(mDecodedDirName);
+        }
+        else
+        {
+            gDirUtilp->deleteFilesInDir(mDecodedDirName, "*");
+        }
+    }
+}
+
+void LLTextureCache::trimDecodedCache(S64 target_size, std::vector<std::string>& removed)
+{
+    while (mDecodedSize > target_size && !mDecodedLRU.empty())
+    {
+        const decoded_key_t key = mDecodedLRU.begin()->second;
+        mDecodedLRU.erase(mDecodedLRU.begin());
+        auto iter = mDecodedEntries.find(key);
+        if (iter != mDecodedEntries.end())
+        {
+            mDecodedSize -= iter->second.mSize;
+            mDecodedEntries.erase(iter);
+        }
+        removed.push_back(getDecodedFileName(key.first, key.second));
+    }
+}
+
+void LLTextureCache::removeFromDecodedCache(const LLUUID& id)
+{
+    std::vector<std::string> removed;
+    {
+        LLMutexLock lock(&mDecodedMutex);
+        auto iter = mDecodedEntries.lower_bound(decoded_key_t(id, 0));
+        while (iter != mDecodedEntries.end() && iter->first.first == id)
+        {
+            mDecodedLRU.erase(std::make_pair(iter->second.mTime, iter->first));
+            mDecodedSize -= iter->second.mSize;
+            removed.push_back(getDecodedFileName(id, iter->first.second));
+            iter = mDecodedEntries.erase(iter);
+        }
+
+        // A write still in flight would bring the image back when it
+        // completes, doWriteToDecodedCache() drops it instead
+        auto write_iter = mDecodedWrites.lower_bound(decoded_key_t(id, 0));
+        while (write_iter != mDecodedWrites.end() && write_iter->first == id)
+        {
+            mDecodedCancelledWrites.insert(*write_iter);
+            ++write_iter;
+        }
+    }
+
+    if (!mReadOnly)
+    {
+        for (const std::string& filename : removed)
+        {
+            LLFile::remove(filename);
+        }
+    }
+}
+
+S32 LLTextureCache::findDecodedLevel(const LLUUID& id, S32 discardlevel)
+{
+    for (S32 level = discardlevel; level >= llmax(discardlevel - 1, 0); --level)
+    {
+        if (mDecodedEntries.find(decoded_key_t(id, level)) != mDecodedEntries.end())
+        {
+            return level;
+        }
+    }
+    return -1;
+}
+
+// Called from the texture fetch threads. Only the index is looked at here,
+// the file is read and inflated on the cache thread.
+LLTextureCache::handle_t LLTextureCache::readFromDecodedCache(const LLUUID& id, S32 discardlevel, bool needs_aux,
+                                                              DecodedReadResponder* responder)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    if (!isDecodedCacheEnabled() || discardlevel < 0)
+    {
+        return nullHandle();
+    }
+    {
+        LLMutexLock lock(&mDecodedMutex);
+        if (findDecodedLevel(id, discardlevel) < 0)
+        {
+            return nullHandle();
+        }
+    }
+
+    LLMutexLock lock(&mWorkersMutex);
+    LLTextureCacheWorker* worker = new LLTextureCacheDecodedWorker(this, id, discardlevel, needs_aux, responder);
+    handle_t handle = worker->read();
+    mReaders[handle] = worker;
+    return handle;
+}
+
+// Called from the cache thread
+bool LLTextureCache::doReadFromDecodedCache(const LLUUID& id, S32 discardlevel, bool needs_aux,
+                                            LLPointer<LLImageRaw>& raw, LLPointer<LLImageRaw>& aux, S32& decoded_discard)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    S32 discard = -1;
+    {
+        LLMutexLock lock(&mDecodedMutex);
+        discard = findDecodedLevel(id, discardlevel);
+        if (discard >= 0)
+        {
+            // Touch the entry so that the purge keeps it
+            auto iter = mDecodedEntries.find(decoded_key_t(id, discard));
+            U32 now = (U32)time(NULL);
+            mDecodedLRU.erase(std::make_pair(iter->second.mTime, iter->first));
+            iter->second.mTime = now;
+            mDecodedLRU.insert(std::make_pair(now, iter->first));
+        }
+    }
+    if (discard < 0)
+    {
+        return false;
+    }
+
+    std::string filename = getDecodedFileName(id, discard);
+    LLUniqueFile file = LLFile::fopen(filename, "rb");
+    DecodedHeader header;
+    llstat stat_data;
+    // The header sizes the buffers below, so a corrupt or truncated file
+    // must not get past it
+    bool success = file && fread(&header, sizeof(header), 1, file) == 1
+        && LLFile::stat(filename, &stat_data) == 0
+        && header.mMagic == DECODED_CACHE_MAGIC
+        && header.mDiscardLevel == discard
+        && header.mWidth <= MAX_IMAGE_SIZE && header.mHeight <= MAX_IMAGE_SIZE
+        && header.mComponents > 0 && header.mComponents <= MAX_IMAGE_COMPONENTS
+        && header.mAuxWidth <= MAX_IMAGE_SIZE && header.mAuxHeight <= MAX_IMAGE_SIZE
+        && header.mAuxComponents >= 0 && header.mAuxComponents <= MAX_IMAGE_COMPONENTS
+        && (U64)header.mCompressedSize <= (U64)stat_data.st_size - sizeof(header)
+        && (U64)header.mDataSize == (U64)header.mWidth * header.mHeight * header.mComponents
+                                    + (U64)header.mAuxWidth * header.mAuxHeight * header.mAuxComponents;
+    if (success && needs_aux && header.mAuxComponents == 0)
+    {
+        // Stored without the aux channel, let the decoder produce it
+        return false;
+    }
+
+    if (success)
+    {
+        std::vector<U8> compressed(header.mCompressedSize);
+        success = fread(compressed.data(), 1, compressed.size(), file) == compressed.size();
+        if (success)
+        {
+            std::vector<U8> data(header.mDataSize);
+            uLongf data_size = (uLongf)data.size();
+            success = uncompress(data.data(), &data_size, compressed.data(), (uLong)compressed.size()) == Z_OK
+                && data_size == data.size();
+            if (success)
+            {
+                S32 raw_size = header.mWidth * header.mHeight * header.mComponents;
+                raw = new LLImageRaw(data.data(), header.mWidth, header.mHeight, header.mComponents);
+                aux = NULL;
+                if (needs_aux)
+                {
+                    aux = new LLImageRaw(data.data() + raw_size, header.mAuxWidth, header.mAuxHeight, header.mAuxComponents);
+                }
+                success = raw->getData() && (aux.isNull() || aux->getData());
+            }
+        }
+    }
+
+    if (!success)
+    {
+        LL_WARNS("TextureCache") << "Failed to read decoded image " << filename << LL_ENDL;
+        file.close();
+        raw = NULL;
+        aux = NULL;
+        bool indexed = false;
+        {
+            LLMutexLock lock(&mDecodedMutex);
+            decoded_key_t key(id, discard);
+            auto iter = mDecodedEntries.find(key);
+            if (iter != mDecodedEntries.end())
+            {
+                mDecodedLRU.erase(std::make_pair(iter->second.mTime, key));
+                mDecodedSize -= iter->second.mSize;
+                mDecodedEntries.erase(iter);
+                indexed = true;
+            }
+        }
+        if (!mReadOnly && indexed)
+        {
+            LLFile::remove(filename);
+        }
+        return false;
+    }
+
+    decoded_discard = discard;
+    return true;
+}
+
+// Called from the texture fetch threads. The images are copied here since
+// the fetcher hands them over to the viewer as soon as it is done.
+void LLTextureCache::writeToDecodedCache(const LLUUID& id, S32 discardlevel, const LLImageRaw* raw, const LLImageRaw* aux)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    if (mReadOnly || !isDecodedCacheEnabled() || !raw || discardlevel < 0 || discardlevel > MAX_DISCARD_LEVEL)
+    {
+        return;
+    }
+    if (raw->getWidth() * raw->getHeight() < DECODED_CACHE_MIN_PIXELS)
+    {
+        return;
+    }
+
+    decoded_key_t key(id, discardlevel);
+    {
+        LLMutexLock lock(&mDecodedMutex);
+        if (mDecodedEntries.find(key) != mDecodedEntries.end()
+            || mDecodedWrites.find(key) != mDecodedWrites.end()
+            || mDecodedWrites.size() >= DECODED_CACHE_MAX_PENDING_WRITES)
+        {
+            return;
+        }
+        mDecodedWrites.insert(key);
+    }
+
+    LLPointer<LLImageRaw> raw_copy;
+    LLPointer<LLImageRaw> aux_copy;
+    {
+        LLImageDataSharedLock lock(raw);
+        raw_copy = new LLImageRaw(raw->getData(), raw->getWidth(), raw->getHeight(), raw->getComponents());
+    }
+    if (aux)
+    {
+        LLImageDataSharedLock lock(aux);
+        aux_copy = new LLImageRaw(aux->getData(), aux->getWidth(), aux->getHeight(), aux->getComponents());
+    }
+
+    auto slot = std::make_shared<DecodedWriteSlot>(this, key);
+    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    if (!general_queue || !general_queue->post([slot, raw_copy, aux_copy]()
+        {
+            slot->mCache->doWriteToDecodedCache(*slot, raw_copy, aux_copy);
+        }))
+    {
+        doWriteToDecodedCache(*slot, raw_copy, aux_copy);
+    }
+}
+
+LLTextureCache::DecodedWriteSlot::~DecodedWriteSlot()
+{
+    LLMutexLock lock(&mCache->mDecodedMutex);
+    if (!mReleased)
+    {
+        mCache->mDecodedWrites.erase(mKey);
+        mCache->mDecodedCancelledWrites.erase(mKey);
+    }
+}
+
+void LLTextureCache::doWriteToDecodedCache(DecodedWriteSlot& slot, LLPointer<LLImageRaw> raw, LLPointer<LLImageRaw> aux)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    const decoded_key_t key = slot.mKey;
+    S32 raw_size = raw->getData() ? raw->getDataSize() : 0;
+    S32 aux_size = aux.notNull() && aux->getData() ? aux->getDataSize() : 0;
+
+    bool success = raw_size > 0;
+    S64 file_size = 0;
+    std::string filename = getDecodedFileName(key.first, key.second);
+    if (success)
+    {
+        std::vector<U8> data(raw_size + aux_size);
+        memcpy(data.data(), raw->getData(), raw_size);
+        if (aux_size > 0)
+        {
+            memcpy(data.data() + raw_size, aux->getData(), aux_size);
+        }
+
+        uLongf compressed_size = compressBound((uLong)data.size());
+        std::vector<U8> compressed(compressed_size);
+        // Favour the inflate speed, this tier exists to be read quickly
+        success = compress2(compressed.data(), &compressed_size, data.data(), (uLong)data.size(), Z_BEST_SPEED) == Z_OK;
+        if (success)
+        {
+            DecodedHeader header;
+            memset(&header, 0, sizeof(header));
+            header.mMagic = DECODED_CACHE_MAGIC;
+            header.mDataSize = (U32)data.size();
+            header.mCompressedSize = (U32)compressed_size;
+            header.mWidth = raw->getWidth();
+            header.mHeight = raw->getHeight();
+            header.mComponents = raw->getComponents();
+            if (aux_size > 0)
+            {
+                header.mAuxWidth = aux->getWidth();
+                header.mAuxHeight = aux->getHeight();
+                header.mAuxComponents = aux->getComponents();
+            }
+            header.mDiscardLevel = (S8)key.second;
+
+            // Written aside then renamed so that readers never see a partial file
+            std::string tmp_filename = filename + ".tmp";
+            {
+                LLUniqueFile file = LLFile::fopen(tmp_filename, "wb");
+                success = file
+                    && fwrite(&header, sizeof(header), 1, file) == 1
+                    && fwrite(compressed.data(), 1, compressed_size, file) == compressed_size;
+            }
+            success = success && LLFile::replace(tmp_filename, filename) == 0;
+            if (!success)
+            {
+                LLFile::remove(tmp_filename, ENOENT);
+            }
+            file_size = sizeof(header) + compressed_size;
+        }
+    }
+
+    std::vector<std::string> removed;
+    {
+        LLMutexLock lock(&mDecodedMutex);
+        mDecodedWrites.erase(key);
+        slot.mReleased = true;
+        if (mDecodedCancelledWrites.erase(key))
+        {
+            // removeFromDecodedCache() or a purge ran while this was written
+            if (success)
+            {
+                removed.push_back(filename);
+            }
+            success = false;
+        }
+        else if (success)
+        {
+            U32 now = (U32)time(NULL);
+            DecodedEntry& entry = mDecodedEntries[key];
+            entry.mSize = file_size;
+            entry.mTime = now;
+            mDecodedLRU.insert(std::make_pair(now, key));
+            mDecodedSize += file_size;
+            if (mDecodedSize > mDecodedMaxSize)
+            {
+                trimDecodedCache((S64)(mDecodedMaxSize * DECODED_CACHE_TRIM_RATIO), removed);
+            }
+        }
+    }
+
+    if (!success && removed.empty())
+    {
+        LL_DEBUGS("TextureCache") << "Failed to write decoded image " << filename << LL_ENDL;
+    }
+    for (const std::string& removed_filename : removed)
+    {
+        LLFile::remove(removed_filename);
+    }
+}
+
 bool LLTextureCache::writeComplete(handle_t handle, bool abort)
 {
     lockWorkers();
@@ -2220,75 +2762,28 @@ void LLTextureCache::addCompleted(Responder* responder, bool success)
 
 //////////////////////////////////////////////////////////////////////////////
 
-//called after mHeaderMutex is locked.
-void LLTextureCache::removeCachedTexture(const LLUUID& id)
-{
-    if(mTexturesSizeMap.find(id) != mTexturesSizeMap.end())
-    {
-        mTexturesSizeTotal -= mTexturesSizeMap[id] ;
-        mTexturesSizeMap.erase(id);
-    }
-    mHeaderIDMap.erase(id);
-    // We are inside header's mutex so mHeaderAPRFilePoolp is safe to use,
-    // but getLocalAPRFilePool() is not safe, it might be in use by worker
-    LLAPRFile::remove(getTextureFileName(id), mHeaderAPRFilePoolp);
-}
-
-//called after mHeaderMutex is locked.
-void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
-{
-    bool file_maybe_exists = true;  // Always attempt to remove when idx is invalid.
-
-    if(idx >= 0) //valid entry
-    {
-        if (entry.mBodySize == 0)   // Always attempt to remove when mBodySize > 0.
-        {
-          // Sanity check. Shouldn't exist when body size is 0.
-          // We are inside header's mutex so mHeaderAPRFilePoolp is safe to use,
-          // but getLocalAPRFilePool() is not safe, it might be in use by worker
-          if (LLAPRFile::isExist(filename, mHeaderAPRFilePoolp))
-          {
-              LL_WARNS("TextureCache") << "Entry has body size of zero but file " << filename << " exists. Deleting this file, too." << LL_ENDL;
-          }
-          else
-          {
-              file_maybe_exists = false;
-          }
-        }
-        mTexturesSizeTotal -= entry.mBodySize;
-
-        entry.mImageSize = -1;
-        entry.mBodySize = 0;
-        mHeaderIDMap.erase(entry.mID);
-        mTexturesSizeMap.erase(entry.mID);
-        mFreeList.insert(idx);
-    }
-
-    if (file_maybe_exists)
-    {
-        LLAPRFile::remove(filename, mHeaderAPRFilePoolp);
-    }
-}
-
 bool LLTextureCache::removeFromCache(const LLUUID& id)
 {
     //LL_WARNS() << "Removing texture from cache: " << id << LL_ENDL;
     bool ret = false ;
     if (!mReadOnly)
     {
-        lockHeaders() ;
+        HeaderShard& shard = getShard(id);
+        LLMutexLock lock(&shard.mMutex);
 
         Entry entry;
-        S32 idx = openAndReadEntry(id, entry, false);
+        S32 idx = openAndReadEntry(shard, id, entry, false);
         std::string tex_filename = getTextureFileName(id);
-        removeEntry(idx, entry, tex_filename) ;
+        removeEntry(shard, idx, tex_filename) ;
         if (idx >= 0)
         {
-            writeEntryToHeaderImmediately(idx, entry);
+            writeShardEntry(shard, idx);
             ret = true;
         }
-
-        unlockHeaders() ;
+        else
+        {
+            removeFromDecodedCache(id);
+        }
     }
     return ret ;
 }
@@ -34,6 +34,12 @@
 
 #include "llworkerthread.h"
 
+#include <atomic>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
 class LLImageFormatted;
 class LLTextureCacheWorker;
 class LLImageRaw;
@@ -43,6 +49,7 @@ class LLTextureCache : public LLWorkerThread
     friend class LLTextureCacheWorker;
     friend class LLTextureCacheRemoteWorker;
     friend class LLTextureCacheLocalFileWorker;
+    friend class LLTextureCacheDecodedWorker;
 
 private:
 
@@ -52,13 +59,22 @@ private:
 
     // Entries
     static const U32 sHeaderEncoderStringSize = 32;
+    // The entries are split in shards by UUID. Each shard owns a contiguous
+    // range of entry indices (and so its own region of texture.entries,
+    // texture.cache and the fast cache) and is guarded by its own mutex.
+    static const U32 sHeaderShardCount = 16;
     struct EntriesInfo
     {
-        EntriesInfo() : mVersion(0.f), mAdressSize(0), mEntries(0) { memset(mEncoderVersion, 0, sHeaderEncoderStringSize); }
+        EntriesInfo() : mVersion(0.f), mAdressSize(0), mShardSize(0)
+        {
+            memset(mEncoderVersion, 0, sHeaderEncoderStringSize);
+            memset(mShardEntries, 0, sizeof(mShardEntries));
+        }
         F32 mVersion;
         U32 mAdressSize;
         char mEncoderVersion[sHeaderEncoderStringSize];
-        U32 mEntries;
+        U32 mShardSize; // entry indices owned by each shard
+        U32 mShardEntries[sHeaderShardCount]; // entry indices in use in each shard
     };
     struct Entry
     {
@@ -82,6 +98,29 @@ private:
 #pragma pack(pop)
 #endif
 
+    typedef std::set<std::pair<U32, S32> > time_idx_set_t;
+
+    struct HeaderShard
+    {
+        HeaderShard() : mIndex(0), mBase(0), mBodySize(0), mAPRPoolp(NULL) {}
+
+        LLMutex mMutex;
+        U32 mIndex;
+        S32 mBase; // first entry index owned by this shard
+        // Copy of the shard's records in texture.entries, by index - mBase.
+        // Unused records have mImageSize < 0.
+        std::vector<Entry> mEntries;
+        std::set<S32> mFreeList; // deleted entries
+        std::unordered_map<LLUUID, S32> mIDMap;
+        // (time, index) of every entry in mIDMap, least recently used first
+        time_idx_set_t mLRU;
+        // Entries whose time stamp has not been written yet
+        std::set<S32> mUpdatedEntries;
+        S64 mBodySize; // sum of the body sizes of the entries
+        // Not thread safe, used under mMutex only
+        LLVolatileAPRPool* mAPRPoolp;
+    };
+
 public:
 
     class Responder : public LLResponder
@@ -110,6 +149,26 @@ public:
         }
     };
 
+    class DecodedReadResponder : public Responder
+    {
+    public:
+        DecodedReadResponder() : mDiscardLevel(-1) {}
+        void setData(U8* data, S32 datasize, S32 imagesize, S32 imageformat, bool imagelocal)
+        {
+            // not used
+        }
+        void setDecoded(LLImageRaw* raw, LLImageRaw* aux, S32 discardlevel)
+        {
+            mRawImage = raw;
+            mAuxImage = aux;
+            mDiscardLevel = discardlevel;
+        }
+    protected:
+        LLPointer<LLImageRaw> mRawImage;
+        LLPointer<LLImageRaw> mAuxImage;
+        S32 mDiscardLevel;
+    };
+
     LLTextureCache(bool threaded);
     ~LLTextureCache();
 
@@ -133,6 +192,18 @@ public:
 
     bool removeFromCache(const LLUUID& id);
 
+    // Decoded tier: the raw images at the discard levels the fetcher actually
+    // decoded, zlib compressed, so that revisits can skip the J2C decode.
+    // Reads return the coarsest stored level no coarser than discardlevel
+    // and no more than one level finer. They are done on the cache thread
+    // like the J2C reads and complete through readComplete(); nullHandle()
+    // is returned when no such level is stored. Writes are compressed on
+    // the General thread pool. Both are thread safe.
+    handle_t readFromDecodedCache(const LLUUID& id, S32 discardlevel, bool needs_aux,
+                                  DecodedReadResponder* responder);
+    void writeToDecodedCache(const LLUUID& id, S32 discardlevel, const LLImageRaw* raw, const LLImageRaw* aux);
+    bool isDecodedCacheEnabled() const { return mDecodedMaxSize > 0; }
+
     // For LLTextureCacheWorker::Responder
     LLTextureCacheWorker* getReader(handle_t handle);
     LLTextureCacheWorker* getWriter(handle_t handle);
@@ -144,7 +215,7 @@ public:
     S32 getNumWrites() { return static_cast<S32>(mWriters.size()); }
     S64Bytes getUsage() { return S64Bytes(mTexturesSizeTotal); }
     S64Bytes getMaxUsage() { return S64Bytes(sCacheMaxTexturesSize); }
-    U32 getEntries() { return mHeaderEntriesInfo.mEntries; }
+    U32 getEntries();
     U32 getMaxEntries() { return sCacheMaxEntries; };
     bool isInCache(const LLUUID& id) ;
     bool isInLocal(const LLUUID& id) ; //not thread safe at the moment
@@ -163,40 +234,73 @@ private:
     void readHeaderCache();
     void clearCorruptedCache();
     void purgeAllTextures(bool purge_directories);
-    void purgeTexturesLazy(F32 time_limit_sec);
+    bool purgeTexturesLazy(F32 time_limit_sec);
     void purgeTextures(bool validate);
-    LLAPRFile* openHeaderEntriesFile(bool readonly, S32 offset);
-    void closeHeaderEntriesFile();
     void readEntriesHeader();
     void setEntriesHeader();
     void writeEntriesHeader();
-    S32 openAndReadEntry(const LLUUID& id, Entry& entry, bool create);
+    // Shard access. lockAllShards() must be used by anything that touches
+    // more than one shard at a time or the files as a whole.
+    HeaderShard& getShard(const LLUUID& id) { return mShards[id.getDigest64() % sHeaderShardCount]; }
+    U32 getShardSize() const { return sCacheMaxEntries / sHeaderShardCount; }
+    void lockAllShards();
+    void unlockAllShards();
+    void resetShards();
+    // The following expect the shard's mutex to be locked
+    S32 openAndReadEntry(HeaderShard& shard, const LLUUID& id, Entry& entry, bool create);
+    void updateEntryTimeStamp(HeaderShard& shard, S32 idx, Entry& entry);
+    bool writeShardEntry(HeaderShard& shard, S32 idx);
+    bool writeShardEntryCount(HeaderShard& shard);
+    bool writeShardEntries(HeaderShard& shard);
+    void writeUpdatedEntries(HeaderShard& shard);
+    void removeEntry(HeaderShard& shard, S32 idx, const std::string& filename);
+    void removeCachedTexture(HeaderShard& shard, S32 idx);
     bool updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_body_size);
-    void updateEntryTimeStamp(S32 idx, Entry& entry) ;
-    U32 openAndReadEntries(std::vector<Entry>& entries);
-    void writeEntriesAndClose(const std::vector<Entry>& entries);
-    void readEntryFromHeaderImmediately(S32& idx, Entry& entry) ;
-    void writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header = false) ;
-    void removeEntry(S32 idx, Entry& entry, std::string& filename);
-    void removeCachedTexture(const LLUUID& id) ;
     S32 getHeaderCacheEntry(const LLUUID& id, Entry& entry);
     S32 setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize);
     void writeUpdatedEntries() ;
-    void updatedHeaderEntriesFile() ;
-    void lockHeaders() { mHeaderMutex.lock(); }
-    void unlockHeaders() { mHeaderMutex.unlock(); }
 
     void openFastCache(bool first_time = false);
     void closeFastCache(bool forced = false);
     bool writeToFastCache(LLUUID image_id, S32 cache_id, LLPointer<LLImageRaw> raw, S32 discardlevel);
 
+    typedef std::pair<LLUUID, S32> decoded_key_t; // (id, discard level)
+    struct DecodedEntry
+    {
+        S64 mSize; // file size
+        U32 mTime; // last access, seconds since 1/1/1970
+    };
+    // A write reserved by writeToDecodedCache(). doWriteToDecodedCache()
+    // releases it; if the write throws or is dropped with its queue the
+    // destructor does.
+    struct DecodedWriteSlot
+    {
+        DecodedWriteSlot(LLTextureCache* cache, const decoded_key_t& key) : mCache(cache), mKey(key), mReleased(false) {}
+        ~DecodedWriteSlot();
+        LLTextureCache* mCache;
+        decoded_key_t mKey;
+        bool mReleased; // set with mDecodedMutex locked
+    };
+    std::string getDecodedFileName(const LLUUID& id, S32 discardlevel);
+    void initDecodedCache();
+    void purgeDecodedCache(bool purge_directory);
+    void removeFromDecodedCache(const LLUUID& id);
+    // Expects mDecodedMutex to be locked, returns the stored level to read or -1
+    S32 findDecodedLevel(const LLUUID& id, S32 discardlevel);
+    // Called from the cache thread
+    bool doReadFromDecodedCache(const LLUUID& id, S32 discardlevel, bool needs_aux,
+                                LLPointer<LLImageRaw>& raw, LLPointer<LLImageRaw>& aux, S32& decoded_discard);
+    void doWriteToDecodedCache(DecodedWriteSlot& slot, LLPointer<LLImageRaw> raw, LLPointer<LLImageRaw> aux);
+    // Expects mDecodedMutex to be locked, returns the files to delete
+    void trimDecodedCache(S64 target_size, std::vector<std::string>& removed);
+
 private:
     // Internal
     LLMutex mWorkersMutex;
+    // Taken before all the shard mutexes by lockAllShards()
     LLMutex mHeaderMutex;
     LLMutex mListMutex;
     LLMutex mFastCacheMutex;
-    LLAPRFile* mHeaderAPRFile;
     LLVolatileAPRPool* mFastCachePoolp;
 
     // mLocalAPRFilePoolp is not thread safe and is meant only for workers
@@ -220,11 +324,10 @@ private:
     std::string mHeaderEntriesFileName;
     std::string mHeaderDataFileName;
     std::string mFastCacheFileName;
-    EntriesInfo mHeaderEntriesInfo;
-    std::set<S32> mFreeList; // deleted entries
-    std::set<LLUUID> mLRU;
-    typedef std::map<LLUUID, S32> id_map_t;
-    id_map_t mHeaderIDMap;
+    EntriesInfo mHeaderEntriesInfo; // version part only, entry counts live in the shards
+    HeaderShard mShards[sHeaderShardCount];
+    // A shard failed to write its records, cleared from update()
+    LLAtomicBool mCorruptedCache;
 
     LLAPRFile*   mFastCachep;
     LLFrameTimer mFastCacheTimer;
@@ -232,15 +335,22 @@ private:
 
     // BODIES (TEXTURES minus headers)
     std::string mTexturesDirName;
-    typedef std::map<LLUUID,S32> size_map_t;
-    size_map_t mTexturesSizeMap;
-    S64 mTexturesSizeTotal;
+    std::atomic<S64> mTexturesSizeTotal;
     LLAtomicBool mDoPurge;
 
-    typedef std::map<S32, Entry> idx_entry_map_t;
-    idx_entry_map_t mUpdatedEntryMap;
-    typedef std::vector<std::pair<S32, Entry> > idx_entry_vector_t;
-    idx_entry_vector_t mPurgeEntryList;
+    // DECODED (raw images by id and discard level)
+    std::string mDecodedDirName;
+    LLMutex mDecodedMutex;
+    std::map<decoded_key_t, DecodedEntry> mDecodedEntries;
+    std::set<std::pair<U32, decoded_key_t> > mDecodedLRU; // least recently used first
+    std::set<decoded_key_t> mDecodedWrites; // writes in flight
+    std::set<decoded_key_t> mDecodedCancelledWrites; // writes in flight whose image was removed meanwhile
+    S64 mDecodedSize;
+    S64 mDecodedMaxSize;
+
+    // Lazy purge progress, only used by the thread calling writeToCache()
+    U32 mPurgeShard;
+    S64 mPurgeShardTarget;
 
     // Statics
     static F32 sHeaderCacheVersion;
@@ -62,10 +62,12 @@
 #include "bufferstream.h"
 #include "llcorehttputil.h"
 #include "llhttpretrypolicy.h"
+#include "lltexturefetchtrace.h"
 
 LLTrace::CountStatHandle<F64> LLTextureFetch::sCacheHit("texture_cache_hit");
 LLTrace::CountStatHandle<F64> LLTextureFetch::sCacheAttempt("texture_cache_attempt");
 LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > LLTextureFetch::sCacheHitRate("texture_cache_hits");
+LLTrace::CountStatHandle<F64> LLTextureFetch::sDecodedCacheHit("texture_decoded_cache_hit");
 
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sCacheReadLatency("texture_cache_read_latency");
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexDecodeLatency("texture_decode_latency");
@@ -117,12 +119,13 @@ const std::string sTesterName("TextureFetchTester");
 // The Work Queue
 //
 // The two central classes are LLTextureFetch and LLTextureFetchWorker.
-// LLTextureFetch combines threading with a priority queue of work
-// requests.  The priority queue is sorted by a U32 priority derived
-// from the F32 priority in the APIs.  The *only* work request that
-// receives service time by this thread is the highest priority
-// request.  All others wait until it is complete or a dynamic priority
-// change has re-ordered work.
+// LLTextureFetch combines threading with priority queues of work
+// requests.  There is one ready queue per stage (cache read, HTTP,
+// decode, cache write), each a heap sorted by the F32 priority in the
+// APIs.  The thread takes the highest priority request from each
+// non-empty queue in turn, and updateRequestPriority() moves a queued
+// request within its heap.  Requests that are waiting on I/O are in
+// none of the queues (see Worker State Machine).
 //
 // LLTextureFetchWorker implements the work request and is 1:1 with
 // texture fetch requests.  Embedded in each is a state machine that
@@ -157,6 +160,7 @@ const std::string sTesterName("TextureFetchTester");
 // 6.  Mwc      Mutex covering LLWorkerClass's members (base class of
 //              LLTextureFetchWorker).  One per request.
 // 7.  Mw       LLTextureFetchWorker's mutex.  One per request.
+// 8.  Mfr      LLTextureFetch's mutex covering the ready queues.
 //
 //
 // Lock Ordering Rules
@@ -166,6 +170,7 @@ const std::string sTesterName("TextureFetchTester");
 // acquiring 'B'.
 //
 // 1.    Mw < Mfnq
+// 2.    Mw < Ct < Mfr
 // (there are many more...)
 //
 //
@@ -214,11 +219,13 @@ const std::string sTesterName("TextureFetchTester");
 //
 // "doWork" will be executed for a given worker on its respective
 // LLQueuedThread.  If doWork returns true, the worker is treated
-// as completed.  If doWork returns false, the worker will be
-// put on the back of the work queue at the start of the next iteration
-// of the mainloop.  If a worker is waiting on a resource, it should
-// return false as soon as possible and not block to avoid starving
-// other workers of cpu cycles.
+// as completed.  If doWork returns false, parkWork() is asked whether
+// the worker is waiting on a cache read, an HTTP reply or slot, a
+// decode or a cache write.  If so it is parked and the completion
+// callback puts it back on a ready queue with wakeWork().  Otherwise
+// (timers, retries) it is retried after a short delay.  If a worker
+// is waiting on a resource, it should return false as soon as possible
+// and not block to avoid starving other workers of cpu cycles.
 //
 
 
@@ -313,6 +320,31 @@ private:
         LLUUID mID;
     };
 
+    class DecodedCacheReadResponder : public LLTextureCache::DecodedReadResponder
+    {
+    public:
+
+        // Threads:  Ttf
+        DecodedCacheReadResponder(LLTextureFetch* fetcher, const LLUUID& id)
+            : mFetcher(fetcher), mID(id)
+        {
+        }
+
+        // Threads:  Ttc
+        virtual void completed(bool success)
+        {
+            LL_PROFILE_ZONE_SCOPED;
+            LLTextureFetchWorker* worker = mFetcher->getWorker(mID);
+            if (worker)
+            {
+                worker->callbackDecodedCacheRead(success, mRawImage, mAuxImage, mDiscardLevel);
+            }
+        }
+    private:
+        LLTextureFetch* mFetcher;
+        LLUUID mID;
+    };
+
     class CacheWriteResponder : public LLTextureCache::WriteResponder
     {
     public:
@@ -384,6 +416,9 @@ public:
     // Threads:  Tmain
     /*virtual*/ bool deleteOK(); // called from update()
 
+    // Threads:  Ttf
+    /*virtual*/ bool parkWork(S32 param); // called from parkRequest()
+
     ~LLTextureFetchWorker();
 
     // Threads:  Ttf
@@ -395,6 +430,9 @@ public:
     void callbackCacheRead(bool success, LLImageFormatted* image,
                            S32 imagesize, bool islocal);
 
+    // Threads:  Ttc
+    void callbackDecodedCacheRead(bool success, LLImageRaw* raw, LLImageRaw* aux, S32 discardlevel);
+
     // Threads:  Ttc
     void callbackCacheWrite(bool success);
 
@@ -471,6 +509,22 @@ private:
     // Locks:  Mw
     void removeFromCache();
 
+    // Threads:  Ttf
+    // Locks:  Mw
+    bool readFromDecodedCache();
+
+    // Threads:  Ttf
+    // Locks:  Mw
+    bool useDecodedCacheRead();
+
+    // Threads:  Ttf
+    // Locks:  Mw
+    bool reusePreviousDecode(S32 discard);
+
+    // Threads:  Ttf
+    // Locks:  Mw
+    void keepDecode(S32 source_bytes);
+
     // Threads:  Ttf
     bool writeToCacheComplete();
 
@@ -530,6 +584,12 @@ private:
     LLPointer<LLImageFormatted> mFormattedImage;
     LLPointer<LLImageRaw>       mRawImage,
                                 mAuxImage;
+    // Last successful decode, kept across INIT so a later request
+    // can be served from it (see reusePreviousDecode())
+    LLPointer<LLImageRaw>       mPrevRawImage,
+                                mPrevAuxImage;
+    S32                         mPrevDecodedDiscard;
+    S32                         mPrevDecodedBytes;          // -1 if not decoded from mFormattedImage
     FTType mFTType;
     LLUUID mID;
     LLHost mHost;
@@ -564,6 +624,9 @@ private:
     e_request_state mSentRequest;
     handle_t mDecodeHandle;
     bool mLoaded;
+    bool mDecodedCacheChecked; // the decoded tier was looked at for this request
+    bool mDecodedCacheRead; // mCacheReadHandle reads from the decoded tier
+    S32 mDecodedCacheDiscard; // discard level of what that read returned, -1 if nothing
     bool mDecoded;
     bool mWritten;
     bool mNeedsAux;
@@ -600,6 +663,10 @@ private:
     U32                     mCacheReadCount,
                             mCacheWriteCount,
                             mResourceWaitCount;         // Requests entering WAIT_HTTP_RESOURCE2
+
+    // Position in LLTextureFetch's ready queues
+    S32                     mReadyQueue;                // Mfr, -1 when not queued
+    U32                     mReadyIndex;                // Mfr
 };
 
 //////////////////////////////////////////////////////////////////////////////
@@ -873,6 +940,8 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
       mRequestedDiscard(-1),
       mLoadedDiscard(-1),
       mDecodedDiscard(-1),
+      mPrevDecodedDiscard(-1),
+      mPrevDecodedBytes(-1),
       mCacheReadTime(0.f),
       mCacheWriteTime(0.f),
       mDecodeTime(0.f),
@@ -886,6 +955,9 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
       mSkippedStatesTime(0),
       mCachedSize(0),
       mLoaded(false),
+      mDecodedCacheChecked(false),
+      mDecodedCacheRead(false),
+      mDecodedCacheDiscard(-1),
       mSentRequest(UNSENT),
       mDecodeHandle(0),
       mDecoded(false),
@@ -912,7 +984,9 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
       mResourceWaitCount(0U),
       mFetchRetryPolicy(10.f,3600.f,2.f,10),
       mCanUseCapability(true),
-      mRegionRetryAttempt(0)
+      mRegionRetryAttempt(0),
+      mReadyQueue(-1),
+      mReadyIndex(0)
 {
     mType = host.isOk() ? LLImageBase::TYPE_AVATAR_BAKE : LLImageBase::TYPE_NORMAL;
 //  LL_INFOS(LOG_TXT) << "Create: " << mID << " mHost:" << host << " Discard=" << discard << LL_ENDL;
@@ -1115,6 +1189,9 @@ bool LLTextureFetchWorker::doWork(S32 param)
         mFileSize = 0;
         mCachedSize = 0;
         mLoaded = false;
+        mDecodedCacheChecked = false;
+        mDecodedCacheRead = false;
+        mDecodedCacheDiscard = -1;
         mSentRequest = UNSENT;
         mDecoded  = false;
         mWritten  = false;
@@ -1167,9 +1244,15 @@ bool LLTextureFetchWorker::doWork(S32 param)
             }
             else if ((mUrl.empty() || mFTType==FTT_SERVER_BAKE) && mFetcher->canLoadFromCache())
             {
+                mCacheReadTimer.reset();
+                if (!mDecodedCacheChecked && readFromDecodedCache())
+                {
+                    // Decoded in an earlier visit, the cache thread reads
+                    // that back and the J2C read and decode are skipped
+                    return false;
+                }
                 ++mCacheReadCount;
                 CacheReadResponder* responder = new CacheReadResponder(mFetcher, mID, mFormattedImage);
-                mCacheReadTimer.reset();
                 mCacheReadHandle = mFetcher->mTextureCache->readFromCache(mID,
                                                                           offset, size, responder);;
             }
@@ -1189,6 +1272,17 @@ bool LLTextureFetchWorker::doWork(S32 param)
             if (mFetcher->mTextureCache->readComplete(mCacheReadHandle, false))
             {
                 mCacheReadHandle = LLTextureCache::nullHandle();
+                if (mDecodedCacheRead)
+                {
+                    mDecodedCacheRead = false;
+                    mLoaded = false;
+                    if (useDecodedCacheRead())
+                    {
+                        setState(DONE);
+                    }
+                    // else read the J2C data as if the tier had not been looked at
+                    return doWork(param);
+                }
                 setState(CACHE_POST);
                 add(LLTextureFetch::sCacheHit, 1.0);
                 mCacheReadTime = mCacheReadTimer.getElapsedTimeF32();
@@ -1275,9 +1369,11 @@ bool LLTextureFetchWorker::doWork(S32 param)
         if ( use_http && mCanUseHTTP && mUrl.empty())//get http url.
         {
             LLViewerRegion* region = getRegion();
-            if (region)
+            // Trace replays run without a region, see LLTextureFetchReplay
+            std::string replay_url = region ? std::string() : mFetcher->getReplayAssetUrl();
+            if (region || !replay_url.empty())
             {
-                std::string http_url = region->getViewerAssetUrl();
+                std::string http_url = region ? region->getViewerAssetUrl() : replay_url;
                 if (!http_url.empty())
                 {
                     if (mFTType != FTT_DEFAULT)
@@ -1289,7 +1385,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
                     mWriteToCacheState = CAN_WRITE ; //because this texture has a fixed texture id.
                     mCanUseCapability = true;
                     mRegionRetryAttempt = 0;
-                    mLastRegionId = region->getRegionID();
+                    mLastRegionId = region ? region->getRegionID() : LLUUID::null;
                 }
                 else
                 {
@@ -1518,7 +1614,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
                     if (mCanUseHTTP && !mUrl.empty() && cur_size <= 0)
                     {
                         LLViewerRegion* region = getRegion();
-                        if (!region || mLastRegionId != region->getRegionID())
+                        if (region ? mLastRegionId != region->getRegionID() : mFetcher->getReplayAssetUrl().empty())
                         {
                             if (mFTType != FTT_MAP_TILE)
                             {
@@ -1544,7 +1640,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
                     if (mCanUseHTTP && !mUrl.empty() && cur_size <= 0)
                     {
                         LLViewerRegion* region = getRegion();
-                        if (!region || mLastRegionId != region->getRegionID())
+                        if (region ? mLastRegionId != region->getRegionID() : mFetcher->getReplayAssetUrl().empty())
                         {
                             // try on new region.
                             mUrl.clear();
@@ -1768,6 +1864,10 @@ bool LLTextureFetchWorker::doWork(S32 param)
         S32 discard = mHaveAllData && mFormattedImage->getCodec() != IMG_CODEC_J2C ? 0 : mLoadedDiscard;
         mDecoded  = false;
         setState(DECODE_IMAGE_UPDATE);
+        if (reusePreviousDecode(discard))
+        {
+            return doWork(param);
+        }
         LL_DEBUGS(LOG_TXT) << mID << ": Decoding. Bytes: " << mFormattedImage->getDataSize() << " Discard: " << discard
                            << " All Data: " << mHaveAllData << LL_ENDL;
 
@@ -1820,6 +1920,11 @@ bool LLTextureFetchWorker::doWork(S32 param)
                 llassert_always(mRawImage.notNull());
                 LL_DEBUGS(LOG_TXT) << mID << ": Decoded. Discard: " << mDecodedDiscard
                                    << " Raw Image: " << llformat("%dx%d",mRawImage->getWidth(),mRawImage->getHeight()) << LL_ENDL;
+                if (!mInLocalCache && (mFTType == FTT_DEFAULT || mFTType == FTT_SERVER_BAKE))
+                {
+                    mFetcher->mTextureCache->writeToDecodedCache(mID, mDecodedDiscard, mRawImage, mAuxImage);
+                }
+                keepDecode(mFormattedImage.notNull() ? mFormattedImage->getDataSize() : -1);
                 setState(WRITE_TO_CACHE);
             }
             // fall through
@@ -1965,6 +2070,7 @@ void LLTextureFetchWorker::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRe
             setGetStatus(status, reason);
             releaseHttpSemaphore();
             setState(LOAD_FROM_NETWORK);
+            wakeWork();
             return;
         }
         else
@@ -2026,6 +2132,8 @@ void LLTextureFetchWorker::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRe
     mFetcher->removeFromHTTPQueue(mID, data_size);
 
     recordTextureDone(true, data_size);
+
+    wakeWork();
 }                                                                       // -Mw
 
 
@@ -2127,6 +2235,36 @@ bool LLTextureFetchWorker::deleteOK()
     return delete_ok;
 }
 
+// Threads:  Ttf
+
+// virtual
+bool LLTextureFetchWorker::parkWork(S32 param)
+{
+    LLMutexLock lock(&mWorkMutex);                                      // +Mw
+
+    // Only park while the event that calls wakeWork() is still outstanding
+    switch (mState)
+    {
+    case LOAD_FROM_TEXTURE_CACHE:
+        // callbackCacheRead()
+        return !mLoaded && mCacheReadHandle != LLTextureCache::nullHandle();
+    case WAIT_HTTP_RESOURCE2:
+        // releaseHttpWaiters()
+        return mFetcher->isHttpWaiter(mID);
+    case WAIT_HTTP_REQ:
+        // onCompleted()
+        return !mLoaded && mHttpActive;
+    case DECODE_IMAGE_UPDATE:
+        // callbackDecoded()
+        return !mDecoded && mDecodeHandle != 0;
+    case WAIT_ON_WRITE:
+        // callbackCacheWrite()
+        return !mWritten && mCacheWriteHandle != LLTextureCache::nullHandle();
+    default:
+        return false;
+    }
+}                                                                       // -Mw
+
 // Threads:  Ttf
 void LLTextureFetchWorker::removeFromCache()
 {
@@ -2275,6 +2413,26 @@ void LLTextureFetchWorker::callbackCacheRead(bool success, LLImageFormatted* ima
         }
     }
     mLoaded = true;
+    wakeWork();
+}                                                                       // -Mw
+
+// Threads:  Ttc
+void LLTextureFetchWorker::callbackDecodedCacheRead(bool success, LLImageRaw* raw, LLImageRaw* aux, S32 discardlevel)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    LLMutexLock lock(&mWorkMutex);                                      // +Mw
+    if (mState != LOAD_FROM_TEXTURE_CACHE || !mDecodedCacheRead)
+    {
+        return;
+    }
+    if (success)
+    {
+        mRawImage = raw;
+        mAuxImage = aux;
+        mDecodedCacheDiscard = discardlevel;
+    }
+    mLoaded = true;
+    wakeWork();
 }                                                                       // -Mw
 
 // Threads:  Ttc
@@ -2287,6 +2445,7 @@ void LLTextureFetchWorker::callbackCacheWrite(bool success)
         return;
     }
     mWritten = true;
+    wakeWork();
 }                                                                       // -Mw
 
 //////////////////////////////////////////////////////////////////////////////
@@ -2336,11 +2495,140 @@ void LLTextureFetchWorker::callbackDecoded(bool success, const std::string &erro
         mDecodedDiscard = -1; // Redundant, here for clarity and paranoia
     }
     mDecoded = true;
+    wakeWork();
 //  LL_INFOS(LOG_TXT) << mID << " : DECODE COMPLETE " << LL_ENDL;
 }                                                                       // -Mw
 
 //////////////////////////////////////////////////////////////////////////////
 
+// Threads:  Ttf
+// Locks:  Mw
+bool LLTextureFetchWorker::readFromDecodedCache()
+{
+    mDecodedCacheChecked = true;
+    if (mFTType != FTT_DEFAULT && mFTType != FTT_SERVER_BAKE)
+    {
+        return false;
+    }
+
+    DecodedCacheReadResponder* responder = new DecodedCacheReadResponder(mFetcher, mID);
+    LLPointer<LLTextureCache::Responder> responder_ref(responder); // deleted here when nothing is read
+    mDecodedCacheDiscard = -1;
+    mCacheReadHandle = mFetcher->mTextureCache->readFromDecodedCache(mID, mDesiredDiscard, mNeedsAux, responder);
+    if (mCacheReadHandle == LLTextureCache::nullHandle())
+    {
+        return false;
+    }
+    mDecodedCacheRead = true;
+    return true;
+}
+
+// Threads:  Ttf
+// Locks:  Mw
+bool LLTextureFetchWorker::useDecodedCacheRead()
+{
+    if (mDecodedCacheDiscard < 0 || mRawImage.isNull())
+    {
+        mRawImage = NULL;
+        mAuxImage = NULL;
+        return false;
+    }
+
+    mLoadedDiscard = mDecodedCacheDiscard;
+    mDecodedDiscard = mDecodedCacheDiscard;
+    mDecoded = true;
+    mInCache = true;
+    keepDecode(-1);
+    mWriteToCacheState = NOT_WRITE;
+    mCacheReadTime = mCacheReadTimer.getElapsedTimeF32();
+    mDecodeTime = 0.f;
+    add(LLTextureFetch::sCacheHit, 1.0);
+    add(LLTextureFetch::sDecodedCacheHit, 1.0);
+    record(LLTextureFetch::sCacheHitRate, LLUnits::Ratio::fromValue(1));
+    LL_DEBUGS(LOG_TXT) << mID << ": Decoded cache hit. Discard: " << mDecodedDiscard
+                       << " Raw Image: " << llformat("%dx%d", mRawImage->getWidth(), mRawImage->getHeight()) << LL_ENDL;
+    return true;
+}
+
+// Serves a decode request from the previous decode of this worker when
+// that holds everything the request could produce:
+// * the same discard level from the same bytes (e.g. a retry or a
+//   re-request that brought no new data), or
+// * a coarser discard level, which is a box filtered copy of the finer
+//   one and costs a fraction of a JPEG2000 decode.
+// A finer level still needs the codec; OpenJPEG has no way to resume
+// from the coarser level's coefficients.
+//
+// Threads:  Ttf
+// Locks:  Mw
+bool LLTextureFetchWorker::reusePreviousDecode(S32 discard)
+{
+    if (mPrevRawImage.isNull() || discard < mPrevDecodedDiscard)
+    {
+        return false;
+    }
+    if (mNeedsAux && mPrevAuxImage.isNull())
+    {
+        return false;
+    }
+
+    S32 shift = discard - mPrevDecodedDiscard;
+    if (shift == 0)
+    {
+        if (mFormattedImage.isNull() || mFormattedImage->getDataSize() != mPrevDecodedBytes)
+        {
+            return false;
+        }
+        mRawImage = mPrevRawImage;
+        mAuxImage = NULL;
+        if (mNeedsAux)
+        {
+            mAuxImage = mPrevAuxImage;
+        }
+    }
+    else
+    {
+        // J2C levels round up, see ceildivpow2 in llimagej2coj
+        S32 round = (1 << shift) - 1;
+        S32 width = (mPrevRawImage->getWidth() + round) >> shift;
+        S32 height = (mPrevRawImage->getHeight() + round) >> shift;
+        mRawImage = mPrevRawImage->scaled(width, height);
+        mAuxImage = NULL;
+        if (mNeedsAux)
+        {
+            mAuxImage = mPrevAuxImage->scaled((mPrevAuxImage->getWidth() + round) >> shift,
+                                              (mPrevAuxImage->getHeight() + round) >> shift);
+        }
+        if (mRawImage.isNull() || (mNeedsAux && mAuxImage.isNull()))
+        {
+            mRawImage = NULL;
+            mAuxImage = NULL;
+            return false;
+        }
+    }
+
+    mDecodedDiscard = discard;
+    mDecoded = true;
+    LL_DEBUGS(LOG_TXT) << mID << ": Reused decode of discard " << mPrevDecodedDiscard
+                       << " for discard " << discard << LL_ENDL;
+    return true;
+}
+
+// Threads:  Ttf
+// Locks:  Mw
+void LLTextureFetchWorker::keepDecode(S32 source_bytes)
+{
+    // Only replace a finer decode when this one came from newer bytes
+    if (mPrevRawImage.notNull() && mDecodedDiscard > mPrevDecodedDiscard && source_bytes <= mPrevDecodedBytes)
+    {
+        return;
+    }
+    mPrevRawImage = mRawImage;
+    mPrevAuxImage = mAuxImage;
+    mPrevDecodedDiscard = mDecodedDiscard;
+    mPrevDecodedBytes = source_bytes;
+}
+
 // Threads:  Ttf
 bool LLTextureFetchWorker::writeToCacheComplete()
 {
@@ -2415,6 +2703,9 @@ LLTextureFetch::LLTextureFetch(LLTextureCache* cache, bool threaded, bool qa_mod
       mDebugPause(false),
       mQueueMutex(),
       mNetworkQueueMutex(),
+      mReadyMutex(),
+      mNextReadyQueue(0),
+      mReadySequence(0),
       mTextureCache(cache),
       mTextureBandwidth(0),
       mHTTPTextureBits(0),
@@ -2492,6 +2783,11 @@ S32 LLTextureFetch::createRequest(FTType f_type, const std::string& url, const L
         return CREATE_REQUEST_ERROR_DEFAULT;
     }
 
+    if (LLTextureFetchTrace::isRecording())
+    {
+        LLTextureFetchTrace::recordCreate(id, f_type, priority, w, h, c, desired_discard, needs_aux);
+    }
+
     if (f_type == FTT_SERVER_BAKE)
     {
         LL_DEBUGS("Avatar") << " requesting " << id << " " << w << "x" << h << " discard " << desired_discard << " type " << f_type << LL_ENDL;
@@ -2632,6 +2928,10 @@ void LLTextureFetch::removeFromHTTPQueue(const LLUUID& id, S32Bytes received_siz
 void LLTextureFetch::deleteRequest(const LLUUID& id, bool cancel)
 {
     LL_PROFILE_ZONE_SCOPED;
+    if (LLTextureFetchTrace::isRecording())
+    {
+        LLTextureFetchTrace::recordDelete(id, cancel);
+    }
     lockQueue();                                                        // +Mfq
     LLTextureFetchWorker* worker = getWorkerAfterLock(id);
     if (worker)
@@ -2844,6 +3144,10 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level, S3
 bool LLTextureFetch::updateRequestPriority(const LLUUID& id, F32 priority)
 {
     LL_PROFILE_ZONE_SCOPED;
+    if (LLTextureFetchTrace::isRecording())
+    {
+        LLTextureFetchTrace::recordPriority(id, priority);
+    }
     mRequestQueue.tryPost([=, this]()
         {
             LLTextureFetchWorker* worker = getWorker(id);
@@ -2852,12 +3156,29 @@ bool LLTextureFetch::updateRequestPriority(const LLUUID& id, F32 priority)
                 worker->lockWorkMutex();                                        // +Mw
                 worker->setImagePriority(priority);
                 worker->unlockWorkMutex();                                      // -Mw
-            }
+
+                LLMutexLock lock(&mReadyMutex);                                 // +Mfr
+                updateReadyPriority(worker, priority);
+            }                                                                   // -Mfr
         });
 
     return true;
 }
 
+// Threads:  T*
+void LLTextureFetch::setReplayAssetUrl(const std::string& url)
+{
+    LLMutexLock lock(&mQueueMutex);                                     // +Mfq
+    mReplayAssetUrl = url;
+}                                                                       // -Mfq
+
+// Threads:  T*
+std::string LLTextureFetch::getReplayAssetUrl()
+{
+    LLMutexLock lock(&mQueueMutex);                                     // +Mfq
+    return mReplayAssetUrl;
+}                                                                       // -Mfq
+
 // Replicates and expands upon the base class's
 // getPending() implementation.  getPending() and
 // runCondition() replicate one another's logic to
@@ -3359,6 +3680,7 @@ void LLTextureFetch::releaseHttpWaiters()
         }
 
         worker->setState(LLTextureFetchWorker::SEND_HTTP_REQ);
+        worker->wakeWork();
         worker->unlockWorkMutex();                                      // -Mw
 
         removeHttpWaiter(worker->mID);
@@ -3382,6 +3704,177 @@ int LLTextureFetch::getHttpWaitersCount()
     return ret;
 }
 
+// Threads:  T*
+
+// virtual
+void LLTextureFetch::scheduleRequest(QueuedRequest* req)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    LLTextureFetchWorker* worker = static_cast<LLTextureFetchWorker*>(static_cast<WorkRequest*>(req)->getWorkerClass());
+    {
+        LLMutexLock lock(&mReadyMutex);                                 // +Mfr
+        pushReady(worker, req);
+    }                                                                   // -Mfr
+
+    // One dispatch per queued request, it runs whichever is best by then
+    mRequestQueue.post([this]() { processNextReady(); });
+}
+
+// Threads:  Ttf
+void LLTextureFetch::processNextReady()
+{
+    LL_PROFILE_ZONE_SCOPED;
+    QueuedRequest* req = NULL;
+    {
+        LLMutexLock lock(&mReadyMutex);                                 // +Mfr
+        for (U32 i = 0; i < READY_QUEUE_COUNT; ++i)
+        {
+            U32 queue = (mNextReadyQueue + i) % READY_QUEUE_COUNT;
+            if (!mReadyQueues[queue].empty())
+            {
+                req = popReady(queue);
+                mNextReadyQueue = (queue + 1) % READY_QUEUE_COUNT;
+                break;
+            }
+        }
+    }                                                                   // -Mfr
+
+    if (req)
+    {
+        processRequest(req);
+    }
+}
+
+// Locks:  Mfr
+void LLTextureFetch::pushReady(LLTextureFetchWorker* worker, QueuedRequest* req)
+{
+    llassert(worker->mReadyQueue < 0);
+
+    // The state is read without Mw, a stale value only picks the queue
+    U32 queue;
+    switch (worker->mState)
+    {
+    case LLTextureFetchWorker::LOAD_FROM_NETWORK:
+    case LLTextureFetchWorker::WAIT_HTTP_RESOURCE:
+    case LLTextureFetchWorker::WAIT_HTTP_RESOURCE2:
+    case LLTextureFetchWorker::SEND_HTTP_REQ:
+    case LLTextureFetchWorker::WAIT_HTTP_REQ:
+        queue = READY_HTTP;
+        break;
+    case LLTextureFetchWorker::DECODE_IMAGE:
+    case LLTextureFetchWorker::DECODE_IMAGE_UPDATE:
+        queue = READY_DECODE;
+        break;
+    case LLTextureFetchWorker::WRITE_TO_CACHE:
+    case LLTextureFetchWorker::WAIT_ON_WRITE:
+    case LLTextureFetchWorker::DONE:
+        queue = READY_CACHE_WRITE;
+        break;
+    default:
+        queue = READY_CACHE_READ;
+        break;
+    }
+
+    ready_queue_t& heap = mReadyQueues[queue];
+    ReadyEntry entry;
+    entry.mPriority = worker->getImagePriority();
+    entry.mSequence = mReadySequence++;
+    entry.mWorker = worker;
+    entry.mRequest = req;
+    heap.push_back(entry);
+    worker->mReadyQueue = queue;
+    worker->mReadyIndex = (U32)heap.size() - 1;
+    moveReady(queue, worker->mReadyIndex);
+}
+
+// Locks:  Mfr
+LLQueuedThread::QueuedRequest* LLTextureFetch::popReady(U32 queue)
+{
+    ready_queue_t& heap = mReadyQueues[queue];
+    llassert(!heap.empty());
+    ReadyEntry top = heap.front();
+    top.mWorker->mReadyQueue = -1;
+
+    if (heap.size() > 1)
+    {
+        heap.front() = heap.back();
+        heap.front().mWorker->mReadyIndex = 0;
+        heap.pop_back();
+        moveReady(queue, 0);
+    }
+    else
+    {
+        heap.pop_back();
+    }
+    return top.mRequest;
+}
+
+// Locks:  Mfr
+void LLTextureFetch::updateReadyPriority(LLTextureFetchWorker* worker, F32 priority)
+{
+    if (worker->mReadyQueue < 0)
+    {
+        // Running or parked, the new priority is picked up when it's queued again
+        return;
+    }
+    mReadyQueues[worker->mReadyQueue][worker->mReadyIndex].mPriority = priority;
+    moveReady(worker->mReadyQueue, worker->mReadyIndex);
+}
+
+// Restores the heap order around an entry whose priority changed, or that
+// was just placed, by sifting it up or down as needed.
+//
+// Locks:  Mfr
+void LLTextureFetch::moveReady(U32 queue, U32 index)
+{
+    ready_queue_t& heap = mReadyQueues[queue];
+    auto before = [](const ReadyEntry& lhs, const ReadyEntry& rhs)
+    {
+        return lhs.mPriority > rhs.mPriority
+            || (lhs.mPriority == rhs.mPriority && lhs.mSequence < rhs.mSequence);
+    };
+
+    ReadyEntry entry = heap[index];
+    U32 size = (U32)heap.size();
+
+    // Up
+    while (index > 0)
+    {
+        U32 parent = (index - 1) / 2;
+        if (!before(entry, heap[parent]))
+        {
+            break;
+        }
+        heap[index] = heap[parent];
+        heap[index].mWorker->mReadyIndex = index;
+        index = parent;
+    }
+
+    // Down
+    while (true)
+    {
+        U32 child = index * 2 + 1;
+        if (child >= size)
+        {
+            break;
+        }
+        if (child + 1 < size && before(heap[child + 1], heap[child]))
+        {
+            ++child;
+        }
+        if (!before(heap[child], entry))
+        {
+            break;
+        }
+        heap[index] = heap[child];
+        heap[index].mWorker->mReadyIndex = index;
+        index = child;
+    }
+
+    heap[index] = entry;
+    entry.mWorker->mReadyIndex = index;
+}
+
 
 // Threads:  T*
 void LLTextureFetch::updateStateStats(U32 cache_read, U32 cache_write, U32 res_wait)
@@ -110,6 +110,14 @@ public:
     // Threads:  T*
     bool updateRequestPriority(const LLUUID& id, F32 priority);
 
+    // Fetch by UUID from this server when there is no region, for trace
+    // replays (see LLTextureFetchReplay). Empty when no replay is running.
+    // Threads:  T*
+    void setReplayAssetUrl(const std::string& url);
+
+    // Threads:  T*
+    std::string getReplayAssetUrl();
+
     // Threads:  T* (but not safe)
     void setTextureBandwidth(F32 bandwidth) { mTextureBandwidth = bandwidth; }
 
@@ -269,6 +277,23 @@ private:
     // Threads:  Ttf
     void commonUpdate();
 
+    // Puts a worker's request on the ready queue for its stage and posts
+    // one processNextReady() for it.
+    // Threads:  T*
+    // Locks:  -Mfr
+    /*virtual*/ void scheduleRequest(QueuedRequest* req);
+
+    // Runs the highest priority request of the next non-empty ready queue.
+    // Threads:  Ttf
+    void processNextReady();
+
+    // Ready queue helpers
+    // Locks:  Mfr
+    void pushReady(LLTextureFetchWorker* worker, QueuedRequest* req);
+    QueuedRequest* popReady(U32 queue);
+    void updateReadyPriority(LLTextureFetchWorker* worker, F32 priority);
+    void moveReady(U32 queue, U32 index);
+
     // Metrics command helpers
     /**
      * Enqueues a command request at the end of the command queue
@@ -312,6 +337,7 @@ public:
 
     static LLTrace::CountStatHandle<F64>        sCacheHit;
     static LLTrace::CountStatHandle<F64>        sCacheAttempt;
+    static LLTrace::CountStatHandle<F64>        sDecodedCacheHit;
     static LLTrace::SampleStatHandle<F32Seconds> sCacheReadLatency;
     static LLTrace::SampleStatHandle<F32Seconds> sTexDecodeLatency;
     static LLTrace::SampleStatHandle<F32Seconds> sCacheWriteLatency;
@@ -321,6 +347,31 @@ public:
 private:
     LLMutex mQueueMutex;        //to protect mRequestMap and mCommands only
     LLMutex mNetworkQueueMutex; //to protect mHTTPTextureQueue
+    LLMutex mReadyMutex;        //to protect the ready queues
+
+    // Requests that can make progress, one queue per stage so a burst of
+    // cache hits can't starve decodes and vice versa.  Each queue is a
+    // binary heap ordered by worker priority; workers keep their index so
+    // a priority change can move them in place.
+    enum e_ready_queue
+    {
+        READY_CACHE_READ = 0,
+        READY_HTTP,
+        READY_DECODE,
+        READY_CACHE_WRITE,
+        READY_QUEUE_COUNT
+    };
+    struct ReadyEntry
+    {
+        F32 mPriority;
+        U64 mSequence;      // FIFO among equal priorities
+        LLTextureFetchWorker* mWorker;
+        QueuedRequest* mRequest;
+    };
+    typedef std::vector<ReadyEntry> ready_queue_t;
+    ready_queue_t mReadyQueues[READY_QUEUE_COUNT];                      // Mfr
+    U32 mNextReadyQueue;                                                // Mfr
+    U64 mReadySequence;                                                 // Mfr
 
     LLTextureCache* mTextureCache;
 
@@ -334,6 +385,7 @@ private:
     typedef std::map<LLHost,std::set<LLUUID> > cancel_queue_t;
     F32 mTextureBandwidth;                                              // <none>
     F32 mMaxBandwidth;                                                  // Mfnq
+    std::string mReplayAssetUrl;                                        // Mfq
     LLTextureInfo mTextureInfo;
     LLTextureInfo mTextureInfoMainThread;
 
@@ -0,0 +1,468 @@
+/**
+ * @file lltexturefetchtrace.cpp
+ * @brief Recording and headless replay of texture fetch requests
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexturefetchtrace.h"
+
+#include "llappviewer.h"
+#include "lldir.h"
+#include "llfile.h"
+#include "llimageworker.h"
+#include "llsdserialize.h"
+#include "lltexturecache.h"
+#include "lltexturefetch.h"
+#include "llviewercontrol.h"
+#include "llviewertexture.h"
+
+#include <algorithm>
+#include <limits>
+
+// Requests still outstanding this long after the last call of the trace
+// was replayed are counted as timed out.
+static const F64 REPLAY_TIMEOUT = 60.0;
+
+static const std::string TRACE_FILENAME("texture_fetch_trace.txt");
+static const std::string REPLAY_RESULTS_FILENAME("texture_fetch_replay.xml");
+
+std::atomic<bool> LLTextureFetchTrace::sRecording(false);
+
+namespace
+{
+    // Recording state, guarded by sTraceMutex
+    LLMutex sTraceMutex;
+    LLFILE* sTraceFile = NULL;
+    LLTimer sTraceTimer;
+
+    std::unique_ptr<LLTextureFetchReplay> sReplay;
+}
+
+//static
+void LLTextureFetchTrace::initClass()
+{
+    if (gSavedSettings.getBOOL("TextureFetchTraceRecord"))
+    {
+        std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, TRACE_FILENAME);
+        LLMutexLock lock(&sTraceMutex);
+        sTraceFile = LLFile::fopen(filename, "w");
+        if (sTraceFile)
+        {
+            LL_INFOS("TextureFetchTrace") << "Recording texture fetch requests to " << filename << LL_ENDL;
+            sTraceTimer.reset();
+            sRecording = true;
+        }
+        else
+        {
+            LL_WARNS("TextureFetchTrace") << "Unable to open " << filename << LL_ENDL;
+        }
+    }
+
+    std::string replay_filename = gSavedSettings.getString("TextureFetchReplayFile");
+    if (!replay_filename.empty())
+    {
+        std::string url = gSavedSettings.getString("TextureFetchReplayURL");
+        sReplay = std::make_unique<LLTextureFetchReplay>(gSavedSettings.getF32("TextureFetchReplaySpeed"),
+                                                         gSavedSettings.getBOOL("TextureFetchReplayQuit"));
+        if (sReplay->load(replay_filename))
+        {
+            LL_INFOS("TextureFetchTrace") << "Replaying " << replay_filename << " from " << url << LL_ENDL;
+            LLAppViewer::getTextureFetch()->setReplayAssetUrl(url);
+            sReplay->start();
+        }
+        else
+        {
+            sReplay.reset();
+        }
+    }
+}
+
+//static
+void LLTextureFetchTrace::cleanupClass()
+{
+    sReplay.reset();
+
+    LLMutexLock lock(&sTraceMutex);
+    sRecording = false;
+    if (sTraceFile)
+    {
+        LLFile::close(sTraceFile);
+        sTraceFile = NULL;
+    }
+}
+
+//static
+void LLTextureFetchTrace::record(const std::string& line)
+{
+    LLMutexLock lock(&sTraceMutex);
+    if (sTraceFile)
+    {
+        fprintf(sTraceFile, "%.4f %s\n", sTraceTimer.getElapsedTimeF64().value(), line.c_str());
+    }
+}
+
+//static
+void LLTextureFetchTrace::recordCreate(const LLUUID& id, S32 f_type, F32 priority, S32 w, S32 h, S32 c, S32 discard, bool needs_aux)
+{
+    record(llformat("C %s %d %.2f %d %d %d %d %d", id.asString().c_str(), f_type, priority, w, h, c, discard, (S32)needs_aux));
+}
+
+//static
+void LLTextureFetchTrace::recordPriority(const LLUUID& id, F32 priority)
+{
+    record(llformat("P %s %.2f", id.asString().c_str(), priority));
+}
+
+//static
+void LLTextureFetchTrace::recordDelete(const LLUUID& id, bool cancel)
+{
+    record(llformat("D %s %d", id.asString().c_str(), (S32)cancel));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+LLTextureFetchReplay::LLTextureFetchReplay(F32 speed, bool quit_when_done)
+    : mNextRecord(0),
+      mSpeed(speed),
+      mQuitWhenDone(quit_when_done),
+      mDone(false),
+      mLastRecordTime(0.0),
+      mRequests(0),
+      mCompleted(0),
+      mFailed(0),
+      mTimedOut(0),
+      mRawBytes(0),
+      mQueueSamples(0)
+{
+}
+
+LLTextureFetchReplay::~LLTextureFetchReplay()
+{
+    mConnection.disconnect();
+}
+
+bool LLTextureFetchReplay::load(const std::string& filename)
+{
+    llifstream file(filename.c_str());
+    if (!file.is_open())
+    {
+        LL_WARNS("TextureFetchTrace") << "Unable to open texture fetch trace " << filename << LL_ENDL;
+        return false;
+    }
+
+    std::string line;
+    S32 line_number = 0;
+    while (std::getline(file, line))
+    {
+        ++line_number;
+        Record record;
+        char id[UUID_STR_LENGTH] = { 0 };
+        S32 flag = 0;
+        S32 fields = sscanf(line.c_str(), "%lf %c %36s", &record.mTime, &record.mOp, id);
+        if (fields != 3 || !LLUUID::validate(id))
+        {
+            LL_WARNS("TextureFetchTrace") << "Skipping malformed line " << line_number << LL_ENDL;
+            continue;
+        }
+        record.mID.set(id);
+        record.mType = FTT_DEFAULT;
+        record.mPriority = 0.f;
+        record.mWidth = record.mHeight = record.mComponents = 0;
+        record.mDiscard = 0;
+        record.mNeedsAux = false;
+        record.mCancel = false;
+
+        const char* args = line.c_str();
+        // Skip the time, op and id
+        for (S32 i = 0; i < 3 && args; ++i)
+        {
+            args = strchr(args, ' ');
+            args = args ? args + 1 : NULL;
+        }
+
+        bool valid = false;
+        switch (record.mOp)
+        {
+        case 'C':
+            valid = args && sscanf(args, "%d %f %d %d %d %d %d", &record.mType, &record.mPriority, &record.mWidth,
+                                   &record.mHeight, &record.mComponents, &record.mDiscard, &flag) == 7;
+            break;
+        case 'P':
+            valid = args && sscanf(args, "%f", &record.mPriority) == 1;
+            break;
+        case 'D':
+            valid = args && sscanf(args, "%d", &flag) == 1;
+            break;
+        default:
+            break;
+        }
+        if (!valid)
+        {
+            LL_WARNS("TextureFetchTrace") << "Skipping malformed line " << line_number << LL_ENDL;
+            continue;
+        }
+        if (record.mOp == 'D')
+        {
+            record.mCancel = flag != 0;
+        }
+        else
+        {
+            record.mNeedsAux = flag != 0;
+        }
+        mRecords.push_back(record);
+    }
+
+    // Traces are written in time order but several threads may record
+    std::stable_sort(mRecords.begin(), mRecords.end(),
+                     [](const Record& a, const Record& b) { return a.mTime < b.mTime; });
+
+    LL_INFOS("TextureFetchTrace") << "Loaded " << mRecords.size() << " texture fetch calls from " << filename << LL_ENDL;
+    return !mRecords.empty();
+}
+
+void LLTextureFetchReplay::start()
+{
+    mRecording.start();
+    mTimer.reset();
+    mConnection = LLEventPumps::instance().obtain("mainloop")
+        .listen("LLTextureFetchReplay", boost::bind(&LLTextureFetchReplay::tick, this, _1));
+}
+
+// called once per frame by the "mainloop" LLEventPump
+bool LLTextureFetchReplay::tick(const LLSD&)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    if (mDone)
+    {
+        return false;
+    }
+
+    F64 now = mTimer.getElapsedTimeF64();
+    F64 trace_time = mSpeed > 0.f ? now * mSpeed : std::numeric_limits<F64>::max();
+    if (mNextRecord < mRecords.size())
+    {
+        while (mNextRecord < mRecords.size() && mRecords[mNextRecord].mTime <= trace_time)
+        {
+            issue(mRecords[mNextRecord++]);
+        }
+        mLastRecordTime = now;
+    }
+
+    pollRequests();
+    sampleQueues();
+
+    if (mNextRecord >= mRecords.size())
+    {
+        if (!mPending.empty() && now - mLastRecordTime > REPLAY_TIMEOUT)
+        {
+            LLTextureFetch* fetcher = LLAppViewer::getTextureFetch();
+            for (const auto& pending : mPending)
+            {
+                fetcher->deleteRequest(pending.first, true);
+            }
+            mTimedOut = (U32)mPending.size();
+            mPending.clear();
+        }
+        if (mPending.empty())
+        {
+            finish();
+        }
+    }
+    return false;
+}
+
+void LLTextureFetchReplay::issue(const Record& record)
+{
+    LLTextureFetch* fetcher = LLAppViewer::getTextureFetch();
+    switch (record.mOp)
+    {
+    case 'C':
+    {
+        if (record.mType == FTT_MAP_TILE || record.mType == FTT_LOCAL_FILE)
+        {
+            // Not fetched by id, nothing to get them from
+            break;
+        }
+        // Baked textures are fetched by id from the stand-in server too
+        S32 discard = fetcher->createRequest(FTT_DEFAULT, LLStringUtil::null, record.mID, LLHost(), record.mPriority,
+                                             record.mWidth, record.mHeight, record.mComponents, record.mDiscard,
+                                             record.mNeedsAux, true);
+        if (discard >= 0 && mPending.emplace(record.mID, mTimer.getElapsedTimeF64()).second)
+        {
+            ++mRequests;
+        }
+        break;
+    }
+    case 'P':
+        if (mPending.find(record.mID) != mPending.end())
+        {
+            fetcher->updateRequestPriority(record.mID, record.mPriority);
+        }
+        break;
+    case 'D':
+        if (mPending.erase(record.mID))
+        {
+            fetcher->deleteRequest(record.mID, record.mCancel);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// Same as LLViewerFetchedTexture: a finished request hands its raw image
+// over and is deleted.
+void LLTextureFetchReplay::pollRequests()
+{
+    LLTextureFetch* fetcher = LLAppViewer::getTextureFetch();
+    F64 now = mTimer.getElapsedTimeF64();
+    for (auto iter = mPending.begin(); iter != mPending.end(); )
+    {
+        S32 discard = -1;
+        S32 state = 0;
+        LLPointer<LLImageRaw> raw;
+        LLPointer<LLImageRaw> aux;
+        LLCore::HttpStatus status;
+        if (!fetcher->getRequestFinished(iter->first, discard, state, raw, aux, status))
+        {
+            ++iter;
+            continue;
+        }
+
+        if (raw.notNull() && discard >= 0)
+        {
+            ++mCompleted;
+            mRawBytes += raw->getDataSize();
+            mLatencies.push_back((F32)(now - iter->second));
+        }
+        else
+        {
+            ++mFailed;
+        }
+        fetcher->deleteRequest(iter->first, true);
+        iter = mPending.erase(iter);
+    }
+}
+
+void LLTextureFetchReplay::sampleQueues()
+{
+    LLTextureFetch* fetcher = LLAppViewer::getTextureFetch();
+    LLTextureCache* cache = LLAppViewer::getTextureCache();
+    ++mQueueSamples;
+    mFetchQueue.sample(fetcher->getNumRequests());
+    mHTTPQueue.sample(fetcher->getNumHTTPRequests());
+    mCacheReadQueue.sample(cache->getNumReads());
+    mCacheWriteQueue.sample(cache->getNumWrites());
+    mDecodeQueue.sample(LLAppViewer::getImageDecodeThread()->getPending());
+}
+
+LLSD LLTextureFetchReplay::QueueDepth::asLLSD(U32 samples) const
+{
+    LLSD sd;
+    sd["mean"] = samples ? (F64)mSum / samples : 0.0;
+    sd["max"] = (LLSD::Integer)mMax;
+    return sd;
+}
+
+void LLTextureFetchReplay::finish()
+{
+    mDone = true;
+    mRecording.stop();
+    mConnection.disconnect();
+    // requests without a region go back to failing without one
+    LLAppViewer::getTextureFetch()->setReplayAssetUrl(LLStringUtil::null);
+
+    F64 duration = mTimer.getElapsedTimeF64();
+    std::sort(mLatencies.begin(), mLatencies.end());
+    auto percentile = [this](F32 p)
+    {
+        return mLatencies.empty() ? 0.f : mLatencies[llmin((size_t)(p * mLatencies.size()), mLatencies.size() - 1)];
+    };
+    F64 latency_sum = 0.0;
+    for (F32 latency : mLatencies)
+    {
+        latency_sum += latency;
+    }
+
+    LLSD results;
+    results["duration"] = duration;
+    results["requests"] = (LLSD::Integer)mRequests;
+    results["completed"] = (LLSD::Integer)mCompleted;
+    results["failed"] = (LLSD::Integer)mFailed;
+    results["timed_out"] = (LLSD::Integer)mTimedOut;
+    results["textures_per_second"] = duration > 0.0 ? mCompleted / duration : 0.0;
+    results["raw_mb_per_second"] = duration > 0.0 ? mRawBytes / (1024.0 * 1024.0) / duration : 0.0;
+
+    LLSD& latency = results["request_latency"];
+    latency["mean"] = mLatencies.empty() ? 0.0 : latency_sum / mLatencies.size();
+    latency["p50"] = percentile(0.5f);
+    latency["p95"] = percentile(0.95f);
+    latency["max"] = mLatencies.empty() ? 0.f : mLatencies.back();
+
+    auto stage = [this](LLTrace::SampleStatHandle<F32Seconds>& stat)
+    {
+        LLSD sd;
+        sd["mean"] = (F64)mRecording.getMean(stat).value();
+        sd["max"] = (F64)mRecording.getMax(stat).value();
+        sd["samples"] = mRecording.getSampleCount(stat);
+        return sd;
+    };
+    LLSD& stages = results["stage_latency"];
+    stages["cache_read"] = stage(LLTextureFetch::sCacheReadLatency);
+    stages["decode"] = stage(LLTextureFetch::sTexDecodeLatency);
+    stages["cache_write"] = stage(LLTextureFetch::sCacheWriteLatency);
+    stages["fetch"] = stage(LLTextureFetch::sTexFetchLatency);
+    results["cache_hits"] = mRecording.getSum(LLTextureFetch::sCacheHit);
+    results["decoded_cache_hits"] = mRecording.getSum(LLTextureFetch::sDecodedCacheHit);
+
+    LLSD& queues = results["queue_depth"];
+    queues["fetch"] = mFetchQueue.asLLSD(mQueueSamples);
+    queues["http"] = mHTTPQueue.asLLSD(mQueueSamples);
+    queues["cache_read"] = mCacheReadQueue.asLLSD(mQueueSamples);
+    queues["cache_write"] = mCacheWriteQueue.asLLSD(mQueueSamples);
+    queues["decode"] = mDecodeQueue.asLLSD(mQueueSamples);
+
+    LL_INFOS("TextureFetchTrace") << "Replay done in " << duration << "s: " << mCompleted << "/" << mRequests
+                                  << " textures (" << mFailed << " failed, " << mTimedOut << " timed out), "
+                                  << results["textures_per_second"].asReal() << " textures/s, latency p50 "
+                                  << latency["p50"].asReal() << "s p95 " << latency["p95"].asReal() << "s" << LL_ENDL;
+
+    std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, REPLAY_RESULTS_FILENAME);
+    llofstream file(filename.c_str());
+    if (file.is_open())
+    {
+        LLSDSerialize::toPrettyXML(results, file);
+        LL_INFOS("TextureFetchTrace") << "Replay results written to " << filename << LL_ENDL;
+    }
+    else
+    {
+        LL_WARNS("TextureFetchTrace") << "Unable to write " << filename << LL_ENDL;
+    }
+
+    if (mQuitWhenDone)
+    {
+        LLAppViewer::instance()->forceQuit();
+    }
+}
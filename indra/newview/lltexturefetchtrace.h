@@ -0,0 +1,162 @@
+/**
+ * @file lltexturefetchtrace.h
+ * @brief Recording and headless replay of texture fetch requests
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTUREFETCHTRACE_H
+#define LL_LLTEXTUREFETCHTRACE_H
+
+#include "llevents.h"
+#include "lltimer.h"
+#include "lltracerecording.h"
+#include "lluuid.h"
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLTextureFetchTrace
+//
+// Records the createRequest(), updateRequestPriority() and deleteRequest()
+// calls made to LLTextureFetch during a session (TextureFetchTraceRecord)
+// to texture_fetch_trace.txt in the logs folder, one call per line:
+//
+//   <seconds> C <id> <type> <priority> <width> <height> <components> <discard> <needs aux>
+//   <seconds> P <id> <priority>
+//   <seconds> D <id> <cancel>
+//
+// Such a trace can then be replayed (TextureFetchReplayFile) before login,
+// see LLTextureFetchReplay.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLTextureFetchTrace
+{
+public:
+    // Starts recording and/or replaying as the settings ask, called once
+    // the texture fetcher and the caches are up.
+    static void initClass();
+    static void cleanupClass();
+
+    static bool isRecording() { return sRecording; }
+
+    // Thread safe, to be called only if isRecording()
+    static void recordCreate(const LLUUID& id, S32 f_type, F32 priority, S32 w, S32 h, S32 c, S32 discard, bool needs_aux);
+    static void recordPriority(const LLUUID& id, F32 priority);
+    static void recordDelete(const LLUUID& id, bool cancel);
+
+private:
+    static void record(const std::string& line);
+
+    static std::atomic<bool> sRecording;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLTextureFetchReplay
+//
+// Plays a recorded trace back against the real texture fetcher, texture
+// cache, decode thread and HTTP stack. There is no region before login so
+// the fetcher gets the textures from TextureFetchReplayURL, typically a
+// stand-in server (see scripts/perf/texture_server.py) serving a folder of
+// J2C files. Runs with HeadlessClient set, so without rendering.
+//
+// Finished requests are polled every frame the way LLViewerFetchedTexture
+// does. Once the trace is played and every request finished (or timed out)
+// the throughput, request latencies, the fetcher's per-stage latency stats
+// and the queue depths are logged and written to texture_fetch_replay.xml
+// in the logs folder.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLTextureFetchReplay
+{
+public:
+    // speed scales the trace's clock, 0 issues every call at once
+    LLTextureFetchReplay(F32 speed, bool quit_when_done);
+    ~LLTextureFetchReplay();
+
+    bool load(const std::string& filename);
+    void start();
+    bool isDone() const { return mDone; }
+
+private:
+    struct Record
+    {
+        F64 mTime;
+        char mOp; // 'C'reate, 'P'riority or 'D'elete
+        LLUUID mID;
+        S32 mType;
+        F32 mPriority;
+        S32 mWidth;
+        S32 mHeight;
+        S32 mComponents;
+        S32 mDiscard;
+        bool mNeedsAux;
+        bool mCancel;   // for 'D'
+    };
+
+    struct QueueDepth
+    {
+        QueueDepth() : mSum(0), mMax(0) {}
+        void sample(size_t depth) { mSum += depth; mMax = llmax(mMax, depth); }
+        LLSD asLLSD(U32 samples) const;
+
+        U64 mSum;
+        size_t mMax;
+    };
+
+    bool tick(const LLSD&);
+    void issue(const Record& record);
+    void pollRequests();
+    void sampleQueues();
+    void finish();
+
+    std::vector<Record> mRecords;
+    size_t mNextRecord;
+    F32 mSpeed;
+    bool mQuitWhenDone;
+    bool mDone;
+
+    // Outstanding requests and the time they were created at
+    std::unordered_map<LLUUID, F64> mPending;
+
+    LLTimer mTimer;
+    F64 mLastRecordTime;
+    LLTrace::Recording mRecording;
+    LLTempBoundListener mConnection;
+
+    U32 mRequests;
+    U32 mCompleted;
+    U32 mFailed;
+    U32 mTimedOut;
+    U64 mRawBytes;
+    std::vector<F32> mLatencies;
+
+    U32 mQueueSamples;
+    QueueDepth mFetchQueue;
+    QueueDepth mHTTPQueue;
+    QueueDepth mCacheReadQueue;
+    QueueDepth mCacheWriteQueue;
+    QueueDepth mDecodeQueue;
+};
+
+#endif // LL_LLTEXTUREFETCHTRACE_H
@@ -161,7 +161,7 @@ void LLVisualParamHint::preRender(bool clear_depth)
     gAgentAvatarp->updateComposites();
     // Calling LLCharacter version, as we don't want position/height changes to cause the avatar to jump
     // up and down when we're doing preview renders. -Nyx
-    gAgentAvatarp->LLCharacter::updateVisualParams();
+    gAgentAvatarp->LLAvatarAppearance::updateVisualParams();
 
     if (gAgentAvatarp->mDrawable.notNull())
     {
@@ -93,6 +93,7 @@
 #include "llhudmanager.h"
 #include "llimview.h"
 #include "llinventorybridge.h"
+#include "llinventorycacheloader.h"
 #include "llinventorydefines.h"
 #include "llinventoryfunctions.h"
 #include "llpanellogin.h"
@@ -1936,6 +1937,19 @@ class LLAdvancedForceParamsToDefault : public view_listener_t
 };
 
 
+class LLAdvancedBenchmarkAppearanceMorphs : public view_listener_t
+{
+    bool handleEvent(const LLSD& userdata)
+    {
+        if (isAgentAvatarValid())
+        {
+            gAgentAvatarp->benchmarkMorphs(gSavedSettings.getS32("AppearanceMorphBenchmarkRounds"));
+        }
+        return true;
+    }
+};
+
+
 //////////////////////////
 //   ANIMATION SPEED    //
 //////////////////////////
@@ -2286,6 +2300,23 @@ class LLAdvancedPurgeDiskCache : public view_listener_t
 };
 
 
+///////////////////////////////
+// BENCHMARK INVENTORY CACHE //
+///////////////////////////////
+
+
+class LLAdvancedBenchmarkInventoryCache : public view_listener_t
+{
+    bool handleEvent(const LLSD& userdata)
+    {
+        // Runs on the main thread, the loaders fan out to the
+        // "General" pool just like they do at login
+        inventory_cache_benchmark(gSavedSettings.getS32("InventoryCacheBenchmarkItems"));
+        return true;
+    }
+};
+
+
 ////////////////////////
 // PURGE SHADER CACHE //
 ////////////////////////
@@ -9971,6 +10002,7 @@ void initialize_menus()
 
     // Advanced > Character (toplevel)
     view_listener_t::addMenu(new LLAdvancedForceParamsToDefault(), "Advanced.ForceParamsToDefault");
+    view_listener_t::addMenu(new LLAdvancedBenchmarkAppearanceMorphs(), "Advanced.BenchmarkAppearanceMorphs");
     view_listener_t::addMenu(new LLAdvancedReloadVertexShader(), "Advanced.ReloadVertexShader");
     view_listener_t::addMenu(new LLAdvancedToggleAnimationInfo(), "Advanced.ToggleAnimationInfo");
     view_listener_t::addMenu(new LLAdvancedCheckAnimationInfo(), "Advanced.CheckAnimationInfo");
@@ -9998,6 +10030,7 @@ void initialize_menus()
 
     // Advanced > Cache
     view_listener_t::addMenu(new LLAdvancedPurgeDiskCache(), "Advanced.PurgeDiskCache");
+    view_listener_t::addMenu(new LLAdvancedBenchmarkInventoryCache(), "Advanced.BenchmarkInventoryCache");
 
     // Advanced > Recorder
     view_listener_t::addMenu(new LLAdvancedAgentPilot(), "Advanced.AgentPilot");
@@ -40,6 +40,7 @@
 #include "llinventorydefines.h"
 #include "lllslconstants.h"
 #include "llmaterialtable.h"
+#include "llmessagedecoders.h"
 #include "llregionhandle.h"
 #include "llsd.h"
 #include "llsdserialize.h"
@@ -478,26 +479,21 @@ void process_layer_data(LLMessageSystem *mesgsys, void **user_data)
         LL_WARNS() << "Invalid region for layer data." << LL_ENDL;
         return;
     }
-    S32 size;
-    S8 type;
-
-    mesgsys->getS8Fast(_PREHASH_LayerID, _PREHASH_Type, type);
-    size = mesgsys->getSizeFast(_PREHASH_LayerData, _PREHASH_Data);
-    if (0 == size)
+    LLMessageDecoders::LayerData msg;
+    if (!msg.decode(mesgsys))
     {
-        LL_WARNS("Messaging") << "Layer data has zero size." << LL_ENDL;
+        LL_WARNS("Messaging") << "Malformed layer data." << LL_ENDL;
         return;
     }
-    if (size < 0)
+    S8 type = (S8)msg.getLayerID().getType();
+    S32 size = msg.getLayerData().getDataSize();
+    if (0 == size)
     {
-        // getSizeFast() is probably trying to tell us about an error
-        LL_WARNS("Messaging") << "getSizeFast() returned negative result: "
-            << size
-            << LL_ENDL;
+        LL_WARNS("Messaging") << "Layer data has zero size." << LL_ENDL;
         return;
     }
     U8 *datap = new U8[size];
-    mesgsys->getBinaryDataFast(_PREHASH_LayerData, _PREHASH_Data, datap, size);
+    memcpy(datap, msg.getLayerData().getData(), size);
     LLVLData *vl_datap = new LLVLData(regionp, type, datap, size);
     if (mesgsys->getReceiveCompressedSize())
     {
@@ -3641,6 +3637,11 @@ void process_kill_object(LLMessageSystem *mesgsys, void **user_data)
         U32 local_id;
         mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
 
+        if (regionp)
+        {
+            gObjectList.removePendingUpdate(regionp, local_id);
+        }
+
         gObjectList.getUUIDFromLocal(id, local_id, ip, port);
         if (id == LLUUID::null)
         {
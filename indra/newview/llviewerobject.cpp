@@ -671,10 +671,17 @@ void LLViewerObject::initObjectDataMap()
     //-------
 }
 
+//static
+U32 LLViewerObject::getObjectDataOffset(const std::string& name)
+{
+    std::map<std::string, U32>::const_iterator found = sObjectDataMap.find(name);
+    return found != sObjectDataMap.end() ? found->second : 0;
+}
+
 //static
 void LLViewerObject::unpackVector3(LLDataPackerBinaryBuffer* dp, LLVector3& value, std::string name)
 {
-    dp->shift(sObjectDataMap[name]);
+    dp->shift(getObjectDataOffset(name));
     dp->unpackVector3(value, name.c_str());
     dp->reset();
 }
@@ -682,7 +689,7 @@ void LLViewerObject::unpackVector3(LLDataPackerBinaryBuffer* dp, LLVector3& valu
 //static
 void LLViewerObject::unpackUUID(LLDataPackerBinaryBuffer* dp, LLUUID& value, std::string name)
 {
-    dp->shift(sObjectDataMap[name]);
+    dp->shift(getObjectDataOffset(name));
     dp->unpackUUID(value, name.c_str());
     dp->reset();
 }
@@ -690,7 +697,7 @@ void LLViewerObject::unpackUUID(LLDataPackerBinaryBuffer* dp, LLUUID& value, std
 //static
 void LLViewerObject::unpackU32(LLDataPackerBinaryBuffer* dp, U32& value, std::string name)
 {
-    dp->shift(sObjectDataMap[name]);
+    dp->shift(getObjectDataOffset(name));
     dp->unpackU32(value, name.c_str());
     dp->reset();
 }
@@ -698,7 +705,7 @@ void LLViewerObject::unpackU32(LLDataPackerBinaryBuffer* dp, U32& value, std::st
 //static
 void LLViewerObject::unpackU8(LLDataPackerBinaryBuffer* dp, U8& value, std::string name)
 {
-    dp->shift(sObjectDataMap[name]);
+    dp->shift(getObjectDataOffset(name));
     dp->unpackU8(value, name.c_str());
     dp->reset();
 }
@@ -706,14 +713,14 @@ void LLViewerObject::unpackU8(LLDataPackerBinaryBuffer* dp, U8& value, std::stri
 //static
 U32 LLViewerObject::unpackParentID(LLDataPackerBinaryBuffer* dp, U32& parent_id)
 {
-    dp->shift(sObjectDataMap["SpecialCode"]);
+    dp->shift(getObjectDataOffset("SpecialCode"));
     U32 value;
     dp->unpackU32(value, "SpecialCode");
 
     parent_id = 0;
     if(value & 0x20)
     {
-        S32 offset = sObjectDataMap["ParentID"];
+        S32 offset = getObjectDataOffset("ParentID");
         if(!(value & 0x80))
         {
             offset -= sizeof(LLVector3);
@@ -1155,7 +1162,7 @@ U32 LLViewerObject::extractSpatialExtents(LLDataPackerBinaryBuffer *dp, LLVector
 }
 
 U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
-                     void **user_data,
+                     const LLObjectUpdateInfo* info,
                      U32 block_num,
                      const EObjectUpdateType update_type,
                      LLDataPacker *dp)
@@ -1163,7 +1170,7 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
     LL_PROFILE_ZONE_SCOPED;
     LL_DEBUGS_ONCE("SceneLoadTiming") << "Received viewer object data" << LL_ENDL;
 
-    LL_DEBUGS("ObjectUpdate") << " mesgsys " << mesgsys << " dp " << dp << " id " << getID() << " update_type " << (S32) update_type << LL_ENDL;
+    LL_DEBUGS("ObjectUpdate") << " mesgsys " << mesgsys << " info " << info << " dp " << dp << " id " << getID() << " update_type " << (S32) update_type << LL_ENDL;
 
     // The new OBJECTDATA_FIELD_SIZE_124, OBJECTDATA_FIELD_SIZE_140, OBJECTDATA_FIELD_SIZE_80
     // and OBJECTDATA_FIELD_SIZE_64 lengths should be supported in the existing cases below.
@@ -1191,9 +1198,9 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
     // Coordinates of objects on simulators are region-local.
     U64 region_handle = 0;
 
-    if(mesgsys != NULL)
+    if(info != NULL)
     {
-        mesgsys->getU64Fast(_PREHASH_RegionData, _PREHASH_RegionHandle, region_handle);
+        region_handle = info->mRegionHandle;
         LLViewerRegion* regionp = LLWorld::getInstance()->getRegionFromHandle(region_handle);
         if(regionp != mRegionp && regionp && mRegionp)//region cross
         {
@@ -1231,11 +1238,9 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
     }
 
     F32 time_dilation = 1.f;
-    if(mesgsys != NULL)
+    if(info != NULL)
     {
-        U16 time_dilation16;
-        mesgsys->getU16Fast(_PREHASH_RegionData, _PREHASH_TimeDilation, time_dilation16);
-        time_dilation = ((F32) time_dilation16) / 65535.f;
+        time_dilation = info->mTimeDilation;
         mRegionp->setTimeDilation(time_dilation);
     }
 
@@ -1906,11 +1911,9 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                 // Preload these five flags for every object.
                 // Finer shades require the object to be selected, and the selection manager
                 // stores the extended permission info.
-                if(mesgsys != NULL)
+                if(info != NULL)
                 {
-                U32 flags;
-                mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, block_num);
-                loadFlags(flags);
+                loadFlags(info->mUpdateFlags);
                 }
             }
             break;
@@ -1941,12 +1944,12 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                 // No parent now, new parent in message -> attach to that parent if possible
                 LLUUID parent_uuid;
 
-                if(mesgsys != NULL)
+                if(info != NULL)
                 {
                     gObjectList.getUUIDFromLocal(parent_uuid,
                                                         parent_id,
-                                                        mesgsys->getSenderIP(),
-                                                        mesgsys->getSenderPort());
+                                                        info->mSender.getAddress(),
+                                                        info->mSender.getPort());
                 }
                 else
                 {
@@ -2038,10 +2041,10 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                     //parent_id
                     U32 ip, port;
 
-                    if(mesgsys != NULL)
+                    if(info != NULL)
                     {
-                        ip = mesgsys->getSenderIP();
-                        port = mesgsys->getSenderPort();
+                        ip = info->mSender.getAddress();
+                        port = info->mSender.getPort();
                     }
                     else
                     {
@@ -2086,12 +2089,12 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                 {
                     LLUUID parent_uuid;
 
-                    if(mesgsys != NULL)
+                    if(info != NULL)
                     {
                         gObjectList.getUUIDFromLocal(parent_uuid,
                                                         parent_id,
-                                                        gMessageSystem->getSenderIP(),
-                                                        gMessageSystem->getSenderPort());
+                                                        info->mSender.getAddress(),
+                                                        info->mSender.getPort());
                     }
                     else
                     {
@@ -2122,10 +2125,10 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                         //
                         U32 ip, port;
 
-                        if(mesgsys != NULL)
+                        if(info != NULL)
                         {
-                            ip = mesgsys->getSenderIP();
-                            port = mesgsys->getSenderPort();
+                            ip = info->mSender.getAddress();
+                            port = info->mSender.getPort();
                         }
                         else
                         {
@@ -2215,14 +2218,16 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 
     new_rot.normQuat();
 
-    if (sPingInterpolate && mesgsys != NULL)
+    if (sPingInterpolate && info != NULL)
     {
-        LLCircuitData *cdp = gMessageSystem->mCircuitInfo.findCircuit(mesgsys->getSender());
+        LLCircuitData *cdp = gMessageSystem->mCircuitInfo.findCircuit(info->mSender);
         if (cdp)
         {
             // Note: delay is U32 and usually less then second,
             // converting it into seconds with valueInUnits will result in 0
             F32 ping_delay = 0.5f * time_dilation * ( ((F32)cdp->getPingDelay().value()) * 0.001f + gFrameDTClamped);
+            // a staged update waited this long after it came in
+            ping_delay += time_dilation * (F32)(LLFrameTimer::getElapsedSeconds() - info->mReceiveTime);
             LLVector3 diff = getVelocity() * ping_delay;
             new_pos_parent += diff;
         }
@@ -2240,9 +2245,9 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 
     // If we're going to skip this message, why are we
     // doing all the parenting, etc above?
-    if(mesgsys != NULL)
+    if(info != NULL)
     {
-    U32 packet_id = mesgsys->getCurrentRecvPacketID();
+    U32 packet_id = info->mPacketID;
     if (packet_id < mLatestRecvPacketID &&
         mLatestRecvPacketID - packet_id < 65536)
     {
@@ -33,6 +33,7 @@
 
 #include "llassetstorage.h"
 //#include "llhudicon.h"
+#include "llhost.h"
 #include "llinventory.h"
 #include "llrefcount.h"
 #include "llprimitive.h"
@@ -91,6 +92,21 @@ typedef enum e_object_update_type
     OUT_UNKNOWN,
 } EObjectUpdateType;
 
+// What an object update needs from the message it came in besides the
+// block of its object. Updates from the object cache have none.
+struct LLObjectUpdateInfo
+{
+    LLHost      mSender;
+    U64         mRegionHandle = 0;
+    F32         mTimeDilation = 1.f;
+    U32         mPacketID = 0;
+    F64         mReceiveTime = 0.0;    // LLFrameTimer::getElapsedSeconds()
+    // of the object's block, for compressed and terse updates
+    U32         mUpdateFlags = 0;
+    const U8*   mTextureEntry = NULL;
+    S32         mTextureEntrySize = 0;
+};
+
 
 // callback typedef for inventory
 typedef void (*inventory_callback)(LLViewerObject*,
@@ -175,7 +191,7 @@ public:
 
     static  U32     extractSpatialExtents(LLDataPackerBinaryBuffer *dp, LLVector3& pos, LLVector3& scale, LLQuaternion& rot);
     virtual U32     processUpdateMessage(LLMessageSystem *mesgsys,
-                                        void **user_data,
+                                        const LLObjectUpdateInfo* info,
                                         U32 block_num,
                                         const EObjectUpdateType update_type,
                                         LLDataPacker *dp);
@@ -655,6 +671,10 @@ public:
     static void unpackU32(LLDataPackerBinaryBuffer* dp, U32& value, std::string name);
     static void unpackU8(LLDataPackerBinaryBuffer* dp, U8& value, std::string name);
     static U32 unpackParentID(LLDataPackerBinaryBuffer* dp, U32& parent_id);
+private:
+    // never inserts, so the General pool can unpack staged updates while
+    // the main thread unpacks others
+    static U32 getObjectDataOffset(const std::string& name);
 
 public:
     //counter-translation
@@ -29,6 +29,7 @@
 #include "llviewerobjectlist.h"
 
 #include "message.h"
+#include "llmessagedecoders.h"
 #include "llfasttimer.h"
 #include "llrender.h"
 #include "llwindow.h"       // decBusyCount()
@@ -80,6 +81,7 @@
 #include "llvocache.h"
 #include "llcorehttputil.h"
 #include "llstartup.h"
+#include "workqueue.h"
 
 #include <algorithm>
 #include <iterator>
@@ -125,6 +127,9 @@ void LLViewerObjectList::destroy()
     mDeadObjects.clear();
     mMapObjects.clear();
     mUUIDObjectMap.clear();
+    mStagedUpdates.clear();
+    mPendingUpdates.clear();
+    mPendingUpdateMap.clear();
 }
 
 
@@ -223,7 +228,7 @@ S32 gFullObjectUpdates = 0;
 S32 gTerseObjectUpdates = 0;
 
 void LLViewerObjectList::processUpdateCore(LLViewerObject* objectp,
-                                           void** user_data,
+                                           const LLObjectUpdateInfo* info,
                                            U32 i,
                                            const EObjectUpdateType update_type,
                                            LLDataPacker* dpp,
@@ -241,7 +246,7 @@ void LLViewerObjectList::processUpdateCore(LLViewerObject* objectp,
     LL_DEBUGS("ObjectUpdate") << "uuid " << objectp->mID << " calling processUpdateMessage "
                               << objectp << " just_created " << just_created << " from_cache " << from_cache << " msg " << msg << LL_ENDL;
 
-    objectp->processUpdateMessage(msg, user_data, i, update_type, dpp);
+    objectp->processUpdateMessage(msg, info, i, update_type, dpp);
 
     if (objectp->isDead())
     {
@@ -262,9 +267,9 @@ void LLViewerObjectList::processUpdateCore(LLViewerObject* objectp,
     // RN: this must be called after we have a drawable
     // (from gPipeline.addObject)
     // so that the drawable parent is set properly
-    if(msg != NULL)
+    if(info != NULL)
     {
-    findOrphans(objectp, msg->getSenderIP(), msg->getSenderPort());
+    findOrphans(objectp, info->mSender.getAddress(), info->mSender.getPort());
     }
     else
     {
@@ -404,11 +409,54 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
     LLUUID      fullid;
     S32         i;
 
-    // figure out which simulator these are from and get it's index
-    // Coordinates in simulators are region-local
-    // Until we get region-locality working on viewer we
-    // have to transform to absolute coordinates.
-    num_objects = mesgsys->getNumberOfBlocksFast(_PREHASH_ObjectData);
+    // Full updates come in ObjectUpdate, and the decoder only finds their
+    // blocks: processUpdateMessage() still reads them with the generic
+    // getters, so that message is decoded up front and not on demand.
+    LLMessageDecoders::ObjectUpdate full_msg;
+    LLMessageDecoders::ObjectUpdateCompressed compressed_msg;
+    LLMessageDecoders::ImprovedTerseObjectUpdate terse_msg;
+    LLObjectUpdateInfo info;
+    info.mSender = mesgsys->getSender();
+    info.mPacketID = mesgsys->getCurrentRecvPacketID();
+    info.mReceiveTime = LLFrameTimer::getElapsedSeconds();
+    U16 time_dilation16 = 0;
+    bool decoded;
+    if (!compressed)
+    {
+        decoded = full_msg.decode(mesgsys);
+        if (decoded)
+        {
+            num_objects = full_msg.getNumberOfObjectDataBlocks();
+            info.mRegionHandle = full_msg.getRegionData().getRegionHandle();
+            time_dilation16 = full_msg.getRegionData().getTimeDilation();
+        }
+    }
+    else if (update_type == OUT_TERSE_IMPROVED)
+    {
+        decoded = terse_msg.decode(mesgsys);
+        if (decoded)
+        {
+            num_objects = terse_msg.getNumberOfObjectDataBlocks();
+            info.mRegionHandle = terse_msg.getRegionData().getRegionHandle();
+            time_dilation16 = terse_msg.getRegionData().getTimeDilation();
+        }
+    }
+    else
+    {
+        decoded = compressed_msg.decode(mesgsys);
+        if (decoded)
+        {
+            num_objects = compressed_msg.getNumberOfObjectDataBlocks();
+            info.mRegionHandle = compressed_msg.getRegionData().getRegionHandle();
+            time_dilation16 = compressed_msg.getRegionData().getTimeDilation();
+        }
+    }
+    if (!decoded)
+    {
+        LL_WARNS() << "Malformed object update from " << mesgsys->getSender() << LL_ENDL;
+        return;
+    }
+    info.mTimeDilation = ((F32) time_dilation16) / 65535.f;
 
     // I don't think this case is ever hit.  TODO* Test this.
     if (!compressed && update_type != OUT_FULL)
@@ -446,14 +494,11 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
         gFullObjectUpdates += num_objects;
     }
 
-    U64 region_handle;
-    mesgsys->getU64Fast(_PREHASH_RegionData, _PREHASH_RegionHandle, region_handle);
-
-    LLViewerRegion *regionp = LLWorld::getInstance()->getRegionFromHandle(region_handle);
+    LLViewerRegion *regionp = LLWorld::getInstance()->getRegionFromHandle(info.mRegionHandle);
 
     if (!regionp)
     {
-        LL_WARNS() << "Object update from unknown region! " << region_handle << LL_ENDL;
+        LL_WARNS() << "Object update from unknown region! " << info.mRegionHandle << LL_ENDL;
         return;
     }
 
@@ -468,17 +513,39 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 
         if (compressed)
         {
+            const U8* data;
+            S32 uncompressed_length;
+            if (update_type == OUT_TERSE_IMPROVED)
+            {
+                const LLMessageDecoders::ImprovedTerseObjectUpdate::ObjectDataBlock& block = terse_msg.getObjectData(i);
+                data = block.getData();
+                uncompressed_length = block.getDataSize();
+                info.mUpdateFlags = 0;
+                info.mTextureEntry = block.getTextureEntry();
+                info.mTextureEntrySize = block.getTextureEntrySize();
+            }
+            else
+            {
+                const LLMessageDecoders::ObjectUpdateCompressed::ObjectDataBlock& block = compressed_msg.getObjectData(i);
+                data = block.getData();
+                uncompressed_length = block.getDataSize();
+                info.mUpdateFlags = block.getUpdateFlags();
+            }
+
             compressed_dp.reset();
 
-            S32 uncompressed_length = mesgsys->getSizeFast(_PREHASH_ObjectData, i, _PREHASH_Data);
+            if (uncompressed_length > (S32)sizeof(compressed_dpbuffer))
+            {
+                LL_WARNS() << "Compressed object update data is " << uncompressed_length << " bytes, truncating" << LL_ENDL;
+                uncompressed_length = (S32)sizeof(compressed_dpbuffer);
+            }
             LL_DEBUGS("ObjectUpdate") << "got binary data from message to compressed_dpbuffer" << LL_ENDL;
-            mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, compressed_dpbuffer, 0, i, 2048);
+            memcpy(compressed_dpbuffer, data, uncompressed_length);
             compressed_dp.assignBuffer(compressed_dpbuffer, uncompressed_length);
 
             if (update_type != OUT_TERSE_IMPROVED) // OUT_FULL_COMPRESSED only?
             {
-                U32 flags = 0;
-                mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
+                U32 flags = info.mUpdateFlags;
 
                 compressed_dp.unpackUUID(fullid, "ID");
                 compressed_dp.unpackU32(local_id, "LocalID");
@@ -495,12 +562,11 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
                     recorder.objectUpdateFailure();
                     continue;
                 }
-                else if ((flags & FLAGS_TEMPORARY_ON_REZ) == 0)
-                {
-                    //send to object cache
-                    regionp->cacheFullUpdate(compressed_dp, flags);
-                    continue;
-                }
+
+                //create or cache the object later, see processPendingUpdates()
+                queuePendingUpdate(regionp, local_id, info, compressed_dpbuffer,
+                                   llclamp(compressed_dp.getBufferSize(), 0, (S32)sizeof(compressed_dpbuffer)));
+                continue;
             }
             else //OUT_TERSE_IMPROVED
             {
@@ -519,7 +585,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
         }
         else if (update_type != OUT_FULL) // !compressed, !OUT_FULL ==> OUT_FULL_CACHED only?
         {
-            mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+            local_id = full_msg.getObjectData(i).getID();
 
             getUUIDFromLocal(fullid,
                             local_id,
@@ -538,10 +604,23 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
         else // OUT_FULL only?
         {
             update_cache = true;
-            mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_FullID, fullid, i);
-            mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+            const LLMessageDecoders::ObjectUpdate::ObjectDataBlock& block = full_msg.getObjectData(i);
+            fullid = block.getFullID();
+            local_id = block.getID();
+            info.mUpdateFlags = block.getUpdateFlags();
             LL_DEBUGS("ObjectUpdate") << "Full Update, obj " << local_id << ", global ID " << fullid << " from " << mesgsys->getSender() << LL_ENDL;
         }
+
+        // a staged full update is older than this one
+        if (applyPendingUpdate(regionp, local_id) && fullid.isNull())
+        {
+            // the object did not exist until now
+            getUUIDFromLocal(fullid,
+                             local_id,
+                             gMessageSystem->getSenderIP(),
+                             gMessageSystem->getSenderPort());
+        }
+
         objectp = findObject(fullid);
 
         if (compressed)
@@ -613,7 +692,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
                     continue;
                 }
 
-                mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_PCode, pcode, i);
+                pcode = full_msg.getObjectData(i).getPCode();
 
             }
 #ifdef IGNORE_DEAD
@@ -653,7 +732,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
             {
                 objectp->mLocalID = local_id;
             }
-            processUpdateCore(objectp, user_data, i, update_type, &compressed_dp, justCreated);
+            processUpdateCore(objectp, &info, i, update_type, &compressed_dp, justCreated);
 
 #if 0
             if (update_type != OUT_TERSE_IMPROVED) // OUT_FULL_COMPRESSED only?
@@ -676,12 +755,14 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
             {
                 objectp->mLocalID = local_id;
             }
-            processUpdateCore(objectp, user_data, i, update_type, NULL, justCreated);
+            processUpdateCore(objectp, &info, i, update_type, NULL, justCreated);
         }
         recorder.objectUpdateEvent(update_type);
         objectp->setLastUpdateType(update_type);
     }
 
+    decodeStagedBlocks();
+
     LLVOAvatar::cullAvatarsByPixelArea();
 }
 
@@ -698,11 +779,17 @@ void LLViewerObjectList::processCachedObjectUpdate(LLMessageSystem *mesgsys,
 {
     //processObjectUpdate(mesgsys, user_data, update_type, true, false);
 
-    S32 num_objects = mesgsys->getNumberOfBlocksFast(_PREHASH_ObjectData);
+    LLMessageDecoders::ObjectUpdateCached msg;
+    if (!msg.decode(mesgsys))
+    {
+        LL_WARNS() << "Malformed cached object update from " << mesgsys->getSender() << LL_ENDL;
+        return;
+    }
+
+    S32 num_objects = msg.getNumberOfObjectDataBlocks();
     gFullObjectUpdates += num_objects;
 
-    U64 region_handle;
-    mesgsys->getU64Fast(_PREHASH_RegionData, _PREHASH_RegionHandle, region_handle);
+    U64 region_handle = msg.getRegionData().getRegionHandle();
     LLViewerRegion *regionp = LLWorld::getInstance()->getRegionFromHandle(region_handle);
     if (!regionp)
     {
@@ -714,15 +801,15 @@ void LLViewerObjectList::processCachedObjectUpdate(LLMessageSystem *mesgsys,
 
     for (S32 i = 0; i < num_objects; i++)
     {
-        U32 id;
-        U32 crc;
-        U32 flags;
-        mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, id, i);
-        mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_CRC, crc, i);
-        mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
+        const LLMessageDecoders::ObjectUpdateCached::ObjectDataBlock& data = msg.getObjectData(i);
+        U32 id = data.getID();
+        U32 crc = data.getCRC();
+        U32 flags = data.getUpdateFlags();
 
         LL_DEBUGS("ObjectUpdate") << "got probe for id " << id << " crc " << crc << LL_ENDL;
 
+        applyPendingUpdate(regionp, id);
+
         // Lookup data packer and add this id to cache miss lists if necessary.
         U8 cache_miss_type = LLViewerRegion::CACHE_MISS_TYPE_NONE;
         if (regionp->probeCache(id, crc, flags, cache_miss_type))
@@ -739,6 +826,266 @@ void LLViewerObjectList::processCachedObjectUpdate(LLMessageSystem *mesgsys,
     return;
 }
 
+void LLViewerObjectList::queuePendingUpdate(LLViewerRegion* regionp, U32 local_id, const LLObjectUpdateInfo& info, const U8* data, S32 size)
+{
+    std::shared_ptr<StagedBlock> block = std::make_shared<StagedBlock>();
+    block->mRegionp = regionp;
+    block->mLocalID = local_id;
+    block->mData.assign(data, data + size);
+    mBlocksToDecode.push_back(block);
+
+    pending_update_map_t::iterator found = mPendingUpdateMap.find(std::make_pair(regionp, local_id));
+    if (found != mPendingUpdateMap.end())
+    {
+        // only the newest full update of an object matters, it waits for
+        // its decode with the others
+        PendingUpdate& update = *found->second;
+        mStagedUpdates.splice(mStagedUpdates.end(), getUpdateList(update), found->second);
+        update.mInfo = info;
+        update.mBlock = block;
+        update.mDecoded = false;
+        return;
+    }
+
+    PendingUpdate update;
+    update.mRegionp = regionp;
+    update.mLocalID = local_id;
+    update.mInfo = info;
+    update.mBlock = block;
+    mStagedUpdates.push_back(std::move(update));
+    mPendingUpdateMap[std::make_pair(regionp, local_id)] = std::prev(mStagedUpdates.end());
+}
+
+void LLViewerObjectList::decodeStagedBlocks()
+{
+    if (mBlocksToDecode.empty())
+    {
+        return;
+    }
+
+    typedef std::vector<std::shared_ptr<StagedBlock>> blocks_t;
+    blocks_t blocks;
+    blocks.swap(mBlocksToDecode);
+
+    // extractSpatialExtents() only reads the block and, through find(), the
+    // object data map
+    auto decode = [](const blocks_t& blocks)
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("decode staged updates");
+        for (const std::shared_ptr<StagedBlock>& block : blocks)
+        {
+            LLDataPackerBinaryBuffer dp(block->mData.data(), (S32)block->mData.size());
+            LLVector3 scale;
+            LLQuaternion rot;
+            block->mParentID = LLViewerObject::extractSpatialExtents(&dp, block->mPosition, scale, rot);
+        }
+    };
+    auto set_decoded = [this](const blocks_t& blocks)
+    {
+        pending_update_list_t decoded;
+        for (const std::shared_ptr<StagedBlock>& block : blocks)
+        {
+            // unless a newer update replaced it or it was applied already
+            pending_update_map_t::iterator found = mPendingUpdateMap.find(std::make_pair(block->mRegionp, block->mLocalID));
+            if (found != mPendingUpdateMap.end() && found->second->mBlock == block)
+            {
+                decoded.splice(decoded.end(), mStagedUpdates, found->second);
+                found->second->mDecoded = true;
+            }
+        }
+        mergeDecodedUpdates(decoded);
+    };
+
+    LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
+    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    if (!main_queue || !general_queue ||
+        !main_queue->postTo(general_queue,
+                            [decode, blocks]() { decode(blocks); return blocks; },
+                            [set_decoded](const blocks_t& decoded) { set_decoded(decoded); }))
+    {
+        decode(blocks);
+        set_decoded(blocks);
+    }
+}
+
+void LLViewerObjectList::mergeDecodedUpdates(pending_update_list_t& decoded)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+
+    const LLVector3 agent_pos = gAgent.getPositionAgent();
+    for (PendingUpdate& update : decoded)
+    {
+        if (!update.mBlock->mParentID)
+        {
+            LLVector3 pos = update.mRegionp->getPosAgentFromRegion(update.mBlock->mPosition);
+            update.mDistanceSquared = dist_vec_squared(pos, agent_pos);
+        }
+    }
+
+    // Roots before children, nearest roots first. Only the new batch is
+    // sorted, the updates already waiting keep the distances they were
+    // merged with. Both steps are stable, so children apply in the order
+    // they arrived, and the map's iterators stay valid.
+    auto apply_before = [](const PendingUpdate& a, const PendingUpdate& b)
+    {
+        bool a_root = !a.mBlock->mParentID;
+        bool b_root = !b.mBlock->mParentID;
+        if (a_root != b_root)
+        {
+            return a_root;
+        }
+        return a_root && a.mDistanceSquared < b.mDistanceSquared;
+    };
+    decoded.sort(apply_before);
+    mPendingUpdates.merge(decoded, apply_before);
+}
+
+bool LLViewerObjectList::applyPendingUpdate(LLViewerRegion* regionp, U32 local_id)
+{
+    if (mPendingUpdateMap.empty())
+    {
+        return false;
+    }
+    pending_update_map_t::iterator found = mPendingUpdateMap.find(std::make_pair(regionp, local_id));
+    if (found == mPendingUpdateMap.end())
+    {
+        return false;
+    }
+    applyPendingUpdate(found->second);
+    return true;
+}
+
+void LLViewerObjectList::applyPendingUpdate(pending_update_list_t::iterator iter)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+
+    // off the lists first, the update can kill objects
+    PendingUpdate update = std::move(*iter);
+    mPendingUpdateMap.erase(std::make_pair(update.mRegionp, update.mLocalID));
+    getUpdateList(update).erase(iter);
+
+    LLViewerRegion* regionp = update.mRegionp;
+    const LLHost& host = update.mInfo.mSender;
+    LLViewerStatsRecorder& recorder = LLViewerStatsRecorder::instance();
+
+    LLDataPackerBinaryBuffer dp(update.mBlock->mData.data(), (S32)update.mBlock->mData.size());
+    if ((update.mInfo.mUpdateFlags & FLAGS_TEMPORARY_ON_REZ) == 0)
+    {
+        //send to object cache
+        regionp->cacheFullUpdate(dp, update.mInfo.mUpdateFlags);
+        return;
+    }
+
+    LLUUID fullid;
+    U32 local_id;
+    LLPCode pcode = 0;
+    dp.unpackUUID(fullid, "ID");
+    dp.unpackU32(local_id, "LocalID");
+    dp.unpackU8(pcode, "PCode");
+
+    bool justCreated = false;
+    LLViewerObject* objectp = findObject(fullid);
+
+    // Reset object local id and region pointer if things have changed,
+    // same as processObjectUpdate()
+    if (objectp &&
+        ((objectp->mLocalID != local_id) ||
+         (objectp->getRegion() != regionp)))
+    {
+        removeFromLocalIDTable(objectp);
+        setUUIDAndLocal(fullid, local_id, host.getAddress(), host.getPort(), objectp);
+
+        if (objectp->getRegion() != regionp)
+        {   // Object changed region, so update it
+            objectp->updateRegion(regionp); // for LLVOAvatar
+        }
+    }
+
+    if (!objectp)
+    {
+        objectp = createObject(pcode, regionp, fullid, local_id, host);
+
+        LL_DEBUGS("ObjectUpdate") << "creating staged object " << fullid << " result " << objectp << LL_ENDL;
+
+        if (!objectp)
+        {
+            LL_INFOS() << "createObject failure for object: " << fullid << LL_ENDL;
+            recorder.objectUpdateFailure();
+            return;
+        }
+
+        justCreated = true;
+        mNumNewObjects++;
+    }
+
+    if (objectp->isDead())
+    {
+        LL_WARNS() << "Dead object " << objectp->mID << " in UUID map 1!" << LL_ENDL;
+    }
+
+    // the update is applied as it came in, only its message is gone
+    objectp->mLocalID = local_id;
+    processUpdateCore(objectp, &update.mInfo, 0, OUT_FULL_COMPRESSED, &dp, justCreated, true);
+
+    recorder.objectUpdateEvent(OUT_FULL_COMPRESSED);
+    objectp->setLastUpdateType(OUT_FULL_COMPRESSED);
+}
+
+void LLViewerObjectList::processPendingUpdates(F32 max_time)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+
+    // keep up with a steady trickle of updates however busy the frame is
+    const S32 MIN_UPDATES = 16;
+
+    LLTimer update_timer;
+    S32 count = 0;
+    while (!mPendingUpdates.empty())
+    {
+        if (count >= MIN_UPDATES && update_timer.getElapsedTimeF32() > max_time)
+        {
+            break;
+        }
+        applyPendingUpdate(mPendingUpdates.begin());
+        count++;
+    }
+
+    if (count > 0)
+    {
+        LLVOAvatar::cullAvatarsByPixelArea();
+    }
+}
+
+void LLViewerObjectList::removePendingUpdate(LLViewerRegion* regionp, U32 local_id)
+{
+    pending_update_map_t::iterator found = mPendingUpdateMap.find(std::make_pair(regionp, local_id));
+    if (found != mPendingUpdateMap.end())
+    {
+        getUpdateList(*found->second).erase(found->second);
+        mPendingUpdateMap.erase(found);
+    }
+}
+
+void LLViewerObjectList::cleanupPendingUpdates(LLViewerRegion* regionp)
+{
+    for (pending_update_list_t* updates : { &mStagedUpdates, &mPendingUpdates })
+    {
+        pending_update_list_t::iterator iter = updates->begin();
+        while (iter != updates->end())
+        {
+            if (iter->mRegionp == regionp)
+            {
+                mPendingUpdateMap.erase(std::make_pair(regionp, iter->mLocalID));
+                iter = updates->erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+}
+
 void LLViewerObjectList::dirtyAllObjectInventory()
 {
     for (vobj_list_t::iterator iter = mObjects.begin(); iter != mObjects.end(); ++iter)
@@ -914,6 +1261,9 @@ void LLViewerObjectList::update(LLAgent &agent)
 
     std::vector<LLViewerObject*>::iterator idle_end = idle_list.begin()+idle_count;
 
+    static LLCachedControl<bool> parallel_avatar_poses(gSavedSettings, "AvatarParallelPoses", true);
+    LLVOAvatar::setDeferPoses(parallel_avatar_poses);
+
     if (gSavedSettings.getBOOL("FreezeTime"))
     {
 
@@ -926,6 +1276,8 @@ void LLViewerObjectList::update(LLAgent &agent)
                 objectp->idleUpdate(agent, frame_time);
             }
         }
+
+        LLVOAvatar::updateDeferredPoses();
     }
     else
     {
@@ -937,6 +1289,9 @@ void LLViewerObjectList::update(LLAgent &agent)
                 objectp->idleUpdate(agent, frame_time);
         }
 
+        // finish the avatars that left their pose to be blended in parallel
+        LLVOAvatar::updateDeferredPoses();
+
         //update flexible objects
         LLVolumeImplFlexible::updateClass();
 
@@ -27,7 +27,9 @@
 #ifndef LL_LLVIEWEROBJECTLIST_H
 #define LL_LLVIEWEROBJECTLIST_H
 
+#include <list>
 #include <map>
+#include <memory>
 #include <set>
 
 // common includes
@@ -81,12 +83,24 @@ public:
     void cleanDeadObjects(const bool use_timer = true); // Clean up the dead object list.
 
     // Simulator and viewer side object updates...
-    void processUpdateCore(LLViewerObject* objectp, void** data, U32 block, const EObjectUpdateType update_type,
+    void processUpdateCore(LLViewerObject* objectp, const LLObjectUpdateInfo* info, U32 block, const EObjectUpdateType update_type,
                            LLDataPacker* dpp, bool justCreated, bool from_cache = false);
     LLViewerObject* processObjectUpdateFromCache(LLVOCacheEntry* entry, LLViewerRegion* regionp);
     void processObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type, bool compressed=false);
     void processCompressedObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type);
     void processCachedObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type);
+
+    // Compressed full updates are staged: the message handler copies them
+    // out of the packet, the General thread pool decodes where their
+    // objects are, and this applies them until max_time (seconds) runs out,
+    // roots before children and nearest first. Temporary objects are
+    // created, the others go to the region's object cache. Any other
+    // update of an object applies its staged one first.
+    void processPendingUpdates(F32 max_time);
+    void removePendingUpdate(LLViewerRegion* regionp, U32 local_id);
+    void cleanupPendingUpdates(LLViewerRegion* regionp);
+    S32 getNumPendingUpdates() const { return (S32)(mStagedUpdates.size() + mPendingUpdates.size()); }
+
     void updateApparentAngles(LLAgent &agent);
     void update(LLAgent &agent);
 
@@ -226,6 +240,40 @@ protected:
     friend class LLViewerObject;
 
 private:
+    // The block of a staged update, and what the General thread pool
+    // decodes from it. Nothing writes mData once the block is posted.
+    struct StagedBlock
+    {
+        LLViewerRegion* mRegionp;   // only to find the update again
+        U32 mLocalID;
+        std::vector<U8> mData;
+        U32 mParentID = 0;
+        LLVector3 mPosition;        // region local for a root
+    };
+    struct PendingUpdate
+    {
+        LLViewerRegion* mRegionp;
+        U32 mLocalID;
+        LLObjectUpdateInfo mInfo;   // of the message it came in
+        std::shared_ptr<StagedBlock> mBlock;
+        bool mDecoded = false;      // mBlock's decoded fields can be read
+        F32 mDistanceSquared = 0.f; // from the agent, when decoded
+    };
+    typedef std::list<PendingUpdate> pending_update_list_t;
+    typedef std::map<std::pair<LLViewerRegion*, U32>, pending_update_list_t::iterator> pending_update_map_t;
+
+    void queuePendingUpdate(LLViewerRegion* regionp, U32 local_id, const LLObjectUpdateInfo& info, const U8* data, S32 size);
+    bool applyPendingUpdate(LLViewerRegion* regionp, U32 local_id);
+    void applyPendingUpdate(pending_update_list_t::iterator iter);
+    void decodeStagedBlocks();
+    void mergeDecodedUpdates(pending_update_list_t& decoded);
+    pending_update_list_t& getUpdateList(const PendingUpdate& update) { return update.mDecoded ? mPendingUpdates : mStagedUpdates; }
+
+    pending_update_list_t mStagedUpdates;   // waiting for their decode, as they arrived
+    pending_update_list_t mPendingUpdates;  // decoded, in the order they apply
+    pending_update_map_t mPendingUpdateMap; // into either list
+    std::vector<std::shared_ptr<StagedBlock>> mBlocksToDecode;
+
     static void reportObjectCostFailure(LLSD &objectList);
     void fetchObjectCostsCoro(std::string url);
 
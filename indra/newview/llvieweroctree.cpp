@@ -33,6 +33,7 @@
 #include "llglslshader.h"
 #include "llviewershadermgr.h"
 #include "lldrawpoolwater.h"
+#include "threadpool.h"
 
 //-----------------------------------------------------------------------------------
 //static variables definitions
@@ -102,6 +103,7 @@ U8* get_box_fan_indices_ptr(LLCamera* camera, const LLVector4a& center)
     return (U8*) (sOcclusionIndices+cypher*8);
 }
 
+#ifndef LL_TEST
 //create a vertex buffer for efficiently rendering cubes
 LLVertexBuffer* ll_create_cube_vb(U32 type_mask)
 {
@@ -133,6 +135,7 @@ LLVertexBuffer* ll_create_cube_vb(U32 type_mask)
 
     return ret;
 }
+#endif // LL_TEST
 
 
 #define LL_TRACK_PENDING_OCCLUSION_QUERIES 0
@@ -790,6 +793,7 @@ void LLViewerOctreeGroup::checkStates()
 //-------------------------------------------------------------------------------------------
 //occulsion culling functions and classes
 //-------------------------------------------------------------------------------------------
+#ifndef LL_TEST
 std::set<U32> LLOcclusionCullingGroup::sPendingQueries;
 
 static std::queue<GLuint> sFreeQueries;
@@ -1300,6 +1304,7 @@ void LLOcclusionCullingGroup::doOcclusion(LLCamera* camera, const LLVector4a* sh
         }
     }
 }
+#endif // LL_TEST
 //-------------------------------------------------------------------------------------------
 //end of occulsion culling functions and classes
 //-------------------------------------------------------------------------------------------
@@ -1361,7 +1366,7 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
     if (mRes == 2 ||
         (mRes && group->hasState(LLViewerOctreeGroup::SKIP_FRUSTUM_CHECK)))
     {   //fully in, just add everything
-        OctreeTraveler::traverse(n);
+        traverseChildren(n);
     }
     else
     {
@@ -1369,13 +1374,209 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
 
         if (mRes)
         { //at least partially in, run on down
-            OctreeTraveler::traverse(n);
+            traverseChildren(n);
         }
 
         mRes = 0;
     }
 }
 
+//same as OctreeTraveler::traverse(n), except that the children of a node
+//that is partially in are frustum checked together before going down.
+void LLViewerOctreeCull::traverseChildren(const OctreeNode* n)
+{
+    n->accept(this);
+
+    const U32 count = n->getChildCount();
+    if (mRes == 2 || count < 2)
+    {
+        //children inherit the result, or the only child may skip its check
+        for (U32 i = 0; i < count; i++)
+        {
+            traverse(n->getChild(i));
+        }
+        return;
+    }
+
+    //a node with more than one child never has SKIP_FRUSTUM_CHECK set on its
+    //children, so each of them needs the frustum check traverse() would do.
+    S32 results[8]; //an octree node has at most 8 children
+    llassert(count <= 8);
+    frustumCheckChildren(n, results);
+
+    for (U32 i = 0; i < count; i++)
+    {
+        const OctreeNode* child = n->getChild(i);
+        LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) child->getListener(0);
+
+        if (earlyFail(group))
+        {
+            continue;
+        }
+
+        mRes = results[i];
+        if (mRes)
+        { //at least partially in, run on down
+            traverseChildren(child);
+        }
+
+        mRes = 0;
+    }
+}
+
+void LLViewerOctreeCull::gather(const OctreeNode* n)
+{
+    mRecords.clear();
+    gatherNode(n, frustumCheck((LLViewerOctreeGroup*) n->getListener(0)));
+}
+
+//mirrors traverse() and traverseChildren() minus earlyFail(), replay() calls that
+void LLViewerOctreeCull::gatherNode(const OctreeNode* n, S32 res)
+{
+    const size_t index = mRecords.size();
+    mRecords.push_back({ n, 0, res, 1 });
+
+    if (res)
+    {
+        const U32 count = n->getChildCount();
+        if (res == 1 && count > 0 && n->getElementCount() > 0)
+        {
+            mRecords[index].mObjectsRes = frustumCheckObjects((LLViewerOctreeGroup*) n->getListener(0));
+        }
+
+        if (res == 2)
+        {
+            for (U32 i = 0; i < count; i++)
+            {
+                gatherNode(n->getChild(i), 2);
+            }
+        }
+        else if (count == 1)
+        {
+            const OctreeNode* child = n->getChild(0);
+            LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) child->getListener(0);
+            gatherNode(child, group->hasState(LLViewerOctreeGroup::SKIP_FRUSTUM_CHECK) ? res : frustumCheck(group));
+        }
+        else if (count > 1)
+        {
+            S32 results[8]; //an octree node has at most 8 children
+            llassert(count <= 8);
+            frustumCheckChildren(n, results);
+            for (U32 i = 0; i < count; i++)
+            {
+                gatherNode(n->getChild(i), results[i]);
+            }
+        }
+    }
+
+    mRecords[index].mSubtreeSize = (U32)(mRecords.size() - index - 1);
+}
+
+//static
+void LLViewerOctreeCull::traverseParallel(const cull_list_t& culls)
+{
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("cull gather");
+        LL::parallel_for("FrameTasks", culls.size(), [&culls](size_t i)
+            {
+                LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("cull gather job");
+                culls[i].first->gather(culls[i].second);
+            });
+    }
+
+    LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("cull replay");
+    for (const cull_list_t::value_type& cull : culls)
+    {
+        cull.first->replay();
+    }
+}
+
+void LLViewerOctreeCull::replay()
+{
+    for (size_t i = 0; i < mRecords.size(); )
+    {
+        i = replayNode(i);
+    }
+    mRecords.clear();
+}
+
+size_t LLViewerOctreeCull::replayNode(size_t index)
+{
+    const CullRecord& record = mRecords[index];
+    const size_t end = index + 1 + record.mSubtreeSize;
+
+    if (earlyFail((LLViewerOctreeGroup*) record.mNode->getListener(0)) || !record.mRes)
+    {
+        return end;
+    }
+
+    mRes = record.mRes;
+    mReplayRecord = &record;
+    record.mNode->accept(this);
+    mReplayRecord = NULL;
+
+    for (size_t i = index + 1; i < end; )
+    {
+        i = replayNode(i);
+    }
+
+    mRes = 0;
+    return end;
+}
+
+//virtual
+void LLViewerOctreeCull::frustumCheckChildren(const OctreeNode* n, S32* results)
+{
+    for (U32 i = 0; i < n->getChildCount(); i++)
+    {
+        results[i] = frustumCheck((LLViewerOctreeGroup*) n->getChild(i)->getListener(0));
+    }
+}
+
+//gathers the bounds of the children into LLCameraAABB4 four at a time
+template <typename T>
+void LLViewerOctreeCull::batchCheckChildren(const OctreeNode* n, S32* results, T check)
+{
+    const U32 count = n->getChildCount();
+    for (U32 i = 0; i < count; i += LLCameraAABB4::NUM_BOXES)
+    {
+        LLCameraAABB4 boxes;
+        const U32 num = llmin(count - i, (U32)LLCameraAABB4::NUM_BOXES);
+        for (U32 j = 0; j < num; j++)
+        {
+            const LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) n->getChild(i + j)->getListener(0);
+            boxes.set(j, group->mBounds[0], group->mBounds[1]);
+        }
+
+        S32 batch_results[LLCameraAABB4::NUM_BOXES];
+        check(boxes, batch_results);
+        for (U32 j = 0; j < num; j++)
+        {
+            results[i + j] = batch_results[j];
+        }
+    }
+}
+
+void LLViewerOctreeCull::AABBInFrustumNoFarClipChildBounds(const OctreeNode* n, S32* results)
+{
+    batchCheckChildren(n, results, [this](const LLCameraAABB4& boxes, S32* res) { mCamera->AABBInFrustumNoFarClip4(boxes, res); });
+}
+
+void LLViewerOctreeCull::AABBInFrustumChildBounds(const OctreeNode* n, S32* results)
+{
+    batchCheckChildren(n, results, [this](const LLCameraAABB4& boxes, S32* res) { mCamera->AABBInFrustum4(boxes, res); });
+}
+
+void LLViewerOctreeCull::AABBInRegionFrustumNoFarClipChildBounds(const OctreeNode* n, S32* results)
+{
+    batchCheckChildren(n, results, [this](const LLCameraAABB4& boxes, S32* res) { mCamera->AABBInRegionFrustumNoFarClip4(boxes, res); });
+}
+
+void LLViewerOctreeCull::AABBInRegionFrustumChildBounds(const OctreeNode* n, S32* results)
+{
+    batchCheckChildren(n, results, [this](const LLCameraAABB4& boxes, S32* res) { mCamera->AABBInRegionFrustum4(boxes, res); });
+}
+
 //------------------------------------------
 //agent space group culling
 S32 LLViewerOctreeCull::AABBInFrustumNoFarClipGroupBounds(const LLViewerOctreeGroup* group)
@@ -1482,7 +1683,7 @@ bool LLViewerOctreeCull::checkObjects(const OctreeNode* branch, const LLViewerOc
     {
         return true;
     }
-    else if (mRes == 1 && !frustumCheckObjects(group)) //no objects in frustum
+    else if (mRes == 1 && !(mReplayRecord ? mReplayRecord->mObjectsRes : frustumCheckObjects(group))) //no objects in frustum
     {
         return false;
     }
@@ -370,10 +370,24 @@ class LLViewerOctreeCull : public OctreeTraveler
 {
 public:
     LLViewerOctreeCull(LLCamera* camera)
-        : mCamera(camera), mRes(0) { }
+        : mCamera(camera), mRes(0), mReplayRecord(NULL) { }
+    virtual ~LLViewerOctreeCull() {}
 
     virtual void traverse(const OctreeNode* n);
 
+    //traverse() in two steps. gather() does all the frustum checks and may run
+    //off the main thread, it only reads the octree bounds and the camera.
+    //Neither may change until replay() has done everything else traverse()
+    //would do, in the same order, on the main thread.
+    void gather(const OctreeNode* n);
+    void replay();
+
+    //traverse() of every culler on its octree. The gather() passes run at once
+    //on the "FrameTasks" thread pool, the replay() passes run here in list
+    //order, so the result is the same as traversing them one after the other.
+    typedef std::vector<std::pair<LLViewerOctreeCull*, const OctreeNode*> > cull_list_t;
+    static void traverseParallel(const cull_list_t& culls);
+
 protected:
     virtual bool earlyFail(LLViewerOctreeGroup* group);
 
@@ -397,8 +411,18 @@ protected:
     S32 AABBInRegionFrustumObjectBounds(const LLViewerOctreeGroup* group);
     S32 AABBRegionSphereIntersectObjectExtents(const LLViewerOctreeGroup* group, const LLVector3& shift);
 
+    //group cull of all the children of a node, four boxes at a time.
+    //results[i] is what the single group version returns for child i.
+    void AABBInFrustumNoFarClipChildBounds(const OctreeNode* n, S32* results);
+    void AABBInFrustumChildBounds(const OctreeNode* n, S32* results);
+    void AABBInRegionFrustumNoFarClipChildBounds(const OctreeNode* n, S32* results);
+    void AABBInRegionFrustumChildBounds(const OctreeNode* n, S32* results);
+
     virtual S32 frustumCheck(const LLViewerOctreeGroup* group) = 0;
     virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group) = 0;
+    //frustumCheck() of every child of a node, called before any of them is
+    //traversed. Override with the batched tests above where possible.
+    virtual void frustumCheckChildren(const OctreeNode* n, S32* results);
 
     bool checkProjectionArea(const LLVector4a& center, const LLVector4a& size, const LLVector3& shift, F32 pixel_threshold, F32 near_radius);
     virtual bool checkObjects(const OctreeNode* branch, const LLViewerOctreeGroup* group);
@@ -406,9 +430,29 @@ protected:
     virtual void processGroup(LLViewerOctreeGroup* group);
     virtual void visit(const OctreeNode* branch);
 
+private:
+    //a node reached by gather(), in traversal order
+    struct CullRecord
+    {
+        const OctreeNode* mNode;
+        U32 mSubtreeSize;   //number of records below this one
+        S32 mRes;           //frustumCheck() result, or the one inherited from the parent
+        S32 mObjectsRes;    //frustumCheckObjects() result if checkObjects() needs it
+    };
+
+    void traverseChildren(const OctreeNode* n);
+    void gatherNode(const OctreeNode* n, S32 res);
+    size_t replayNode(size_t index);
+    template <typename T>
+    void batchCheckChildren(const OctreeNode* n, S32* results, T check);
+
 protected:
     LLCamera *mCamera;
     S32 mRes;
+
+private:
+    std::vector<CullRecord> mRecords;
+    const CullRecord* mReplayRecord;
 };
 
 //scan the octree, output the info of each node for debug use.
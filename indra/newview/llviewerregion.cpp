@@ -37,6 +37,7 @@
 #include "llregionflags.h"
 #include "llregionhandle.h"
 #include "llsurface.h"
+#include "llmessagedecoders.h"
 #include "message.h"
 //#include "vmath.h"
 #include "v3math.h"
@@ -730,6 +731,7 @@ LLViewerRegion::~LLViewerRegion()
     mImpl->mWaitingSet.clear();
 
     gVLManager.cleanupData(this);
+    gObjectList.cleanupPendingUpdates(this);
     // Can't do this on destruction, because the neighbor pointers might be invalid.
     // This should be reference counted...
     disconnectAllNeighbors();
@@ -2320,28 +2322,35 @@ void LLViewerRegion::updateCoarseLocations(LLMessageSystem* msg)
     mMapAvatars.clear();
     mMapAvatarIDs.clear(); // only matters in a rare case but it's good to be safe.
 
+    LLMessageDecoders::CoarseLocationUpdate coarse;
+    if (!coarse.decode(msg))
+    {
+        LL_WARNS("Messaging") << "Malformed coarse location update" << LL_ENDL;
+        return;
+    }
+
     U8 x_pos = 0;
     U8 y_pos = 0;
     U8 z_pos = 0;
 
     U32 pos = 0x0;
 
-    S16 agent_index;
-    S16 target_index;
-    msg->getS16Fast(_PREHASH_Index, _PREHASH_You, agent_index);
-    msg->getS16Fast(_PREHASH_Index, _PREHASH_Prey, target_index);
+    S16 agent_index = coarse.getIndex().getYou();
+    S16 target_index = coarse.getIndex().getPrey();
+    S32 agent_count = coarse.getNumberOfAgentDataBlocks();
+    S32 count = coarse.getNumberOfLocationBlocks();
 
-    bool has_agent_data = msg->has(_PREHASH_AgentData);
-    S32 count = msg->getNumberOfBlocksFast(_PREHASH_Location);
+    bool has_agent_data = agent_count > 0;
     for(S32 i = 0; i < count; i++)
     {
-        msg->getU8Fast(_PREHASH_Location, _PREHASH_X, x_pos, i);
-        msg->getU8Fast(_PREHASH_Location, _PREHASH_Y, y_pos, i);
-        msg->getU8Fast(_PREHASH_Location, _PREHASH_Z, z_pos, i);
+        const LLMessageDecoders::CoarseLocationUpdate::LocationBlock& location = coarse.getLocation(i);
+        x_pos = location.getX();
+        y_pos = location.getY();
+        z_pos = location.getZ();
         LLUUID agent_id = LLUUID::null;
-        if(has_agent_data)
+        if(has_agent_data && i < agent_count)
         {
-            msg->getUUIDFast(_PREHASH_AgentData, _PREHASH_AgentID, agent_id, i);
+            agent_id = coarse.getAgentData(i).getAgentID();
         }
 
         //LL_INFOS() << "  object X: " << (S32)x_pos << " Y: " << (S32)y_pos
@@ -52,6 +52,8 @@
 #include "llcallingcard.h"      // IDEVO for LLAvatarTracker
 #include "lldrawpoolavatar.h"
 #include "lldriverparam.h"
+#include "llpolymesh.h"
+#include "llpolymorph.h"
 #include "llpolyskeletaldistortion.h"
 #include "lleditingmotion.h"
 #include "llemote.h"
@@ -114,6 +116,7 @@
 #include "llskinningutil.h"
 
 #include "llperfstats.h"
+#include "threadpool.h"
 
 #include <boost/lexical_cast.hpp>
 
@@ -594,6 +597,8 @@ bool LLVOAvatar::sLimitNonImpostors = false; // True unless RenderAvatarMaxNonIm
 F32 LLVOAvatar::sRenderDistance = 256.f;
 S32 LLVOAvatar::sNumVisibleAvatars = 0;
 S32 LLVOAvatar::sNumLODChangesThisFrame = 0;
+bool LLVOAvatar::sDeferPoses = false;
+std::vector<LLPointer<LLVOAvatar> > LLVOAvatar::sDeferredPoseAvatars;
 
 const LLUUID LLVOAvatar::sStepSoundOnLand("e8af4a28-aa83-4310-a7c4-c047e15ea0df");
 const LLUUID LLVOAvatar::sStepSounds[LL_MCODE_END] =
@@ -672,6 +677,7 @@ LLVOAvatar::LLVOAvatar(const LLUUID& id,
     mCulled( false ),
     mVisibilityRank(0),
     mNeedsSkin(false),
+    mDeferredDetailedUpdate(false),
     mLastSkinTime(0.f),
     mUpdatePeriod(1),
     mOverallAppearance(AOA_INVISIBLE),
@@ -2567,14 +2573,14 @@ void LLVOAvatar::updateMeshData()
 // LLVOAvatar::processUpdateMessage()
 //------------------------------------------------------------------------
 U32 LLVOAvatar::processUpdateMessage(LLMessageSystem *mesgsys,
-                                     void **user_data,
+                                     const LLObjectUpdateInfo* info,
                                      U32 block_num, const EObjectUpdateType update_type,
                                      LLDataPacker *dp)
 {
     const bool had_no_name = !getNVPair("FirstName");
 
     // Do base class updates...
-    U32 retval = LLViewerObject::processUpdateMessage(mesgsys, user_data, block_num, update_type, dp);
+    U32 retval = LLViewerObject::processUpdateMessage(mesgsys, info, block_num, update_type, dp);
 
     // Print out arrival information once we have name of avatar.
     const bool has_name = getNVPair("FirstName");
@@ -2834,8 +2840,23 @@ void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
     // animate the character
     // store off last frame's root position to be consistent with camera position
     mLastRootPos = mRoot->getWorldPosition();
+    mMotionController.setDeferPose(sDeferPoses && !isSelf());
     bool detailed_update = updateCharacter(agent);
+    mMotionController.setDeferPose(false);
 
+    if (mMotionController.hasDeferredPose())
+    {
+        // the rest needs the new pose, see updateDeferredPoses()
+        mDeferredDetailedUpdate = detailed_update;
+        sDeferredPoseAvatars.push_back(this);
+        return;
+    }
+
+    finishIdleUpdate(detailed_update);
+}
+
+void LLVOAvatar::finishIdleUpdate(bool detailed_update)
+{
     static LLUICachedControl<bool> visualizers_in_calls("ShowVoiceVisualizersInCalls", false);
     bool voice_enabled = (visualizers_in_calls || LLVoiceClient::getInstance()->inProximalChannel()) &&
                          LLVoiceClient::getInstance()->getVoiceEnabled(mID);
@@ -2977,7 +2998,7 @@ void LLVOAvatar::idleUpdateVoiceVisualizer(bool voice_enabled, const LLVector3 &
                     if( mAahMorph ) mAahMorph->setWeight(mAahMorph->getMinWeight());
 
                     mLipSyncActive = false;
-                    LLCharacter::updateVisualParams();
+                    LLAvatarAppearance::updateVisualParams();
                     dirtyMesh();
                 }
             }
@@ -3246,7 +3267,7 @@ void LLVOAvatar::idleUpdateLipSync(bool voice_enabled)
         }
 
         mLipSyncActive = true;
-        LLCharacter::updateVisualParams();
+        LLAvatarAppearance::updateVisualParams();
         dirtyMesh();
     }
 }
@@ -4900,6 +4921,20 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
         }
     }
 
+    if (mMotionController.hasDeferredPose())
+    {
+        // mRoot is not animated, so placing it before the pose is blended
+        // makes no difference
+        return visible;
+    }
+
+    finishCharacterUpdate(visible);
+
+    return visible;
+}
+
+void LLVOAvatar::finishCharacterUpdate(bool visible)
+{
     // update head position
     updateHeadOffset();
 
@@ -4914,8 +4949,50 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
         // System avatar mesh vertices need to be reskinned.
         mNeedsSkin = true;
     }
+}
 
-    return visible;
+//static
+void LLVOAvatar::setDeferPoses(bool defer)
+{
+    sDeferPoses = defer;
+}
+
+//static
+void LLVOAvatar::updateDeferredPoses()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    sDeferPoses = false;
+    if (sDeferredPoseAvatars.empty())
+    {
+        return;
+    }
+
+    std::vector<LLPointer<LLVOAvatar> > avatars;
+    avatars.swap(sDeferredPoseAvatars);
+
+    // Blending a pose and updating the world matrices only touch the joints
+    // of that one avatar, so every avatar ends up the same as when updated
+    // serially.
+    LL::parallel_for("FrameTasks", avatars.size(), [&avatars](size_t i)
+        {
+            LL_PROFILE_ZONE_NAMED_CATEGORY_AVATAR("avatar pose job");
+            LLVOAvatar* avatar = avatars[i];
+            if (!avatar->isDead())
+            {
+                avatar->mMotionController.applyDeferredPose();
+                avatar->mRoot->updateWorldMatrixChildren();
+            }
+        });
+
+    // the rest of each update, in the order the avatars were updated
+    for (LLVOAvatar* avatar : avatars)
+    {
+        if (!avatar->isDead())
+        {
+            avatar->finishCharacterUpdate(avatar->mDeferredDetailedUpdate);
+            avatar->finishIdleUpdate(avatar->mDeferredDetailedUpdate);
+        }
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -7210,7 +7287,7 @@ void LLVOAvatar::updateVisualParams()
         }
     }
 
-    LLCharacter::updateVisualParams();
+    LLAvatarAppearance::updateVisualParams();
 
     if (mLastSkeletonSerialNum != mSkeletonSerialNum)
     {
@@ -7223,6 +7300,81 @@ void LLVOAvatar::updateVisualParams()
     updateHeadOffset();
 }
 
+void LLVOAvatar::benchmarkMorphs(S32 rounds)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    typedef std::vector<std::pair<LLVisualParam*, F32> > weights_t;
+    weights_t saved;
+    for (LLVisualParam* param = getFirstVisualParam(); param; param = getNextVisualParam())
+    {
+        if (dynamic_cast<LLPolyMorphTarget*>(param) && !param->isAnimating())
+        {
+            saved.emplace_back(param, param->getWeight());
+        }
+    }
+
+    std::vector<LLPolyMesh*> meshes;
+    for (polymesh_map_t::value_type& mesh_pair : mPolyMeshes)
+    {
+        if (!mesh_pair.second->isLOD())
+        {
+            meshes.push_back(mesh_pair.second);
+        }
+    }
+
+    const bool batch_morphs = sBatchMorphs;
+    rounds = llmax(1, rounds);
+    F64 seconds[2] = { 0.0, 0.0 };
+    std::vector<LLVector4a> normals[2];
+    for (S32 batched = 0; batched < 2; ++batched)
+    {
+        sBatchMorphs = batched != 0;
+        LLTimer timer;
+        for (S32 round = 0; round < rounds; ++round)
+        {
+            for (weights_t::value_type& param_weight : saved)
+            {
+                param_weight.first->setWeight(param_weight.first->getMinWeight());
+            }
+            LLAvatarAppearance::updateVisualParams();
+            for (weights_t::value_type& param_weight : saved)
+            {
+                param_weight.first->setWeight(param_weight.first->getMaxWeight());
+            }
+            LLAvatarAppearance::updateVisualParams();
+        }
+        seconds[batched] = timer.getElapsedTimeF64();
+
+        // both ways must leave the same normals at the same weights, give
+        // or take what the extra rounds added up in rounding
+        for (LLPolyMesh* mesh : meshes)
+        {
+            normals[batched].insert(normals[batched].end(), mesh->getNormals(), mesh->getNormals() + mesh->getNumVertices());
+        }
+    }
+    sBatchMorphs = batch_morphs;
+
+    for (weights_t::value_type& param_weight : saved)
+    {
+        param_weight.first->setWeight(param_weight.second);
+    }
+    updateVisualParams();
+
+    LL_INFOS("Avatar") << "Morph benchmark: " << saved.size() << " morphs on " << meshes.size() << " meshes, "
+                       << rounds << " rounds: one at a time " << seconds[0] << "s, batched " << seconds[1] << "s" << LL_ENDL;
+    for (size_t i = 0; i < normals[0].size(); ++i)
+    {
+        LLVector4a diff;
+        diff.setSub(normals[0][i], normals[1][i]);
+        if (diff.dot3(diff).getF32() > 1.e-6f)
+        {
+            LL_WARNS("Avatar") << "Morph benchmark: batched morphs left different normals" << LL_ENDL;
+            break;
+        }
+    }
+}
+
 void LLVOAvatar::setCorrectedPixelArea(F32 area)
 {
     // We always want to look good to ourselves
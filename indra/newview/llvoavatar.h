@@ -127,7 +127,7 @@ public:
     /*virtual*/ LLVOAvatar*     asAvatar();
 
     virtual U32                 processUpdateMessage(LLMessageSystem *mesgsys,
-                                                     void **user_data,
+                                                     const LLObjectUpdateInfo* info,
                                                      U32 block_num,
                                                      const EObjectUpdateType update_type,
                                                      LLDataPacker *dp);
@@ -241,6 +241,11 @@ public:
     /*virtual*/ LLVector3       getPosAgentFromGlobal(const LLVector3d &position);
     virtual void                updateVisualParams();
 
+    // Sets every morph of this avatar to its minimum and then its maximum
+    // weight rounds times, with and without morph batching, logs how long
+    // each took and puts the weights back.
+    void                        benchmarkMorphs(S32 rounds);
+
 /**                    Inherited
  **                                                                            **
  *******************************************************************************/
@@ -279,6 +284,15 @@ public:
     void            updateOrientation(LLAgent &agent, F32 speed, F32 delta_time);
     void            updateTimeStep();
     void            updateRootPositionAndRotation(LLAgent &agent, F32 speed, bool was_sit_ground_constrained);
+    void            finishCharacterUpdate(bool visible);
+
+    // LLViewerObjectList::update() sets this around its idleUpdate() loop.
+    // Avatars other than self then leave blending their pose, updating their
+    // skeleton and everything after that in idleUpdate() to
+    // updateDeferredPoses(), which does the first two for all of them at once
+    // on the FrameTasks thread pool.
+    static void     setDeferPoses(bool defer);
+    static void     updateDeferredPoses();
 
     void            idleUpdateVoiceVisualizer(bool voice_enabled, const LLVector3 &position);
     void            idleUpdateMisc(bool detailed_update);
@@ -297,6 +311,7 @@ public:
     void            addNameTagLine(const std::string& line, const LLColor4& color, S32 style, const LLFontGL* font, const bool use_ellipses = false);
     void            idleUpdateRenderComplexity();
     void            idleUpdateDebugInfo();
+    void            finishIdleUpdate(bool detailed_update);
     void            accountRenderComplexityForObject(LLViewerObject *attached_object,
                                                      const F32 max_attachment_complexity,
                                                      LLVOVolume::texture_cost_t& textures,
@@ -363,6 +378,8 @@ public:
     static bool     sShowCollisionVolumes;  // show skeletal collision volumes
     static bool     sVisibleInFirstPerson;
     static S32      sNumLODChangesThisFrame;
+    static bool     sDeferPoses;
+    static std::vector<LLPointer<LLVOAvatar> > sDeferredPoseAvatars;
     static S32      sNumVisibleChatBubbles;
     static bool     sDebugInvisible;
     static bool     sShowAttachmentPoints;
@@ -563,6 +580,7 @@ private:
     bool        shouldAlphaMask();
 
     bool        mNeedsSkin; // avatar has been animated and verts have not been updated
+    bool        mDeferredDetailedUpdate; // what updateCharacter() returned when its pose was deferred
     F32         mLastSkinTime; //value of gFrameTimeSeconds at last skin update
 
     S32         mUpdatePeriod;
@@ -34,6 +34,7 @@
 #include "llagentcamera.h"
 #include "llsdserialize.h"
 #include "llworld.h" // For LLWorld::getInstance()
+#include "workqueue.h"
 //static variables
 U32 LLVOCacheEntry::sMinFrameRange = 0;
 F32 LLVOCacheEntry::sNearRadius = 1.0f;
@@ -55,6 +56,77 @@ bool check_write(LLAPRFile* apr_file, void* src, S32 n_bytes)
     return apr_file->write(src, n_bytes) == n_bytes ;
 }
 
+namespace
+{
+    // Writes to a temporary file and renames it over filename, so a reader
+    // never sees a half written cache file. Safe to call off the main thread.
+    bool write_file_atomically(const std::string& filename, const void* data, size_t size)
+    {
+        const std::string temp_filename = filename + ".tmp";
+        LLFILE* fp = LLFile::fopen(temp_filename, "wb");
+        if (!fp)
+        {
+            return false;
+        }
+        bool success = fwrite(data, 1, size, fp) == size;
+        success = (fclose(fp) == 0) && success;
+        if (success)
+        {
+            success = LLFile::replace(temp_filename, filename) == 0;
+        }
+        if (!success)
+        {
+            LLFile::remove(temp_filename, ENOENT);
+        }
+        return success;
+    }
+
+    // Deep copy that shares no LLSD::Impl with sd (llsd_clone() shares
+    // scalars), so the copy can be handed to another thread.
+    LLSD unshared_llsd_copy(const LLSD& sd)
+    {
+        switch (sd.type())
+        {
+        case LLSD::TypeBoolean:
+            return LLSD(sd.asBoolean());
+        case LLSD::TypeInteger:
+            return LLSD(sd.asInteger());
+        case LLSD::TypeReal:
+            return LLSD(sd.asReal());
+        case LLSD::TypeString:
+            return LLSD(std::string(sd.asStringRef()));
+        case LLSD::TypeUUID:
+            return LLSD(sd.asUUID());
+        case LLSD::TypeDate:
+            return LLSD(sd.asDate());
+        case LLSD::TypeURI:
+            return LLSD(sd.asURI());
+        case LLSD::TypeBinary:
+            return LLSD(sd.asBinary());
+        case LLSD::TypeMap:
+        {
+            LLSD copy = LLSD::emptyMap();
+            for (LLSD::map_const_iterator it = sd.beginMap(); it != sd.endMap(); ++it)
+            {
+                copy[it->first] = unshared_llsd_copy(it->second);
+            }
+            return copy;
+        }
+        case LLSD::TypeArray:
+        {
+            LLSD copy = LLSD::emptyArray();
+            for (const LLSD& item : llsd::inArray(sd))
+            {
+                copy.append(unshared_llsd_copy(item));
+            }
+            return copy;
+        }
+        default:
+            return LLSD();
+        }
+    }
+}
+
 // Material Override Cache needs a version label, so we can upgrade this later.
 const std::string LLGLTFOverrideCacheEntry::VERSION_LABEL = {"GLTFCacheVer"};
 const int LLGLTFOverrideCacheEntry::VERSION = 1;
@@ -163,6 +235,8 @@ LLVOCacheEntry::LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &
     mHitCount(0),
     mDupeCount(0),
     mCRCChangeCount(0),
+    mMappedOffset(0),
+    mMappedSize(0),
     mState(INACTIVE),
     mSceneContrib(0.f),
     mValid(true),
@@ -183,6 +257,8 @@ LLVOCacheEntry::LLVOCacheEntry()
     mDupeCount(0),
     mCRCChangeCount(0),
     mBuffer(NULL),
+    mMappedOffset(0),
+    mMappedSize(0),
     mState(INACTIVE),
     mSceneContrib(0.f),
     mValid(true),
@@ -192,75 +268,32 @@ LLVOCacheEntry::LLVOCacheEntry()
     mDP.assignBuffer(mBuffer, 0);
 }
 
-LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
+LLVOCacheEntry::LLVOCacheEntry(const U8* header, LLVOCacheMappedFile* file, size_t offset, S32 size)
 :   LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY),
-    mBuffer(NULL),
     mUpdateFlags(-1),
+    mBuffer(NULL),
+    mMappedFile(file),
+    mMappedOffset(offset),
+    mMappedSize(size),
     mState(INACTIVE),
     mSceneContrib(0.f),
     mValid(false),
     mParentID(0),
     mBSphereRadius(-1.0f)
 {
-    S32 size = -1;
-    bool success;
-    static U8 data_buffer[ENTRY_HEADER_SIZE];
-
     mDP.assignBuffer(mBuffer, 0);
+    mMappedFile->mEntries.insert(this);
 
-    success = check_read(apr_file, (void *)data_buffer, ENTRY_HEADER_SIZE);
-    if (success)
-    {
-        memcpy(&mLocalID, data_buffer, sizeof(U32));
-        memcpy(&mCRC, data_buffer + sizeof(U32), sizeof(U32));
-        memcpy(&mHitCount, data_buffer + (2 * sizeof(U32)), sizeof(S32));
-        memcpy(&mDupeCount, data_buffer + (3 * sizeof(U32)), sizeof(S32));
-        memcpy(&mCRCChangeCount, data_buffer + (4 * sizeof(U32)), sizeof(S32));
-        memcpy(&size, data_buffer + (5 * sizeof(U32)), sizeof(S32));
-
-        // Corruption in the cache entries
-        if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1))
-        {
-            // We've got a bogus size, skip reading it.
-            // We won't bother seeking, because the rest of this file
-            // is likely bogus, and will be tossed anyway.
-            LL_WARNS() << "Bogus cache entry, size " << size << ", aborting!" << LL_ENDL;
-            success = false;
-        }
-    }
-    if(success && size > 0)
-    {
-        mBuffer = new U8[size];
-        success = check_read(apr_file, mBuffer, size);
-
-        if(success)
-        {
-            mDP.assignBuffer(mBuffer, size);
-        }
-        else
-        {
-            // Improve logging around vocache
-            LL_WARNS() << "Error loading cache entry for " << mLocalID << ", size " << size << " aborting!" << LL_ENDL;
-            delete[] mBuffer ;
-            mBuffer = NULL ;
-        }
-    }
-
-    if(!success)
-    {
-        mLocalID = 0;
-        mCRC = 0;
-        mHitCount = 0;
-        mDupeCount = 0;
-        mCRCChangeCount = 0;
-        mBuffer = NULL;
-        mEntry = NULL;
-        mState = INACTIVE;
-    }
+    memcpy(&mLocalID, header, sizeof(U32));
+    memcpy(&mCRC, header + sizeof(U32), sizeof(U32));
+    memcpy(&mHitCount, header + (2 * sizeof(U32)), sizeof(S32));
+    memcpy(&mDupeCount, header + (3 * sizeof(U32)), sizeof(S32));
+    memcpy(&mCRCChangeCount, header + (4 * sizeof(U32)), sizeof(S32));
 }
 
 LLVOCacheEntry::~LLVOCacheEntry()
 {
+    releaseMappedFile();
     mDP.freeBuffer();
 }
 
@@ -273,6 +306,7 @@ void LLVOCacheEntry::updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp)
     }
 
     mDP.freeBuffer();
+    releaseMappedFile();
 
     llassert_always(dp.getBufferSize() > 0);
     mBuffer = new U8[dp.getBufferSize()];
@@ -280,6 +314,27 @@ void LLVOCacheEntry::updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp)
     mDP = dp;
 }
 
+// Copy the entry's data out of the region file it was read from
+void LLVOCacheEntry::loadMappedData()
+{
+    llassert(mMappedFile.notNull() && !mBuffer);
+
+    mBuffer = new U8[mMappedSize];
+    memcpy(mBuffer, mMappedFile->getData() + mMappedOffset, mMappedSize);
+    mDP.assignBuffer(mBuffer, mMappedSize);
+
+    releaseMappedFile();
+}
+
+void LLVOCacheEntry::releaseMappedFile()
+{
+    if (mMappedFile.notNull())
+    {
+        mMappedFile->mEntries.erase(this);
+        mMappedFile = NULL;
+    }
+}
+
 void LLVOCacheEntry::setParentID(U32 id)
 {
     if(mParentID != id)
@@ -308,10 +363,11 @@ void LLVOCacheEntry::removeAllChildren()
 //virtual
 void LLVOCacheEntry::setOctreeEntry(LLViewerOctreeEntry* entry)
 {
-    if(!entry && mDP.getBufferSize() > 0)
+    LLDataPackerBinaryBuffer* dp = entry ? NULL : getDP();
+    if(dp)
     {
         LLUUID fullid;
-        LLViewerObject::unpackUUID(&mDP, fullid, "ID");
+        LLViewerObject::unpackUUID(dp, fullid, "ID");
 
         LLViewerObject* obj = gObjectList.findObject(fullid);
         if(obj && obj->mDrawable)
@@ -405,6 +461,11 @@ LLVOCacheEntry* LLVOCacheEntry::getChild()
 
 LLDataPackerBinaryBuffer *LLVOCacheEntry::getDP()
 {
+    if (mMappedFile.notNull())
+    {
+        loadMappedData();
+    }
+
     if (mDP.getBufferSize() == 0)
     {
         //LL_INFOS() << "Not getting cache entry, invalid!" << LL_ENDL;
@@ -430,9 +491,15 @@ void LLVOCacheEntry::dump() const
         << LL_ENDL;
 }
 
-S32 LLVOCacheEntry::writeToBuffer(U8 *data_buffer) const
+S32 LLVOCacheEntry::getDataSize() const
 {
-    S32 size = mDP.getBufferSize();
+    return mMappedFile.notNull() ? mMappedSize : mDP.getBufferSize();
+}
+
+// The entry's record in the index at the start of the region file
+S32 LLVOCacheEntry::writeHeaderToBuffer(U8 *data_buffer) const
+{
+    S32 size = getDataSize();
 
     if (size > MAX_ENTRY_BODY_SIZE)
     {
@@ -446,9 +513,18 @@ S32 LLVOCacheEntry::writeToBuffer(U8 *data_buffer) const
     memcpy(data_buffer + (3 * sizeof(U32)), &mDupeCount, sizeof(S32));
     memcpy(data_buffer + (4 * sizeof(U32)), &mCRCChangeCount, sizeof(S32));
     memcpy(data_buffer + (5 * sizeof(U32)), &size, sizeof(S32));
-    memcpy(data_buffer + ENTRY_HEADER_SIZE, (void*)mBuffer, size);
 
-    return ENTRY_HEADER_SIZE + size;
+    return ENTRY_HEADER_SIZE;
+}
+
+// Entries that were never used are written straight from the old file
+S32 LLVOCacheEntry::writeDataToBuffer(U8 *data_buffer) const
+{
+    S32 size = getDataSize();
+    const U8* data = mMappedFile.notNull() ? mMappedFile->getData() + mMappedOffset : mBuffer;
+    memcpy(data_buffer, data, size);
+
+    return size;
 }
 
 #ifndef LL_TEST
@@ -825,6 +901,22 @@ public:
         return res;
     }
 
+    virtual void frustumCheckChildren(const OctreeNode* n, S32* results)
+    {
+#if 0
+        AABBInRegionFrustumChildBounds(n, results);
+#else
+        AABBInRegionFrustumNoFarClipChildBounds(n, results);
+        for (U32 i = 0; i < n->getChildCount(); i++)
+        {
+            if (results[i] != 0)
+            {
+                results[i] = llmin(results[i], AABBRegionSphereIntersectGroupExtents((LLViewerOctreeGroup*)n->getChild(i)->getListener(0), mLocalShift));
+            }
+        }
+#endif
+    }
+
     virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group)
     {
 #if 0
@@ -993,28 +1085,41 @@ void LLVOCachePartition::selectBackObjects(LLCamera &camera, F32 pixel_threshold
 
 #ifndef LL_TEST
 S32 LLVOCachePartition::cull(LLCamera &camera, bool do_occlusion)
+{
+    std::unique_ptr<LLViewerOctreeCull> culler = prepareCull(camera, do_occlusion);
+    if(!culler)
+    {
+        return 0;
+    }
+
+    culler->traverse(mOctree);
+    finishCull();
+    return 1;
+}
+
+std::unique_ptr<LLViewerOctreeCull> LLVOCachePartition::prepareCull(LLCamera &camera, bool do_occlusion)
 {
     static LLCachedControl<bool> use_object_cache_occlusion(gSavedSettings,"UseObjectCacheOcclusion");
 
     if(!LLViewerRegion::sVOCacheCullingEnabled)
     {
-        return 0;
+        return NULL;
     }
     if(mRegionp->isPaused())
     {
-        return 0;
+        return NULL;
     }
 
     ((LLViewerOctreeGroup*)mOctree->getListener(0))->rebound();
 
     if(LLViewerCamera::sCurCameraID != LLViewerCamera::CAMERA_WORLD)
     {
-        return 0; //no need for those cameras.
+        return NULL; //no need for those cameras.
     }
 
     if(mCulledTime[LLViewerCamera::sCurCameraID] == LLViewerOctreeEntryData::getCurrentFrame())
     {
-        return 0; //already culled
+        return NULL; //already culled
     }
     mCulledTime[LLViewerCamera::sCurCameraID] = LLViewerOctreeEntryData::getCurrentFrame();
 
@@ -1035,7 +1140,7 @@ S32 LLVOCachePartition::cull(LLCamera &camera, bool do_occlusion)
             //process back objects selection
             selectBackObjects(camera, LLVOCacheEntry::getSquaredPixelThreshold(mFrontCull),
                 do_occlusion && use_object_cache_occlusion);
-            return 0; //nothing changed, reduce frequency of culling
+            return NULL; //nothing changed, reduce frequency of culling
         }
     }
     else
@@ -1048,15 +1153,16 @@ S32 LLVOCachePartition::cull(LLCamera &camera, bool do_occlusion)
     camera.calcRegionFrustumPlanes(region_agent, gAgentCamera.mDrawDistance);
 
     mFrontCull = true;
-    LLVOCacheOctreeCull culler(&camera, mRegionp, region_agent, do_occlusion && use_object_cache_occlusion,
+    return std::make_unique<LLVOCacheOctreeCull>(&camera, mRegionp, region_agent, do_occlusion && use_object_cache_occlusion,
         LLVOCacheEntry::getSquaredPixelThreshold(mFrontCull), this);
-    culler.traverse(mOctree);
+}
 
+void LLVOCachePartition::finishCull()
+{
     if(!sNeedsOcclusionCheck)
     {
         sNeedsOcclusionCheck = !mOccludedGroups.empty();
     }
-    return 1;
 }
 #endif // LL_TEST
 
@@ -1129,6 +1235,69 @@ void LLVOCachePartition::removeOccluder(LLVOCacheGroup* group)
     }
     mOccludedGroups.erase(group);
 }
+//-------------------------------------------------------------------
+//LLVOCacheMappedFile
+//-------------------------------------------------------------------
+LLVOCacheMappedFile::mapped_file_set_t LLVOCacheMappedFile::sMappedFiles;
+
+LLVOCacheMappedFile::LLVOCacheMappedFile(U64 handle)
+:   mHandle(handle)
+{
+    sMappedFiles.insert(this);
+}
+
+LLVOCacheMappedFile::~LLVOCacheMappedFile()
+{
+    sMappedFiles.erase(this);
+}
+
+bool LLVOCacheMappedFile::open(const std::string& filename)
+{
+    return mFile.open(filename);
+}
+
+void LLVOCacheMappedFile::detach()
+{
+#if LL_WINDOWS
+    // Only what the entries still reference is copied, and each entry
+    // would have copied its data out in getDP() anyway
+    while (!mEntries.empty())
+    {
+        (*mEntries.begin())->loadMappedData();
+    }
+    mFile.close();
+#endif
+}
+
+//static
+void LLVOCacheMappedFile::detach(U64 handle)
+{
+    // Detaching can release the last reference to a file, which takes it
+    // out of sMappedFiles
+    std::vector<LLPointer<LLVOCacheMappedFile> > files;
+    for (LLVOCacheMappedFile* file : sMappedFiles)
+    {
+        if (file->mHandle == handle)
+        {
+            files.push_back(file);
+        }
+    }
+    for (LLVOCacheMappedFile* file : files)
+    {
+        file->detach();
+    }
+}
+
+//static
+void LLVOCacheMappedFile::detachAll()
+{
+    std::vector<LLPointer<LLVOCacheMappedFile> > files(sMappedFiles.begin(), sMappedFiles.end());
+    for (LLVOCacheMappedFile* file : files)
+    {
+        file->detach();
+    }
+}
+
 //-------------------------------------------------------------------
 //LLVOCache
 //-------------------------------------------------------------------
@@ -1158,6 +1327,18 @@ LLVOCache::LLVOCache(bool read_only) :
 
 LLVOCache::~LLVOCache()
 {
+    // Don't hang the shutdown on a stuck disk. A region file that didn't
+    // make it is still listed in the header and is caught by the read checks.
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (auto& [handle, pending] : mPendingWrites)
+    {
+        if (pending.mResult.wait_until(deadline) != std::future_status::ready)
+        {
+            LL_WARNS() << "Gave up waiting for object cache write of region " << handle << LL_ENDL;
+        }
+    }
+    mPendingWrites.clear();
+
     if(mEnabled)
     {
         writeCacheHeader();
@@ -1242,6 +1423,8 @@ void LLVOCache::removeCache(ELLPath location, bool started)
     std::string mask = "*";
     std::string cache_dir = gDirUtilp->getExpandedFilename(location, object_cache_dirname);
     LL_INFOS() << "Removing cache at " << cache_dir << LL_ENDL;
+    waitForAllPendingWrites();
+    LLVOCacheMappedFile::detachAll();
     gDirUtilp->deleteFilesInDir(cache_dir, mask); //delete all files
     LLFile::rmdir(cache_dir);
 
@@ -1265,6 +1448,8 @@ void LLVOCache::removeCache()
 
     std::string mask = "*";
     LL_INFOS() << "Removing object cache at " << mObjectCacheDirName << LL_ENDL;
+    waitForAllPendingWrites();
+    LLVOCacheMappedFile::detachAll();
     gDirUtilp->deleteFilesInDir(mObjectCacheDirName, mask);
 
     clearCacheInMemory() ;
@@ -1363,6 +1548,8 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
     std::string filename;
     getObjectCacheFilename(entry->mHandle, filename);
     LL_WARNS("GLTF", "VOCache") << "Removing object cache for handle " << entry->mHandle << "Filename: " << filename << LL_ENDL;
+    waitForPendingWrites(entry->mHandle);
+    LLVOCacheMappedFile::detach(entry->mHandle);
     LLAPRFile::remove(filename, mLocalAPRFilePoolp);
 
     // Note: `removeFromCache` should take responsibility for cleaning up all cache artefacts specfic to the handle/entry.
@@ -1518,6 +1705,101 @@ bool LLVOCache::updateEntry(const HeaderEntryInfo* entry)
     return check_write(&apr_file, (void*)entry, sizeof(HeaderEntryInfo)) ;
 }
 
+void LLVOCache::postWrite(U64 handle, U32 type, std::function<bool()> write)
+{
+    reapPendingWrites();
+
+    auto task = std::make_shared<std::packaged_task<bool()>>(std::move(write));
+    PendingWrite pending;
+    pending.mResult = task->get_future();
+    pending.mType = type;
+
+    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    if (!general_queue || !general_queue->post([task]() { (*task)(); }))
+    {
+        (*task)();
+    }
+    mPendingWrites.emplace(handle, std::move(pending));
+}
+
+void LLVOCache::waitForPendingWrites(U64 handle, U32 types)
+{
+    // Take the results before acting on them, removing an entry comes
+    // back here through removeFromCache().
+    U32 failed = 0;
+    auto range = mPendingWrites.equal_range(handle);
+    for (auto iter = range.first; iter != range.second; )
+    {
+        if (iter->second.mType & types)
+        {
+            bool success = false;
+            try
+            {
+                success = iter->second.mResult.get();
+            }
+            catch (...)
+            {
+                LOG_UNHANDLED_EXCEPTION("object cache write");
+            }
+            if (!success)
+            {
+                failed |= iter->second.mType;
+            }
+            iter = mPendingWrites.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    if (failed & WRITE_EXTRAS)
+    {
+        // also removes the objects
+        removeGenericExtrasForHandle(handle);
+    }
+    else if (failed & WRITE_OBJECTS)
+    {
+        LL_WARNS() << "Failed to write object cache for handle " << handle << LL_ENDL;
+        removeEntry(handle);
+    }
+}
+
+void LLVOCache::waitForAllPendingWrites()
+{
+    while (!mPendingWrites.empty())
+    {
+        waitForPendingWrites(mPendingWrites.begin()->first);
+    }
+}
+
+void LLVOCache::reapPendingWrites()
+{
+    std::vector<U64> finished;
+    for (auto& [handle, pending] : mPendingWrites)
+    {
+        if (pending.mResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready
+            && (finished.empty() || finished.back() != handle))
+        {
+            finished.push_back(handle);
+        }
+    }
+    for (U64 handle : finished)
+    {
+        // only the finished writes of the region will be waited on
+        U32 types = 0;
+        auto range = mPendingWrites.equal_range(handle);
+        for (auto iter = range.first; iter != range.second; ++iter)
+        {
+            if (iter->second.mResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                types |= iter->second.mType;
+            }
+        }
+        waitForPendingWrites(handle, types);
+    }
+}
+
 // we now return bool to trigger dirty cache
 // this in turn forces a rewrite after a partial read due to corruption.
 bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map)
@@ -1529,6 +1811,8 @@ bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
     }
     llassert_always(mInitialized);
 
+    waitForPendingWrites(handle);
+
     handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle) ;
     if(iter == mHandleEntryMap.end()) //no cache
     {
@@ -1536,18 +1820,26 @@ bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
         return false; // arguably no a problem, but we'll mark this as dirty anyway.
     }
 
+    LL_PROFILE_ZONE_SCOPED;
+
     bool success = true ;
     S32 num_entries = 0 ; // lifted out of inner loop.
     std::string filename; // lifted out of loop
     {
-        LLUUID cache_id;
+        // The file is an index of the entries' headers followed by their
+        // data, in the same order. Only the index is read here, each entry
+        // keeps the file mapped until its data is needed.
         getObjectCacheFilename(handle, filename);
-        LLAPRFile apr_file(filename, APR_READ|APR_BINARY, mLocalAPRFilePoolp);
-
-        success = check_read(&apr_file, cache_id.mData, UUID_BYTES);
+        LLPointer<LLVOCacheMappedFile> file = new LLVOCacheMappedFile(handle);
+        success = file->open(filename) && file->getSize() >= UUID_BYTES + sizeof(S32);
 
         if(success)
         {
+            const U8* data = file->getData();
+            const size_t file_size = file->getSize();
+
+            LLUUID cache_id;
+            memcpy(cache_id.mData, data, UUID_BYTES);
             if(cache_id != id)
             {
                 LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
@@ -1556,21 +1848,39 @@ bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 
             if(success)
             {
-                success = check_read(&apr_file, &num_entries, sizeof(S32)) ;
+                memcpy(&num_entries, data + UUID_BYTES, sizeof(S32));
 
-                if(success)
+                size_t offset = UUID_BYTES + sizeof(S32);
+                if (num_entries < 0 || (size_t)num_entries > (file_size - offset) / ENTRY_HEADER_SIZE)
                 {
-                    for (S32 i = 0; i < num_entries && apr_file.eof() != APR_EOF; i++)
+                    LL_WARNS() << "Aborting cache file load for " << filename << ", bad entry count " << num_entries << LL_ENDL;
+                    success = false;
+                }
+
+                const U8* header = data + offset;
+                offset += (size_t)num_entries * ENTRY_HEADER_SIZE;
+                for (S32 i = 0; success && i < num_entries; i++, header += ENTRY_HEADER_SIZE)
+                {
+                    S32 size;
+                    memcpy(&size, header + (5 * sizeof(U32)), sizeof(S32));
+
+                    // Corruption in the cache entries
+                    if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1) || (size_t)size > file_size - offset)
                     {
-                        LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(&apr_file);
-                        if (!entry->getLocalID())
-                        {
-                            LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
-                            success = false ;
-                            break ;
-                        }
-                        cache_entry_map[entry->getLocalID()] = entry;
+                        LL_WARNS() << "Bogus cache entry, size " << size << ", aborting!" << LL_ENDL;
+                        success = false;
+                        break;
                     }
+
+                    LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(header, file, offset, size);
+                    offset += size;
+                    if (!entry->getLocalID())
+                    {
+                        LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
+                        success = false ;
+                        break ;
+                    }
+                    cache_entry_map[entry->getLocalID()] = entry;
                 }
             }
         }
@@ -1602,6 +1912,8 @@ void LLVOCache::readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCac
     }
     llassert_always(mInitialized);
 
+    waitForPendingWrites(handle);
+
     handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle) ;
     if(iter == mHandleEntryMap.end()) //no cache
     {
@@ -1751,6 +2063,9 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
         return ;
     }
 
+    // The previous write of this file has to be out of the way first
+    waitForPendingWrites(handle, WRITE_OBJECTS);
+
     HeaderEntryInfo* entry;
     handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle) ;
     if(iter == mHandleEntryMap.end()) //new entry
@@ -1792,68 +2107,51 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
         return ; //nothing changed, no need to update.
     }
 
-    //write to cache file
+    // Snapshot the file contents here, where the entries can be touched,
+    // and leave the writing to the general thread pool
+    std::shared_ptr<std::vector<U8>> contents = std::make_shared<std::vector<U8>>();
     bool success = true ;
     {
-        std::string filename;
-        getObjectCacheFilename(handle, filename);
-        LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_BINARY|APR_TRUNCATE, mLocalAPRFilePoolp);
+        // Entries still reading from the old file need their own copy of it
+        LLVOCacheMappedFile::detach(handle);
 
-        success = check_write(&apr_file, (void*)id.mData, UUID_BYTES);
+        std::vector<const LLVOCacheEntry*> entries;
+        entries.reserve(cache_entry_map.size());
+        size_t file_size = UUID_BYTES + sizeof(S32);
+        for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
+        {
+            if (!removal_enabled || iter->second->isValid())
+            {
+                entries.push_back(iter->second);
+                file_size += ENTRY_HEADER_SIZE + iter->second->getDataSize();
+            }
+        }
 
-        if(success)
+        contents->resize(file_size);
+        U8* data_buffer = contents->data();
+        memcpy(data_buffer, id.mData, UUID_BYTES);
+        S32 num_entries = static_cast<S32>(entries.size());
+        memcpy(data_buffer + UUID_BYTES, &num_entries, sizeof(S32));
+        S32 size_in_buffer = UUID_BYTES + sizeof(S32);
+
+        // The index of headers first, then the data in the same order
+        for (S32 pass = 0; success && pass < 2; ++pass)
         {
-            S32 num_entries = static_cast<S32>(cache_entry_map.size()); // if removal is enabled num_entries might be wrong
-            success = check_write(&apr_file, &num_entries, sizeof(S32));
-            if (success)
+            for (const LLVOCacheEntry* cache_entry : entries)
             {
-                const S32 buffer_size = 32768; //should be large enough for couple MAX_ENTRY_BODY_SIZE
-                U8 data_buffer[buffer_size]; // generaly entries are fairly small, so collect them and drop onto disk in one go
-                S32 size_in_buffer = 0;
+                S32 size = pass == 0 ? cache_entry->writeHeaderToBuffer(data_buffer + size_in_buffer)
+                                     : cache_entry->writeDataToBuffer(data_buffer + size_in_buffer);
 
-                // This can have a lot of entries, so might be better to dump them into buffer first and write in one go.
-                for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); success && iter != cache_entry_map.end(); ++iter)
+                if (size > 0) // body is minimum of 1
                 {
-                    if (!removal_enabled || iter->second->isValid())
-                    {
-                        S32 size = iter->second->writeToBuffer(data_buffer + size_in_buffer);
-
-                        if (size > ENTRY_HEADER_SIZE) // body is minimum of 1
-                        {
-                            size_in_buffer += size;
-                        }
-                        else
-                        {
-                            LL_WARNS() << "Failed to write cache entry to buffer for " << filename << ", entry number " << iter->second->getLocalID() << LL_ENDL;
-                            success = false;
-                            break;
-                        }
-
-                        // Make sure we have space in buffer for next element
-                        if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE + ENTRY_HEADER_SIZE)
-                        {
-                            success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                            size_in_buffer = 0;
-                            if (!success)
-                            {
-                                LL_WARNS() << "Failed to write cache to disk " << filename << LL_ENDL;
-                                break;
-                            }
-                        }
-                    }
+                    size_in_buffer += size;
                 }
-
-                if (success && size_in_buffer > 0)
+                else
                 {
-                    // final write
-                    success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                    if(!success)
-                    {
-                        LL_WARNS() << "Failed to write cache entry to disk " << filename << LL_ENDL;
-                    }
-                    size_in_buffer = 0;
+                    LL_WARNS() << "Failed to write cache entry to buffer for " << filename << ", entry number " << cache_entry->getLocalID() << LL_ENDL;
+                    success = false;
+                    break;
                 }
-                LL_DEBUGS("VOCache") << "Wrote " << num_entries << " entries to the primary VOCache file " << filename << ". success = " << (success ? "True":"False") << LL_ENDL;
             }
         }
     }
@@ -1861,9 +2159,15 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
     if(!success)
     {
         removeEntry(entry) ;
+        return ;
     }
 
-    return ;
+    postWrite(handle, WRITE_OBJECTS, [filename, contents]()
+        {
+            bool result = write_file_atomically(filename, contents->data(), contents->size());
+            LL_DEBUGS("VOCache") << "Wrote primary VOCache file " << filename << ". success = " << (result ? "True":"False") << LL_ENDL;
+            return result;
+        });
 }
 
 void LLVOCache::removeGenericExtrasForHandle(U64 handle)
@@ -1903,39 +2207,18 @@ void LLVOCache::writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LL
         return;
     }
 
-    std::string filename = getObjectCacheExtrasFilename(handle);
-    llofstream out(filename, std::ios::out | std::ios::binary);
-    if(!out.good())
-    {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        removeGenericExtrasForHandle(handle);
-        return;
-    }
-    // It is good practice to version file formats so let's add one.
-    // legacy versions will be treated as version 0.
-    out << LLGLTFOverrideCacheEntry::VERSION_LABEL << ":" << LLGLTFOverrideCacheEntry::VERSION << '\n';
+    // Don't start on the file while the previous write may still be busy with it
+    waitForPendingWrites(handle, WRITE_EXTRAS);
 
-    out << id << '\n';
-    if(!out.good())
-    {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        removeGenericExtrasForHandle(handle);
-        return;
-    }
-    // Because we don't write out all the entries we need to record a placeholder and rewrite this later
-    auto num_entries_placeholder = out.tellp();
-    out << std::setw(10) << std::setfill('0') << 0 << '\n';
-    if(!out.good())
-    {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        removeGenericExtrasForHandle(handle);
-        return;
-    }
+    std::string filename = getObjectCacheExtrasFilename(handle);
 
     // get ViewerRegion pointer from handle
     LLViewerRegion* pRegion = LLWorld::getInstance()->getRegionFromHandle(handle);
 
-    U32 num_entries = 0;
+    // Collect the entries here and leave formatting and writing them to the
+    // general thread pool. The copies must not share any LLSD with the
+    // originals, LLSD reference counts are not thread safe.
+    std::shared_ptr<std::vector<LLSD>> entries = std::make_shared<std::vector<LLSD>>();
     U32 skipped = 0;
     size_t inmem_entries = cache_extras_entry_map.size();
     for (auto [local_id, entry] : cache_extras_entry_map)
@@ -1956,30 +2239,35 @@ void LLVOCache::writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LL
         {
             LLSD entry_llsd = entry.toLLSD();
             entry_llsd["local_id"] = (S32)local_id;
-            LLSDSerialize::serialize(entry_llsd, out, LLSDSerialize::LLSD_XML);
-            out << '\n';
-            if(!out.good())
-            {
-                // We're not in a good place when this happens so we might as well nuke the file.
-                LL_WARNS() << "Failed writing extras cache for handle " << handle << ". Corrupted cache file " << filename << " removed." << LL_ENDL;
-                removeGenericExtrasForHandle(handle);
-                return;
-            }
-            num_entries++;
+            entries->push_back(unshared_llsd_copy(entry_llsd));
         }
         else
         {
             skipped++;
         }
     }
-    // Rewrite the placeholder
-    out.seekp(num_entries_placeholder);
-    out << std::setw(10) << std::setfill('0') << num_entries << '\n';
-    if(!out.good())
-    {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        removeGenericExtrasForHandle(handle);
-        return;
-    }
-    LL_DEBUGS("GLTF") << "Completed writing extras cache for handle " << handle << ", " << num_entries << " entries. Total in RAM: " << inmem_entries << " skipped (no persist): " << skipped << LL_ENDL;
+
+    postWrite(handle, WRITE_EXTRAS, [handle, id, filename, entries, skipped, inmem_entries]()
+        {
+            std::ostringstream out;
+            // It is good practice to version file formats so let's add one.
+            // legacy versions will be treated as version 0.
+            out << LLGLTFOverrideCacheEntry::VERSION_LABEL << ":" << LLGLTFOverrideCacheEntry::VERSION << '\n';
+            out << id << '\n';
+            out << std::setw(10) << std::setfill('0') << entries->size() << '\n';
+            for (const LLSD& entry_llsd : *entries)
+            {
+                LLSDSerialize::serialize(entry_llsd, out, LLSDSerialize::LLSD_XML);
+                out << '\n';
+            }
+
+            const std::string contents = out.str();
+            if (!write_file_atomically(filename, contents.data(), contents.size()))
+            {
+                LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
+                return false;
+            }
+            LL_DEBUGS("GLTF") << "Completed writing extras cache for handle " << handle << ", " << entries->size() << " entries. Total in RAM: " << inmem_entries << " skipped (no persist): " << skipped << LL_ENDL;
+            return true;
+        });
 }
@@ -32,13 +32,55 @@
 #include "lldir.h"
 #include "llvieweroctree.h"
 #include "llapr.h"
+#include "llmappedfile.h"
 #include "llgltfmaterial.h"
 
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
 #include <unordered_map>
 
 //---------------------------------------------------------------------------
 // Cache entries
 class LLCamera;
+class LLVOCacheEntry;
+
+// A region's object cache file, mapped into memory by LLVOCache::readFromCache().
+// Entries read from the file keep a reference to it and only copy their data
+// out when something asks for it (see LLVOCacheEntry::getDP()).
+class LLVOCacheMappedFile : public LLRefCount
+{
+public:
+    LLVOCacheMappedFile(U64 handle);
+
+    bool open(const std::string& filename);
+
+    const U8* getData() const { return mFile.getData(); }
+    size_t getSize() const    { return mFile.getSize(); }
+
+    // Get the region file out of the way of a writer that is about to
+    // replace or remove it. A POSIX mapping outlives the file's name, so
+    // this only does anything on Windows, where the entries still using
+    // the file copy out their own data and the mapping is closed.
+    static void detach(U64 handle);
+    static void detachAll();
+
+protected:
+    ~LLVOCacheMappedFile();
+
+private:
+    friend class LLVOCacheEntry;
+
+    void detach();
+
+    U64             mHandle;
+    LLMappedFile    mFile;
+    std::set<LLVOCacheEntry*> mEntries; // entries still reading from mFile
+
+    typedef std::set<LLVOCacheMappedFile*> mapped_file_set_t;
+    static mapped_file_set_t sMappedFiles; // main thread only, like LLVOCache
+};
 
 class LLGLTFOverrideCacheEntry
 {
@@ -102,7 +144,9 @@ protected:
     ~LLVOCacheEntry();
 public:
     LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &dp);
-    LLVOCacheEntry(LLAPRFile* apr_file);
+    // header is the entry's record in the index of a mapped region file,
+    // and the entry's data is the size bytes at offset in that file.
+    LLVOCacheEntry(const U8* header, LLVOCacheMappedFile* file, size_t offset, S32 size);
     LLVOCacheEntry();
 
     void updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp);
@@ -125,7 +169,9 @@ public:
     F32 getSceneContribution() const             { return mSceneContrib;}
 
     void dump() const;
-    S32 writeToBuffer(U8 *data_buffer) const;
+    S32 getDataSize() const;
+    S32 writeHeaderToBuffer(U8 *data_buffer) const;
+    S32 writeDataToBuffer(U8 *data_buffer) const;
     LLDataPackerBinaryBuffer *getDP();
     void recordHit();
     void recordDupe() { mDupeCount++; }
@@ -156,7 +202,11 @@ public:
     static F32  getSquaredPixelThreshold(bool is_front);
 
 private:
+    friend class LLVOCacheMappedFile;
+
     void updateParentBoundingInfo(const LLVOCacheEntry* child);
+    void loadMappedData();
+    void releaseMappedFile();
 
 public:
     typedef std::map<U32, LLPointer<LLVOCacheEntry> >      vocache_entry_map_t;
@@ -177,6 +227,11 @@ protected:
     LLDataPackerBinaryBuffer    mDP;
     U8                          *mBuffer;
 
+    // Where the data still is if it has not been copied into mBuffer yet
+    LLPointer<LLVOCacheMappedFile> mMappedFile;
+    size_t                      mMappedOffset;
+    S32                         mMappedSize;
+
     F32                         mSceneContrib; //projected scene contributuion of this object.
     U32                         mState; //high 16 bits reserved for special use.
     vocache_entry_set_t         mChildrenList; //children entries in a linked set.
@@ -215,6 +270,11 @@ public:
     bool addEntry(LLViewerOctreeEntry* entry);
     void removeEntry(LLViewerOctreeEntry* entry);
     /*virtual*/ S32 cull(LLCamera &camera, bool do_occlusion);
+    // cull() in two halves. prepareCull() localizes the camera, it returns
+    // NULL when there is nothing more to do this frame. finishCull() goes
+    // after the culler has been run on the octree.
+    std::unique_ptr<LLViewerOctreeCull> prepareCull(LLCamera &camera, bool do_occlusion);
+    void finishCull();
     void addOccluders(LLViewerOctreeGroup* gp);
     void resetOccluders();
     void processOccluders(LLCamera* camera);
@@ -310,6 +370,29 @@ private:
     void purgeEntries(U32 size);
     bool updateEntry(const HeaderEntryInfo* entry);
 
+    // Region cache files are written on the "General" thread pool. The data
+    // is snapshotted on the main thread; write() only touches its own copy.
+    enum EWriteType : U32
+    {
+        WRITE_OBJECTS = 1 << 0,
+        WRITE_EXTRAS  = 1 << 1,
+        WRITE_ALL     = WRITE_OBJECTS | WRITE_EXTRAS
+    };
+    struct PendingWrite
+    {
+        std::future<bool> mResult;
+        U32 mType;
+    };
+    typedef std::multimap<U64, PendingWrite> pending_write_map_t;
+
+    void postWrite(U64 handle, U32 type, std::function<bool()> write);
+    // Block until the given writes for the region are on disk, dropping the
+    // cache entry for any write that failed.
+    void waitForPendingWrites(U64 handle, U32 types = WRITE_ALL);
+    void waitForAllPendingWrites();
+    // Pick up writes that have already finished, without blocking.
+    void reapPendingWrites();
+
 private:
     bool                 mEnabled;
     bool                 mInitialized ;
@@ -322,6 +405,7 @@ private:
     LLVolatileAPRPool*   mLocalAPRFilePoolp ;
     header_entry_queue_t mHeaderEntryQueue;
     handle_entry_map_t   mHandleEntryMap;
+    pending_write_map_t  mPendingWrites;
 };
 
 #endif
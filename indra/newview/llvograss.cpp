@@ -242,13 +242,13 @@ void LLVOGrass::cleanupClass()
 }
 
 U32 LLVOGrass::processUpdateMessage(LLMessageSystem *mesgsys,
-                                          void **user_data,
+                                          const LLObjectUpdateInfo* info,
                                           U32 block_num,
                                           const EObjectUpdateType update_type,
                                           LLDataPacker *dp)
 {
     // Do base class updates...
-    U32 retval = LLViewerObject::processUpdateMessage(mesgsys, user_data, block_num, update_type, dp);
+    U32 retval = LLViewerObject::processUpdateMessage(mesgsys, info, block_num, update_type, dp);
 
     updateSpecies();
 
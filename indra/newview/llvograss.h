@@ -46,7 +46,7 @@ public:
     virtual U32 getPartitionType() const;
 
     /*virtual*/ U32 processUpdateMessage(LLMessageSystem *mesgsys,
-                                            void **user_data,
+                                            const LLObjectUpdateInfo* info,
                                             U32 block_num,
                                             const EObjectUpdateType update_type,
                                             LLDataPacker *dp);
@@ -275,12 +275,12 @@ void LLVOTree::cleanupClass()
 }
 
 U32 LLVOTree::processUpdateMessage(LLMessageSystem *mesgsys,
-                                          void **user_data,
+                                          const LLObjectUpdateInfo* info,
                                           U32 block_num, EObjectUpdateType update_type,
                                           LLDataPacker *dp)
 {
     // Do base class updates...
-    U32 retval = LLViewerObject::processUpdateMessage(mesgsys, user_data, block_num, update_type, dp);
+    U32 retval = LLViewerObject::processUpdateMessage(mesgsys, info, block_num, update_type, dp);
 
     if (  (getVelocity().lengthSquared() > 0.f)
         ||(getAcceleration().lengthSquared() > 0.f)
@@ -55,7 +55,7 @@ public:
     static bool isTreeRenderingStopped();
 
     /*virtual*/ U32 processUpdateMessage(LLMessageSystem *mesgsys,
-                                            void **user_data,
+                                            const LLObjectUpdateInfo* info,
                                             U32 block_num, const EObjectUpdateType update_type,
                                             LLDataPacker *dp);
     /*virtual*/ void idleUpdate(LLAgent &agent, const F64 &time);
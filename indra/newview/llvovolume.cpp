@@ -89,6 +89,7 @@
 #include "llavatarappearancedefines.h"
 #include "llgltfmateriallist.h"
 #include "gltfscenemanager.h"
+#include "threadpool.h"
 
 const F32 FORCE_SIMPLE_RENDER_AREA = 512.f;
 const F32 FORCE_CULL_AREA = 8.f;
@@ -333,7 +334,7 @@ void LLVOVolume::cleanupClass()
 }
 
 U32 LLVOVolume::processUpdateMessage(LLMessageSystem *mesgsys,
-                                          void **user_data,
+                                          const LLObjectUpdateInfo* info,
                                           U32 block_num, EObjectUpdateType update_type,
                                           LLDataPacker *dp)
 {
@@ -345,7 +346,7 @@ U32 LLVOVolume::processUpdateMessage(LLMessageSystem *mesgsys,
     const bool previously_color_changed = mColorChanged;
 
     // Do base class updates...
-    U32 retval = LLViewerObject::processUpdateMessage(mesgsys, user_data, block_num, update_type, dp);
+    U32 retval = LLViewerObject::processUpdateMessage(mesgsys, info, block_num, update_type, dp);
 
     LLUUID sculpt_id;
     U8 sculpt_type = 0;
@@ -519,12 +520,12 @@ U32 LLVOVolume::processUpdateMessage(LLMessageSystem *mesgsys,
         }
         else
         {
-            S32 texture_length = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_TextureEntry);
+            S32 texture_length = info ? llmin(info->mTextureEntrySize, 1024) : 0;
             if (texture_length)
             {
                 U8                          tdpbuffer[1024];
                 LLDataPackerBinaryBuffer    tdp(tdpbuffer, 1024);
-                mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_TextureEntry, tdpbuffer, 0, block_num, 1024);
+                memcpy(tdpbuffer, info->mTextureEntry, texture_length);
                 S32 result = unpackTEMessage(tdp);
                 if (result & teDirtyBits)
                 {
@@ -4973,11 +4974,15 @@ void LLRiggedVolume::update(
     LLMatrix4a mat[kMaxJoints];
     U32 maxJoints = LLSkinningUtil::getMeshJointCount(skin);
     LLSkinningUtil::initSkinningMatrixPalette(mat, maxJoints, skin, avatar);
+
+    // fold the bind shape matrix into the palette, the blend of the joint
+    // matrices of a vertex is then the only transform it goes through
     const LLMatrix4a bind_shape_matrix = skin->mBindShapeMatrix;
+    for (U32 j = 0; j < maxJoints; ++j)
+    {
+        matMul(bind_shape_matrix, mat[j], mat[j]);
+    }
 
-    S32 rigged_vert_count = 0;
-    S32 rigged_face_count = 0;
-    LLVector4a box_min, box_max;
     S32 face_begin;
     S32 face_end;
     if (face_index == DO_NOT_UPDATE_FACES)
@@ -4995,7 +5000,10 @@ void LLRiggedVolume::update(
         face_begin = face_index;
         face_end = face_begin + 1;
     }
-    for (S32 i = face_begin; i < face_end; ++i)
+
+    // faces only write to themselves, so they can be skinned and get their
+    // octrees rebuilt on several threads
+    auto update_face = [&](S32 i)
     {
         const LLVolumeFace& vol_face = volume->getVolumeFace(i);
 
@@ -5012,8 +5020,6 @@ void LLRiggedVolume::update(
             if (pos && dst_face.mExtents)
             {
                 U32 max_joints = LLSkinningUtil::getMaxJointCount();
-                rigged_vert_count += dst_face.mNumVertices;
-                rigged_face_count++;
 
             #if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
                 if (vol_face.mJointIndices) // fast path with preconditioned joint indices
@@ -5028,12 +5034,7 @@ void LLRiggedVolume::update(
                         LLSkinningUtil::getPerVertexSkinMatrixWithIndices(w, joint_indices_cursor, mat, final_mat, src);
                         joint_indices_cursor += 4;
 
-                        LLVector4a& v = vol_face.mPositions[j];
-                        LLVector4a t;
-                        LLVector4a dst;
-                        bind_shape_matrix.affineTransform(v, t);
-                        final_mat.affineTransform(t, dst);
-                        pos[j] = dst;
+                        final_mat.affineTransform(vol_face.mPositions[j], pos[j]);
                     }
                 }
                 else
@@ -5044,12 +5045,7 @@ void LLRiggedVolume::update(
                         LLMatrix4a final_mat;
                         LLSkinningUtil::getPerVertexSkinMatrix(weight[j].getF32ptr(), mat, false, final_mat, max_joints);
 
-                        LLVector4a& v = vol_face.mPositions[j];
-                        LLVector4a t;
-                        LLVector4a dst;
-                        bind_shape_matrix.affineTransform(v, t);
-                        final_mat.affineTransform(t, dst);
-                        pos[j] = dst;
+                        final_mat.affineTransform(vol_face.mPositions[j], pos[j]);
                     }
                 }
 
@@ -5060,11 +5056,6 @@ void LLRiggedVolume::update(
 
                 min = pos[0];
                 max = pos[1];
-                if (i==0)
-                {
-                    box_min = min;
-                    box_max = max;
-                }
 
                 for (S32 j = 1; j < dst_face.mNumVertices; ++j)
                 {
@@ -5072,9 +5063,6 @@ void LLRiggedVolume::update(
                     max.setMax(max, pos[j]);
                 }
 
-                box_min.setMin(min,box_min);
-                box_max.setMax(max,box_max);
-
                 dst_face.mCenter->setAdd(dst_face.mExtents[0], dst_face.mExtents[1]);
                 dst_face.mCenter->mul(0.5f);
 
@@ -5086,6 +5074,41 @@ void LLRiggedVolume::update(
                 dst_face.createOctree();
             }
         }
+    };
+
+    static LLCachedControl<bool> parallel_rigged(gSavedSettings, "RenderParallelRiggedVolumes", true);
+    if (parallel_rigged && face_end - face_begin > 1)
+    {
+        LL::parallel_for("FrameTasks", face_end - face_begin, [&](size_t i) { update_face(face_begin + (S32)i); });
+    }
+    else
+    {
+        for (S32 i = face_begin; i < face_end; ++i)
+        {
+            update_face(i);
+        }
+    }
+
+    S32 rigged_vert_count = 0;
+    S32 rigged_face_count = 0;
+    LLVector4a box_min, box_max;
+    box_min.clear();
+    box_max.clear();
+    for (S32 i = face_begin; i < face_end; ++i)
+    {
+        const LLVolumeFace& dst_face = mVolumeFaces[i];
+        if (volume->getVolumeFace(i).mWeights && dst_face.mPositions && dst_face.mExtents)
+        {
+            if (rigged_face_count == 0)
+            {
+                box_min = dst_face.mExtents[0];
+                box_max = dst_face.mExtents[1];
+            }
+            box_min.setMin(box_min, dst_face.mExtents[0]);
+            box_max.setMax(box_max, dst_face.mExtents[1]);
+            rigged_vert_count += dst_face.mNumVertices;
+            rigged_face_count++;
+        }
     }
     mExtraDebugText = llformat("rigged %d/%d - box (%f %f %f) (%f %f %f)",
                                rigged_face_count, rigged_vert_count,
@@ -5252,6 +5275,182 @@ void LLVolumeGeometryManager::freeFaces()
     }
 }
 
+namespace
+{
+    // a face geometry write queued by LLVolumeGeometryManager::getGeometryVolume()
+    struct DeferredGeometry
+    {
+        LLPointer<LLDrawable> mDrawable;
+        LLFace* mFace;
+        LLPointer<LLVertexBuffer> mBuffer; // buffer the face was laid out in when queued
+        LLPointer<LLVolume> mVolume;
+        LLPointer<LLSpatialGroup> mRebuildOnFail;
+        LLMatrix4 mMatVert;
+        LLMatrix3 mMatNormal;
+        U32 mRebuildState;  // drawable REBUILD_ flags when queued
+        U32 mPendingState;  // drawable REBUILD_ flags when filled
+        U16 mIndexOffset;
+        bool mForceRebuild;
+        bool mResult;
+    };
+
+    bool sDeferGeometry = false;
+    std::vector<DeferredGeometry> sDeferredGeometry;
+    // latest entry in sDeferredGeometry for each face
+    std::unordered_map<LLFace*, size_t> sDeferredGeometryIndex;
+
+    void fill_geometry(DeferredGeometry& fill)
+    {
+        fill.mResult = fill.mFace->getGeometryVolume(*fill.mVolume, fill.mFace->getTEOffset(),
+                                                     fill.mMatVert, fill.mMatNormal, fill.mIndexOffset,
+                                                     fill.mForceRebuild, fill.mRebuildOnFail.notNull());
+    }
+
+    void geometry_failed(LLSpatialGroup* rebuild_on_fail)
+    {
+        if (rebuild_on_fail)
+        {   // Something's gone wrong with the vertex buffer accounting,
+            // rebuild this group with no debug assert because MESH_DIRTY
+            rebuild_on_fail->dirtyGeom();
+            gPipeline.markRebuild(rebuild_on_fail);
+        }
+        else
+        {
+            LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
+        }
+    }
+
+    bool has_face(const LLDrawable* drawablep, const LLFace* facep)
+    {
+        for (S32 i = 0; i < drawablep->getNumFaces(); ++i)
+        {
+            if (drawablep->getFace(i) == facep)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+//static
+void LLVolumeGeometryManager::getGeometryVolume(LLFace* facep, LLVolume* volume, const LLMatrix4& mat_vert, const LLMatrix3& mat_normal,
+                                                U16 index_offset, bool force_rebuild, LLSpatialGroup* rebuild_on_fail)
+{
+    if (!sDeferGeometry)
+    {
+        if (!facep->getGeometryVolume(*volume, facep->getTEOffset(), mat_vert, mat_normal, index_offset,
+                                      force_rebuild, rebuild_on_fail != nullptr))
+        {
+            geometry_failed(rebuild_on_fail);
+        }
+        return;
+    }
+
+    LLDrawable* drawablep = facep->getDrawable();
+    U32 rebuild_state = drawablep->getState() & LLDrawable::REBUILD_ALL;
+
+    auto found = sDeferredGeometryIndex.find(facep);
+    if (found != sDeferredGeometryIndex.end() && sDeferredGeometry[found->second].mBuffer == facep->getVertexBuffer())
+    {   // written again into the same layout (rebuildGeom then rebuildMesh),
+        // the later write wins but still covers what the earlier one would have
+        DeferredGeometry& fill = sDeferredGeometry[found->second];
+        fill.mVolume = volume;
+        fill.mMatVert = mat_vert;
+        fill.mMatNormal = mat_normal;
+        fill.mIndexOffset = index_offset;
+        fill.mRebuildState |= rebuild_state;
+        fill.mForceRebuild |= force_rebuild;
+        if (rebuild_on_fail)
+        {
+            fill.mRebuildOnFail = rebuild_on_fail;
+        }
+        return;
+    }
+
+    // an earlier entry for another layout is dropped in fillDeferredGeometry()
+    sDeferredGeometryIndex[facep] = sDeferredGeometry.size();
+    sDeferredGeometry.push_back({ drawablep, facep, facep->getVertexBuffer(), volume, rebuild_on_fail,
+                                  mat_vert, mat_normal, rebuild_state, 0, index_offset, force_rebuild, false });
+}
+
+//static
+void LLVolumeGeometryManager::deferGeometry()
+{
+    static LLCachedControl<bool> parallel_geometry(gSavedSettings, "RenderParallelGeometry", true);
+    sDeferGeometry = parallel_geometry;
+}
+
+//static
+void LLVolumeGeometryManager::fillDeferredGeometry()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+    sDeferGeometry = false;
+
+    if (sDeferredGeometry.empty())
+    {
+        return;
+    }
+
+    // skip writes for faces that went away or were laid out again since
+    std::vector<DeferredGeometry*> fills;
+    fills.reserve(sDeferredGeometry.size());
+    for (DeferredGeometry& fill : sDeferredGeometry)
+    {
+        if (!fill.mDrawable->isDead() &&
+            has_face(fill.mDrawable, fill.mFace) &&
+            fill.mFace->getVertexBuffer() == fill.mBuffer)
+        {
+            fill.mPendingState = fill.mDrawable->getState() & LLDrawable::REBUILD_ALL;
+            fills.push_back(&fill);
+        }
+    }
+
+    // the rebuild flags were cleared after queueing, put them back while
+    // the faces are written so each write covers what it did when queued
+    for (DeferredGeometry* fill : fills)
+    {
+        fill->mDrawable->setState(fill->mRebuildState);
+    }
+
+    std::vector<DeferredGeometry*> threaded;
+    std::vector<DeferredGeometry*> serial;
+    threaded.reserve(fills.size());
+    for (DeferredGeometry* fill : fills)
+    {
+        LLViewerObject* vobj = fill->mFace->getViewerObject();
+        if (vobj && vobj->getVolume() == fill->mVolume &&
+            fill->mFace->prepareGeometryVolume(fill->mFace->getTEOffset(), fill->mForceRebuild))
+        {
+            threaded.push_back(fill);
+        }
+        else
+        {
+            serial.push_back(fill);
+        }
+    }
+
+    LL::parallel_for("FrameTasks", threaded.size(), [&threaded](size_t i) { fill_geometry(*threaded[i]); });
+
+    // after the threaded writes, the GLTF selection buffer is a copy of the whole buffer
+    for (DeferredGeometry* fill : serial)
+    {
+        fill_geometry(*fill);
+    }
+
+    for (DeferredGeometry* fill : fills)
+    {
+        fill->mDrawable->clearState(fill->mRebuildState & ~fill->mPendingState);
+        if (!fill->mResult)
+        {
+            geometry_failed(fill->mRebuildOnFail);
+        }
+    }
+
+    sDeferredGeometry.clear();
+    sDeferredGeometryIndex.clear();
+}
+
 void LLVolumeGeometryManager::registerFace(LLSpatialGroup* group, LLFace* facep, U32 type)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
@@ -6135,18 +6334,12 @@ void LLVolumeGeometryManager::rebuildMesh(LLSpatialGroup* group)
                             LLVertexBuffer* buff = face->getVertexBuffer();
                             if (buff)
                             {
-                                if (!face->getGeometryVolume(*volume, // volume
-                                    face->getTEOffset(),              // face_index
-                                    vobj->getRelativeXform(),         // mat_vert_in
-                                    vobj->getRelativeXformInvTrans(), // mat_norm_in
+                                getGeometryVolume(face, volume,
+                                    vobj->getRelativeXform(),         // mat_vert
+                                    vobj->getRelativeXformInvTrans(), // mat_normal
                                     face->getGeomIndex(),             // index_offset
                                     false,                            // force_rebuild
-                                    true))                            // no_debug_assert
-                                {   // Something's gone wrong with the vertex buffer accounting,
-                                    // rebuild this group with no debug assert because MESH_DIRTY
-                                    group->dirtyGeom();
-                                    gPipeline.markRebuild(group);
-                                }
+                                    group);                           // rebuild_on_fail
                             }
                         }
                     }
@@ -6486,13 +6679,8 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
                         vobj->updateRelativeXform(true);
                     }
 
-                    U32 te_idx = facep->getTEOffset();
-
-                    if (!facep->getGeometryVolume(*volume, te_idx,
-                        vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), index_offset,true))
-                    {
-                        LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
-                    }
+                    getGeometryVolume(facep, volume,
+                        vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), index_offset, true, nullptr);
 
                     if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
                     {
@@ -191,7 +191,7 @@ public:
     void updateReflectionProbePtr();
 
     /*virtual*/ U32     processUpdateMessage(LLMessageSystem *mesgsys,
-                                            void **user_data,
+                                            const LLObjectUpdateInfo* info,
                                             U32 block_num, const EObjectUpdateType update_type,
                                             LLDataPacker *dp) override;
 
@@ -2497,28 +2497,36 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result)
 
     sCull->clear();
 
-    for (LLWorld::region_list_t::const_iterator iter = LLWorld::getInstance()->getRegionList().begin();
-            iter != LLWorld::getInstance()->getRegionList().end(); ++iter)
+    static LLCachedControl<bool> parallel_cull(gSavedSettings, "RenderParallelCull", true);
+    if (parallel_cull)
     {
-        LLViewerRegion* region = *iter;
-
-        for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS; i++)
+        updateCullParallel(camera);
+    }
+    else
+    {
+        for (LLWorld::region_list_t::const_iterator iter = LLWorld::getInstance()->getRegionList().begin();
+                iter != LLWorld::getInstance()->getRegionList().end(); ++iter)
         {
-            LLSpatialPartition* part = region->getSpatialPartition(i);
-            if (part)
+            LLViewerRegion* region = *iter;
+
+            for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS; i++)
             {
-                if (hasRenderType(part->mDrawableType))
+                LLSpatialPartition* part = region->getSpatialPartition(i);
+                if (part)
                 {
-                    part->cull(camera);
+                    if (hasRenderType(part->mDrawableType))
+                    {
+                        part->cull(camera);
+                    }
                 }
             }
-        }
 
-        //scan the VO Cache tree
-        LLVOCachePartition* vo_part = region->getVOCachePartition();
-        if(vo_part)
-        {
-            vo_part->cull(camera, sUseOcclusion > 0);
+            //scan the VO Cache tree
+            LLVOCachePartition* vo_part = region->getVOCachePartition();
+            if(vo_part)
+            {
+                vo_part->cull(camera, sUseOcclusion > 0);
+            }
         }
     }
 
@@ -2542,6 +2550,65 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result)
     }
 }
 
+// Same culls as the loop in updateCull(), but the frustum checks of all the
+// partitions run at once on the "FrameTasks" thread pool. Everything else
+// stays on this thread and happens in the same order, so the cull result
+// does not change.
+//
+// Every partition is prepared (rebound, VO cache camera set up, VO cache back
+// object selection) before any of them is replayed, where the loop prepares
+// each one just before culling it. The gather passes read the bounds rebound()
+// writes, so all of that has to be done before they start. Moving it ahead of
+// the replays changes nothing: a replay marks groups and drawables visible and
+// issues occlusion queries for its own octree, it never moves an object or
+// touches another partition's octree, and the region's visible VO cache
+// groups that selectBackObjects() reads are only written by that region's own
+// VO cache cull, which does not run in a frame where it selects back objects.
+void LLPipeline::updateCullParallel(LLCamera& camera)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+    std::vector<std::unique_ptr<LLViewerOctreeCull> > cullers;
+    std::vector<std::unique_ptr<LLCamera> > region_cameras; // each VO cache cull localizes its own copy
+    std::vector<LLVOCachePartition*> vo_parts;
+    LLViewerOctreeCull::cull_list_t culls;
+
+    for (LLViewerRegion* region : LLWorld::getInstance()->getRegionList())
+    {
+        for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS; i++)
+        {
+            LLSpatialPartition* part = region->getSpatialPartition(i);
+            if (part && hasRenderType(part->mDrawableType))
+            {
+                cullers.push_back(part->prepareCull(camera));
+                culls.emplace_back(cullers.back().get(), part->mOctree);
+            }
+        }
+
+        LLVOCachePartition* vo_part = region->getVOCachePartition();
+        if (vo_part)
+        {
+            std::unique_ptr<LLCamera> region_camera = std::make_unique<LLCamera>(camera);
+            std::unique_ptr<LLViewerOctreeCull> culler = vo_part->prepareCull(*region_camera, sUseOcclusion > 0);
+            if (culler)
+            {
+                culls.emplace_back(culler.get(), vo_part->mOctree);
+                cullers.push_back(std::move(culler));
+                region_cameras.push_back(std::move(region_camera));
+                vo_parts.push_back(vo_part);
+            }
+        }
+    }
+
+    LLViewerOctreeCull::traverseParallel(culls);
+
+    // only sets a flag read after the cull, so it can wait for all the replays
+    for (LLVOCachePartition* vo_part : vo_parts)
+    {
+        vo_part->finishCull();
+    }
+}
+
 void LLPipeline::markNotCulled(LLSpatialGroup* group, LLCamera& camera)
 {
     if (group->isEmpty())
@@ -3554,6 +3621,9 @@ void LLPipeline::postSort(LLCamera &camera)
 
     LL_PUSH_CALLSTACKS();
 
+    // vertex data for the groups rebuilt below is written all at once after the rebuilds
+    LLVolumeGeometryManager::deferGeometry();
+
     if (!gCubeSnapshot)
     {
         // rebuild drawable geometry
@@ -3689,6 +3759,8 @@ void LLPipeline::postSort(LLCamera &camera)
 
     mMeshDirtyGroup.clear();
 
+    LLVolumeGeometryManager::fillDeferredGeometry();
+
     if (!sShadowRender)
     {
         // order alpha groups by distance
@@ -484,6 +484,7 @@ private:
     void hideDrawable( LLDrawable *pDrawable );
     void unhideDrawable( LLDrawable *pDrawable );
     void skipRenderingShadows();
+    void updateCullParallel(LLCamera& camera);
 public:
     enum {GPU_CLASS_MAX = 3 };
 
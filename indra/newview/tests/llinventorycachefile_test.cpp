@@ -0,0 +1,147 @@
+/**
+ * @file llinventorycachefile_test.cpp
+ * @brief Test the binary inventory cache
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "../llviewerprecompiledheaders.h"
+#include "../test/lltut.h"
+
+#include "../llinventorycachefile.h"
+
+#include "llfile.h"
+#include "stringize.h"
+
+#include "llviewerinventory_stub.cpp"
+
+namespace
+{
+    const S32 CACHE_VERSION = 3;
+
+    LLPointer<LLViewerInventoryItem> make_item(const LLUUID& parent_id, LLAssetType::EType type, const std::string& name)
+    {
+        LLPermissions perm;
+        perm.init(LLUUID::generateNewID(), LLUUID::generateNewID(), LLUUID::null, LLUUID::null);
+        perm.initMasks(PERM_ALL, PERM_ALL, PERM_NONE, PERM_NONE, PERM_COPY | PERM_TRANSFER);
+        return new LLViewerInventoryItem(LLUUID::generateNewID(), parent_id, perm, LLUUID::generateNewID(),
+                                         type, LLInventoryType::defaultForAssetType(type), name, name + " description",
+                                         LLSaleInfo(LLSaleInfo::FS_COPY, 10), 0, 1700000000);
+    }
+}
+
+// -------------------------------------------------------------------------------------------
+// TUT
+// -------------------------------------------------------------------------------------------
+namespace tut
+{
+    struct invCacheFileTest
+    {
+        std::string mFilename;
+
+        invCacheFileTest()
+        {
+            mFilename = STRINGIZE(LLFile::tmpdir() << "llinventorycachefile-test-" << LLUUID::generateNewID() << ".inv.bin");
+        }
+
+        ~invCacheFileTest()
+        {
+            LLFile::remove(mFilename, ENOENT);
+        }
+    };
+
+    typedef test_group<invCacheFileTest> invCacheFileTestFactory;
+    typedef invCacheFileTestFactory::object invCacheFileTestObject;
+    tut::invCacheFileTestFactory tut_test("LLInventoryCacheFile");
+
+    template<> template<>
+    void invCacheFileTestObject::test<1>()
+    {
+        set_test_name("Round trip");
+
+        LLInventoryCacheFile::cat_array_t categories;
+        LLInventoryCacheFile::item_array_t items;
+        LLPointer<LLViewerInventoryCategory> folder = new LLViewerInventoryCategory(LLUUID::generateNewID(), LLUUID::null,
+                                                                                   LLFolderType::FT_NOTECARD, "Notecards",
+                                                                                   LLUUID::generateNewID());
+        folder->setVersion(7);
+        categories.push_back(folder);
+        items.push_back(make_item(folder->getUUID(), LLAssetType::AT_NOTECARD, "Notecard"));
+
+        ensure("save succeeds", LLInventoryCacheFile::save(mFilename, CACHE_VERSION, categories, items));
+
+        LLInventoryCacheFile cache_file;
+        ensure("open succeeds", cache_file.open(mFilename, CACHE_VERSION));
+        ensure_equals("category count", cache_file.getCategoryCount(), 1);
+        ensure_equals("item count", cache_file.getItemCount(), 1);
+
+        LLInventoryCacheFile::cat_array_t read_categories;
+        cache_file.readCategories(0, cache_file.getCategoryCount(), read_categories);
+        ensure_equals("categories read", read_categories.size(), 1);
+        ensure_equals("category id", read_categories[0]->getUUID(), folder->getUUID());
+        ensure_equals("category owner", read_categories[0]->getOwnerID(), folder->getOwnerID());
+        ensure_equals("category version", read_categories[0]->getVersion(), 7);
+
+        LLInventoryCacheFile::item_array_t read_items;
+        LLInventoryCacheFile::changed_items_t cats_to_update;
+        cache_file.readItems(0, cache_file.getItemCount(), read_items, cats_to_update);
+        ensure_equals("items read", read_items.size(), 1);
+        ensure("no folder to update", cats_to_update.empty());
+
+        const LLViewerInventoryItem* item = read_items[0];
+        ensure_equals("item id", item->getUUID(), items[0]->getUUID());
+        ensure_equals("item parent", item->getParentUUID(), folder->getUUID());
+        ensure_equals("item type", item->getActualType(), LLAssetType::AT_NOTECARD);
+        ensure_equals("item name", item->getName(), items[0]->getName());
+        ensure_equals("item description", item->getDescription(), items[0]->getDescription());
+        ensure_equals("item creator", item->getPermissions().getCreator(), items[0]->getPermissions().getCreator());
+        ensure_equals("item sale price", item->getSaleInfo().getSalePrice(), 10);
+
+        ensure("wrong cache version is obsolete", !cache_file.open(mFilename, CACHE_VERSION + 1) && cache_file.isObsolete());
+    }
+
+    template<> template<>
+    void invCacheFileTestObject::test<2>()
+    {
+        set_test_name("Unknown asset type");
+
+        // Items of a type this viewer can not handle must not be created
+        // from the cache; their folder has to be fetched again instead
+        const LLUUID folder_id = LLUUID::generateNewID();
+        LLInventoryCacheFile::cat_array_t categories;
+        LLInventoryCacheFile::item_array_t items;
+        items.push_back(make_item(folder_id, LLAssetType::AT_UNKNOWN, "Unknown"));
+        items.push_back(make_item(folder_id, LLAssetType::AT_NONE, "None"));
+
+        ensure("save succeeds", LLInventoryCacheFile::save(mFilename, CACHE_VERSION, categories, items));
+
+        LLInventoryCacheFile cache_file;
+        ensure("open succeeds", cache_file.open(mFilename, CACHE_VERSION));
+
+        LLInventoryCacheFile::item_array_t read_items;
+        LLInventoryCacheFile::changed_items_t cats_to_update;
+        cache_file.readItems(0, cache_file.getItemCount(), read_items, cats_to_update);
+        ensure_equals("unknown type item skipped", read_items.size(), 1);
+        ensure_equals("AT_NONE is not unknown", read_items[0]->getUUID(), items[1]->getUUID());
+        ensure_equals("folder to update", cats_to_update.size(), 1);
+        ensure("parent folder invalidated", cats_to_update.count(folder_id) == 1);
+    }
+}
@@ -0,0 +1,99 @@
+/**
+ * @file llviewerinventory_stub.cpp
+ * @brief  stub class to allow unit testing
+ *
+ * $LicenseInfo:firstyear=2025&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2025, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "../llviewerinventory.h"
+
+// Items and categories that behave like their llinventory base classes,
+// without the agent, the inventory model or any messaging behind them.
+
+LLViewerInventoryItem::LLViewerInventoryItem(const LLUUID& uuid,
+                                             const LLUUID& parent_uuid,
+                                             const LLPermissions& perm,
+                                             const LLUUID& asset_uuid,
+                                             LLAssetType::EType type,
+                                             LLInventoryType::EType inv_type,
+                                             const std::string& name,
+                                             const std::string& desc,
+                                             const LLSaleInfo& sale_info,
+                                             U32 flags,
+                                             time_t creation_date_utc) :
+    LLInventoryItem(uuid, parent_uuid, perm, asset_uuid, type, inv_type,
+                    name, desc, sale_info, flags, (S32)creation_date_utc),
+    mIsComplete(true)
+{
+}
+
+LLViewerInventoryItem::~LLViewerInventoryItem() {}
+LLAssetType::EType LLViewerInventoryItem::getType() const { return LLInventoryItem::getType(); }
+const LLUUID& LLViewerInventoryItem::getAssetUUID() const { return LLInventoryItem::getAssetUUID(); }
+const LLUUID& LLViewerInventoryItem::getProtectedAssetUUID() const { return LLInventoryItem::getAssetUUID(); }
+const std::string& LLViewerInventoryItem::getName() const { return LLInventoryItem::getName(); }
+S32 LLViewerInventoryItem::getSortField() const { return -1; }
+void LLViewerInventoryItem::getSLURL() {}
+const LLPermissions& LLViewerInventoryItem::getPermissions() const { return LLInventoryItem::getPermissions(); }
+const bool LLViewerInventoryItem::getIsFullPerm() const { return false; }
+const LLUUID& LLViewerInventoryItem::getCreatorUUID() const { return LLInventoryItem::getCreatorUUID(); }
+const std::string& LLViewerInventoryItem::getDescription() const { return LLInventoryItem::getDescription(); }
+const LLSaleInfo& LLViewerInventoryItem::getSaleInfo() const { return LLInventoryItem::getSaleInfo(); }
+const LLUUID& LLViewerInventoryItem::getThumbnailUUID() const { return LLInventoryItem::getThumbnailUUID(); }
+LLInventoryType::EType LLViewerInventoryItem::getInventoryType() const { return LLInventoryItem::getInventoryType(); }
+bool LLViewerInventoryItem::isWearableType() const { return false; }
+LLWearableType::EType LLViewerInventoryItem::getWearableType() const { return LLWearableType::WT_INVALID; }
+bool LLViewerInventoryItem::isSettingsType() const { return false; }
+LLSettingsType::type_e LLViewerInventoryItem::getSettingsType() const { return LLSettingsType::ST_NONE; }
+U32 LLViewerInventoryItem::getFlags() const { return LLInventoryItem::getFlags(); }
+time_t LLViewerInventoryItem::getCreationDate() const { return LLInventoryItem::getCreationDate(); }
+U32 LLViewerInventoryItem::getCRC32() const { return LLInventoryItem::getCRC32(); }
+void LLViewerInventoryItem::copyItem(const LLInventoryItem* other) { LLInventoryItem::copyItem(other); }
+void LLViewerInventoryItem::updateParentOnServer(bool restamp) const {}
+void LLViewerInventoryItem::updateServer(bool is_new) const {}
+void LLViewerInventoryItem::packMessage(LLMessageSystem* msg) const {}
+bool LLViewerInventoryItem::unpackMessage(LLMessageSystem* msg, const char* block, S32 block_num) { return false; }
+bool LLViewerInventoryItem::unpackMessage(const LLSD& item) { return false; }
+bool LLViewerInventoryItem::importLegacyStream(std::istream& input_stream) { return false; }
+void LLViewerInventoryItem::setTransactionID(const LLTransactionID& transaction_id) { mTransactionID = transaction_id; }
+
+LLViewerInventoryCategory::LLViewerInventoryCategory(const LLUUID& uuid,
+                                                     const LLUUID& parent_uuid,
+                                                     LLFolderType::EType pref,
+                                                     const std::string& name,
+                                                     const LLUUID& owner_id) :
+    LLInventoryCategory(uuid, parent_uuid, pref, name),
+    mOwnerID(owner_id),
+    mVersion(LLViewerInventoryCategory::VERSION_UNKNOWN),
+    mDescendentCount(LLViewerInventoryCategory::DESCENDENT_COUNT_UNKNOWN),
+    mFetching(FETCH_NONE)
+{
+}
+
+LLViewerInventoryCategory::~LLViewerInventoryCategory() {}
+S32 LLViewerInventoryCategory::getVersion() const { return mVersion; }
+void LLViewerInventoryCategory::setVersion(S32 version) { mVersion = version; }
+void LLViewerInventoryCategory::updateParentOnServer(bool restamp_children) const {}
+void LLViewerInventoryCategory::updateServer(bool is_new) const {}
+void LLViewerInventoryCategory::packMessage(LLMessageSystem* msg) const {}
+void LLViewerInventoryCategory::unpackMessage(LLMessageSystem* msg, const char* block, S32 block_num) {}
+bool LLViewerInventoryCategory::unpackMessage(const LLSD& category) { return false; }
@@ -0,0 +1,266 @@
+/**
+ * @file llvieweroctree_test.cpp
+ * @date 2026-10-16
+ * @brief Test viewer octree culling
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "../llviewerprecompiledheaders.h"
+#include "../test/lltut.h"
+
+#include "../llvieweroctree.h"
+#include "../pipeline.h"
+
+#include "lltimer.h"
+#include "threadpool.h"
+
+#include <set>
+
+namespace
+{
+    class TestEntryData : public LLViewerOctreeEntryData
+    {
+    public:
+        TestEntryData(const LLVector4a& center, F32 radius)
+            : LLViewerOctreeEntryData(LLViewerOctreeEntry::LLDRAWABLE)
+        {
+            setOctreeEntry(NULL);
+
+            LLVector4a size;
+            size.splat(radius);
+            LLVector4a min, max;
+            min.setSub(center, size);
+            max.setAdd(center, size);
+            setSpatialExtents(min, max);
+            setPositionGroup(center);
+            setBinRadius(radius * 2.f);
+        }
+    };
+
+    // Records the groups it would draw, in order. Groups in mEarlyFail fail
+    // the way occluded ones do, earlyFail() is checked again on replay.
+    class TestCull : public LLViewerOctreeCull
+    {
+    public:
+        TestCull(LLCamera* camera, const std::set<const LLViewerOctreeGroup*>& early_fail)
+            : LLViewerOctreeCull(camera), mEarlyFail(early_fail)
+        {
+        }
+
+        std::vector<const LLViewerOctreeGroup*> mDrawn;
+
+    protected:
+        bool earlyFail(LLViewerOctreeGroup* group) override
+        {
+            return mEarlyFail.count(group) > 0;
+        }
+
+        S32 frustumCheck(const LLViewerOctreeGroup* group) override
+        {
+            return AABBInFrustumGroupBounds(group);
+        }
+
+        S32 frustumCheckObjects(const LLViewerOctreeGroup* group) override
+        {
+            return AABBInFrustumObjectBounds(group);
+        }
+
+        void frustumCheckChildren(const OctreeNode* n, S32* results) override
+        {
+            AABBInFrustumChildBounds(n, results);
+        }
+
+        void processGroup(LLViewerOctreeGroup* group) override
+        {
+            mDrawn.push_back(group);
+        }
+
+    private:
+        const std::set<const LLViewerOctreeGroup*>& mEarlyFail;
+    };
+
+    // Camera at origin looking down +x turned by yaw around z, frustum
+    // corners laid out the way LLViewerCamera::updateFrustumPlanes() does it.
+    void make_camera(LLCamera& camera, const LLVector3& origin, F32 yaw)
+    {
+        const F32 n = 1.f, nh = 0.5f, f = 128.f, fh = 64.f;
+        LLVector3 frust[8] =
+        {
+            LLVector3(n,  nh, -nh), LLVector3(n, -nh, -nh), LLVector3(n, -nh, nh), LLVector3(n,  nh, nh),
+            LLVector3(f,  fh, -fh), LLVector3(f, -fh, -fh), LLVector3(f, -fh, fh), LLVector3(f,  fh, fh)
+        };
+        const F32 c = cosf(yaw), s = sinf(yaw);
+        for (LLVector3& v : frust)
+        {
+            v.set(origin.mV[VX] + v.mV[VX] * c - v.mV[VY] * s,
+                  origin.mV[VY] + v.mV[VX] * s + v.mV[VY] * c,
+                  origin.mV[VZ] + v.mV[VZ]);
+        }
+        camera.calcAgentFrustumPlanes(frust);
+    }
+
+    void collect_groups(const OctreeNode* node, std::vector<const LLViewerOctreeGroup*>& groups)
+    {
+        groups.push_back((const LLViewerOctreeGroup*) node->getListener(0));
+        for (U32 i = 0; i < node->getChildCount(); i++)
+        {
+            collect_groups(node->getChild(i), groups);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Mock objects for the dependencies of the code we're testing
+LLViewerCamera::eCameraID LLViewerCamera::sCurCameraID{};
+S32 LLPipeline::sUseOcclusion{};
+
+// -------------------------------------------------------------------------------------------
+// TUT
+// -------------------------------------------------------------------------------------------
+namespace tut
+{
+    struct viewerOctreeTest
+    {
+        viewerOctreeTest()
+            : mPool("FrameTasks", 3)
+        {
+            mOctreeMaxCapacity = gOctreeMaxCapacity;
+            mOctreeMinSize = gOctreeMinSize;
+            gOctreeMaxCapacity = 16;
+            gOctreeMinSize = 0.5f;
+            mPool.start();
+        }
+
+        ~viewerOctreeTest()
+        {
+            mPool.close();
+            for (OctreeNode* octree : mOctrees)
+            {
+                delete octree;
+            }
+            mEntries.clear();
+            gOctreeMaxCapacity = mOctreeMaxCapacity;
+            gOctreeMinSize = mOctreeMinSize;
+        }
+
+        // a region of count objects from 0.5m to 8m across, spread over a 256m square
+        OctreeNode* makeRegion(const LLVector3& origin, U32 count, U32 seed)
+        {
+            LLVector4a center(origin.mV[VX] + 128.f, origin.mV[VY] + 128.f, origin.mV[VZ] + 128.f);
+            LLVector4a size;
+            size.splat(128.f);
+            OctreeRoot* octree = new OctreeRoot(center, size, NULL);
+            new LLViewerOctreeGroup(octree);
+            mOctrees.push_back(octree);
+
+            for (U32 i = 0; i < count; i++)
+            {
+                seed = seed * 1664525 + 1013904223;
+                F32 x = (F32)((seed >> 8) & 0xff);
+                F32 y = (F32)((seed >> 16) & 0xff);
+                F32 z = (F32)((seed >> 24) & 0x3f);
+                F32 radius = 0.25f + (F32)(seed & 0xf) * 0.25f;
+                LLPointer<TestEntryData> data = new TestEntryData(LLVector4a(origin.mV[VX] + x, origin.mV[VY] + y, origin.mV[VZ] + z), radius);
+                octree->insert(data->getEntry());
+                mEntries.push_back(data);
+            }
+
+            ((LLViewerOctreeGroup*) octree->getListener(0))->rebound();
+            return octree;
+        }
+
+        LL::ThreadPool mPool;
+        std::vector<OctreeNode*> mOctrees;
+        std::vector<LLPointer<TestEntryData> > mEntries;
+        U32 mOctreeMaxCapacity;
+        F32 mOctreeMinSize;
+    };
+
+    typedef test_group<viewerOctreeTest> viewer_octree_t;
+    typedef viewer_octree_t::object viewer_octree_object_t;
+    tut::viewer_octree_t tut_viewer_octree("LLViewerOctree");
+
+    template<> template<>
+    void viewer_octree_object_t::test<1>()
+    {
+        set_test_name("Parallel traversal draws what traverse() draws, in the same order");
+
+        // a 4x4 grid of regions seen from a camera path that circles over
+        // the middle of the grid
+        const U32 REGIONS = 16, OBJECTS = 2000, FRAMES = 16;
+        for (U32 i = 0; i < REGIONS; i++)
+        {
+            makeRegion(LLVector3(256.f * (i % 4), 256.f * (i / 4), 0.f), OBJECTS, i + 1);
+        }
+
+        // every 31st group fails early, as if occluded
+        std::vector<const LLViewerOctreeGroup*> groups;
+        for (OctreeNode* octree : mOctrees)
+        {
+            collect_groups(octree, groups);
+        }
+        std::set<const LLViewerOctreeGroup*> early_fail;
+        for (size_t i = 3; i < groups.size(); i += 31)
+        {
+            early_fail.insert(groups[i]);
+        }
+
+        F32 serial_time = 0.f, parallel_time = 0.f;
+        size_t drawn = 0;
+        LLTimer timer;
+        for (U32 f = 0; f < FRAMES; f++)
+        {
+            F32 angle = F_TWO_PI * f / FRAMES;
+            LLCamera camera;
+            make_camera(camera, LLVector3(512.f + 300.f * cosf(angle), 512.f + 300.f * sinf(angle), 40.f), angle + F_PI_BY_TWO);
+
+            std::vector<std::unique_ptr<TestCull> > serial, parallel;
+            LLViewerOctreeCull::cull_list_t culls;
+            for (OctreeNode* octree : mOctrees)
+            {
+                serial.push_back(std::make_unique<TestCull>(&camera, early_fail));
+                parallel.push_back(std::make_unique<TestCull>(&camera, early_fail));
+                culls.emplace_back(parallel.back().get(), octree);
+            }
+
+            timer.reset();
+            for (size_t i = 0; i < mOctrees.size(); i++)
+            {
+                serial[i]->traverse(mOctrees[i]);
+            }
+            serial_time += timer.getElapsedTimeAndResetF32();
+            LLViewerOctreeCull::traverseParallel(culls);
+            parallel_time += timer.getElapsedTimeF32();
+
+            for (size_t i = 0; i < mOctrees.size(); i++)
+            {
+                ensure(STRINGIZE("region " << i << " frame " << f), parallel[i]->mDrawn == serial[i]->mDrawn);
+                drawn += serial[i]->mDrawn.size();
+            }
+        }
+
+        LL_INFOS() << "culled " << REGIONS << " regions of " << OBJECTS << " objects over " << FRAMES << " frames: serial "
+                   << serial_time * 1000.f << "ms, parallel " << parallel_time * 1000.f << "ms" << LL_ENDL;
+        ensure("camera path sees something", drawn > 0);
+    }
+}
@@ -38,13 +38,38 @@
 
 #include "../llviewerobjectlist.h"
 #include "../llviewerregion.h"
+#include "../llworld.h"
 
 #include "lldir_stub.cpp"
 #include "llvieweroctree_stub.cpp"
 
 namespace
 {
+    // A region's worth of cache entries with made up object update data
+    void make_region_cache(LLVOCacheEntry::vocache_entry_map_t& entries, U32 count, U32 seed)
+    {
+        std::vector<U8> data(2048);
+        for (U32 local_id = 1; local_id <= count; ++local_id)
+        {
+            seed = seed * 1664525 + 1013904223;
+            S32 size = 64 + (seed >> 8) % 1024;
+            for (S32 i = 0; i < size; ++i)
+            {
+                data[i] = (U8)(local_id * 31 + i);
+            }
+            LLDataPackerBinaryBuffer dp(data.data(), size);
+            entries[local_id] = new LLVOCacheEntry(local_id, seed, dp);
+        }
+    }
 
+    bool same_data(LLVOCacheEntry* a, LLVOCacheEntry* b)
+    {
+        LLDataPackerBinaryBuffer* a_dp = a->getDP();
+        LLDataPackerBinaryBuffer* b_dp = b->getDP();
+        return a_dp && b_dp
+            && a_dp->getBufferSize() == b_dp->getBufferSize()
+            && memcmp(a_dp->getBuffer(), b_dp->getBuffer(), a_dp->getBufferSize()) == 0;
+    }
 }
 
 
@@ -58,11 +83,15 @@ LLDebugBeacon::~LLDebugBeacon() = default;
 LLViewerObjectList gObjectList{};
 LLViewerCamera::eCameraID LLViewerCamera::sCurCameraID{};
 void LLViewerObject::unpackUUID(LLDataPackerBinaryBuffer *dp, LLUUID &value, std::string name) {}
+void LLViewerObjectList::getUUIDFromLocal(LLUUID &id, const U32 local_id, const U32 ip, const U32 port) {}
 
 bool LLViewerRegion::addVisibleGroup(LLViewerOctreeGroup*) { return false; }
 U32 LLViewerRegion::getNumOfVisibleGroups() const { return 0; }
 LLVector3 LLViewerRegion::getOriginAgent() const { return LLVector3::zero; }
 S32 LLViewerRegion::sLastCameraUpdated{};
+void LLViewerRegion::clearVOCacheFromMemory() {}
+
+LLViewerRegion* LLWorld::getRegionFromHandle(const U64 &handle) { return NULL; }
 
 // -------------------------------------------------------------------------------------------
 // TUT
@@ -138,10 +167,94 @@ namespace tut
     void vocacheTestObject::test<2>()
     {
         LLVOCacheEntry::vocache_gltf_overrides_map_t extras;
+        LLVOCacheEntry::vocache_entry_map_t entries;
 
         U64 region_handle = to_region_handle(140, 81);
         LLUUID region_id = LLUUID::generateNewID();
 
-        LLVOCache::instance().readGenericExtrasFromCache(region_handle, region_id, extras);
+        LLVOCache::instance().readGenericExtrasFromCache(region_handle, region_id, extras, entries);
+    }
+
+    template<> template<>
+    void vocacheTestObject::test<3>()
+    {
+        set_test_name("Region cache round trip");
+
+        U64 region_handle = to_region_handle(141, 81);
+        LLUUID region_id = LLUUID::generateNewID();
+        LLVOCache& cache = LLVOCache::instance();
+
+        LLVOCacheEntry::vocache_entry_map_t written;
+        make_region_cache(written, 500, 1);
+        cache.writeToCache(region_handle, region_id, written, true, false);
+
+        LLVOCacheEntry::vocache_entry_map_t read;
+        ensure("read succeeds", cache.readFromCache(region_handle, region_id, read));
+        ensure_equals("entry count", read.size(), written.size());
+
+        // Rewrite the file while only some of the entries have been used,
+        // the rest still have to come from the file that was read
+        for (auto& [local_id, entry] : read)
+        {
+            if (local_id % 3 == 0)
+            {
+                ensure("early entry data", same_data(entry, written[local_id]));
+            }
+        }
+        cache.writeToCache(region_handle, region_id, read, true, false);
+
+        LLVOCacheEntry::vocache_entry_map_t reread;
+        ensure("reread succeeds", cache.readFromCache(region_handle, region_id, reread));
+        ensure_equals("reread entry count", reread.size(), written.size());
+        for (auto& [local_id, entry] : written)
+        {
+            ensure_equals("crc", reread[local_id]->getCRC(), entry->getCRC());
+            ensure("entry data", same_data(read[local_id], entry));
+            ensure("rewritten entry data", same_data(reread[local_id], entry));
+        }
+    }
+
+    template<> template<>
+    void vocacheTestObject::test<4>()
+    {
+        set_test_name("Region cache read benchmark");
+
+        // Large regions have tens of thousands of cached objects, and only
+        // some of them are ever turned into objects
+        const U32 ENTRY_COUNTS[] = { 1000, 15000, 30000 };
+        const S32 ITERATIONS = 10;
+
+        LLVOCache& cache = LLVOCache::instance();
+        for (U32 count : ENTRY_COUNTS)
+        {
+            U64 region_handle = to_region_handle(142, 81);
+            LLUUID region_id = LLUUID::generateNewID();
+
+            LLVOCacheEntry::vocache_entry_map_t written;
+            make_region_cache(written, count, count);
+            cache.writeToCache(region_handle, region_id, written, true, false);
+
+            // Read only, then read and use every entry
+            F64 seconds[2];
+            for (S32 pass = 0; pass < 2; ++pass)
+            {
+                LLTimer timer;
+                for (S32 i = 0; i < ITERATIONS; ++i)
+                {
+                    LLVOCacheEntry::vocache_entry_map_t read;
+                    ensure("read succeeds", cache.readFromCache(region_handle, region_id, read));
+                    if (pass)
+                    {
+                        for (auto& [local_id, entry] : read)
+                        {
+                            ensure("entry data", entry->getDP() != NULL);
+                        }
+                    }
+                }
+                seconds[pass] = timer.getElapsedTimeF64() / ITERATIONS;
+            }
+            LL_INFOS("VOCache") << count << " entries: read " << seconds[0] * 1000.0 << " ms, read and use all "
+                                << seconds[1] * 1000.0 << " ms" << LL_ENDL;
+        }
     }
 }
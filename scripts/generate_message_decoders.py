@@ -0,0 +1,330 @@
+#!/usr/bin/env python3
+"""\
+@file generate_message_decoders.py
+@brief Generates typed decoders for template messages.
+
+$LicenseInfo:firstyear=2026&license=viewerlgpl$
+Second Life Viewer Source Code
+Copyright (C) 2026, Linden Research, Inc.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation;
+version 2.1 of the License only.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+$/LicenseInfo$
+"""
+
+"""generate_message_decoders writes a C++ header with one LLMessageDecoder
+subclass per named message of message_template.msg. Each decoder knows the
+layout of its message at compile time, finds its blocks in the received
+packet in one pass and reads variables straight out of the packet.
+
+usage: generate_message_decoders.py --template FILE --output FILE MESSAGE...
+"""
+
+import sys
+import os.path
+
+def add_indra_lib_path():
+    root = os.path.realpath(__file__)
+    # always insert the directory of the script in the search path
+    dir = os.path.dirname(root)
+    if dir not in sys.path:
+        sys.path.insert(0, dir)
+
+    # Now go look for indra/lib/python in the parent dies
+    while root != os.path.sep:
+        root = os.path.dirname(root)
+        dir = os.path.join(root, 'indra', 'lib', 'python')
+        if os.path.isdir(dir):
+            if dir not in sys.path:
+                sys.path.insert(0, dir)
+            break
+    else:
+        print("This script is not inside a valid installation.", file=sys.stderr)
+        sys.exit(1)
+
+add_indra_lib_path()
+
+import optparse
+
+from indra.ipc import llmessage
+
+# template type: (C++ type, EMsgVariableType, size in the packet, reader)
+FIXED_TYPES = {
+    llmessage.Variable.U8:           ("U8", "MVT_U8", 1, "read<U8>(%s, MVT_U8)"),
+    llmessage.Variable.U16:          ("U16", "MVT_U16", 2, "read<U16>(%s, MVT_U16)"),
+    llmessage.Variable.U32:          ("U32", "MVT_U32", 4, "read<U32>(%s, MVT_U32)"),
+    llmessage.Variable.U64:          ("U64", "MVT_U64", 8, "read<U64>(%s, MVT_U64)"),
+    llmessage.Variable.S8:           ("S8", "MVT_S8", 1, "read<S8>(%s, MVT_S8)"),
+    llmessage.Variable.S16:          ("S16", "MVT_S16", 2, "read<S16>(%s, MVT_S16)"),
+    llmessage.Variable.S32:          ("S32", "MVT_S32", 4, "read<S32>(%s, MVT_S32)"),
+    llmessage.Variable.S64:          ("S64", "MVT_S64", 8, "read<S64>(%s, MVT_S64)"),
+    llmessage.Variable.F32:          ("F32", "MVT_F32", 4, "readF32(%s)"),
+    llmessage.Variable.F64:          ("F64", "MVT_F64", 8, "readF64(%s)"),
+    llmessage.Variable.LLVECTOR3:    ("LLVector3", "MVT_LLVector3", 12, "readVector3(%s)"),
+    llmessage.Variable.LLVECTOR3D:   ("LLVector3d", "MVT_LLVector3d", 24, "readVector3d(%s)"),
+    llmessage.Variable.LLVECTOR4:    ("LLVector4", "MVT_LLVector4", 16, "readVector4(%s)"),
+    llmessage.Variable.LLQUATERNION: ("LLQuaternion", "MVT_LLQuaternion", 12, "readQuat(%s)"),
+    llmessage.Variable.LLUUID:       ("LLUUID", "MVT_LLUUID", 16, "readUUID(%s)"),
+    llmessage.Variable.BOOL:         ("bool", "MVT_BOOL", 1, "(read<U8>(%s, MVT_BOOL) != 0)"),
+    llmessage.Variable.IPADDR:       ("U32", "MVT_IP_ADDR", 4, "read<U32>(%s, MVT_IP_ADDR)"),
+    llmessage.Variable.IPPORT:       ("U16", "MVT_IP_PORT", 2, "readIPPort(%s)"),
+}
+
+BLOCK_TYPES = {
+    llmessage.Block.SINGLE:   "MBT_SINGLE",
+    llmessage.Block.MULTIPLE: "MBT_MULTIPLE",
+    llmessage.Block.VARIABLE: "MBT_VARIABLE",
+}
+
+HEADER = """\
+/**
+ * @file llmessagedecoders.h
+ * @brief Typed decoders for the busiest template messages.
+ *
+ * Generated by scripts/generate_message_decoders.py from
+ * %(template)s.
+ * Do not edit: change the list of messages in indra/llmessage/CMakeLists.txt.
+ */
+
+#ifndef LL_LLMESSAGEDECODERS_H
+#define LL_LLMESSAGEDECODERS_H
+
+#include "llmessagedecoder.h"
+
+namespace LLMessageDecoders
+{
+"""
+
+FOOTER = """\
+}
+
+#endif // LL_LLMESSAGEDECODERS_H
+"""
+
+def message_number(message):
+    """The number LLTemplateParser gives the message at run time."""
+    if message.priority == llmessage.Message.HIGH:
+        return message.number
+    if message.priority == llmessage.Message.MEDIUM:
+        return (255 << 8) | message.number
+    if message.priority == llmessage.Message.LOW:
+        return (255 << 24) | (255 << 16) | message.number
+    return message.number
+
+def max_blocks(block):
+    if block.repeat == llmessage.Block.SINGLE:
+        return 1
+    if block.repeat == llmessage.Block.MULTIPLE:
+        return block.count
+    # the count of a Variable block is one byte
+    return 255
+
+def variable_size(variable):
+    if variable.type in llmessage.Variable.typeswithsize:
+        return int(variable.size)
+    return FIXED_TYPES[variable.type][2]
+
+def emsg_type(variable):
+    if variable.type == llmessage.Variable.FIXED:
+        return "MVT_FIXED"
+    if variable.type == llmessage.Variable.VARIABLE:
+        return "MVT_VARIABLE"
+    return FIXED_TYPES[variable.type][1]
+
+def layout_runs(block):
+    """Split the variables of a block into the runs between variable length
+    fields. Returns (run sizes, placed variables), where each placed variable
+    is (variable, run index, offset in run)."""
+    runs = [0]
+    placed = []
+    for variable in block.variables:
+        placed.append((variable, len(runs) - 1, runs[-1]))
+        runs[-1] += variable_size(variable)
+        if variable.type == llmessage.Variable.VARIABLE:
+            runs.append(0)
+    return runs, placed
+
+def generate_block(out, block):
+    runs, placed = layout_runs(block)
+    out.append("    class %sBlock\n" % block.name)
+    out.append("    {\n")
+    out.append("    public:\n")
+    for variable, run, offset in placed:
+        at = "mData[%d] + %d" % (run, offset)
+        if variable.type == llmessage.Variable.VARIABLE:
+            prefix = int(variable.size)
+            out.append("        const U8* get%s() const { return %s + %d; }\n"
+                       % (variable.name, at, prefix))
+            out.append("        S32 get%sSize() const { return readVariableSize(%s, %d); }\n"
+                       % (variable.name, at, prefix))
+        elif variable.type == llmessage.Variable.FIXED:
+            out.append("        const U8* get%s() const { return %s; }\n" % (variable.name, at))
+            out.append("        S32 get%sSize() const { return %d; }\n"
+                       % (variable.name, int(variable.size)))
+        else:
+            cpp_type, _, _, reader = FIXED_TYPES[variable.type]
+            out.append("        %s get%s() const { return %s; }\n"
+                       % (cpp_type, variable.name, reader % at))
+    out.append("\n")
+    out.append("    private:\n")
+    out.append("        friend class %s;\n" % "%(message)s")
+    out.append("        // where each run of fixed size variables starts\n")
+    out.append("        const U8* mData[%d];\n" % len(runs))
+    out.append("    };\n\n")
+
+def generate_decode(out, message):
+    out.append("    // Finds the blocks of a message body. False if it is cut short.\n")
+    out.append("    bool decode(const U8* body, S32 size)\n")
+    out.append("    {\n")
+    out.append("        S32 pos = 0;\n")
+    for block in message.blocks:
+        out.append("\n")
+        if block.repeat == llmessage.Block.VARIABLE:
+            out.append("        mNum%s = readBlockCount(body, size, pos);\n" % block.name)
+        else:
+            out.append("        mNum%s = %d;\n" % (block.name, max_blocks(block)))
+        out.append("        for (S32 i = 0; i < mNum%s; ++i)\n" % block.name)
+        out.append("        {\n")
+        out.append("            %sBlock& block = m%s[i];\n" % (block.name, block.name))
+        out.append("            block.mData[0] = body + pos;\n")
+        run = 0
+        run_size = 0
+        for variable in block.variables:
+            if variable.type == llmessage.Variable.VARIABLE:
+                if run_size:
+                    out.append("            if (!skipFixed(size, pos, %d)) return false;\n" % run_size)
+                out.append("            if (!skipVariable(body, size, pos, %d)) return false;\n"
+                           % int(variable.size))
+                run += 1
+                run_size = 0
+                out.append("            block.mData[%d] = body + pos;\n" % run)
+            else:
+                run_size += variable_size(variable)
+        if run_size:
+            out.append("            if (!skipFixed(size, pos, %d)) return false;\n" % run_size)
+        out.append("        }\n")
+    out.append("        return true;\n")
+    out.append("    }\n\n")
+
+def generate_layout(out, message):
+    out.append("    // The layout this decoder was generated for.\n")
+    out.append("    static const MessageLayout& getLayout()\n")
+    out.append("    {\n")
+    for block in message.blocks:
+        if not block.variables:
+            continue
+        out.append("        static const VariableLayout %s_variables[] =\n" % block.name)
+        out.append("        {\n")
+        for variable in block.variables:
+            out.append("            { \"%s\", %s, %d },\n"
+                       % (variable.name, emsg_type(variable), variable_size(variable)))
+        out.append("        };\n")
+    out.append("        static const BlockLayout blocks[] =\n")
+    out.append("        {\n")
+    for block in message.blocks:
+        if block.variables:
+            variables = "%s_variables, %d" % (block.name, len(block.variables))
+        else:
+            variables = "NULL, 0"
+        out.append("            { \"%s\", %s, %d, %s },\n"
+                   % (block.name, BLOCK_TYPES[block.repeat],
+                      block.count if block.repeat == llmessage.Block.MULTIPLE else 1,
+                      variables))
+    out.append("        };\n")
+    out.append("        static const MessageLayout layout = { \"%s\", MESSAGE_NUMBER, blocks, %d };\n"
+               % (message.name, len(message.blocks)))
+    out.append("        return layout;\n")
+    out.append("    }\n\n")
+
+def generate_message(message):
+    out = []
+    out.append("\n// %s %s %d %s %s\n"
+               % (message.name, message.priority, message.number, message.trust, message.coding))
+    out.append("class %s : public LLMessageDecoder\n" % message.name)
+    out.append("{\n")
+    out.append("public:\n")
+    out.append("    static constexpr U32 MESSAGE_NUMBER = 0x%08X;\n\n" % message_number(message))
+
+    for block in message.blocks:
+        generate_block(out, block)
+
+    initializers = ", ".join("mNum%s(0)" % block.name for block in message.blocks)
+    out.append("    %s() : %s {}\n\n" % (message.name, initializers))
+
+    for block in message.blocks:
+        out.append("    S32 getNumberOf%sBlocks() const { return mNum%s; }\n" % (block.name, block.name))
+        out.append("    const %sBlock& get%s(S32 i = 0) const { llassert(i >= 0 && i < mNum%s); return m%s[i]; }\n"
+                   % (block.name, block.name, block.name, block.name))
+    out.append("\n")
+
+    out.append("    // Decodes the message msg is handling, from its generic decode if this\n")
+    out.append("    // decoder is not registered. False if it is not a %s or is cut short.\n"
+               % message.name)
+    out.append("    bool decode(const LLMessageSystem* msg)\n")
+    out.append("    {\n")
+    out.append("        const U8* body = NULL;\n")
+    out.append("        S32 size = 0;\n")
+    out.append("        return getMessageBody(msg, getLayout(), body, size) && decode(body, size);\n")
+    out.append("    }\n\n")
+    generate_decode(out, message)
+    generate_layout(out, message)
+
+    out.append("    // Checks the template msg loaded agrees with getLayout() and, if so,\n")
+    out.append("    // lets the message skip the generic decode.\n")
+    out.append("    static bool registerDecoder(LLMessageSystem* msg) { return LLMessageDecoder::registerDecoder(msg, getLayout()); }\n\n")
+
+    out.append("private:\n")
+    for block in message.blocks:
+        out.append("    S32 mNum%s;\n" % block.name)
+        out.append("    %sBlock m%s[%d];\n" % (block.name, block.name, max_blocks(block)))
+    out.append("};\n")
+    return "".join(out) % { "message": message.name }
+
+def main():
+    parser = optparse.OptionParser(
+        usage="usage: %prog --template FILE --output FILE MESSAGE...")
+    parser.add_option("--template", help="message_template.msg to read")
+    parser.add_option("--output", help="header to write")
+    (options, args) = parser.parse_args()
+    if not options.template or not options.output or not args:
+        parser.error("need a template, an output file and at least one message")
+
+    with open(options.template) as f:
+        template = llmessage.parseTemplateFile(f)
+
+    text = [HEADER % { "template": os.path.basename(options.template) }]
+    for name in args:
+        message = template.messages.get(name)
+        if not message:
+            print("%s is not in %s" % (name, options.template), file=sys.stderr)
+            return 1
+        text.append(generate_message(message))
+    text.append(FOOTER)
+    text = "".join(text)
+
+    # don't touch an unchanged header, everything including it would rebuild
+    try:
+        with open(options.output) as f:
+            if f.read() == text:
+                return 0
+    except IOError:
+        pass
+    with open(options.output, "w") as f:
+        f.write(text)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""\
+@file   texture_server.py
+@date   2025-06-02
+@brief  Stand-in for the ViewerAsset capability, serving a folder of J2C
+        files by texture_id for the viewer's texture fetch trace replay
+        (TextureFetchReplayFile / --replaytexturefetch).
+
+Textures are looked up as <folder>/<texture_id>.j2c. Range requests are
+honoured the way the asset servers do, so the viewer's partial fetches and
+discard level logic are exercised.
+
+$LicenseInfo:firstyear=2025&license=viewerlgpl$
+Copyright (c) 2025, Linden Research, Inc.
+$/LicenseInfo$
+"""
+
+import argparse
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+import os
+import re
+import sys
+import time
+from urllib.parse import parse_qs, urlparse
+
+RANGE_RE = re.compile(r'bytes=(\d*)-(\d*)$')
+UUID_RE = re.compile(r'^[0-9a-fA-F]{8}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{12}$')
+
+class TextureHandler(BaseHTTPRequestHandler):
+    # set by main()
+    folder = None
+    delay = 0.0
+
+    def do_GET(self):
+        query = parse_qs(urlparse(self.path).query)
+        texture_id = query.get('texture_id', [''])[0]
+        if not UUID_RE.match(texture_id):
+            self.send_error(400, 'Missing or invalid texture_id')
+            return
+
+        filename = os.path.join(self.folder, texture_id.lower() + '.j2c')
+        try:
+            with open(filename, 'rb') as f:
+                data = f.read()
+        except OSError:
+            self.send_error(404)
+            return
+
+        if self.delay:
+            time.sleep(self.delay)
+
+        start, end = 0, len(data) - 1
+        status = 200
+        match = RANGE_RE.match(self.headers.get('Range', ''))
+        if match and (match.group(1) or match.group(2)):
+            if match.group(1):
+                start = int(match.group(1))
+                if match.group(2):
+                    end = min(int(match.group(2)), end)
+            else:
+                # suffix range, the last N bytes
+                start = max(0, len(data) - int(match.group(2)))
+            if start > end:
+                self.send_response(416)
+                self.send_header('Content-Range', 'bytes */%d' % len(data))
+                self.end_headers()
+                return
+            status = 206
+
+        body = data[start:end + 1]
+        self.send_response(status)
+        self.send_header('Content-Type', 'image/x-j2c')
+        self.send_header('Content-Length', str(len(body)))
+        if status == 206:
+            self.send_header('Content-Range', 'bytes %d-%d/%d' % (start, end, len(data)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format, *args):
+        if self.server.verbose:
+            super().log_message(format, *args)
+
+def main(*raw_args):
+    parser = argparse.ArgumentParser(description="""
+Serve a folder of J2C files by texture_id for the viewer's texture fetch
+trace replay. Start the viewer with
+  --set HeadlessClient 1 --replaytexturefetch texture_fetch_trace.txt
+  --set TextureFetchReplayURL http://127.0.0.1:<port>""")
+    parser.add_argument('folder', help="""folder of <texture_id>.j2c files""")
+    parser.add_argument('-p', '--port', type=int, default=8000,
+                        help="""port to listen on (default %(default)s)""")
+    parser.add_argument('-d', '--delay', type=float, default=0.0,
+                        help="""milliseconds to wait before each response, to
+                        simulate the network""")
+    parser.add_argument('-v', '--verbose', action='store_true',
+                        help="""log every request""")
+    args = parser.parse_args(raw_args)
+
+    TextureHandler.folder = args.folder
+    TextureHandler.delay = args.delay / 1000.0
+    server = ThreadingHTTPServer(('127.0.0.1', args.port), TextureHandler)
+    server.verbose = args.verbose
+    print('Serving %s on http://127.0.0.1:%d' % (args.folder, args.port))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main(*sys.argv[1:]))
+    except Exception as err:
+        sys.exit(str(err))